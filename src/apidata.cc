@@ -243,5 +243,4 @@ namespace dd
         ++hit;
       }
   }
-
 }
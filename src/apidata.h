@@ -43,6 +43,7 @@
 #include <sstream>
 #include <typeinfo>
 #include "utils/oatpp.hpp"
+#include "utils/msgpack_writer.hpp"
 #include "oatpp/parser/json/mapping/ObjectMapper.hpp"
 
 namespace dd
@@ -285,6 +286,22 @@ namespace dd
      */
     void toJVal(JDoc &jd, JVal &jv) const;
 
+    /**
+     * \brief writes APIData to a JSON or MessagePack writer, without
+     * intermediate document
+     * @param writer destination writer
+     */
+    template <typename Writer> void write(Writer &writer) const;
+
+    /**
+     * \brief writes a value to a JSON or MessagePack writer, without copy
+     * nor intermediate document
+     * @param writer destination writer
+     * @param key value key, null is written if missing
+     */
+    template <typename Writer>
+    void write(Writer &writer, const std::string &key) const;
+
     /**
      * \brief converts APIData to oat++ DTO
      */
@@ -557,6 +574,139 @@ namespace dd
     JVal *_jv = nullptr;
   };
 
+  /**
+   * \brief visitor class for streaming APIData to a JSON or MessagePack
+   * writer, skipping the types that visitor_rjson ignores
+   */
+  template <typename Writer> class visitor_writer
+  {
+  public:
+    visitor_writer(Writer *writer) : _writer(writer)
+    {
+    }
+
+    /**
+     * \brief whether a value is written, i.e. is not ignored
+     */
+    static bool written(const ad_variant_type &val)
+    {
+      return !val.is<std::vector<cv::Mat>>()
+#ifdef USE_CUDA_CV
+             && !val.is<std::vector<cv::cuda::GpuMat>>()
+#endif
+             && !val.is<std::vector<std::pair<int, int>>>()
+             && !val.is<oatpp::Any>();
+    }
+
+    void operator()(const std::string &str)
+    {
+      _writer->String(str.c_str(), str.size());
+    }
+    void operator()(const int &i)
+    {
+      _writer->Int(i);
+    }
+    void operator()(const long int &i)
+    {
+      _writer->Uint64(static_cast<uint64_t>(i));
+    }
+    void operator()(const long long int &i)
+    {
+      _writer->Uint64(static_cast<uint64_t>(i));
+    }
+    void operator()(const double &d)
+    {
+      _writer->Double(d);
+    }
+    void operator()(const bool &b)
+    {
+      _writer->Bool(b);
+    }
+    void operator()(const APIData &ad)
+    {
+      _writer->StartObject();
+      for (auto hit = ad._data.begin(); hit != ad._data.end(); ++hit)
+        {
+          if (!written((*hit).second))
+            continue;
+          _writer->Key((*hit).first.c_str(), (*hit).first.size());
+          mapbox::util::apply_visitor(*this, (*hit).second);
+        }
+      _writer->EndObject();
+    }
+    void operator()(const std::vector<double> &vd)
+    {
+      write_double_array(*_writer, vd);
+    }
+    void operator()(const std::vector<int> &vd)
+    {
+      _writer->StartArray();
+      for (const int &i : vd)
+        _writer->Int(i);
+      _writer->EndArray();
+    }
+    void operator()(const std::vector<bool> &vd)
+    {
+      _writer->StartArray();
+      for (size_t i = 0; i < vd.size(); i++)
+        _writer->Bool(vd[i]);
+      _writer->EndArray();
+    }
+    void operator()(const std::vector<std::string> &vs)
+    {
+      _writer->StartArray();
+      for (const std::string &str : vs)
+        _writer->String(str.c_str(), str.size());
+      _writer->EndArray();
+    }
+    void operator()(const std::vector<cv::Mat> &vcv)
+    {
+      (void)vcv;
+    }
+#ifdef USE_CUDA_CV
+    void operator()(const std::vector<cv::cuda::GpuMat> &vcv)
+    {
+      (void)vcv;
+    }
+#endif
+    void operator()(const std::vector<std::pair<int, int>> &vpi)
+    {
+      (void)vpi;
+    }
+    void operator()(const std::vector<APIData> &vad)
+    {
+      _writer->StartArray();
+      for (const APIData &ad : vad)
+        (*this)(ad);
+      _writer->EndArray();
+    }
+    void operator()(const oatpp::Any &dto)
+    {
+      (void)dto;
+    }
+
+    Writer *_writer = nullptr;
+  };
+
+  template <typename Writer> void APIData::write(Writer &writer) const
+  {
+    visitor_writer<Writer> vw(&writer);
+    vw(*this);
+  }
+
+  template <typename Writer>
+  void APIData::write(Writer &writer, const std::string &key) const
+  {
+    auto hit = _data.find(key);
+    if (hit == _data.end())
+      {
+        writer.Null();
+        return;
+      }
+    visitor_writer<Writer> vw(&writer);
+    mapbox::util::apply_visitor(vw, (*hit).second);
+  }
+
 }
 
 #endif
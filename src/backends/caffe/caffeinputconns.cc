@@ -1782,7 +1782,7 @@ namespace dd
 
     //- read categoricals first if any as it affects the number of columns (and
     // thus bounds)
-    if (!_cifc->_categoricals.empty())
+    if (!_cifc->_categoricals->empty())
       {
         std::unordered_map<std::string, CCategorical> categoricals;
         for (auto fname : allfiles)
@@ -2530,19 +2530,19 @@ namespace dd
   }
 
   void SVMCaffeInputFileConn::add_train_svmline(
-      const int &label, const std::unordered_map<int, double> &vals,
+      const int &label, std::vector<std::pair<int, double>> vals,
       const int &count)
   {
     if (!_db || !_train)
       {
-        SVMInputFileConn::add_train_svmline(label, vals, count);
+        SVMInputFileConn::add_train_svmline(label, std::move(vals), count);
         return;
       }
 
     const int kMaxKeyLength = 256;
     char key_cstr[kMaxKeyLength];
 
-    SparseDatum d = to_sparse_datum(SVMline(label, vals));
+    SparseDatum d = to_sparse_datum(SVMline(label, std::move(vals)));
 
     // sequential
     int length = snprintf(
@@ -2570,19 +2570,19 @@ namespace dd
   }
 
   void SVMCaffeInputFileConn::add_test_svmline(
-      const int &label, const std::unordered_map<int, double> &vals,
+      const int &label, std::vector<std::pair<int, double>> vals,
       const int &count)
   {
     if (!_db || !_train)
       {
-        SVMInputFileConn::add_test_svmline(label, vals, count);
+        SVMInputFileConn::add_test_svmline(label, std::move(vals), count);
         return;
       }
 
     const int kMaxKeyLength = 256;
     char key_cstr[kMaxKeyLength];
 
-    SparseDatum d = to_sparse_datum(SVMline(label, vals));
+    SparseDatum d = to_sparse_datum(SVMline(label, std::move(vals)));
 
     // sequential
     int length = snprintf(
@@ -1089,7 +1089,7 @@ namespace dd
       if (ad.has("embedding") && ad.get("embedding").get<bool>())
         _embed = true;
       _sequence_txt = _sequence;
-      _max_embed_id = _alphabet.size() + 1; // +1 as offset to null index
+      _max_embed_id = _alphabet->size() + 1; // +1 as offset to null index
     }
 
     int channels() const
@@ -1119,7 +1119,7 @@ namespace dd
     int width() const
     {
       if (_characters && !_embed)
-        return _alphabet.size();
+        return _alphabet->size();
       return 1;
     }
 
@@ -1331,7 +1331,7 @@ namespace dd
       else if (_embed && !_characters)
         datum_channels = _sequence;
       else
-        datum_channels = _vocab.size(); // XXX: may be very large
+        datum_channels = _vocab->size(); // XXX: may be very large
       datum.set_channels(datum_channels);
       datum.set_height(1);
       datum.set_width(1);
@@ -1350,8 +1350,8 @@ namespace dd
                   std::string key;
                   double val;
                   tbe->get_next_elt(key, val);
-                  if ((wit = _vocab.find(key)) != _vocab.end())
-                    datum.set_float_data(_vocab[key]._pos,
+                  if ((wit = _vocab->find(key)) != _vocab->end())
+                    datum.set_float_data((*wit).second._pos,
                                          static_cast<float>(val));
                 }
             }
@@ -1364,8 +1364,9 @@ namespace dd
                   std::string key;
                   double val;
                   tbe->get_next_elt(key, val);
-                  if ((wit = _vocab.find(key)) != _vocab.end())
-                    datum.add_float_data(static_cast<float>(_vocab[key]._pos));
+                  if ((wit = _vocab->find(key)) != _vocab->end())
+                    datum.add_float_data(
+                        static_cast<float>((*wit).second._pos));
                   ++i;
                   if (i == _sequence) // tmp limit on sequence length
                     break;
@@ -1385,7 +1386,7 @@ namespace dd
               double val = -1.0;
               tbe->get_next_elt(key, val);
               uint32_t c = std::strtoul(key.c_str(), 0, 10);
-              if ((whit = _alphabet.find(c)) != _alphabet.end())
+              if ((whit = _alphabet->find(c)) != _alphabet->end())
                 vals.push_back((*whit).second);
               else
                 vals.push_back(-1);
@@ -1397,14 +1398,14 @@ namespace dd
             {
               for (int c = 0; c < _sequence; c++)
                 {
-                  std::vector<float> v(_alphabet.size(), 0.0);
+                  std::vector<float> v(_alphabet->size(), 0.0);
                   if (c < (int)vals.size() && vals[c] != -1)
                     v[vals[c]] = 1.0;
                   for (float f : v)
                     datum.add_float_data(f);
                 }
               datum.set_height(_sequence);
-              datum.set_width(_alphabet.size());
+              datum.set_width(_alphabet->size());
             }
           else
             {
@@ -1435,16 +1436,16 @@ namespace dd
           std::string key;
           double val;
           tbe->get_next_elt(key, val);
-          if ((wit = _vocab.find(key)) != _vocab.end())
+          if ((wit = _vocab->find(key)) != _vocab->end())
             {
-              int word_pos = _vocab[key]._pos;
+              int word_pos = (*wit).second._pos;
               datum.add_data(static_cast<float>(val));
               datum.add_indices(word_pos);
               ++nwords;
             }
         }
       datum.set_nnz(nwords);
-      datum.set_size(_vocab.size());
+      datum.set_size(_vocab->size());
       return datum;
     }
 
@@ -1521,10 +1522,10 @@ namespace dd
     }
 
     virtual void add_train_svmline(const int &label,
-                                   const std::unordered_map<int, double> &vals,
+                                   std::vector<std::pair<int, double>> vals,
                                    const int &count);
     virtual void add_test_svmline(const int &label,
-                                  const std::unordered_map<int, double> &vals,
+                                  std::vector<std::pair<int, double>> vals,
                                   const int &count);
 
     void transform(const APIData &ad)
@@ -2999,9 +2999,9 @@ namespace dd
     if (ad.has("chain") && ad.get("chain").get<bool>())
       cad.add("chain", true);
 
-    this->_stats.transform_start();
+    auto transform_tstart = this->_stats.transform_start();
     inputc.transform(cad);
-    this->_stats.transform_end();
+    this->_stats.transform_end(transform_tstart);
 
     int batch_size = inputc.test_batch_size();
     this->_stats.inc_inference_count(batch_size);
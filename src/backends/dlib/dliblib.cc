@@ -148,7 +148,7 @@ namespace dd
     APIData cad = ad;
     cad.add("model_repo", this->_mlmodel._repo);
 
-    this->_stats.transform_start();
+    auto transform_tstart = this->_stats.transform_start();
     try
       {
         inputc.transform(cad);
@@ -157,7 +157,7 @@ namespace dd
       {
         throw;
       }
-    this->_stats.transform_end();
+    this->_stats.transform_end(transform_tstart);
 
     APIData ad_mllib = ad.getobj("parameters").getobj("mllib");
     int batch_size = inputc.batch_size();
@@ -31,6 +31,7 @@
 #include "ncnnlib.h"
 #include "ncnninputconns.h"
 #include "dto/service_predict.hpp"
+#include "utils/topk.hpp"
 
 namespace dd
 {
@@ -160,7 +161,7 @@ namespace dd
     TInputConnectorStrategy inputc(this->_inputc);
     TOutputConnectorStrategy tout(this->_outputc);
 
-    this->_stats.transform_start();
+    auto transform_tstart = this->_stats.transform_start();
     try
       {
         inputc.transform(ad);
@@ -169,7 +170,7 @@ namespace dd
       {
         throw;
       }
-    this->_stats.transform_end();
+    this->_stats.transform_end(transform_tstart);
 
     this->_stats.inc_inference_count(inputc._ids.size());
 
@@ -324,31 +325,18 @@ namespace dd
           }
         else
           {
-            std::vector<float> cls_scores;
+            const ncnn::Mat &cls_out = inputc._out.at(b);
+            const float *cls_scores = cls_out;
+            std::vector<int> best_ids;
+            topk_utils::topk(cls_scores, 1, cls_out.w, output_params->best,
+                             best_ids);
 
-            cls_scores.resize(inputc._out.at(b).w);
-            for (int j = 0; j < inputc._out.at(b).w; j++)
+            for (int id : best_ids)
               {
-                cls_scores[j] = inputc._out.at(b)[j];
-              }
-            int size = cls_scores.size();
-            std::vector<std::pair<float, int>> vec;
-            vec.resize(size);
-            for (int i = 0; i < size; i++)
-              {
-                vec[i] = std::make_pair(cls_scores[i], i);
-              }
-
-            std::partial_sort(vec.begin(), vec.begin() + output_params->best,
-                              vec.end(),
-                              std::greater<std::pair<float, int>>());
-
-            for (int i = 0; i < output_params->best; i++)
-              {
-                if (vec[i].first < output_params->confidence_threshold)
+                if (cls_scores[id] < output_params->confidence_threshold)
                   continue;
-                cats.push_back(this->_mlmodel.get_hcorresp(vec[i].second));
-                probs.push_back(vec[i].first);
+                cats.push_back(this->_mlmodel.get_hcorresp(id));
+                probs.push_back(cls_scores[id]);
               }
           }
 
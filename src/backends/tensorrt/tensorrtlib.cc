@@ -836,7 +836,7 @@ namespace dd
     cudaStreamCreate(&cstream);
 
     TOutputConnectorStrategy tout(this->_outputc);
-    this->_stats.transform_start();
+    auto transform_tstart = this->_stats.transform_start();
 #ifdef USE_CUDA_CV
     inputc._cuda_buf = static_cast<float *>(_buffers.at(_inputIndex));
     auto cv_stream = cv::cuda::StreamAccessor::wrapStream(cstream);
@@ -851,7 +851,7 @@ namespace dd
       {
         throw;
       }
-    this->_stats.transform_end();
+    this->_stats.transform_end(transform_tstart);
 
     this->_stats.inc_inference_count(inputc._batch_size);
 
@@ -1065,7 +1065,10 @@ namespace dd
                     bbox_utils::nms_sorted_bboxes(
                         bboxes, probs, cats,
                         (double)output_params->nms_threshold,
-                        (int)output_params->best_bbox);
+                        (int)output_params->best_bbox,
+                        (bool)output_params->nms_per_class,
+                        (double)output_params->nms_sigma,
+                        (double)output_params->confidence_threshold);
                   }
 
                 if (leave)
@@ -42,6 +42,7 @@ namespace dd
       }
     _dbData = nullptr;
     _current_index = 0;
+    _series.clear();
   }
 
   void TorchDataset::pop_db_elt(int64_t index, std::string &data,
@@ -297,6 +298,43 @@ namespace dd
       write_tensors_to_db(data, target);
   }
 
+  int64_t TorchDataset::add_series(const at::Tensor &data,
+                                   const at::Tensor &target)
+  {
+    // in db mode windows are written as they come, only the current series
+    // is needed
+    if (_db)
+      _series.clear();
+    _series.push_back(std::make_pair(data, target));
+    return _series.size() - 1;
+  }
+
+  void TorchDataset::add_window(const int64_t &s, const int64_t &start,
+                                const int64_t &length,
+                                const int64_t &target_start,
+                                const int64_t &target_length)
+  {
+    TorchWindow w;
+    w._series = s;
+    w._start = start;
+    w._length = length;
+    w._target_start = target_start;
+    w._target_length = target_length;
+    if (!_db)
+      {
+        _windows.push_back(w);
+        return;
+      }
+    // views would serialize the whole series storage
+    const auto &series = _series.at(s);
+    std::vector<at::Tensor> target;
+    if (target_length > 0)
+      target.push_back(
+          series.second.narrow(0, target_start, target_length).clone());
+    write_tensors_to_db({ series.first.narrow(0, start, length).clone() },
+                        target);
+  }
+
   void TorchDataset::reset(db::Mode dbmode)
   {
     std::lock_guard<std::mutex> guard(_mutex);
@@ -308,6 +346,10 @@ namespace dd
           {
             data_size = _lfiles.size();
           }
+        else if (!_windows.empty())
+          {
+            data_size = _windows.size();
+          }
         else if (!_batches.empty())
           {
             data_size = _batches.size();
@@ -341,10 +383,36 @@ namespace dd
       {
         std::shuffle(_indices.begin(), _indices.end(), _rng);
       }
+
+    if (_shard_count > 1)
+      {
+        if (_db)
+          {
+            // db is read sequentially through a cursor
+            if (_logger)
+              _logger->warn("db datasets are not sharded across ranks, "
+                            "every rank reads the whole dataset");
+          }
+        else
+          {
+            std::vector<int64_t> shard;
+            for (size_t i = _shard_rank; i < _indices.size();
+                 i += _shard_count)
+              shard.push_back(_indices[i]);
+            _indices.swap(shard);
+          }
+      }
   }
 
   std::vector<long int> TorchDataset::targetsize(long int i) const
   {
+    if (!_db && !_windows.empty())
+      {
+        const TorchWindow &w = _windows[0];
+        std::vector<long int> sizes = _series[w._series].second.sizes().vec();
+        sizes[0] = w._target_length;
+        return sizes;
+      }
     if (!_db)
       return _batches[0].target[i].sizes().vec();
 
@@ -362,6 +430,13 @@ namespace dd
 
   std::vector<long int> TorchDataset::datasize(long int i) const
   {
+    if (!_db && !_windows.empty())
+      {
+        const TorchWindow &w = _windows[0];
+        std::vector<long int> sizes = _series[w._series].first.sizes().vec();
+        sizes[0] = w._length;
+        return sizes;
+      }
     if (!_db)
       return _batches[0].data[i].sizes().vec();
 
@@ -550,6 +625,22 @@ namespace dd
                   }
               }
           }
+        else if (!_windows.empty()) // views over time series
+          {
+            data.resize(1);
+            for (auto id : ids)
+              {
+                const TorchWindow &w = _windows[id];
+                const auto &series = _series[w._series];
+                data[0].push_back(series.first.narrow(0, w._start, w._length));
+                if (w._target_length > 0)
+                  {
+                    target.resize(1);
+                    target[0].push_back(series.second.narrow(
+                        0, w._target_start, w._target_length));
+                  }
+              }
+          }
         else // batches
           {
             bool first_iter = true;
@@ -716,6 +807,21 @@ namespace dd
 
   TorchDataset TorchDataset::split(double start, double stop)
   {
+    if (!_windows.empty())
+      {
+        // windows are split, series tensors are shared
+        auto datasize = _windows.size();
+        auto start_it
+            = _windows.begin() + static_cast<int64_t>(datasize * start);
+        auto stop_it
+            = _windows.end() - static_cast<int64_t>(datasize * (1 - stop));
+        TorchDataset new_dataset;
+        new_dataset._series = _series;
+        new_dataset._windows.insert(new_dataset._windows.end(), start_it,
+                                    stop_it);
+        return new_dataset;
+      }
+
     auto datasize = _batches.size();
     auto start_it = _batches.begin() + static_cast<int64_t>(datasize * start);
     auto stop_it
@@ -48,6 +48,20 @@ namespace dd
 
   typedef std::vector<torch::Tensor> BatchToStack;
 
+  /**
+   * \brief window over a time series held by a TorchDataset: data is rows
+   * [start, start + length) of the series data, target is rows
+   * [target_start, target_start + target_length) of the series target
+   */
+  struct TorchWindow
+  {
+    int64_t _series = 0;
+    int64_t _start = 0;
+    int64_t _length = 0;
+    int64_t _target_start = 0;
+    int64_t _target_length = 0; /**< no target if 0 */
+  };
+
   /**
    * \brief dede torch dataset wrapper
    * allows reading from db, controllable randomness ...
@@ -77,6 +91,8 @@ namespace dd
 
   public:
     bool _shuffle = true;            /**< shuffle dataset upon reset() */
+    int _shard_rank = 0;  /**< shard of the data read by this process */
+    int _shard_count = 1; /**< number of shards (distributed training) */
     std::shared_ptr<db::DB> _dbData; /**< db data */
     db::Cursor *_dbCursor = nullptr; /**< db cursor */
     std::vector<int64_t> _indices;   /**< id/key  of data points */
@@ -89,6 +105,10 @@ namespace dd
 
     std::vector<TorchBatch> _batches; /**< Vector containing the whole dataset
                                          (the "cached data") */
+    std::vector<std::pair<at::Tensor, at::Tensor>>
+        _series; /**< time series data and target, [timesteps, dim] each */
+    std::vector<TorchWindow> _windows; /**< windows over _series, served as
+                                          views */
     std::string _dbFullName;          /**< db filename */
     InputConnectorStrategy *_inputc
         = nullptr;               /**< back ptr to input connector. */
@@ -114,9 +134,12 @@ namespace dd
         : _seed(d._seed), _rng(d._rng), _current_index(d._current_index),
           _backend(d._backend), _db(d._db),
           _batches_per_transaction(d._batches_per_transaction), _txn(d._txn),
-          _logger(d._logger), _shuffle(d._shuffle), _dbData(d._dbData),
+          _logger(d._logger), _shuffle(d._shuffle),
+          _shard_rank(d._shard_rank), _shard_count(d._shard_count),
+          _dbData(d._dbData),
           _indices(d._indices), _lfiles(d._lfiles), _lfilesseg(d._lfilesseg),
           _lfilesbbox(d._lfilesbbox), _batches(d._batches),
+          _series(d._series), _windows(d._windows),
           _dbFullName(d._dbFullName), _inputc(d._inputc),
           _classification(d._classification), _image(d._image), _bbox(d._bbox),
           _segmentation(d._segmentation), _test(d._test),
@@ -136,6 +159,22 @@ namespace dd
     void add_batch(const std::vector<at::Tensor> &data,
                    const std::vector<at::Tensor> &target = {});
 
+    /**
+     * \brief adds a time series, stored once whatever the number of windows
+     * over it. Target may share storage with data, e.g. when forecasting.
+     * @return series index
+     */
+    int64_t add_series(const at::Tensor &data, const at::Tensor &target);
+
+    /**
+     * \brief adds a window over series s, see TorchWindow. Windows are
+     * shuffled and sliced from the series at batch time, so that overlapping
+     * windows do not duplicate data.
+     */
+    void add_window(const int64_t &s, const int64_t &start,
+                    const int64_t &length, const int64_t &target_start = 0,
+                    const int64_t &target_length = 0);
+
     /**
      * \brief add an encoded image to a batch, with an int target
      */
@@ -163,6 +202,16 @@ namespace dd
       _shuffle = shuf;
     }
 
+    /**
+     * \brief only read one out of count data points upon reset(), all ranks
+     * must use the same seed so that shards do not overlap
+     */
+    void set_shard(int rank, int count)
+    {
+      _shard_rank = rank;
+      _shard_count = count;
+    }
+
     /**
      * \brief setter for _seed & reinitialize random number generator
      */
@@ -185,7 +234,7 @@ namespace dd
      */
     size_t cache_size() const
     {
-      return _batches.size();
+      return _windows.empty() ? _batches.size() : _windows.size();
     }
 
     /**
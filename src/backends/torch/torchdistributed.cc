@@ -0,0 +1,506 @@
+/**
+ * DeepDetect
+ * Copyright (c) 2023 Jolibrain
+ *
+ * This file is part of deepdetect.
+ *
+ * deepdetect is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * deepdetect is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with deepdetect.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "torchdistributed.h"
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+#include <torch/csrc/autograd/utils/lambda_post_hook.h>
+#if defined(USE_C10D_GLOO)
+#include <torch/csrc/distributed/c10d/FileStore.hpp>
+#include <torch/csrc/distributed/c10d/TCPStore.hpp>
+#endif
+#pragma GCC diagnostic pop
+
+#include "mllibstrategy.h"
+
+namespace dd
+{
+  // ======= GRADIENT BUCKETS
+
+  TorchGradBuckets::TorchGradBuckets(const std::vector<torch::Tensor> &params,
+                                     int64_t bucket_bytes, ReduceFn reduce)
+      : _reduce(reduce)
+  {
+    for (const torch::Tensor &p : params)
+      if (p.requires_grad())
+        _params.push_back(p);
+    _param_bucket.resize(_params.size());
+
+    // last layers produce their gradients first
+    int64_t cur_bytes = 0;
+    for (size_t i = _params.size(); i-- > 0;)
+      {
+        const torch::Tensor &p = _params[i];
+        int64_t bytes = p.numel() * p.element_size();
+        bool new_bucket
+            = _buckets.empty() || cur_bytes + bytes > bucket_bytes
+              || _params[_buckets.back()._params.back()].scalar_type()
+                     != p.scalar_type()
+              || _params[_buckets.back()._params.back()].device()
+                     != p.device();
+        if (new_bucket)
+          {
+            _buckets.emplace_back();
+            cur_bytes = 0;
+          }
+        Bucket &bucket = _buckets.back();
+        int64_t offset = bucket._offsets.empty()
+                             ? 0
+                             : bucket._offsets.back()
+                                   + _params[bucket._params.back()].numel();
+        bucket._params.push_back(i);
+        bucket._offsets.push_back(offset);
+        _param_bucket[i] = _buckets.size() - 1;
+        cur_bytes += bytes;
+      }
+
+    for (Bucket &bucket : _buckets)
+      {
+        const torch::Tensor &last = _params[bucket._params.back()];
+        bucket._flat = torch::zeros({ bucket._offsets.back() + last.numel() },
+                                    last.options().requires_grad(false));
+        bucket._pending = bucket._params.size();
+      }
+
+    for (size_t i = 0; i < _params.size(); ++i)
+      {
+        auto grad_acc = torch::autograd::impl::grad_accumulator(_params[i]);
+        uintptr_t key = grad_acc->add_post_hook(
+            std::make_unique<torch::autograd::utils::LambdaPostHook>(
+                [this, i](const torch::autograd::variable_list &outputs,
+                          const torch::autograd::variable_list &) {
+                  mark_ready(i);
+                  return outputs;
+                }));
+        _hooks.emplace_back(key, grad_acc);
+      }
+  }
+
+  TorchGradBuckets::~TorchGradBuckets()
+  {
+    for (auto &hook : _hooks)
+      hook.second->del_post_hook(hook.first);
+  }
+
+  void TorchGradBuckets::prepare_for_backward(bool reduce)
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _reduce_next = reduce;
+  }
+
+  void TorchGradBuckets::mark_ready(size_t param_id)
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (!_reduce_next)
+      return;
+    Bucket &bucket = _buckets[_param_bucket[param_id]];
+    if (bucket._launched || bucket._pending == 0)
+      return;
+    if (--bucket._pending == 0)
+      launch(bucket);
+  }
+
+  void TorchGradBuckets::launch(Bucket &bucket)
+  {
+    torch::NoGradGuard no_grad;
+    for (size_t k = 0; k < bucket._params.size(); ++k)
+      {
+        const torch::Tensor &p = _params[bucket._params[k]];
+        torch::Tensor slice = bucket._flat.narrow(0, bucket._offsets[k],
+                                                  p.numel());
+        if (p.grad().defined())
+          slice.copy_(p.grad().reshape({ -1 }));
+        else
+          slice.zero_();
+      }
+    bucket._wait = _reduce(&bucket - &_buckets[0], bucket._flat);
+    bucket._launched = true;
+  }
+
+  void TorchGradBuckets::launch_pending()
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    for (Bucket &bucket : _buckets)
+      {
+        // unused parameters never trigger their hook
+        if (!bucket._launched)
+          launch(bucket);
+      }
+  }
+
+  double TorchGradBuckets::finalize()
+  {
+    using namespace std::chrono;
+    launch_pending();
+    std::lock_guard<std::mutex> lock(_mutex);
+    torch::NoGradGuard no_grad;
+
+    auto tstart = steady_clock::now();
+    for (Bucket &bucket : _buckets)
+      {
+        bucket._wait();
+        for (size_t k = 0; k < bucket._params.size(); ++k)
+          {
+            torch::Tensor &p = _params[bucket._params[k]];
+            torch::Tensor slice
+                = bucket._flat.narrow(0, bucket._offsets[k], p.numel())
+                      .view_as(p);
+            if (p.grad().defined())
+              p.mutable_grad().copy_(slice);
+            else
+              p.mutable_grad() = slice.clone();
+          }
+        bucket._launched = false;
+        bucket._pending = bucket._params.size();
+        bucket._wait = nullptr;
+      }
+    _reduce_next = false;
+    return duration<double, std::milli>(steady_clock::now() - tstart).count();
+  }
+
+  torch::Tensor TorchGradBuckets::flat_params(size_t b) const
+  {
+    torch::NoGradGuard no_grad;
+    const Bucket &bucket = _buckets[b];
+    std::vector<torch::Tensor> flat;
+    for (size_t p : bucket._params)
+      flat.push_back(_params[p].reshape({ -1 }));
+    return torch::cat(flat);
+  }
+
+  void TorchGradBuckets::set_params(size_t b, const torch::Tensor &flat)
+  {
+    torch::NoGradGuard no_grad;
+    const Bucket &bucket = _buckets[b];
+    torch::Tensor src = flat.to(bucket._flat.device());
+    for (size_t k = 0; k < bucket._params.size(); ++k)
+      {
+        torch::Tensor p = _params[bucket._params[k]].detach();
+        p.copy_(src.narrow(0, bucket._offsets[k], p.numel()).view_as(p));
+      }
+  }
+
+  void TorchGradBuckets::zero_grad()
+  {
+    torch::NoGradGuard no_grad;
+    for (torch::Tensor &p : _params)
+      if (p.grad().defined())
+        p.mutable_grad().zero_();
+  }
+
+  // ======= MULTI DEVICE REDUCTION
+
+  TorchMultiDeviceReducer::TorchMultiDeviceReducer(
+      const std::vector<std::vector<torch::Tensor>> &params, size_t main_id,
+      int64_t bucket_bytes)
+      : _main_id(main_id)
+  {
+    for (size_t d = 0; d < params.size(); ++d)
+      _buckets.push_back(std::make_shared<TorchGradBuckets>(
+          params[d], bucket_bytes,
+          [this](size_t b, torch::Tensor &) { return bucket_ready(b); }));
+    for (size_t d = 1; d < _buckets.size(); ++d)
+      if (_buckets[d]->size() != _buckets[0]->size())
+        throw MLLibInternalException(
+            "replicas gradients do not have the same layout");
+    _sync.resize(_buckets[_main_id]->size());
+  }
+
+  void TorchMultiDeviceReducer::prepare_for_backward(bool reduce)
+  {
+    if (reduce)
+      {
+        std::lock_guard<std::mutex> lock(_mutex);
+        for (BucketSync &sync : _sync)
+          {
+            sync._ready = 0;
+            sync._done = std::make_shared<std::promise<void>>();
+            sync._done_fut = sync._done->get_future().share();
+          }
+      }
+    for (auto &buckets : _buckets)
+      buckets->prepare_for_backward(reduce);
+  }
+
+  std::function<void()> TorchMultiDeviceReducer::bucket_ready(size_t b)
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    BucketSync &sync = _sync[b];
+    std::shared_future<void> done = sync._done_fut;
+    if (++sync._ready == _buckets.size())
+      _tasks.push_back(std::async(std::launch::async,
+                                  [this, b]() { reduce_bucket(b); }));
+    return [done]() { done.get(); };
+  }
+
+  void TorchMultiDeviceReducer::reduce_bucket(size_t b)
+  {
+    using namespace std::chrono;
+    auto tstart = steady_clock::now();
+    std::shared_ptr<std::promise<void>> done;
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      done = _sync[b]._done;
+    }
+    try
+      {
+        torch::NoGradGuard no_grad;
+        torch::Tensor &main_flat = _buckets[_main_id]->flat_grads(b);
+        for (size_t d = 0; d < _buckets.size(); ++d)
+          if (d != _main_id)
+            main_flat.add_(
+                _buckets[d]->flat_grads(b).to(main_flat.device()));
+        done->set_value();
+      }
+    catch (...)
+      {
+        done->set_exception(std::current_exception());
+      }
+    std::lock_guard<std::mutex> lock(_mutex);
+    _comm_time
+        += duration<double, std::milli>(steady_clock::now() - tstart).count();
+  }
+
+  double TorchMultiDeviceReducer::finalize()
+  {
+    using namespace std::chrono;
+    auto tstart = steady_clock::now();
+    // all replicas must complete their buckets before anyone waits
+    for (auto &buckets : _buckets)
+      buckets->launch_pending();
+    for (auto &buckets : _buckets)
+      buckets->finalize();
+    std::vector<std::future<void>> tasks;
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      tasks.swap(_tasks);
+    }
+    for (auto &t : tasks)
+      t.get();
+    return duration<double, std::milli>(steady_clock::now() - tstart).count();
+  }
+
+  double TorchMultiDeviceReducer::broadcast_parameters()
+  {
+    using namespace std::chrono;
+    auto tstart = steady_clock::now();
+    std::vector<torch::Tensor> weights;
+    for (size_t b = 0; b < _buckets[_main_id]->size(); ++b)
+      weights.push_back(_buckets[_main_id]->flat_params(b));
+
+    std::vector<std::future<void>> tasks;
+    for (size_t d = 0; d < _buckets.size(); ++d)
+      {
+        if (d == _main_id)
+          continue;
+        tasks.push_back(std::async(std::launch::async, [this, d, &weights]() {
+          for (size_t b = 0; b < weights.size(); ++b)
+            _buckets[d]->set_params(b, weights[b]);
+          _buckets[d]->zero_grad();
+        }));
+      }
+    for (auto &t : tasks)
+      t.get();
+    return duration<double, std::milli>(steady_clock::now() - tstart).count();
+  }
+
+  double TorchMultiDeviceReducer::pop_comm_time()
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    double comm_time = _comm_time;
+    _comm_time = 0;
+    return comm_time;
+  }
+
+  // ======= DISTRIBUTED PROCESS GROUP
+
+#if defined(USE_C10D_GLOO)
+  TorchDistributed::TorchDistributed(const APIData &ad_dist,
+                                     std::shared_ptr<spdlog::logger> logger)
+      : _logger(logger)
+  {
+    if (!ad_dist.has("world_size") || !ad_dist.has("rank")
+        || !ad_dist.has("init_method"))
+      throw MLLibBadParamException("distributed training requires "
+                                   "world_size, rank and init_method");
+    _world_size = ad_dist.get("world_size").get<int>();
+    _rank = ad_dist.get("rank").get<int>();
+    if (_world_size < 1 || _rank < 0 || _rank >= _world_size)
+      throw MLLibBadParamException(
+          "invalid distributed rank " + std::to_string(_rank)
+          + " for world_size " + std::to_string(_world_size));
+    if (ad_dist.has("bucket_size_mb"))
+      _bucket_bytes = static_cast<int64_t>(
+          ad_dist.get("bucket_size_mb").get<double>() * 1024 * 1024);
+
+    std::chrono::milliseconds timeout(DEFAULT_DISTRIBUTED_TIMEOUT * 1000);
+    if (ad_dist.has("timeout"))
+      timeout = std::chrono::milliseconds(
+          ad_dist.get("timeout").get<int>() * 1000);
+    if (ad_dist.has("test_timeout"))
+      _test_timeout = std::chrono::milliseconds(
+          ad_dist.get("test_timeout").get<int>() * 1000);
+
+    std::string init_method = ad_dist.get("init_method").get<std::string>();
+    c10::intrusive_ptr<c10d::Store> store;
+    if (init_method.find("file://") == 0)
+      {
+        store = c10::make_intrusive<c10d::FileStore>(init_method.substr(7),
+                                                     _world_size);
+      }
+    else if (init_method.find("tcp://") == 0)
+      {
+        std::string addr = init_method.substr(6);
+        size_t colon = addr.rfind(':');
+        if (colon == std::string::npos)
+          throw MLLibBadParamException(
+              "distributed init_method requires tcp://host:port");
+        c10d::TCPStoreOptions opts;
+        opts.port = std::stoi(addr.substr(colon + 1));
+        opts.isServer = _rank == 0;
+        opts.numWorkers = _world_size;
+        opts.timeout = timeout;
+        store = c10::make_intrusive<c10d::TCPStore>(addr.substr(0, colon),
+                                                    opts);
+      }
+    else
+      throw MLLibBadParamException("unknown distributed init_method "
+                                   + init_method);
+    store->setTimeout(timeout);
+
+    auto options = c10d::ProcessGroupGloo::Options::create(timeout);
+    if (ad_dist.has("iface"))
+      options->devices.push_back(
+          c10d::ProcessGroupGloo::createDeviceForInterface(
+              ad_dist.get("iface").get<std::string>()));
+    else
+      options->devices.push_back(
+          c10d::ProcessGroupGloo::createDefaultDevice());
+
+    _logger->info("joining distributed group {} as rank {}/{}", init_method,
+                  _rank, _world_size);
+    try
+      {
+        _pg = c10::make_intrusive<c10d::ProcessGroupGloo>(store, _rank,
+                                                          _world_size, options);
+      }
+    catch (std::exception &e)
+      {
+        throw MLLibInternalException(
+            std::string("could not join distributed group: ") + e.what());
+      }
+  }
+
+  void TorchDistributed::broadcast_parameters(
+      const std::vector<torch::Tensor> &params)
+  {
+    if (params.empty())
+      return;
+    torch::NoGradGuard no_grad;
+    std::vector<torch::Tensor> flat_params;
+    for (const torch::Tensor &p : params)
+      flat_params.push_back(p.reshape({ -1 }));
+    std::vector<torch::Tensor> flat{ torch::cat(flat_params) };
+    _pg->broadcast(flat)->wait();
+
+    int64_t offset = 0;
+    for (const torch::Tensor &p : params)
+      {
+        torch::Tensor pd = p.detach();
+        pd.copy_(flat[0].narrow(0, offset, p.numel()).view_as(p));
+        offset += p.numel();
+      }
+  }
+
+  double TorchDistributed::average(double val)
+  {
+    std::vector<torch::Tensor> t{ torch::full({ 1 }, val,
+                                              torch::kFloat64) };
+    _pg->allreduce(t)->wait();
+    return t[0].item<double>() / _world_size;
+  }
+
+  TorchDistributed::Status
+  TorchDistributed::sync_status(Status status, bool test_wait)
+  {
+    std::vector<torch::Tensor> t{ torch::full({ 1 }, static_cast<int>(status),
+                                              torch::kInt32) };
+    c10d::AllreduceOptions opts;
+    opts.reduceOp = c10d::ReduceOp::MAX;
+    if (test_wait)
+      opts.timeout = _test_timeout;
+    _pg->allreduce(t, opts)->wait();
+    return static_cast<Status>(t[0].item<int>());
+  }
+
+  std::shared_ptr<TorchGradBuckets>
+  TorchDistributed::make_buckets(const std::vector<torch::Tensor> &params)
+  {
+    auto pg = _pg;
+    int world_size = _world_size;
+    auto buckets = std::make_shared<TorchGradBuckets>(
+        params, _bucket_bytes,
+        [pg, world_size](size_t, torch::Tensor &flat) {
+          flat.div_(world_size);
+          std::vector<torch::Tensor> tensors{ flat };
+          auto work = pg->allreduce(tensors);
+          return std::function<void()>([work]() { work->wait(); });
+        });
+    _logger->info("distributed gradients split into {} buckets",
+                  buckets->size());
+    return buckets;
+  }
+#else
+  TorchDistributed::TorchDistributed(const APIData &ad_dist,
+                                     std::shared_ptr<spdlog::logger> logger)
+      : _logger(logger)
+  {
+    (void)ad_dist;
+    throw MLLibBadParamException(
+        "distributed training requires libtorch built with gloo support");
+  }
+
+  void TorchDistributed::broadcast_parameters(
+      const std::vector<torch::Tensor> &params)
+  {
+    (void)params;
+  }
+
+  double TorchDistributed::average(double val)
+  {
+    return val;
+  }
+
+  TorchDistributed::Status
+  TorchDistributed::sync_status(Status status, bool test_wait)
+  {
+    (void)test_wait;
+    return status;
+  }
+
+  std::shared_ptr<TorchGradBuckets>
+  TorchDistributed::make_buckets(const std::vector<torch::Tensor> &params)
+  {
+    (void)params;
+    return nullptr;
+  }
+#endif
+}
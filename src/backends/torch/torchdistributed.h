@@ -0,0 +1,296 @@
+/**
+ * DeepDetect
+ * Copyright (c) 2023 Jolibrain
+ *
+ * This file is part of deepdetect.
+ *
+ * deepdetect is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * deepdetect is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with deepdetect.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TORCH_DISTRIBUTED_H
+#define TORCH_DISTRIBUTED_H
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+#include <torch/torch.h>
+#if defined(USE_C10D_GLOO)
+#include <torch/csrc/distributed/c10d/ProcessGroupGloo.hpp>
+#endif
+#pragma GCC diagnostic pop
+
+#include <functional>
+#include <future>
+#include <mutex>
+
+#include "apidata.h"
+#include "dd_spdlog.h"
+
+#define DEFAULT_BUCKET_SIZE_MB 25
+#define DEFAULT_DISTRIBUTED_TIMEOUT 1800
+#define DEFAULT_DISTRIBUTED_TEST_TIMEOUT 86400
+
+namespace dd
+{
+
+  /**
+   * \brief groups gradients of a set of parameters into flat contiguous
+   * buckets, and starts an asynchronous reduction of every bucket as soon as
+   * all its gradients have been accumulated by autograd, so that
+   * communication overlaps with the rest of the backward pass.
+   */
+  class TorchGradBuckets
+  {
+  public:
+    /**
+     * \brief launches the reduction of a flat bucket given its index,
+     * returns a function blocking until the reduction is complete
+     */
+    typedef std::function<std::function<void()>(size_t, torch::Tensor &)>
+        ReduceFn;
+
+    /**
+     * \brief assign params to buckets of at most bucket_bytes, in reverse
+     * order since gradients become available from the last layers first
+     */
+    TorchGradBuckets(const std::vector<torch::Tensor> &params,
+                     int64_t bucket_bytes, ReduceFn reduce);
+
+    /**
+     * \brief removes autograd hooks
+     */
+    ~TorchGradBuckets();
+
+    /**
+     * \brief to be called before every backward pass
+     * \param reduce if false, gradients are only accumulated locally (e.g.
+     * when iter_size > 1 and this is not the last pass of the iteration)
+     */
+    void prepare_for_backward(bool reduce);
+
+    /**
+     * \brief launches reduction of buckets that were not launched during
+     * backward, e.g. due to unused parameters
+     */
+    void launch_pending();
+
+    /**
+     * \brief waits for all reductions and writes reduced values back to the
+     * parameters gradients, after launching pending buckets.
+     * \return time spent waiting for communications, in milliseconds
+     */
+    double finalize();
+
+    /**
+     * \brief flat gradient buffer of bucket b
+     */
+    torch::Tensor &flat_grads(size_t b)
+    {
+      return _buckets[b]._flat;
+    }
+
+    /**
+     * \brief copy of the values of bucket b params into a flat tensor
+     */
+    torch::Tensor flat_params(size_t b) const;
+
+    /**
+     * \brief sets values of bucket b params from a flat tensor
+     */
+    void set_params(size_t b, const torch::Tensor &flat);
+
+    /**
+     * \brief zero gradients of all params
+     */
+    void zero_grad();
+
+    /**
+     * \brief number of buckets
+     */
+    size_t size() const
+    {
+      return _buckets.size();
+    }
+
+  protected:
+    struct Bucket
+    {
+      std::vector<size_t> _params;   /**< indices of bucket params */
+      std::vector<int64_t> _offsets; /**< offsets of params in flat */
+      torch::Tensor _flat;           /**< flat gradient buffer */
+      size_t _pending = 0; /**< params with gradient not ready yet */
+      bool _launched = false;
+      std::function<void()> _wait; /**< wait for running reduction */
+    };
+
+    /**
+     * \brief called by autograd once the gradient of a param is accumulated
+     */
+    void mark_ready(size_t param_id);
+
+    /**
+     * \brief copy gradients into flat buffer and start reduction
+     */
+    void launch(Bucket &bucket);
+
+    std::vector<torch::Tensor> _params; /**< params requiring grad */
+    std::vector<size_t> _param_bucket;  /**< bucket of each param */
+    std::vector<Bucket> _buckets;
+    std::vector<std::pair<uintptr_t, std::shared_ptr<torch::autograd::Node>>>
+        _hooks; /**< hooks keys and grad accumulators */
+    ReduceFn _reduce;
+    bool _reduce_next = false; /**< whether current backward reduces */
+    std::mutex _mutex;
+  };
+
+  /**
+   * \brief sums gradients of replicas of a module living on several devices
+   * of the same process onto the main device, one bucket at a time, as soon
+   * as the bucket is complete on all devices
+   */
+  class TorchMultiDeviceReducer
+  {
+  public:
+    /**
+     * \param params parameters of every replica, in the same order
+     * \param main_id index of the replica holding the reduced gradients
+     */
+    TorchMultiDeviceReducer(
+        const std::vector<std::vector<torch::Tensor>> &params, size_t main_id,
+        int64_t bucket_bytes);
+
+    /**
+     * \brief to be called before every backward pass of the replicas
+     */
+    void prepare_for_backward(bool reduce);
+
+    /**
+     * \brief waits for all reductions, gradients of main replica are then
+     * summed over all replicas
+     * \return time spent waiting for communications, in milliseconds
+     */
+    double finalize();
+
+    /**
+     * \brief copy main replica weights to other replicas, bucket by bucket
+     * and zero their gradients
+     * \return duration in milliseconds
+     */
+    double broadcast_parameters();
+
+    /**
+     * \brief cumulated duration of gradient reductions since last call,
+     * in milliseconds, mostly overlapped with backward
+     */
+    double pop_comm_time();
+
+  private:
+    struct BucketSync
+    {
+      size_t _ready = 0; /**< number of replicas with complete bucket */
+      std::shared_ptr<std::promise<void>> _done;
+      std::shared_future<void> _done_fut;
+    };
+
+    /**
+     * \brief one more replica has bucket b ready
+     */
+    std::function<void()> bucket_ready(size_t b);
+
+    /**
+     * \brief sums bucket b of all replicas onto main replica
+     */
+    void reduce_bucket(size_t b);
+
+    size_t _main_id = 0;
+    std::vector<std::shared_ptr<TorchGradBuckets>> _buckets; /**< replicas */
+    std::vector<BucketSync> _sync;
+    std::vector<std::future<void>> _tasks; /**< running reductions */
+    double _comm_time = 0;
+    std::mutex _mutex;
+  };
+
+  /**
+   * \brief process group for data parallel training over multiple processes
+   * (on one or several hosts), using c10d with the gloo backend
+   */
+  class TorchDistributed
+  {
+  public:
+    /**
+     * \brief state of a rank in the training loop, ordered by priority
+     */
+    enum Status
+    {
+      RUNNING = 0,
+      STOPPED = 1,
+      FAILED = 2
+    };
+
+    /**
+     * \brief joins the process group described by api data:
+     * world_size, rank, init_method (file:// or tcp://), timeout and
+     * test_timeout (seconds), iface (network interface) and bucket_size_mb.
+     */
+    TorchDistributed(const APIData &ad_dist,
+                     std::shared_ptr<spdlog::logger> logger);
+
+    /**
+     * \brief true if this process is rank 0, in charge of testing and
+     * snapshotting
+     */
+    bool is_master() const
+    {
+      return _rank == 0;
+    }
+
+    /**
+     * \brief copy rank 0 parameters values to all ranks
+     */
+    void broadcast_parameters(const std::vector<torch::Tensor> &params);
+
+    /**
+     * \brief mean of a scalar value over all ranks
+     */
+    double average(double val);
+
+    /**
+     * \brief highest status over all ranks, blocks until all ranks reach
+     * this point
+     * \param test_wait whether ranks wait for rank 0 to test and snapshot,
+     * with test_timeout instead of timeout
+     */
+    Status sync_status(Status status, bool test_wait = false);
+
+    /**
+     * \brief creates gradient buckets averaged with all-reduce
+     */
+    std::shared_ptr<TorchGradBuckets>
+    make_buckets(const std::vector<torch::Tensor> &params);
+
+  public:
+    int _rank = 0;
+    int _world_size = 1;
+    int64_t _bucket_bytes = DEFAULT_BUCKET_SIZE_MB * 1024 * 1024;
+    std::chrono::milliseconds _test_timeout{
+      DEFAULT_DISTRIBUTED_TEST_TIMEOUT * 1000
+    }; /**< wait for rank 0 test and snapshot. */
+
+  private:
+    std::shared_ptr<spdlog::logger> _logger; /**< mllib logger */
+#if defined(USE_C10D_GLOO)
+    c10::intrusive_ptr<c10d::ProcessGroupGloo> _pg; /**< gloo group */
+#endif
+  };
+}
+#endif
@@ -29,6 +29,7 @@
 #include <torch/torch.h>
 #pragma GCC diagnostic pop
 #include <torch/ordered_dict.h>
+#include "torchstatecache.h"
 
 namespace dd
 {
@@ -170,6 +171,28 @@ namespace dd
       _lstm_continuation = lc;
     }
 
+    /**
+     * lstm states after last forward with continuation
+     */
+    const TorchRNNStates &rnn_memories() const
+    {
+      return _rnn_memories;
+    }
+
+    /**
+     * set lstm states used by upcoming forward() with continuation, lstm
+     * layers with no state start from zero states
+     * @param memories states per lstm layer, batch size must match input
+     */
+    void set_rnn_memories(const TorchRNNStates &memories)
+    {
+      _rnn_memories = memories;
+      for (auto &hm : _rnn_has_memories)
+        hm.second = false;
+      for (auto &m : _rnn_memories)
+        _rnn_has_memories[m.first] = true;
+    }
+
     /**
      * informs torchgraphbackend that parameters are no more used,
      * ie reallocation can be done w/o warning
@@ -230,8 +253,7 @@ namespace dd
         = false; /**< if parameters are use => warn if realloc */
     bool _lstm_continuation
         = false; /**< if lstm should use previous hidden state value */
-    std::unordered_map<std::string, std::tuple<torch::Tensor, torch::Tensor>>
-        _rnn_memories; /**< values of previsous hidden states */
+    TorchRNNStates _rnn_memories; /**< values of previsous hidden states */
     std::unordered_map<std::string, bool>
         _rnn_has_memories; /**< true if previsous hidden values are available
                             */
@@ -711,11 +711,12 @@ namespace dd
 
   // ===== TxtTorchInputFileConn
 
-  void TxtTorchInputFileConn::parse_content(const std::string &content,
-                                            const float &target, int test_id)
+  void TxtTorchInputFileConn::parse_contents(
+      const std::vector<std::string> &contents,
+      const std::vector<float> &targets, int test_id)
   {
     _ndbed = 0;
-    TxtInputFileConn::parse_content(content, target, test_id);
+    TxtInputFileConn::parse_contents(contents, targets, test_id);
     if (_db)
       push_to_db(test_id);
   }
@@ -759,22 +760,24 @@ namespace dd
 
     _generate_vocab = false;
 
-    if (!_characters && (!_train || _ordered_words) && _vocab.empty())
+    if (!_characters && (!_train || _ordered_words) && _vocab->empty())
       deserialize_vocab();
 
     // XXX: move in txtinputconn?
-    make_inv_vocab();
+    // shared with the service connector once built
+    if (_inv_vocab->size() != _vocab->size())
+      make_inv_vocab();
 
     if (_input_format == "bert")
       {
-        _cls_pos = _vocab.at("[CLS]")._pos;
-        _sep_pos = _vocab.at("[SEP]")._pos;
-        _unk_pos = _vocab.at("[UNK]")._pos;
-        _mask_id = _vocab.at("[MASK]")._pos;
+        _cls_pos = _vocab->at("[CLS]")._pos;
+        _sep_pos = _vocab->at("[SEP]")._pos;
+        _unk_pos = _vocab->at("[UNK]")._pos;
+        _mask_id = _vocab->at("[MASK]")._pos;
       }
     else if (_input_format == "gpt2")
       {
-        _eot_pos = _vocab.at("<|endoftext|>")._pos;
+        _eot_pos = _vocab->at("<|endoftext|>")._pos;
       }
 
     if (ad.has("parameters") && ad.getobj("parameters").has("input"))
@@ -899,33 +902,49 @@ namespace dd
         std::string word;
         double val;
         std::vector<int64_t> ids;
+        int64_t last_token = 0;
 
-        while (tow->has_elt())
+        if (!tow->_ids.empty())
           {
-            if (ids.size() >= _width)
-              break;
-
-            tow->get_next_elt(word, val);
-            std::unordered_map<std::string, Word>::iterator it;
-
-            if ((it = _vocab.find(word)) != _vocab.end())
+            // vocabulary positions already given by the wordpiece tokenizer
+            auto iit = tow->_ids.begin();
+            for (; iit != tow->_ids.end() && ids.size() < _width; ++iit)
               {
-                ids.push_back(it->second._pos);
-              }
-            else if (_input_format == "bert")
-              {
-                ids.push_back(_unk_pos);
+                if (*iit >= 0)
+                  ids.push_back(*iit);
+                else if (_input_format == "bert")
+                  ids.push_back(_unk_pos);
               }
+            // Extract last token (needed by gpt2)
+            if (iit != tow->_ids.end() && *iit >= 0)
+              last_token = *iit;
           }
+        else
+          while (tow->has_elt())
+            {
+              if (ids.size() >= _width)
+                break;
+
+              tow->get_next_elt(word, val);
+              std::unordered_map<std::string, Word>::const_iterator it;
+
+              if ((it = _vocab->find(word)) != _vocab->end())
+                {
+                  ids.push_back(it->second._pos);
+                }
+              else if (_input_format == "bert")
+                {
+                  ids.push_back(_unk_pos);
+                }
+            }
 
         // Extract last token (needed by gpt2)
-        int64_t last_token = 0;
-        if (tow->has_elt())
+        if (tow->_ids.empty() && tow->has_elt())
           {
             tow->get_next_elt(word, val);
-            std::unordered_map<std::string, Word>::iterator it;
+            std::unordered_map<std::string, Word>::const_iterator it;
 
-            if ((it = _vocab.find(word)) != _vocab.end())
+            if ((it = _vocab->find(word)) != _vocab->end())
               last_token = it->second._pos;
           }
 
@@ -1193,50 +1212,58 @@ namespace dd
       }
   }
 
+  at::Tensor CSVTSTorchInputFileConn::series_to_tensor(
+      const std::vector<CSVline> &seq, const std::vector<int> &cols)
+  {
+    const int64_t ncols = cols.empty() ? static_cast<int64_t>(_datadim)
+                                       : static_cast<int64_t>(cols.size());
+    at::Tensor t = torch::empty(
+        { static_cast<int64_t>(seq.size()), ncols }, torch::kFloat32);
+    float *p = t.data_ptr<float>();
+    for (const CSVline &line : seq)
+      {
+        if (cols.empty())
+          for (int di = 0; di < _datadim; ++di)
+            *p++ = line._v[di];
+        else
+          for (int c : cols)
+            *p++ = line._v[c];
+      }
+    return t;
+  }
+
+  int64_t
+  CSVTSTorchInputFileConn::add_series(TorchDataset &dataset,
+                                      const std::vector<CSVline> &seq)
+  {
+    if (_forecast_timesteps != -1)
+      {
+        // backcast and forecast are windows over the same lines
+        at::Tensor t = series_to_tensor(seq, {});
+        return dataset.add_series(t, t);
+      }
+    std::vector<int> data_cols;
+    for (int di = 0; di < _datadim; ++di)
+      if (std::find(_label_pos.begin(), _label_pos.end(), di)
+          == _label_pos.end())
+        data_cols.push_back(di);
+    return dataset.add_series(series_to_tensor(seq, data_cols),
+                              series_to_tensor(seq, _label_pos));
+  }
+
   void CSVTSTorchInputFileConn::add_data_instance_forecast(
       const unsigned long int tstart, const int vecindex,
-      TorchDataset &dataset, const std::vector<CSVline> &seq)
+      TorchDataset &dataset, const int64_t series, const size_t seq_size)
   {
-    std::vector<at::Tensor> data_sequence;
     if (_fnames.size() > static_cast<unsigned int>(vecindex))
       _ids.push_back(_fnames[vecindex] + " #" + std::to_string(tstart) + "_"
                      + std::to_string(tstart + _forecast_timesteps
                                       + _backcast_timesteps - 1));
-    for (size_t ti = tstart; ti < tstart + _backcast_timesteps; ++ti)
-      {
-        std::vector<double> datavec;
-        for (int di = 0; di < this->_datadim; ++di)
-          datavec.push_back(seq[ti]._v[di]);
-        at::Tensor data
-            = torch::from_blob(&datavec[0], at::IntList{ _datadim },
-                               torch::kFloat64)
-                  .clone()
-                  .to(torch::kFloat32);
-        data_sequence.push_back(data);
-      }
-    at::Tensor dst = torch::stack(data_sequence);
-
-    if (seq.size() >= _backcast_timesteps + _forecast_timesteps + tstart)
-      {
-        std::vector<at::Tensor> pred_sequence;
-        for (size_t ti = tstart + _backcast_timesteps;
-             ti < tstart + _backcast_timesteps + _forecast_timesteps; ++ti)
-          {
-            std::vector<double> predvec;
-            for (int di = 0; di < this->_datadim; ++di)
-              predvec.push_back(seq[ti]._v[di]);
-            at::Tensor pred
-                = torch::from_blob(&predvec[0], at::IntList{ _datadim },
-                                   torch::kFloat64)
-                      .clone()
-                      .to(torch::kFloat32);
-            pred_sequence.push_back(pred);
-          }
-        at::Tensor pst = torch::stack(pred_sequence);
-        dataset.add_batch({ dst }, { pst });
-      }
+    if (seq_size >= _backcast_timesteps + _forecast_timesteps + tstart)
+      dataset.add_window(series, tstart, _backcast_timesteps,
+                         tstart + _backcast_timesteps, _forecast_timesteps);
     else // we are in inference mode, not forecast available
-      dataset.add_batch({ dst }, {});
+      dataset.add_window(series, tstart, _backcast_timesteps);
   }
 
   void CSVTSTorchInputFileConn::discard_warn(int vecindex,
@@ -1294,79 +1321,27 @@ namespace dd
           {
             _tilogger->info("Add sequence of size {}", seq.size());
           }
+        int64_t series = add_series(dataset, seq);
         for (; tstart + timesteps < static_cast<long int>(seq.size());
              tstart += _offset)
           {
-            add_data_instance_forecast(tstart, vecindex, dataset, seq);
+            add_data_instance_forecast(tstart, vecindex, dataset, series,
+                                       seq.size());
           }
         if (tstart < static_cast<long int>(seq.size()) - 1)
           add_data_instance_forecast(seq.size() - timesteps, vecindex, dataset,
-                                     seq);
+                                     series, seq.size());
       }
   }
 
-  void
-  CSVTSTorchInputFileConn::add_seq(const size_t ti,
-                                   const std::vector<CSVline> &seq,
-                                   std::vector<at::Tensor> &data_sequence,
-                                   std::vector<at::Tensor> &label_sequence)
-  {
-    std::vector<double> datavec;
-    std::vector<double> labelvec;
-    size_t label_size = _label_pos.size();
-    size_t data_size = _datadim - label_size;
-
-    for (size_t li = 0; li < label_size; ++li)
-      labelvec.push_back(seq[ti]._v[_label_pos[li]]);
-    for (int di = 0; di < this->_datadim; ++di)
-      if (std::find(_label_pos.begin(), _label_pos.end(), di)
-          == _label_pos.end())
-        datavec.push_back(seq[ti]._v[di]);
-
-    at::Tensor data
-        = torch::from_blob(&datavec[0],
-                           at::IntList{ static_cast<long int>(data_size) },
-                           torch::kFloat64)
-              .clone()
-              .to(torch::kFloat32);
-    at::Tensor label
-        = torch::from_blob(&labelvec[0],
-                           at::IntList{ static_cast<long int>(label_size) },
-                           torch::kFloat64)
-              .clone()
-              .to(torch::kFloat32);
-    data_sequence.push_back(data);
-    label_sequence.push_back(label);
-  }
-
   void CSVTSTorchInputFileConn::add_data_instance_labels(
       const unsigned long int tstart, const int vecindex,
-      TorchDataset &dataset, const std::vector<CSVline> &seq,
-      const size_t seq_len)
+      TorchDataset &dataset, const int64_t series, const size_t seq_len)
   {
-    unsigned int label_size = _label_pos.size();
-    if (static_cast<int>(label_size) >= _datadim)
-      {
-        std::string errmsg
-            = "label_size (output dim) " + std::to_string(label_size)
-              + " is larger than datadim " + std::to_string(_datadim)
-              + " leading to invalid input dim";
-        this->_logger->error(errmsg);
-        throw InputConnectorBadParamException(errmsg);
-      }
-    std::vector<at::Tensor> data_sequence;
-    std::vector<at::Tensor> label_sequence;
     if (_fnames.size() > static_cast<unsigned int>(vecindex))
       _ids.push_back(_fnames[vecindex] + " #" + std::to_string(tstart) + "_"
                      + std::to_string(tstart + seq_len - 1));
-
-    for (size_t ti = tstart;
-         ti < static_cast<unsigned long int>(tstart + seq_len); ++ti)
-      add_seq(ti, seq, data_sequence, label_sequence);
-
-    at::Tensor dst = torch::stack(data_sequence);
-    at::Tensor lst = torch::stack(label_sequence);
-    dataset.add_batch({ dst }, { lst });
+    dataset.add_window(series, tstart, seq_len, tstart, seq_len);
   }
 
   void CSVTSTorchInputFileConn::fill_dataset_labels(
@@ -1375,6 +1350,17 @@ namespace dd
   {
     int vecindex = -1;
 
+    unsigned int label_size = _label_pos.size();
+    if (!data.empty() && static_cast<int>(label_size) >= _datadim)
+      {
+        std::string errmsg
+            = "label_size (output dim) " + std::to_string(label_size)
+              + " is larger than datadim " + std::to_string(_datadim)
+              + " leading to invalid input dim";
+        this->_logger->error(errmsg);
+        throw InputConnectorBadParamException(errmsg);
+      }
+
     if (_train)
       {
         for (const std::vector<CSVline> &seq : data)
@@ -1386,13 +1372,14 @@ namespace dd
                 discard_warn(vecindex, seq.size(), test_id);
                 continue;
               }
+            int64_t series = add_series(dataset, seq);
             for (; tstart + _timesteps < static_cast<long int>(seq.size());
                  tstart += _offset)
-              add_data_instance_labels(tstart, vecindex, dataset, seq,
+              add_data_instance_labels(tstart, vecindex, dataset, series,
                                        static_cast<unsigned int>(_timesteps));
             if (tstart < static_cast<long int>(seq.size()) - 1)
               add_data_instance_labels(seq.size() - _timesteps, vecindex,
-                                       dataset, seq,
+                                       dataset, series,
                                        static_cast<unsigned int>(_timesteps));
           }
       }
@@ -1400,7 +1387,8 @@ namespace dd
       for (const std::vector<CSVline> &seq : data)
         {
           vecindex++;
-          add_data_instance_labels(0, vecindex, dataset, seq, seq.size());
+          add_data_instance_labels(0, vecindex, dataset,
+                                   add_series(dataset, seq), seq.size());
         }
   }
 
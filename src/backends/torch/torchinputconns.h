@@ -404,7 +404,7 @@ namespace dd
      */
     TxtTorchInputFileConn(const TxtTorchInputFileConn &i)
         : TxtInputFileConn(i), TorchInputInterface(i), _width(i._width),
-          _height(i._height)
+          _height(i._height), _inv_vocab(i._inv_vocab)
     {
       _dataset._inputc = this;
       _test_datasets._inputc = this;
@@ -423,6 +423,8 @@ namespace dd
       TxtInputFileConn::init(ad);
       TorchInputInterface::init(ad, _model_repo, _logger);
       fillup_parameters(ad);
+      if (!_vocab->empty())
+        make_inv_vocab();
     }
 
     /**
@@ -459,7 +461,7 @@ namespace dd
      */
     int64_t vocab_size() const
     {
-      return _vocab.size();
+      return _vocab->size();
     }
 
     /**
@@ -467,7 +469,7 @@ namespace dd
      */
     std::string get_word(int64_t id) const
     {
-      return _inv_vocab.at(id);
+      return _inv_vocab->at(id);
     }
 
     /**
@@ -497,11 +499,12 @@ namespace dd
                       const std::vector<TxtEntry<double> *> &entries);
 
     /**
-     * \brief override txtinputconn parse content in order to put data in db on
-     * the fly if needed
+     * \brief override txtinputconn parse contents in order to put data in db
+     * on the fly if needed
      */
-    void parse_content(const std::string &content, const float &target = -1,
-                       int test_id = -1) override;
+    void parse_contents(const std::vector<std::string> &contents,
+                        const std::vector<float> &targets,
+                        int test_id = -1) override;
 
   private:
     /**
@@ -515,7 +518,8 @@ namespace dd
     unsigned int _width = 512; /**< width of the input tensor */
     unsigned int _height = 0;  /**< default height */
     std::mt19937 _rng;         /**< random number generator for MLM */
-    std::map<int, std::string> _inv_vocab; /**< token id to vocabulary word */
+    SharedState<std::map<int, std::string>>
+        _inv_vocab; /**< token id to vocabulary word */
 
     int64_t _mask_id = -1; /**< ID of mask token in the vocabulary. */
     int64_t _cls_pos = -1; /**< cls token */
@@ -528,12 +532,13 @@ namespace dd
      */
     void make_inv_vocab()
     {
-      _inv_vocab.clear();
+      std::map<int, std::string> inv_vocab;
 
-      for (auto &entry : _vocab)
+      for (auto &entry : *_vocab)
         {
-          _inv_vocab[entry.second._pos] = entry.first;
+          inv_vocab[entry.second._pos] = entry.first;
         }
+      _inv_vocab = std::move(inv_vocab);
     }
   };
 
@@ -732,18 +737,29 @@ namespace dd
                                int test_id);
     void add_data_instance_forecast(const unsigned long int tstart,
                                     const int vecindex, TorchDataset &dataset,
-                                    const std::vector<CSVline> &seq);
+                                    const int64_t series,
+                                    const size_t seq_size);
     void fill_dataset_labels(TorchDataset &dataset,
                              const std::vector<std::vector<CSVline>> &data,
                              int test_id);
     void add_data_instance_labels(const unsigned long int tstart,
                                   const int vecindex, TorchDataset &dataset,
-                                  const std::vector<CSVline> &seq,
-                                  size_t seq_len);
+                                  const int64_t series, size_t seq_len);
 
-    void add_seq(const size_t ti, const std::vector<CSVline> &seq,
-                 std::vector<at::Tensor> &data_sequence,
-                 std::vector<at::Tensor> &label_sequence);
+    /**
+     * \brief copies a sequence into a [timesteps, ncols] tensor
+     * @param cols columns to copy, all if empty
+     */
+    at::Tensor series_to_tensor(const std::vector<CSVline> &seq,
+                                const std::vector<int> &cols);
+
+    /**
+     * \brief stores a sequence in dataset, inputs and labels for labels
+     * datasets, whole lines for forecast
+     * @return series index
+     */
+    int64_t add_series(TorchDataset &dataset,
+                       const std::vector<CSVline> &seq);
 
     void discard_warn(int vecindex, unsigned int seq_size, int test_id);
 
@@ -39,9 +39,12 @@
 #include "torchsolver.h"
 #include "torchloss.h"
 #include "torchutils.h"
+#include "torchdistributed.h"
 
 #include "dto/mllib.hpp"
 #include "utils/bbox.hpp"
+#include "measure_accumulator.h"
+#include "trace.h"
 
 using namespace torch;
 
@@ -86,6 +89,10 @@ namespace dd
     _loss = tl._loss;
     _template_params = tl._template_params;
     _dtype = tl._dtype;
+    _amp_dtype = tl._amp_dtype;
+    _quantizer = tl._quantizer;
+    _warmup_iterations = tl._warmup_iterations;
+    _state_cache = tl._state_cache;
   }
 
   template <class TInputConnectorStrategy, class TOutputConnectorStrategy,
@@ -278,6 +285,16 @@ namespace dd
 
     _main_device = _devices[0];
 
+    _amp_dtype = torch_utils::amp_dtype(mllib_dto->amp, _main_device);
+    if (_amp_dtype != torch::kFloat32)
+      {
+        if (_dtype != torch::kFloat32)
+          throw MLLibBadParamException(
+              "mixed precision requires fp32 datatype");
+        this->_logger->info("using mixed precision with {}",
+                            std::string(mllib_dto->amp));
+      }
+
     // Set model type
     if (mllib_dto->segmentation)
       {
@@ -493,8 +510,73 @@ namespace dd
     if (_module.is_ready(_template))
       {
         _module.print_model_info();
+        this->_model_params = _module._param_count;
+      }
+
+    // int8 quantization, reload from repository or quantize right away
+    if (mllib_dto->quantization != nullptr)
+      {
+        if (_main_device != torch::Device("cpu"))
+          throw MLLibBadParamException(
+              "quantized inference is only available on CPU");
+        _quantizer = std::make_shared<TorchQuantizer>(
+            mllib_dto->quantization, this->_logger);
+        std::string qfile
+            = this->_mlmodel._repo + "/" + _quantizer->filename();
+        if (!this->_mlmodel._traced.empty() && fileops::file_exists(qfile)
+            && fileops::file_last_modif(qfile)
+                   >= fileops::file_last_modif(this->_mlmodel._traced))
+          {
+            this->_logger->info("loading " + qfile);
+            _module._quantized = std::make_shared<torch::jit::script::Module>(
+                torch::jit::load(qfile, _main_device));
+          }
+        else if (!_quantizer->is_static())
+          quantize(nullptr, 1);
+        else
+          this->_logger->warn(
+              "static quantization requires calibration, run a training job "
+              "with mllib.quantization parameters");
+      }
+
+    // frozen and optimized graph for inference, cached by model hash
+    if (mllib_dto->optimize_inference)
+      {
+        if (_quantizer)
+          this->_logger->warn(
+              "optimize_inference is not applied to quantized models");
+        else if (!_module._traced)
+          this->_logger->warn(
+              "optimize_inference is only available for traced models");
+        else
+          {
+            std::string key = fileops::file_hash(this->_mlmodel._traced) + "_"
+                              + _main_device.str() + "_"
+                              + c10::toString(_dtype);
+            std::replace(key.begin(), key.end(), ':', '-');
+            std::string ofile
+                = this->_mlmodel._repo + "/optimized_" + key + ".opt";
+            if (!fileops::file_exists(ofile))
+              fileops::remove_directory_files(this->_mlmodel._repo,
+                                              { ".opt" });
+            try
+              {
+                _module.optimize_traced(ofile);
+                _warmup_iterations = mllib_dto->warmup_iterations;
+              }
+            catch (std::exception &e)
+              {
+                _module._optimized = nullptr;
+                this->_logger->warn(
+                    "could not optimize model, using traced model: {}",
+                    e.what());
+              }
+          }
       }
 
+    _state_cache = std::make_shared<TorchStateCache>(
+        mllib_dto->continuation_cache_size, mllib_dto->continuation_ttl);
+
     _best_metrics = { "map", "meaniou",  "mlacc", "delta_score_0.1", "bacc",
                       "f1",  "net_meas", "acc",   "L1_mean_error",   "eucll" };
     _best_metric_values.resize(1, std::numeric_limits<double>::infinity());
@@ -506,7 +588,8 @@ namespace dd
                 TMLModel>::clear_mllib(__attribute__((unused))
                                        const APIData &ad)
   {
-    std::vector<std::string> extensions{ ".json", ".pt", ".ptw" };
+    std::vector<std::string> extensions{ ".json", ".pt", ".ptw", ".qpt",
+                                         ".opt" };
     fileops::remove_directory_files(this->_mlmodel._repo, extensions);
     this->_logger->info("Torchlib service cleared");
   }
@@ -638,6 +721,63 @@ namespace dd
     tsolver.train();
   }
 
+  template <class TInputConnectorStrategy, class TOutputConnectorStrategy,
+            class TMLModel>
+  void TorchLib<TInputConnectorStrategy, TOutputConnectorStrategy,
+                TMLModel>::quantize(TorchDataset *calibration,
+                                    int64_t batch_size)
+  {
+    if (!_module._traced)
+      throw MLLibBadParamException(
+          "quantization is only available for traced models");
+    if (_main_device != torch::Device("cpu"))
+      throw MLLibBadParamException(
+          "quantized inference is only available on CPU");
+    if (_quantizer->is_static() && !calibration)
+      throw MLLibBadParamException(
+          "static quantization requires calibration data");
+
+    torch::NoGradGuard no_grad;
+    _module._quantized = nullptr;
+    _module.eval();
+    torch::jit::Module observed = _quantizer->prepare(*_module._traced);
+
+    if (calibration)
+      {
+        calibration->reset(false);
+        auto dataloader = torch::data::make_data_loader(
+            *calibration, data::DataLoaderOptions(batch_size));
+        int nbatches = 0;
+        for (TorchBatch batch : *dataloader)
+          {
+            std::vector<c10::IValue> in_vals;
+            for (Tensor tensor : batch.data)
+              in_vals.push_back(tensor.to(_main_device));
+            if (nbatches == 0)
+              {
+                // flops of the float model, per sample
+                int64_t flops = torch_utils::count_flops(
+                    [&]() { _module._traced->forward(in_vals); });
+                this->_model_flops = flops / batch.data[0].size(0);
+                this->_logger->info("float model flops={}",
+                                    this->_model_flops);
+              }
+            if (_quantizer->is_static())
+              observed.forward(in_vals);
+            if (++nbatches >= _quantizer->_calibration_batches)
+              break;
+          }
+        this->_logger->info("calibration done on {} batches", nbatches);
+      }
+
+    _module._quantized = std::make_shared<torch::jit::script::Module>(
+        _quantizer->convert(observed));
+    std::string qfile = this->_mlmodel._repo + "/" + _quantizer->filename();
+    _module._quantized->save(qfile);
+    this->_logger->info("saved quantized model to {}", qfile);
+    this->_model_params = _module._param_count;
+  }
+
   template <class TInputConnectorStrategy, class TOutputConnectorStrategy,
             class TMLModel>
   int TorchLib<TInputConnectorStrategy, TOutputConnectorStrategy,
@@ -660,6 +800,7 @@ namespace dd
         inputc.transform(ad);
         _module.post_transform_train<TInputConnectorStrategy>(
             _template, _template_params, inputc, this->_mlmodel, _main_device);
+        this->_model_params = _module._param_count;
       }
     catch (...)
       {
@@ -811,6 +952,21 @@ namespace dd
           }
       }
 
+    // [quantization] calibrate on training data and quantize, no training
+    if (ad_mllib.has("quantization"))
+      {
+        _quantizer = std::make_shared<TorchQuantizer>(
+            ad_mllib.getobj("quantization")
+                .createSharedDTO<DTO::Quantization>(),
+            this->_logger);
+        quantize(&inputc._dataset, batch_size);
+        inputc.response_params(out);
+        return 0;
+      }
+    // quantized and optimized modules would be outdated by training
+    _module._quantized = nullptr;
+    _module._optimized = nullptr;
+
     // solver params
     int64_t iterations = 1;
     int64_t iter_size = 1;
@@ -855,8 +1011,30 @@ namespace dd
     if (iter_size <= 0)
       iter_size = 1;
 
+    if (ad_mllib.has("amp"))
+      _amp_dtype = torch_utils::amp_dtype(
+          ad_mllib.get("amp").get<std::string>(), _main_device);
+    tsolver.set_amp(_amp_dtype);
+
     size_t gpu_count = _devices.size();
 
+    // [distributed] join process group, each rank reads its own data shard
+    std::shared_ptr<TorchDistributed> dist;
+    if (ad_mllib.has("distributed"))
+      {
+        if (gpu_count > 1)
+          throw MLLibBadParamException(
+              "distributed training supports a single device per process");
+        if (tsolver.sam())
+          throw MLLibBadParamException(
+              "SAM solver is not supported with distributed training");
+        dist = std::make_shared<TorchDistributed>(
+            ad_mllib.getobj("distributed"), this->_logger);
+        inputc._dataset.set_shard(dist->_rank, dist->_world_size);
+      }
+    // only rank 0 tests and saves the model
+    bool master = !dist || dist->is_master();
+
     // create dataset for evaluation during training
     TorchMultipleDataset &eval_dataset = inputc._test_datasets;
     if (eval_dataset.size() == 0)
@@ -916,6 +1094,38 @@ namespace dd
       }
     _module.train();
 
+    // [distributed] start from rank 0 weights, reduce gradients by buckets
+    std::shared_ptr<TorchGradBuckets> dist_buckets;
+    if (dist)
+      {
+        dist->broadcast_parameters(_module.parameters());
+        dist_buckets = dist->make_buckets(_module.parameters());
+      }
+
+    // [multigpu] sum gradients on main device by buckets, during backward
+    std::shared_ptr<TorchMultiDeviceReducer> reducer;
+    if (_devices.size() > 1)
+      {
+        int64_t bucket_bytes = DEFAULT_BUCKET_SIZE_MB * 1024 * 1024;
+        if (ad_mllib.has("bucket_size_mb"))
+          bucket_bytes = static_cast<int64_t>(
+              ad_mllib.get("bucket_size_mb").get<double>() * 1024 * 1024);
+        std::vector<std::vector<Tensor>> rank_params;
+        size_t main_id = 0;
+        for (size_t i = 0; i < _devices.size(); ++i)
+          {
+            if (_devices[i] == _main_device)
+              {
+                main_id = i;
+                rank_params.push_back(_module.parameters());
+              }
+            else
+              rank_params.push_back(ranks[i].module->parameters());
+          }
+        reducer = std::make_shared<TorchMultiDeviceReducer>(
+            rank_params, main_id, bucket_bytes);
+      }
+
     // create dataloader
     inputc._dataset.reset();
     size_t dataloader_max_jobs = 2 * iter_size * gpu_count;
@@ -932,6 +1142,7 @@ namespace dd
     double train_loss = 0;
     std::unordered_map<std::string, double> sub_losses;
     double loss_divider = iter_size * gpu_count;
+    double comm_wait_ms = 0;
     auto data_it = dataloader->begin();
 
     if (data_it == dataloader->end())
@@ -944,10 +1155,17 @@ namespace dd
     if (std::isnan(prev_elapsed_time_ms))
       prev_elapsed_time_ms = 0;
 
+    // [distributed] ranks stop together, once all have reached the same
+    // batch
+    bool dist_stop = false;
+    auto stopped = [&]() {
+      return dist ? dist_stop : !this->_tjob_running.load();
+    };
+
     // `it` is the iteration count (not epoch)
     while (it < iterations)
       {
-        if (!this->_tjob_running.load())
+        if (stopped())
           break;
 
         auto tstart = steady_clock::now();
@@ -975,6 +1193,12 @@ namespace dd
 
         std::exception_ptr eptr;
 
+        if (dist_buckets)
+          dist_buckets->prepare_for_backward((batch_id + 1) % iter_size
+                                             == 0);
+        if (reducer)
+          reducer->prepare_for_backward((batch_id + 1) % iter_size == 0);
+
 #pragma omp parallel for num_threads(_devices.size())
         for (size_t rank = 0; rank < _devices.size(); ++rank)
           {
@@ -1013,17 +1237,22 @@ namespace dd
                 for (auto target : batch.target)
                   targets.push_back(target.to(device));
 
-                // Prediction
-                out_val = rank_module.forward(in_vals);
+                Tensor loss;
+                {
+                  torch_utils::AutocastGuard autocast(device, _amp_dtype);
+
+                  // Prediction
+                  out_val = rank_module.forward(in_vals);
 
-                // Compute loss
-                Tensor loss = rank_tloss.loss(out_val, targets, in_vals);
+                  // Compute loss
+                  loss = rank_tloss.loss(out_val, targets, in_vals);
+                }
 
                 if (loss_divider != 1)
                   loss = loss / loss_divider;
 
                 // Backward
-                loss.backward(
+                tsolver.scale_loss(loss).backward(
                     {},
                     /*retain_graph=*/c10::optional<bool>(retain_graph),
                     /*create_graph=*/false);
@@ -1068,6 +1297,24 @@ namespace dd
             }
           }
 
+        // [distributed] a failing rank still takes part in the gradient
+        // all-reduce, then all ranks fail or stop together
+        if (dist)
+          {
+            if (eptr && dist_buckets && (batch_id + 1) % iter_size == 0)
+              dist_buckets->finalize();
+            TorchDistributed::Status status
+                = eptr ? TorchDistributed::FAILED
+                       : (this->_tjob_running.load()
+                              ? TorchDistributed::RUNNING
+                              : TorchDistributed::STOPPED);
+            status = dist->sync_status(status);
+            if (status == TorchDistributed::FAILED && !eptr)
+              eptr = std::make_exception_ptr(MLLibInternalException(
+                  "training failed on another distributed rank"));
+            dist_stop = status == TorchDistributed::STOPPED;
+          }
+
         try
           {
             if (eptr)
@@ -1082,24 +1329,13 @@ namespace dd
                                          + e.what());
           }
 
-        // Reduce gradients on device #0
-        auto params = _module.parameters();
-
-        for (size_t j = 0; j < _devices.size(); ++j)
-          {
-            if (_devices[j] == _main_device)
-              continue;
-
-            auto params_j = ranks[j].module->parameters();
+        // [distributed] wait for all-reduce of gradients
+        if (dist_buckets && (batch_id + 1) % iter_size == 0)
+          comm_wait_ms += dist_buckets->finalize();
 
-            for (size_t pi = 0; pi < params.size(); ++pi)
-              {
-                Tensor &grad = params[pi].mutable_grad();
-                Tensor gradj = params_j[pi].grad();
-                grad.add_(gradj.to(_main_device));
-              }
-          }
-        // End sync gradients
+        // [multigpu] wait for gradients to be summed on main device
+        if (reducer && (batch_id + 1) % iter_size == 0)
+          comm_wait_ms += reducer->finalize();
 
         // Timing
         auto tstop = steady_clock::now();
@@ -1107,7 +1343,7 @@ namespace dd
 
         if ((batch_id + 1) % iter_size == 0)
           {
-            if (!this->_tjob_running.load())
+            if (stopped())
               {
                 // Interrupt training if the service was deleted
                 break;
@@ -1117,6 +1353,8 @@ namespace dd
 
             try
               {
+                // SAM runs its own forward
+                torch_utils::AutocastGuard autocast(_main_device, _amp_dtype);
                 tsolver.step();
                 tsolver.zero_grad();
               }
@@ -1129,21 +1367,12 @@ namespace dd
               }
 
             // Broadcast weights to all
-            for (size_t j = 0; j < _devices.size(); ++j)
-              {
-                if (_devices[j] == _main_device)
-                  continue;
+            double broadcast_ms = 0;
+            if (reducer)
+              broadcast_ms = reducer->broadcast_parameters();
 
-                auto params_j = ranks[j].module->parameters();
-
-                for (size_t pi = 0; pi < params.size(); ++pi)
-                  {
-                    torch::NoGradGuard guard;
-                    Tensor weight = params[pi];
-                    params_j[pi].copy_(weight.to(_devices.at(j)));
-                    params_j[pi].grad().zero_();
-                  }
-              }
+            if (dist)
+              train_loss = dist->average(train_loss);
 
             tstop = steady_clock::now();
 
@@ -1159,6 +1388,16 @@ namespace dd
             last_it_time
                 += duration_cast<milliseconds>(tstop - tstart).count();
             this->add_meas("iteration_duration_ms", last_it_time);
+            if (reducer || dist_buckets)
+              {
+                // exposed communication time, that was not overlapped with
+                // backward
+                this->add_meas("comm_wait_ms", comm_wait_ms + broadcast_ms);
+                if (reducer)
+                  this->add_meas("comm_time_ms",
+                                 reducer->pop_comm_time() + broadcast_ms);
+                comm_wait_ms = 0;
+              }
 
             double remain_time_ms = last_it_time * (iterations - it);
 
@@ -1193,121 +1432,150 @@ namespace dd
               }
             last_it_time = 0;
 
-            if ((elapsed_it % test_interval == 0 && eval_dataset.size() != 0)
-                || elapsed_it == iterations)
+            bool test_now
+                = (elapsed_it % test_interval == 0 && eval_dataset.size() != 0)
+                  || elapsed_it == iterations;
+            bool save_now
+                = (save_period != 0 && elapsed_it % save_period == 0)
+                  || elapsed_it == iterations;
+            std::exception_ptr test_eptr;
+            try
               {
-                APIData meas_out;
-                this->_logger->info("Start test");
-                tstart = steady_clock::now();
-                tsolver.eval();
-                test(ad, inputc, eval_dataset, test_batch_size, meas_out);
-                tsolver.train();
-                last_test_time
-                    = duration_cast<milliseconds>(steady_clock::now() - tstart)
-                          .count();
-
-                APIData meas_obj = meas_out.getobj("measure");
-                for (const auto &e : sub_losses)
-                  meas_obj.add(e.first, e.second);
-                meas_out.add("measure", meas_obj);
-
-                save_if_best(meas_out, elapsed_it, tsolver,
-                             best_iteration_numbers);
-
-                // print metrics
-                for (size_t i = 0; i < eval_dataset.size() + 1; ++i)
+                if (master && test_now)
                   {
-                    if (i == 0)
-                      {
-                        meas_obj = meas_out.getobj("measure");
-                        this->_logger->info("measures over all test sets");
-                      }
-                    else
-                      {
-                        size_t test_id = i - 1;
-                        meas_obj = meas_out.getv("measures")[test_id];
-                        this->_logger->info("measures on test set "
-                                            + std::to_string(test_id) + " : "
-                                            + eval_dataset.name(test_id));
-                      }
-
-                    std::vector<std::string> meas_names = meas_obj.list_keys();
-                    for (auto name : meas_names)
+                    APIData meas_out;
+                    this->_logger->info("Start test");
+                    tstart = steady_clock::now();
+                    tsolver.eval();
+                    test(ad, inputc, eval_dataset, test_batch_size, meas_out);
+                    tsolver.train();
+                    last_test_time = duration_cast<milliseconds>(
+                                         steady_clock::now() - tstart)
+                                         .count();
+
+                    APIData meas_obj = meas_out.getobj("measure");
+                    for (const auto &e : sub_losses)
+                      meas_obj.add(e.first, e.second);
+                    meas_out.add("measure", meas_obj);
+
+                    save_if_best(meas_out, elapsed_it, tsolver,
+                                 best_iteration_numbers);
+
+                    // print metrics
+                    for (size_t i = 0; i < eval_dataset.size() + 1; ++i)
                       {
-                        std::string metric_name;
                         if (i == 0)
-                          metric_name = name;
+                          {
+                            meas_obj = meas_out.getobj("measure");
+                            this->_logger->info("measures over all test sets");
+                          }
                         else
-                          metric_name = name + "_test" + std::to_string(i - 1);
-
-                        if (name != "cmdiag" && name != "cmfull"
-                            && name != "clacc" && name != "cliou"
-                            && name != "labels" && name != "test_id"
-                            && name != "test_name")
                           {
-                            double mval = meas_obj.get(name).get<double>();
-                            this->_logger->info("{}={}", metric_name, mval);
-                            this->add_meas(metric_name, mval);
-                            this->add_meas_per_iter(metric_name, mval);
+                            size_t test_id = i - 1;
+                            meas_obj = meas_out.getv("measures")[test_id];
+                            this->_logger->info(
+                                "measures on test set "
+                                + std::to_string(test_id) + " : "
+                                + eval_dataset.name(test_id));
                           }
-                        else if (name == "cmdiag" || name == "clacc"
-                                 || name == "cliou")
+
+                        std::vector<std::string> meas_names
+                            = meas_obj.list_keys();
+                        for (auto name : meas_names)
                           {
-                            std::vector<double> mdiag
-                                = meas_obj.get(name)
-                                      .get<std::vector<double>>();
-                            std::vector<std::string> cnames;
-                            std::string mdiag_str;
-                            for (size_t j = 0; j < mdiag.size(); j++)
+                            std::string metric_name;
+                            if (i == 0)
+                              metric_name = name;
+                            else
+                              metric_name
+                                  = name + "_test" + std::to_string(i - 1);
+
+                            if (name != "cmdiag" && name != "cmfull"
+                                && name != "clacc" && name != "cliou"
+                                && name != "labels" && name != "test_id"
+                                && name != "test_name")
+                              {
+                                double mval = meas_obj.get(name).get<double>();
+                                this->_logger->info("{}={}", metric_name,
+                                                    mval);
+                                this->add_meas(metric_name, mval);
+                                this->add_meas_per_iter(metric_name, mval);
+                              }
+                            else if (name == "cmdiag" || name == "clacc"
+                                     || name == "cliou")
                               {
-                                mdiag_str
-                                    += this->_mlmodel.get_hcorresp(j) + ":"
-                                       + std::to_string(mdiag.at(j)) + " ";
-                                this->add_meas_per_iter(
-                                    metric_name + '_'
-                                        + this->_mlmodel.get_hcorresp(j),
-                                    mdiag.at(j));
-                                cnames.push_back(
-                                    this->_mlmodel.get_hcorresp(j));
+                                std::vector<double> mdiag
+                                    = meas_obj.get(name)
+                                          .get<std::vector<double>>();
+                                std::vector<std::string> cnames;
+                                std::string mdiag_str;
+                                for (size_t j = 0; j < mdiag.size(); j++)
+                                  {
+                                    mdiag_str
+                                        += this->_mlmodel.get_hcorresp(j) + ":"
+                                           + std::to_string(mdiag.at(j)) + " ";
+                                    this->add_meas_per_iter(
+                                        metric_name + '_'
+                                            + this->_mlmodel.get_hcorresp(j),
+                                        mdiag.at(j));
+                                    cnames.push_back(
+                                        this->_mlmodel.get_hcorresp(j));
+                                  }
+                                this->_logger->info("{}=[{}]", metric_name,
+                                                    mdiag_str);
+                                this->add_meas(metric_name, mdiag, cnames);
                               }
-                            this->_logger->info("{}=[{}]", metric_name,
-                                                mdiag_str);
-                            this->add_meas(metric_name, mdiag, cnames);
                           }
                       }
-                  }
 
-                if (elapsed_it == iterations)
-                  {
-                    out.add("measure", meas_out.getobj("measure"));
-                    out.add("measures", meas_out.getv("measures"));
+                    if (elapsed_it == iterations)
+                      {
+                        out.add("measure", meas_out.getobj("measure"));
+                        out.add("measures", meas_out.getv("measures"));
+                      }
                   }
-              }
 
-            train_loss = 0;
-            sub_losses.clear();
-
-            if ((save_period != 0 && elapsed_it % save_period == 0)
-                || elapsed_it == iterations)
-              {
-                bool snapshotted = false;
-                for (size_t i = 0; i < best_iteration_numbers.size(); ++i)
+                if (master && save_now)
                   {
+                    bool snapshotted = false;
+                    for (size_t i = 0; i < best_iteration_numbers.size(); ++i)
+                      {
 
-                    if (best_iteration_numbers[i] == elapsed_it)
-                      // current model already snapshoted as best model,
-                      // do not remove regular snapshot if it is  best
-                      // model
+                        if (best_iteration_numbers[i] == elapsed_it)
+                          // current model already snapshoted as best model,
+                          // do not remove regular snapshot if it is  best
+                          // model
+                          {
+                            best_iteration_numbers[i] = -1;
+                            snapshotted = true;
+                          }
+                      }
+                    if (!snapshotted)
                       {
-                        best_iteration_numbers[i] = -1;
-                        snapshotted = true;
+                        snapshot(elapsed_it, tsolver);
                       }
                   }
-                if (!snapshotted)
-                  {
-                    snapshot(elapsed_it, tsolver);
-                  }
               }
+            catch (...)
+              {
+                test_eptr = std::current_exception();
+              }
+
+            // [distributed] other ranks wait for rank 0 test and snapshot
+            if (dist && (test_now || save_now)
+                && dist->sync_status(test_eptr ? TorchDistributed::FAILED
+                                               : TorchDistributed::RUNNING,
+                                     true)
+                       == TorchDistributed::FAILED
+                && !test_eptr)
+              throw MLLibInternalException(
+                  "test or snapshot failed on distributed rank 0");
+            if (test_eptr)
+              std::rethrow_exception(test_eptr);
+
+            train_loss = 0;
+            sub_losses.clear();
+
             ++it;
 
             if (it >= iterations)
@@ -1317,7 +1585,7 @@ namespace dd
         ++batch_id;
       }
 
-    if (!this->_tjob_running.load())
+    if (stopped())
       {
         int64_t elapsed_it = it + 1;
         this->_logger->info("Training job interrupted at iteration {}",
@@ -1335,13 +1603,13 @@ namespace dd
                 snapshotted = true;
               }
           }
-        if (!snapshotted)
+        if (!snapshotted && master)
           snapshot(elapsed_it, tsolver);
         torch_utils::empty_cuda_cache();
         return -1;
       }
 
-    if (skip_training)
+    if (skip_training && master)
       test(ad, inputc, inputc._test_datasets, test_batch_size, out);
     torch_utils::empty_cuda_cache();
 
@@ -1419,6 +1687,11 @@ namespace dd
     else
       throw MLLibBadParamException("unknown datatype " + dt);
 
+    if (mllib_params->amp != nullptr && !mllib_params->amp->empty())
+      _amp_dtype = torch_utils::amp_dtype(mllib_params->amp, _main_device);
+    if (_amp_dtype != torch::kFloat32 && _dtype != torch::kFloat32)
+      throw MLLibBadParamException("mixed precision requires fp32 datatype");
+
     bool bbox = output_params->bbox;
     bool ctc = output_params->ctc;
     double confidence_threshold = output_params->confidence_threshold;
@@ -1438,11 +1711,21 @@ namespace dd
         for (oatpp::String conf : *output_params->confidences)
           confidences.push_back(conf);
       }
+    std::string mask_encoding = output_params->mask_encoding;
+    if (!mask_encoding.empty() && mask_encoding != "rle"
+        && mask_encoding != "png")
+      throw MLLibBadParamException("unknown mask_encoding " + mask_encoding);
 
     bool lstm_continuation = input_params->continuation;
     TInputConnectorStrategy inputc(this->_inputc);
 
-    this->_stats.transform_start();
+    // concurrent predict calls share the graph, its recurrent states and
+    // continuation flag, until the states are stored back
+    std::unique_lock<std::mutex> graph_lock(_graph_mutex, std::defer_lock);
+    if (_module._graph)
+      graph_lock.lock();
+
+    auto transform_tstart = this->_stats.transform_start();
     TOutputConnectorStrategy outputc(this->_outputc);
     outputc._best = best_count;
     try
@@ -1460,12 +1743,13 @@ namespace dd
         _module.post_transform_predict(_template, _template_params, inputc,
                                        this->_mlmodel, _main_device,
                                        predict_dto);
+        this->_model_params = _module._param_count;
       }
     catch (...)
       {
         throw;
       }
-    this->_stats.transform_end();
+    this->_stats.transform_end(transform_tstart);
     _module.to(_dtype);
     torch::Device cpu("cpu");
     _module.eval();
@@ -1495,15 +1779,42 @@ namespace dd
 
     inputc._dataset.reset(false);
 
+    // with series ids, recurrent states are kept per series and series of
+    // same length are batched together, otherwise one state is carried from
+    // one sample to the next
+    std::vector<std::string> series_ids;
+    if (lstm_continuation && input_params->series_ids != nullptr)
+      for (oatpp::String sid : *input_params->series_ids)
+        series_ids.push_back(sid);
+    bool series_states = !series_ids.empty() && _module._graph;
+    if (series_states
+        && series_ids.size() != inputc._dataset.cache_size())
+      throw MLLibBadParamException(
+          "got " + std::to_string(series_ids.size()) + " series_ids for "
+          + std::to_string(inputc._dataset.cache_size()) + " series");
+
     int batch_size = predict_batch_size;
-    if (lstm_continuation)
+    if (lstm_continuation && !series_states)
       batch_size = 1;
+    if (series_states)
+      {
+        const auto &windows = inputc._dataset._windows;
+        for (const TorchWindow &w : windows)
+          if (w._length != windows.at(0)._length)
+            {
+              batch_size = 1;
+              break;
+            }
+      }
 
     auto dataloader = torch::data::make_data_loader(
         std::move(inputc._dataset), data::DataLoaderOptions(batch_size));
 
     std::vector<APIData> results_ads;
     int nsample = 0;
+    size_t nseries = 0;
+    double forward_ms = 0.0;
+    double output_ms = 0.0;
 
     for (TorchBatch batch : *dataloader)
       {
@@ -1516,14 +1827,70 @@ namespace dd
           }
         this->_stats.inc_inference_count(batch.data[0].size(0));
 
+        std::vector<std::string> batch_series;
+        if (series_states)
+          {
+            batch_series.assign(series_ids.begin() + nseries,
+                                series_ids.begin() + nseries
+                                    + batch.data[0].size(0));
+            nseries += batch_series.size();
+            _module._graph->set_rnn_memories(
+                _state_cache->gather(batch_series));
+          }
+
+        // the optimized module may be dropped here, other predict calls
+        // wait for the warm-up before running it
+        if (_warmup_iterations > 0)
+          std::call_once(_warmup_once, [&]() {
+            if (!_module._optimized)
+              return;
+            try
+              {
+                auto latencies
+                    = _module.warmup_optimized(in_vals, _warmup_iterations);
+                this->_logger->info(
+                    "warm-up latency: traced {} ms, optimized {} ms",
+                    latencies.first, latencies.second);
+              }
+            catch (std::exception &e)
+              {
+                _module._optimized = nullptr;
+                this->_logger->warn(
+                    "optimized model failed, using traced model: {}",
+                    e.what());
+              }
+          });
+
+        // dynamic quantization and reloaded quantized models have no
+        // calibration data, float model flops come from the first batch
+        if (_module._quantized && _module._traced)
+          std::call_once(_flops_once, [&]() {
+            if (this->_model_flops > 0)
+              return;
+            int64_t flops = torch_utils::count_flops(
+                [&]() { _module._traced->forward(in_vals); });
+            this->_model_flops = flops / batch.data[0].size(0);
+            this->_logger->info("float model flops={}", this->_model_flops);
+          });
+
+        auto forward_tstart = ServiceStats::now();
         c10::IValue out_ivalue;
         Tensor output;
         try
           {
-            if (extract_layer.empty() || extract_last)
-              out_ivalue = _module.forward(in_vals, forward_method);
-            else
-              out_ivalue = _module.extract(in_vals, extract_layer);
+            {
+              TraceSpan span("TorchModule::forward", "mllib");
+              torch_utils::AutocastGuard autocast(_main_device, _amp_dtype);
+              if (extract_layer.empty() || extract_last)
+                out_ivalue = _module.forward(in_vals, forward_method);
+              else
+                out_ivalue = _module.extract(in_vals, extract_layer);
+            }
+            if (_amp_dtype != torch::kFloat32)
+              out_ivalue = torch_utils::to_fp32(out_ivalue);
+            if (series_states)
+              _state_cache->scatter(batch_series,
+                                    _module._graph->rnn_memories());
 
             if (!bbox && !_segmentation)
               {
@@ -1567,8 +1934,10 @@ namespace dd
                                          + e.what());
           }
 
-        // Output
+        forward_ms += ServiceStats::elapsed_ms(forward_tstart);
 
+        // Output
+        auto output_tstart = ServiceStats::now();
         if (!extract_layer.empty())
           {
             for (int j = 0; j < batch_size; j++)
@@ -1734,12 +2103,16 @@ namespace dd
               }
             else if (_classification)
               {
-                std::tuple<Tensor, Tensor> sorted_output
-                    = output.sort(1, true);
-                Tensor probsf = std::get<0>(sorted_output).to(torch::kFloat);
+                // only the best classes are selected and sorted, for the
+                // whole batch at once
+                int64_t k = std::min(static_cast<int64_t>(best_count),
+                                     output.size(1));
+                std::tuple<Tensor, Tensor> topk_output
+                    = output.topk(k, 1, true, true);
+                Tensor probsf = std::get<0>(topk_output).to(torch::kFloat);
                 auto probs_acc = probsf.accessor<float, 2>();
                 auto indices_acc
-                    = std::get<1>(sorted_output).accessor<int64_t, 2>();
+                    = std::get<1>(topk_output).accessor<int64_t, 2>();
 
                 for (int i = 0; i < output.size(0); ++i)
                   {
@@ -1747,7 +2120,7 @@ namespace dd
                     std::vector<double> probs;
                     std::vector<std::string> cats;
 
-                    for (int j = 0; j < best_count; ++j)
+                    for (int j = 0; j < k; ++j)
                       {
                         if (probs_acc[i][j] < confidence_threshold)
                           {
@@ -1787,27 +2160,30 @@ namespace dd
                   output = torch_utils::to_tensor_safe(out_ivalue);
                 output = torch::softmax(output, 1);
 
-                int imgsize = inputc.width() * inputc.height();
+                // class map is kept as uint8 or int16 and moved off the
+                // device as such, then resized through a cv::Mat header
+                torch::ScalarType seg_type
+                    = output.size(1) <= 256 ? torch::kUInt8 : torch::kInt16;
                 torch::Tensor segmap;
                 torch::Tensor confmap;
                 std::tuple<torch::Tensor, torch::Tensor> maxmap;
                 if (!confidences.empty()) // applies "best" confidence lookup
                   {
-                    maxmap = torch::max(output.clone().squeeze(), 0, false);
-                    confmap = torch::flatten(std::get<0>(maxmap))
-                                  .contiguous()
-                                  .to(torch::kFloat64)
-                                  .to(cpu);
-                    segmap = torch::flatten(std::get<1>(maxmap))
-                                 .contiguous()
-                                 .to(torch::kFloat64)
-                                 .to(cpu);
+                    maxmap = torch::max(output.squeeze(), 0, false);
+                    confmap = std::get<0>(maxmap)
+                                  .to(torch::kFloat32)
+                                  .to(cpu)
+                                  .contiguous();
+                    segmap = std::get<1>(maxmap)
+                                 .to(seg_type)
+                                 .to(cpu)
+                                 .contiguous();
                   }
                 else
-                  segmap = torch::flatten(torch::argmax(output.squeeze(), 0))
-                               .contiguous()
-                               .to(torch::kFloat64)
-                               .to(cpu); // squeeze removes the batch size
+                  segmap = torch::argmax(output.squeeze(), 0)
+                               .to(seg_type)
+                               .to(cpu)
+                               .contiguous(); // squeeze removes the batch size
 
                 APIData rad;
                 std::string uri;
@@ -1817,16 +2193,6 @@ namespace dd
                   uri = std::to_string(results_ads.size());
                 rad.add("uri", uri);
                 rad.add("loss", static_cast<double>(0.0));
-                double *startout = segmap.data_ptr<double>();
-                std::vector<double> vals(startout,
-                                         startout + torch::numel(segmap));
-                std::vector<double> confs;
-                if (!confidences.empty())
-                  {
-                    startout = confmap.data_ptr<double>();
-                    confs = std::vector<double>(
-                        startout, startout + torch::numel(confmap));
-                  }
 
                 auto bit = inputc._imgs_size.find(uri);
                 APIData ad_imgsize;
@@ -1834,25 +2200,28 @@ namespace dd
                 ad_imgsize.add("width", (*bit).second.second);
                 rad.add("imgsize", ad_imgsize);
 
-                if (imgsize
-                    != (*bit).second.first
-                           * (*bit).second.second) // resizing output
-                  // segmentation array
-                  {
-                    vals = ImgInputFileConn::img_resize_vector(
-                        vals, inputc.height(), inputc.width(),
-                        (*bit).second.first, (*bit).second.second, true);
-                    if (!confidences.empty())
-                      confs = ImgInputFileConn::img_resize_vector(
-                          confs, inputc.height(), inputc.width(),
-                          (*bit).second.first, (*bit).second.second, false);
-                  }
+                cv::Mat segmat(segmap.size(0), segmap.size(1),
+                               seg_type == torch::kUInt8 ? CV_8UC1 : CV_16SC1,
+                               segmap.data_ptr());
+                ImgInputFileConn::img_resize_map(segmat, (*bit).second.first,
+                                                 (*bit).second.second, true);
+                if (mask_encoding == "rle")
+                  rad.add("vals", ImgInputFileConn::mask_to_rle(segmat));
+                else if (mask_encoding == "png")
+                  rad.add("vals", ImgInputFileConn::mask_to_png(segmat));
+                else
+                  rad.add("vals", ImgInputFileConn::map_to_vector(segmat));
 
-                rad.add("vals", vals);
                 if (!confidences.empty())
                   {
+                    cv::Mat confmat(confmap.size(0), confmap.size(1),
+                                    CV_32FC1, confmap.data_ptr());
+                    ImgInputFileConn::img_resize_map(
+                        confmat, (*bit).second.first, (*bit).second.second,
+                        false);
                     APIData vconfs;
-                    vconfs.add("best", confs);
+                    vconfs.add("best",
+                               ImgInputFileConn::map_to_vector(confmat));
                     rad.add("confidences", vconfs);
                   }
                 results_ads.push_back(rad);
@@ -1914,8 +2283,17 @@ namespace dd
                   }
               }
           }
+        output_ms += ServiceStats::elapsed_ms(output_tstart);
       }
+    this->_stats.add_stage_duration(ServiceStats::FORWARD, forward_ms);
+
+    // series states live in the cache, not in the graph
+    if (series_states)
+      _module._graph->set_rnn_memories(TorchRNNStates());
+    if (graph_lock.owns_lock())
+      graph_lock.unlock();
 
+    auto output_tstart = ServiceStats::now();
     if (extract_layer.empty() && !_segmentation)
       {
         outputc.add_results(results_ads);
@@ -1936,6 +2314,8 @@ namespace dd
         unsupo.finalize(output_params, out,
                         static_cast<MLModel *>(&this->_mlmodel));
       }
+    output_ms += ServiceStats::elapsed_ms(output_tstart);
+    this->_stats.add_stage_duration(ServiceStats::OUTPUT, output_ms);
 
     if (predict_dto->_chain)
       {
@@ -2003,6 +2383,32 @@ namespace dd
         ad_out.add("measure", meas);
       }
 
+    // measures are accumulated batch after batch instead of keeping every
+    // prediction, unless exact measures are required or not supported
+    std::vector<std::string> measures;
+    if (ad_out.has("measure"))
+      measures = ad_out.get("measure").get<std::vector<std::string>>();
+    MeasureAccumulator::Task task = MeasureAccumulator::CLASSIFICATION;
+    if (_timeserie)
+      task = MeasureAccumulator::TIMESERIE;
+    else if (_bbox)
+      task = MeasureAccumulator::BBOX;
+    else if (_segmentation)
+      task = MeasureAccumulator::SEGMENTATION;
+    else if (_regression)
+      task = MeasureAccumulator::REGRESSION;
+    bool measure_exact = ad_out.has("measure_exact")
+                         && ad_out.get("measure_exact").get<bool>();
+    int auc_bins = ad_out.has("auc_bins")
+                       ? ad_out.get("auc_bins").get<int>()
+                       : 10000;
+    std::unique_ptr<MeasureAccumulator> macc;
+    if (!measure_exact && !_ctc
+        && MeasureAccumulator::supports(task, measures))
+      macc.reset(new MeasureAccumulator(
+          task, measures, _timeserie ? inputc._ntargets : nclasses,
+          auc_bins));
+
     auto dataloader = torch::data::make_data_loader(
         dataset, data::DataLoaderOptions(batch_size));
     torch::Device cpu("cpu");
@@ -2023,7 +2429,12 @@ namespace dd
         c10::IValue out_ivalue;
         try
           {
-            out_ivalue = _module.forward(in_vals);
+            {
+              torch_utils::AutocastGuard autocast(_main_device, _amp_dtype);
+              out_ivalue = _module.forward(in_vals);
+            }
+            if (_amp_dtype != torch::kFloat32)
+              out_ivalue = torch_utils::to_fp32(out_ivalue);
             if (!_bbox && !_segmentation)
               {
                 output = torch_utils::to_tensor_safe(out_ivalue);
@@ -2054,13 +2465,24 @@ namespace dd
               {
                 std::vector<double> targets;
                 std::vector<double> predictions;
-                std::vector<double> targets_unscaled;
-                std::vector<double> predictions_unscaled;
                 for (int t = 0; t < labels.size(1); ++t)
                   for (unsigned int k = 0; k < inputc._ntargets; ++k)
                     {
                       targets.push_back(target_acc[j][t][k]);
                       predictions.push_back(output_acc[j][t][k]);
+                    }
+                if (macc)
+                  {
+                    macc->add_timeserie(predictions.data(), targets.data(),
+                                        predictions.size());
+                    ++entry_id;
+                    continue;
+                  }
+                std::vector<double> targets_unscaled;
+                std::vector<double> predictions_unscaled;
+                for (int t = 0; t < labels.size(1); ++t)
+                  for (unsigned int k = 0; k < inputc._ntargets; ++k)
+                    {
                       targets_unscaled.push_back(
                           unscale(target_acc[j][t][k], k, inputc));
                       predictions_unscaled.push_back(
@@ -2110,7 +2532,10 @@ namespace dd
                     targ_bboxes.index({ torch::indexing::Slice(start, stop) }),
                     targ_labels.index({ torch::indexing::Slice(start, stop) }),
                     bboxes_tensor, labels_tensor, score_tensor);
-                ad_bbox.add(std::to_string(entry_id), vbad);
+                if (macc)
+                  macc->add_bbox(vbad);
+                else
+                  ad_bbox.add(std::to_string(entry_id), vbad);
                 ++entry_id;
               }
           }
@@ -2170,6 +2595,27 @@ namespace dd
             else
               output = torch_utils::to_tensor_safe(out_ivalue);
             output = torch::softmax(output, 1);
+            int tensormap_size = output.size(2) * output.size(3);
+            if (macc)
+              {
+                torch::Tensor segmap = torch::argmax(output, 1)
+                                           .to(cpu)
+                                           .contiguous();
+                torch::Tensor target = batch.target.at(0)
+                                           .to(cpu)
+                                           .to(torch::kInt64)
+                                           .contiguous();
+                const int64_t *pred_arr = segmap.data_ptr<int64_t>();
+                const int64_t *target_arr = target.data_ptr<int64_t>();
+                for (int j = 0; j < output.size(0); ++j)
+                  {
+                    macc->add_segmentation(pred_arr + j * tensormap_size,
+                                           target_arr + j * tensormap_size,
+                                           tensormap_size);
+                    ++entry_id;
+                  }
+                continue;
+              }
             torch::Tensor target = batch.target.at(0).to(torch::kFloat64);
             torch::Tensor segmap
                 = torch::flatten(torch::argmax(output.squeeze(), 0))
@@ -2178,7 +2624,6 @@ namespace dd
                       .to(cpu); // squeeze removes the batch size
             double *startout = segmap.data_ptr<double>();
             double *target_arr = target.data_ptr<double>();
-            int tensormap_size = output.size(2) * output.size(3);
 
             for (int j = 0; j < output.size(0); ++j)
               {
@@ -2207,7 +2652,7 @@ namespace dd
             if (_classification || _seq_training)
               {
                 labels = batch.target[0].view(IntList{ -1 });
-                output = torch::softmax(output, 1).to(cpu);
+                output = torch::softmax(output, 1).to(cpu).contiguous();
                 auto output_acc = output.accessor<float, 2>();
                 auto labels_acc = labels.accessor<int64_t, 1>();
 
@@ -2215,6 +2660,14 @@ namespace dd
                   {
                     if (_masked_lm && labels_acc[j] == -1)
                       continue;
+                    if (macc)
+                      {
+                        macc->add_classification(output.data_ptr<float>()
+                                                     + j * output.size(1),
+                                                 labels_acc[j]);
+                        ++entry_id;
+                        continue;
+                      }
 
                     APIData bad;
                     std::vector<double> predictions;
@@ -2230,13 +2683,21 @@ namespace dd
               }
             else if (_regression)
               {
-                output = output.to(cpu);
-                labels = batch.target[0];
+                output = output.to(cpu).contiguous();
+                labels = batch.target[0].to(cpu).contiguous();
                 unsigned int ntargets = nclasses;
                 auto output_acc = output.accessor<float, 2>();
                 auto labels_acc = labels.accessor<float, 2>();
                 for (int j = 0; j < labels.size(0); ++j)
                   {
+                    if (macc)
+                      {
+                        macc->add_regression(
+                            output.data_ptr<float>() + j * output.size(1),
+                            labels.data_ptr<float>() + j * labels.size(1));
+                        ++entry_id;
+                        continue;
+                      }
                     APIData bad;
                     std::vector<double> predictions;
                     if (ntargets == 1)
@@ -2268,6 +2729,19 @@ namespace dd
     ad_res.add("iteration",
                static_cast<double>(this->get_meas("iteration") + 1));
     ad_res.add("train_loss", this->get_meas("train_loss"));
+    if (macc)
+      {
+        std::vector<std::string> clnames;
+        if (!_timeserie)
+          for (int i = 0; i < nclasses; i++)
+            clnames.push_back(this->_mlmodel.get_hcorresp(i));
+        APIData meas_out;
+        macc->to(meas_out, clnames);
+        SupervisedOutput::add_measure(meas_out, ad_res, out, test_id,
+                                      test_name);
+        _module.train();
+        return 0;
+      }
     if (_timeserie)
       {
         ad_res.add("timeserie", true);
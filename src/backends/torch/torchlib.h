@@ -23,6 +23,7 @@
 #ifndef TORCHLIB_H
 #define TORCHLIB_H
 
+#include <mutex>
 #include <random>
 
 #pragma GCC diagnostic push
@@ -45,6 +46,8 @@
 #include "native/native_net.h"
 #include "torchmodule.h"
 #include "torchsolver.h"
+#include "torchquantization.h"
+#include "torchstatecache.h"
 
 namespace dd
 {
@@ -128,6 +131,22 @@ namespace dd
                                 all test sets.  */
 
     torch::Dtype _dtype = torch::kFloat32;
+    torch::Dtype _amp_dtype
+        = torch::kFloat32; /**< autocast dtype, fp32 if no mixed precision */
+    std::shared_ptr<TorchQuantizer>
+        _quantizer; /**< int8 quantization, if enabled */
+    int _warmup_iterations = 0; /**< warm-up run of the optimized module on
+                                   first predict call, if > 0 */
+    std::once_flag _warmup_once; /**< warm-up is run by a single predict
+                                    call, concurrent calls wait for it */
+    std::once_flag _flops_once; /**< float model flops of quantized models
+                                   without calibration, counted once */
+    std::shared_ptr<TorchStateCache>
+        _state_cache; /**< recurrent states per series, for predict calls
+                         with continuation */
+    std::mutex _graph_mutex; /**< serializes predict calls on graph models,
+                                whose recurrent states and continuation
+                                flag are held by the shared graph */
 
   private:
     /**
@@ -147,6 +166,13 @@ namespace dd
      */
     void snapshot(int64_t elapsed_it, TorchSolver &optimizer);
 
+    /**
+     * \brief int8 quantization of the traced module, saved to the repository.
+     * Activations of static quantization are observed on batches of the
+     * calibration dataset.
+     */
+    void quantize(TorchDataset *calibration, int64_t batch_size);
+
     /**
      * delete superseeded model
      */
@@ -24,6 +24,9 @@
 #include "graph/graph.h"
 #include "native/native.h"
 #include "torchutils.h"
+#include "utils/fileops.hpp"
+
+#include <chrono>
 
 namespace dd
 {
@@ -326,7 +329,11 @@ namespace dd
       {
         if (!forward_method.empty())
           {
-            if (auto method = _traced->find_method(forward_method))
+            // frozen modules only keep forward
+            auto method = traced_forward()->find_method(forward_method);
+            if (!method)
+              method = _traced->find_method(forward_method);
+            if (method)
               {
                 _logger->info("found forward method {}", method->name());
                 auto output = (*method)(std::move(source));
@@ -338,7 +345,7 @@ namespace dd
           }
         else
           {
-            auto output = _traced->forward(source);
+            auto output = traced_forward()->forward(source);
             source = torch_utils::unwrap_c10_vector(output);
           }
       }
@@ -382,7 +389,7 @@ namespace dd
     if (_native)
       return _native->extract(torch_utils::to_tensor_safe(source[0]),
                               extract_layer);
-    auto output = _traced->forward(source);
+    auto output = traced_forward()->forward(source);
     source = torch_utils::unwrap_c10_vector(output);
 
     c10::IValue out_val = source.at(_linear_in);
@@ -443,6 +450,58 @@ namespace dd
       }
   }
 
+  void TorchModule::optimize_traced(const std::string &cache_file)
+  {
+    _optimized = nullptr;
+    if (!_traced)
+      return;
+
+    torch::jit::Module frozen;
+    if (fileops::file_exists(cache_file))
+      {
+        _logger->info("loading frozen model {}", cache_file);
+        frozen = torch::jit::load(cache_file, _device);
+      }
+    else
+      {
+        torch::jit::Module module = _traced->clone();
+        module.to(_device, _dtype);
+        module.eval();
+        frozen = torch::jit::freeze(module);
+        frozen.save(cache_file);
+        _logger->info("saved frozen model to {}", cache_file);
+      }
+    // layout conversions and prepacked weights are device specific and not
+    // all serializable, they are recomputed from the frozen graph
+    _optimized = std::make_shared<torch::jit::script::Module>(
+        torch::jit::optimize_for_inference(frozen));
+  }
+
+  std::pair<double, double>
+  TorchModule::warmup_optimized(const std::vector<c10::IValue> &source,
+                                int iterations)
+  {
+    auto timed_run = [&](torch::jit::script::Module &module) {
+      // first run specializes the graph to the input shapes
+      module.forward(source);
+      if (_device.is_cuda())
+        torch::cuda::synchronize();
+      auto tstart = std::chrono::steady_clock::now();
+      for (int i = 0; i < iterations; ++i)
+        module.forward(source);
+      if (_device.is_cuda())
+        torch::cuda::synchronize();
+      return std::chrono::duration<double, std::milli>(
+                 std::chrono::steady_clock::now() - tstart)
+                 .count()
+             / std::max(iterations, 1);
+    };
+    torch::NoGradGuard no_grad;
+    double traced_ms = timed_run(*_traced);
+    double optimized_ms = timed_run(*_optimized);
+    return { traced_ms, optimized_ms };
+  }
+
   void TorchModule::setup_linear_head(int nclasses,
                                       std::vector<c10::IValue> input_example)
   {
@@ -578,6 +637,8 @@ namespace dd
   {
     _graph = nullptr;
     _traced = nullptr;
+    _quantized = nullptr;
+    _optimized = nullptr;
     _linear_head = nullptr;
     _crnn_head = nullptr;
     _native = nullptr;
@@ -586,6 +647,8 @@ namespace dd
   std::shared_ptr<TorchModule> TorchModule::clone(torch::Device device)
   {
     auto cloned = std::make_shared<TorchModule>(*this);
+    cloned->_quantized = nullptr;
+    cloned->_optimized = nullptr;
 
     if (_native)
       {
@@ -680,6 +743,7 @@ namespace dd
         int64_t graph_param_count;
         print_native_params(_logger, "Graph", *_graph, graph_param_count);
         total_param_count += graph_param_count;
+        _param_count = total_param_count;
         return;
       }
     if (_native)
@@ -687,6 +751,7 @@ namespace dd
         int64_t native_param_count;
         print_native_params(_logger, "Native", *_native, native_param_count);
         total_param_count += native_param_count;
+        _param_count = total_param_count;
         return;
       }
     if (_traced)
@@ -735,6 +800,7 @@ namespace dd
       }
     _logger->info("## Total number of parameters: {}",
                   long_number_to_str(total_param_count));
+    _param_count = total_param_count;
   }
 
   template void TorchModule::post_transform(
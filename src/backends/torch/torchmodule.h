@@ -205,9 +205,42 @@ namespace dd
      **/
     void print_model_info();
 
+    /**
+     * \brief freeze a copy of the traced module and optimize its graph for
+     * inference. The frozen module is loaded from cache_file if it exists,
+     * and saved to it otherwise
+     */
+    void optimize_traced(const std::string &cache_file);
+
+    /**
+     * \brief runs traced and optimized modules on source for a number of
+     * iterations, and returns their average latencies in milliseconds
+     */
+    std::pair<double, double>
+    warmup_optimized(const std::vector<c10::IValue> &source, int iterations);
+
+    /**
+     * \brief torchscript module run by forward: quantized or optimized module
+     * at inference if any, traced module otherwise
+     */
+    std::shared_ptr<torch::jit::script::Module> traced_forward() const
+    {
+      if (_training)
+        return _traced;
+      if (_quantized)
+        return _quantized;
+      return _optimized ? _optimized : _traced;
+    }
+
   public:
     std::shared_ptr<torch::jit::script::Module>
         _traced; /**< traced (torchscript) module, if any */
+    std::shared_ptr<torch::jit::script::Module>
+        _quantized; /**< int8 version of the traced module, used instead of
+                       it for inference */
+    std::shared_ptr<torch::jit::script::Module>
+        _optimized; /**< frozen and optimized version of the traced module,
+                       used instead of it for inference */
     std::shared_ptr<TorchGraphBackend>
         _graph; /**< graph module : torchgraphbackend has same interface as
                    torch::module */
@@ -230,6 +263,8 @@ namespace dd
     int _loss_id = -1; /**<id of the loss output. If >= 0, forward returns this
                           output only during training */
     bool _hidden_states = false; /**< Take BERT hidden states as input. */
+    int64_t _param_count = 0; /**< total number of parameters, computed by
+                                 print_model_info */
 
     unsigned int _nclasses = 0; /**< number of classes */
     bool _finetuning = false;
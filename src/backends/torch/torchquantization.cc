@@ -0,0 +1,155 @@
+/**
+ * DeepDetect
+ * Copyright (c) 2023 Jolibrain
+ *
+ * This file is part of deepdetect.
+ *
+ * deepdetect is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * deepdetect is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with deepdetect.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "torchquantization.h"
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+#include <torch/csrc/jit/passes/fold_conv_bn.h>
+#include <torch/csrc/jit/passes/quantization/finalize.h>
+#include <torch/csrc/jit/passes/quantization/insert_observers.h>
+#include <torch/csrc/jit/passes/quantization/insert_quant_dequant.h>
+#pragma GCC diagnostic pop
+
+#include "mllibstrategy.h"
+
+namespace dd
+{
+  // min/max observer, qparams computed as in torch.ao MinMaxObserver
+  static const std::string observer_src = R"(
+def forward(self, x: Tensor) -> Tensor:
+    if x.numel() == 0:
+        return x
+    x_detached = x.detach()
+    self.min_val = torch.minimum(self.min_val, torch.min(x_detached))
+    self.max_val = torch.maximum(self.max_val, torch.max(x_detached))
+    return x
+
+def calculate_qparams(self) -> Tuple[Tensor, Tensor]:
+    min_val = torch.clamp(self.min_val, max=0.0)
+    max_val = torch.clamp(self.max_val, min=0.0)
+    qrange = float(self.quant_max - self.quant_min)
+    if self.symmetric:
+        max_abs = torch.maximum(-min_val, max_val)
+        scale = torch.clamp(max_abs / (qrange / 2.0), min=1e-8)
+        zero_point = torch.zeros_like(scale, dtype=torch.int64)
+        if self.quant_min >= 0:
+            zero_point = zero_point + (self.quant_min + self.quant_max + 1) // 2
+    else:
+        scale = torch.clamp((max_val - min_val) / qrange, min=1e-8)
+        zero_point = torch.round(min_val / scale).to(torch.int64).neg() + self.quant_min
+        zero_point = torch.clamp(zero_point, self.quant_min, self.quant_max)
+    return scale.reshape([1]), zero_point.reshape([1])
+)";
+
+  TorchQuantizer::TorchQuantizer(
+      const oatpp::Object<DTO::Quantization> &quant_dto,
+      std::shared_ptr<spdlog::logger> logger)
+      : _logger(logger)
+  {
+    _mode = quant_dto->mode;
+    _engine = quant_dto->engine;
+    _calibration_batches = quant_dto->calibration_batches;
+    if (_mode != "dynamic" && _mode != "static")
+      throw MLLibBadParamException("unknown quantization mode " + _mode);
+
+    at::QEngine qengine;
+    if (_engine == "fbgemm")
+      qengine = at::QEngine::FBGEMM;
+    else if (_engine == "qnnpack")
+      qengine = at::QEngine::QNNPACK;
+    else
+      throw MLLibBadParamException("unknown quantization engine " + _engine);
+    const auto &engines = at::globalContext().supportedQEngines();
+    if (std::find(engines.begin(), engines.end(), qengine) == engines.end())
+      throw MLLibBadParamException("quantization engine " + _engine
+                                   + " is not supported by libtorch");
+    // libtorch holds a single quantized engine for the whole process: the
+    // last quantized service created selects it for all of them
+    if (at::globalContext().qEngine() != qengine)
+      _logger->warn("switching process wide quantized engine to {}",
+                    _engine);
+    at::globalContext().setQEngine(qengine);
+    _logger->info("int8 {} quantization with {}", _mode, _engine);
+  }
+
+  torch::jit::Module
+  TorchQuantizer::make_observer(const std::string &name, c10::ScalarType dtype,
+                                bool symmetric, int64_t quant_min,
+                                int64_t quant_max, bool dynamic) const
+  {
+    torch::jit::Module observer("__torch__.dd.quantization." + name);
+    observer.register_attribute("training", c10::BoolType::get(), false);
+    // scalar types and qschemes are stored as ints in torchscript
+    observer.register_attribute("dtype", c10::IntType::get(),
+                                static_cast<int64_t>(dtype));
+    observer.register_attribute(
+        "qscheme", c10::IntType::get(),
+        static_cast<int64_t>(symmetric ? c10::kPerTensorSymmetric
+                                       : c10::kPerTensorAffine));
+    observer.register_attribute("symmetric", c10::BoolType::get(), symmetric);
+    observer.register_attribute("is_dynamic", c10::BoolType::get(), dynamic);
+    observer.register_attribute("quant_min", c10::IntType::get(), quant_min);
+    observer.register_attribute("quant_max", c10::IntType::get(), quant_max);
+    observer.register_buffer(
+        "min_val", torch::tensor(std::numeric_limits<float>::infinity()));
+    observer.register_buffer(
+        "max_val", torch::tensor(-std::numeric_limits<float>::infinity()));
+    observer.define(observer_src);
+    return observer;
+  }
+
+  torch::jit::Module
+  TorchQuantizer::prepare(const torch::jit::Module &module) const
+  {
+    if (!module.find_method("forward"))
+      throw MLLibBadParamException(
+          "quantization requires a traced model with a forward method");
+
+    torch::jit::Module float_module = module.clone();
+    float_module.eval();
+    float_module = torch::jit::FoldConvBatchNorm(float_module);
+
+    torch::jit::QuantType quant_type = is_static()
+                                           ? torch::jit::QuantType::STATIC
+                                           : torch::jit::QuantType::DYNAMIC;
+    // fbgemm activations use 7 bits to avoid overflows in vpmaddubsw
+    int64_t act_max = _engine == "fbgemm" ? 127 : 255;
+    torch::jit::QConfigDict qconfig_dict;
+    qconfig_dict[""] = std::make_tuple(
+        make_observer("ActivationObserver", c10::ScalarType::QUInt8, false, 0,
+                      act_max, !is_static()),
+        make_observer("WeightObserver", c10::ScalarType::QInt8, true, -128,
+                      127, false));
+    return torch::jit::InsertObservers(float_module, "forward", qconfig_dict,
+                                       true, quant_type);
+  }
+
+  torch::jit::Module
+  TorchQuantizer::convert(torch::jit::Module &observed) const
+  {
+    torch::jit::QuantType quant_type = is_static()
+                                           ? torch::jit::QuantType::STATIC
+                                           : torch::jit::QuantType::DYNAMIC;
+    torch::jit::Module quantized = torch::jit::InsertQuantDeQuant(
+        observed, "forward", true, false, quant_type);
+    return torch::jit::Finalize(quantized, quant_type, { "training" });
+  }
+}
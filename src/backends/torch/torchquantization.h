@@ -0,0 +1,97 @@
+/**
+ * DeepDetect
+ * Copyright (c) 2023 Jolibrain
+ *
+ * This file is part of deepdetect.
+ *
+ * deepdetect is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * deepdetect is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with deepdetect.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TORCH_QUANTIZATION_H
+#define TORCH_QUANTIZATION_H
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+#include <torch/torch.h>
+#include <torch/script.h>
+#pragma GCC diagnostic pop
+
+#include "dto/mllib.hpp"
+#include "dd_spdlog.h"
+
+namespace dd
+{
+  /**
+   * \brief post-training int8 quantization of traced (torchscript) modules
+   * for CPU inference, with torchscript graph mode quantization passes.
+   * Dynamic mode quantizes weights ahead of time and activations on the fly,
+   * static mode quantizes activations with ranges observed on calibration
+   * data.
+   */
+  class TorchQuantizer
+  {
+  public:
+    /**
+     * \brief checks quantization parameters and selects quantized engine
+     */
+    TorchQuantizer(const oatpp::Object<DTO::Quantization> &quant_dto,
+                   std::shared_ptr<spdlog::logger> logger);
+
+    /**
+     * \brief whether activations need calibration
+     */
+    bool is_static() const
+    {
+      return _mode == "static";
+    }
+
+    /**
+     * \brief quantized module file name in the model repository
+     */
+    std::string filename() const
+    {
+      return "quantized_" + _mode + "_" + _engine + ".qpt";
+    }
+
+    /**
+     * \brief copy of module with conv/bn folded and observers inserted, to
+     * be run over calibration data in static mode
+     */
+    torch::jit::Module prepare(const torch::jit::Module &module) const;
+
+    /**
+     * \brief replaces observed float operators with quantized operators and
+     * freezes the module
+     */
+    torch::jit::Module convert(torch::jit::Module &observed) const;
+
+  public:
+    std::string _mode = "dynamic";  /**< dynamic or static */
+    std::string _engine = "fbgemm"; /**< fbgemm (x86) or qnnpack (arm) */
+    int _calibration_batches = 10;  /**< static mode calibration batches */
+
+  private:
+    /**
+     * \brief min/max observer as a torchscript module, with the attributes
+     * expected by quantization passes
+     */
+    torch::jit::Module make_observer(const std::string &name,
+                                     c10::ScalarType dtype, bool symmetric,
+                                     int64_t quant_min, int64_t quant_max,
+                                     bool dynamic) const;
+
+    std::shared_ptr<spdlog::logger> _logger; /**< mllib logger */
+  };
+}
+#endif
@@ -278,8 +278,55 @@ namespace dd
       }
   }
 
+  void TorchSolver::set_amp(torch::Dtype amp_dtype)
+  {
+    _loss_scaling = amp_dtype == torch::kFloat16;
+    if (_loss_scaling && _sam)
+      throw MLLibBadParamException(
+          "SAM solver is not supported with fp16 mixed precision");
+    _loss_scale = DEFAULT_LOSS_SCALE;
+    _good_steps = 0;
+    if (_loss_scaling)
+      this->_logger->info("dynamic loss scaling, initial scale: {}",
+                          _loss_scale);
+  }
+
+  bool TorchSolver::unscale_grads()
+  {
+    std::vector<torch::Tensor> grads;
+    for (auto &p : _params)
+      if (p.grad().defined())
+        grads.push_back(p.grad());
+    if (grads.empty())
+      return true;
+    torch::Tensor found_inf
+        = torch::zeros({ 1 }, grads[0].options().dtype(torch::kFloat32));
+    torch::Tensor inv_scale = torch::full({ 1 }, 1.0 / _loss_scale,
+                                          found_inf.options());
+    at::_amp_foreach_non_finite_check_and_unscale_(grads, found_inf,
+                                                    inv_scale);
+    return found_inf.item<float>() == 0.0;
+  }
+
   void TorchSolver::real_step()
   {
+    if (_loss_scaling)
+      {
+        if (!unscale_grads())
+          {
+            _loss_scale /= 2.0;
+            _good_steps = 0;
+            this->_logger->info(
+                "inf/nan gradients, skipping step, loss scale: {}",
+                _loss_scale);
+            return;
+          }
+        if (++_good_steps == DEFAULT_LOSS_SCALE_GROWTH_INTERVAL)
+          {
+            _loss_scale *= 2.0;
+            _good_steps = 0;
+          }
+      }
     if (_clip)
       {
         if (_clip_value > 0.0)
@@ -35,6 +35,8 @@
 #define DEFAULT_CLIP_VALUE 5.0
 #define DEFAULT_CLIP_NORM 100.0
 #define DEFAULT_SAM_RHO 0.05
+#define DEFAULT_LOSS_SCALE 65536.0
+#define DEFAULT_LOSS_SCALE_GROWTH_INTERVAL 2000
 
 namespace dd
 {
@@ -97,6 +99,31 @@ namespace dd
      */
     void step();
 
+    /**
+     * \brief mixed precision training: parameters stay in fp32 and are the
+     * master weights updated by the optimizer, while forward runs under
+     * autocast to amp_dtype. With fp16, the loss is scaled dynamically to
+     * avoid gradients underflow, and steps with inf/nan gradients are
+     * skipped.
+     */
+    void set_amp(torch::Dtype amp_dtype);
+
+    /**
+     * \brief loss to call backward on, scaled if loss scaling is active
+     */
+    torch::Tensor scale_loss(const torch::Tensor &loss) const
+    {
+      return _loss_scaling ? loss * _loss_scale : loss;
+    }
+
+    /**
+     * \brief current loss scale, 1 if loss scaling is not active
+     */
+    double loss_scale() const
+    {
+      return _loss_scaling ? _loss_scale : 1.0;
+    }
+
     /**
      * \brief get base lr for logging purposes
      */
@@ -105,6 +132,14 @@ namespace dd
       return _base_lr;
     }
 
+    /**
+     * \brief whether solver uses SAM, ie does its own forward/backward
+     */
+    bool sam() const
+    {
+      return _sam;
+    }
+
     void eval()
     {
       swap_swa_sgd();
@@ -125,6 +160,12 @@ namespace dd
     void sam_first_step();
     void sam_second_step();
 
+    /**
+     * \brief divides gradients by loss scale
+     * \return false if some gradients are inf or nan
+     */
+    bool unscale_grads();
+
     void swap_swa_sgd()
     {
       if (_swa)
@@ -161,6 +202,10 @@ namespace dd
 
     bool _swa = false; /**< stochastic weights averaging 1803.05407 */
 
+    bool _loss_scaling = false; /**< dynamic loss scaling, for fp16 amp */
+    double _loss_scale = DEFAULT_LOSS_SCALE;
+    int _good_steps = 0; /**< steps since last loss scale update */
+
     TorchModule &_module;
     TorchLoss &_tloss;
     std::shared_ptr<spdlog::logger> _logger; /**< mllib logger. */
@@ -0,0 +1,113 @@
+/**
+ * DeepDetect
+ * Copyright (c) 2023 Jolibrain
+ *
+ * This file is part of deepdetect.
+ *
+ * deepdetect is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * deepdetect is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with deepdetect.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "torchstatecache.h"
+
+namespace dd
+{
+  TorchRNNStates
+  TorchStateCache::gather(const std::vector<std::string> &series)
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    evict(_now());
+    std::vector<const TorchRNNStates *> found(series.size(), nullptr);
+    const TorchRNNStates *ref = nullptr;
+    for (size_t i = 0; i < series.size(); ++i)
+      {
+        auto eit = _entries.find(series[i]);
+        if (eit == _entries.end())
+          continue;
+        found[i] = &(*eit).second._states;
+        ref = found[i];
+      }
+    TorchRNNStates states;
+    if (!ref)
+      return states;
+    for (auto &layer : *ref)
+      {
+        std::vector<torch::Tensor> h, c;
+        for (size_t i = 0; i < series.size(); ++i)
+          {
+            if (found[i])
+              {
+                const auto &s = found[i]->at(layer.first);
+                h.push_back(std::get<0>(s));
+                c.push_back(std::get<1>(s));
+              }
+            else
+              {
+                h.push_back(torch::zeros_like(std::get<0>(layer.second)));
+                c.push_back(torch::zeros_like(std::get<1>(layer.second)));
+              }
+          }
+        states[layer.first]
+            = std::make_tuple(torch::cat(h, 1), torch::cat(c, 1));
+      }
+    return states;
+  }
+
+  void TorchStateCache::scatter(const std::vector<std::string> &series,
+                                const TorchRNNStates &states)
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    Clock::time_point now = _now();
+    for (size_t i = 0; i < series.size(); ++i)
+      {
+        auto eit = _entries.find(series[i]);
+        if (eit == _entries.end())
+          {
+            _lru.push_front(series[i]);
+            eit = _entries.emplace(series[i], Entry()).first;
+            (*eit).second._lru = _lru.begin();
+          }
+        else
+          _lru.splice(_lru.begin(), _lru, (*eit).second._lru);
+        Entry &entry = (*eit).second;
+        entry._last_use = now;
+        // copies, so that batch states are not held
+        for (auto &layer : states)
+          entry._states[layer.first] = std::make_tuple(
+              std::get<0>(layer.second).narrow(1, i, 1).clone(),
+              std::get<1>(layer.second).narrow(1, i, 1).clone());
+      }
+    evict(now);
+  }
+
+  size_t TorchStateCache::size()
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _entries.size();
+  }
+
+  void TorchStateCache::evict(const Clock::time_point &now)
+  {
+    while (!_lru.empty())
+      {
+        auto eit = _entries.find(_lru.back());
+        bool expired
+            = _ttl > 0
+              && now - (*eit).second._last_use > std::chrono::seconds(_ttl);
+        if (!expired && _entries.size() <= _capacity)
+          break;
+        _entries.erase(eit);
+        _lru.pop_back();
+      }
+  }
+}
@@ -0,0 +1,111 @@
+/**
+ * DeepDetect
+ * Copyright (c) 2023 Jolibrain
+ *
+ * This file is part of deepdetect.
+ *
+ * deepdetect is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * deepdetect is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with deepdetect.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TORCH_STATE_CACHE_H
+#define TORCH_STATE_CACHE_H
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+#include <torch/torch.h>
+#pragma GCC diagnostic pop
+
+#include <chrono>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace dd
+{
+  /**
+   * \brief lstm (hidden, cell) states, per lstm layer name. Tensors are
+   * [num_layers, batch, hidden_size].
+   */
+  typedef std::unordered_map<std::string,
+                             std::tuple<torch::Tensor, torch::Tensor>>
+      TorchRNNStates;
+
+  /**
+   * \brief per series recurrent states kept between predict calls, so that a
+   * call only holds the new timesteps of its series. Series are evicted when
+   * not used for more than ttl seconds, or least recently used first when
+   * the cache is full.
+   */
+  class TorchStateCache
+  {
+  public:
+    typedef std::chrono::steady_clock Clock;
+
+    /**
+     * @param capacity max number of series
+     * @param ttl seconds a series is kept after its last use, none if <= 0
+     * @param now time source for expiry, e.g. a fake clock in tests
+     */
+    TorchStateCache(const size_t &capacity, const int &ttl,
+                    const std::function<Clock::time_point()> &now
+                    = Clock::now)
+        : _capacity(capacity), _ttl(ttl), _now(now)
+    {
+    }
+
+    /**
+     * \brief batch states of series, in batch order. Series with no state
+     * start from zero states.
+     * @return empty if no series has a state
+     */
+    TorchRNNStates gather(const std::vector<std::string> &series);
+
+    /**
+     * \brief stores states of series after a forward pass over the batch
+     * @param states batch states, in series order
+     */
+    void scatter(const std::vector<std::string> &series,
+                 const TorchRNNStates &states);
+
+    /**
+     * \brief number of series with a state
+     */
+    size_t size();
+
+  private:
+    struct Entry
+    {
+      TorchRNNStates _states;
+      Clock::time_point _last_use;
+      std::list<std::string>::iterator _lru; /**< position in _lru. */
+    };
+
+    /**
+     * \brief removes expired series, then least recently used ones above
+     * capacity
+     */
+    void evict(const Clock::time_point &now);
+
+    size_t _capacity = 1000;
+    int _ttl = 3600;
+    std::function<Clock::time_point()> _now;
+    std::unordered_map<std::string, Entry> _entries;
+    std::list<std::string> _lru; /**< most recently used first. */
+    std::mutex _mutex;
+  };
+}
+#endif
@@ -20,6 +20,10 @@
  */
 
 #include "torchutils.h"
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+#include <torch/csrc/autograd/profiler_kineto.h>
+#pragma GCC diagnostic pop
 #include "mllibstrategy.h"
 
 #include <google/protobuf/io/coded_stream.h>
@@ -59,6 +63,7 @@ namespace dd
                                      + value.tagKind());
       torch::Tensor t = value.toTensor();
       if (t.scalar_type() == torch::kFloat16
+          || t.scalar_type() == torch::kBFloat16
           || t.scalar_type() == torch::kFloat64)
         return t.to(torch::kFloat32);
       else
@@ -129,6 +134,134 @@ namespace dd
         }
     }
 
+    torch::Dtype amp_dtype(const std::string &amp, const torch::Device &device)
+    {
+      if (amp.empty() || amp == "none" || amp == "fp32")
+        return torch::kFloat32;
+      else if (amp == "bf16")
+        return torch::kBFloat16;
+      else if (amp == "fp16")
+        {
+          if (!device.is_cuda())
+            throw MLLibBadParamException(
+                "amp fp16 is only available on GPU, use bf16 on CPU");
+          return torch::kFloat16;
+        }
+      throw MLLibBadParamException("unknown amp mode " + amp);
+    }
+
+    AutocastGuard::AutocastGuard(const torch::Device &device,
+                                 torch::Dtype dtype)
+        : _enabled(dtype != torch::kFloat32), _cuda(device.is_cuda())
+    {
+      if (!_enabled)
+        return;
+      if (_cuda)
+        {
+          _prev_enabled = at::autocast::is_enabled();
+          _prev_dtype = at::autocast::get_autocast_gpu_dtype();
+          at::autocast::set_autocast_gpu_dtype(dtype);
+          at::autocast::set_enabled(true);
+        }
+      else
+        {
+          _prev_enabled = at::autocast::is_cpu_enabled();
+          _prev_dtype = at::autocast::get_autocast_cpu_dtype();
+          at::autocast::set_autocast_cpu_dtype(dtype);
+          at::autocast::set_cpu_enabled(true);
+        }
+      at::autocast::increment_nesting();
+    }
+
+    AutocastGuard::~AutocastGuard()
+    {
+      if (!_enabled)
+        return;
+      // casted weights are cached until leaving the outermost autocast
+      if (at::autocast::decrement_nesting() == 0)
+        at::autocast::clear_cache();
+      if (_cuda)
+        {
+          at::autocast::set_enabled(_prev_enabled);
+          at::autocast::set_autocast_gpu_dtype(_prev_dtype);
+        }
+      else
+        {
+          at::autocast::set_cpu_enabled(_prev_enabled);
+          at::autocast::set_autocast_cpu_dtype(_prev_dtype);
+        }
+    }
+
+    int64_t count_flops(const std::function<void()> &fn)
+    {
+      namespace prof = torch::profiler::impl;
+      prof::ProfilerConfig config(prof::ProfilerState::KINETO,
+                                  /*report_input_shapes=*/true,
+                                  /*profile_memory=*/false,
+                                  /*with_stack=*/false,
+                                  /*with_flops=*/true);
+      std::set<prof::ActivityType> activities{ prof::ActivityType::CPU };
+      torch::autograd::profiler::prepareProfiler(config, activities);
+      torch::autograd::profiler::enableProfiler(config, activities);
+      try
+        {
+          fn();
+        }
+      catch (...)
+        {
+          torch::autograd::profiler::disableProfiler();
+          throw;
+        }
+      auto result = torch::autograd::profiler::disableProfiler();
+      int64_t flops = 0;
+      for (const auto &e : result->events())
+        flops += e.flops();
+      return flops;
+    }
+
+    c10::IValue to_fp32(const c10::IValue &value)
+    {
+      if (value.isTensor())
+        {
+          torch::Tensor t = value.toTensor();
+          if (t.scalar_type() == torch::kFloat16
+              || t.scalar_type() == torch::kBFloat16)
+            return t.to(torch::kFloat32);
+          return t;
+        }
+      else if (value.isTensorList())
+        {
+          std::vector<torch::Tensor> elems;
+          for (const torch::Tensor &t : value.toTensorVector())
+            elems.push_back(to_fp32(t).toTensor());
+          return elems;
+        }
+      else if (value.isTuple())
+        {
+          std::vector<c10::IValue> elems;
+          for (const c10::IValue &e : value.toTuple()->elements())
+            elems.push_back(to_fp32(e));
+          return c10::ivalue::Tuple::create(std::move(elems));
+        }
+      else if (value.isGenericDict())
+        {
+          auto dict = value.toGenericDict();
+          c10::impl::GenericDict out(dict.keyType(), dict.valueType());
+          for (const auto &e : dict)
+            out.insert(e.key(), to_fp32(e.value()));
+          return out;
+        }
+      else if (value.isList())
+        {
+          auto list = value.toList();
+          c10::impl::GenericList out(list.elementType());
+          for (size_t i = 0; i < list.size(); ++i)
+            out.push_back(to_fp32(list.get(i)));
+          return out;
+        }
+      return value;
+    }
+
     template <typename FromParamsList>
     void
     copy_tensors(const FromParamsList &from_params,
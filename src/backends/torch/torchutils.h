@@ -33,6 +33,7 @@
 #pragma GCC diagnostic ignored "-Wunused-parameter"
 #include <torch/torch.h>
 #include <torch/script.h>
+#include <ATen/autocast_mode.h>
 #pragma GCC diagnostic pop
 
 #include <google/protobuf/message.h>
@@ -107,6 +108,45 @@ namespace dd
 
     std::vector<c10::IValue> unwrap_c10_vector(const c10::IValue &output);
 
+    /**
+     * \brief autocast dtype from `amp` api value: "bf16" (CPU & GPU) or
+     * "fp16" (GPU only). Returns kFloat32 if mixed precision is disabled ("",
+     * "none" or "fp32").
+     */
+    torch::Dtype amp_dtype(const std::string &amp,
+                           const torch::Device &device);
+
+    /**
+     * \brief enables autocast to a lower precision dtype on the device type
+     * for the lifetime of the guard. Autocast state is thread local, every
+     * thread running a forward pass needs its own guard. No-op if dtype is
+     * kFloat32.
+     */
+    class AutocastGuard
+    {
+    public:
+      AutocastGuard(const torch::Device &device, torch::Dtype dtype);
+      ~AutocastGuard();
+
+    private:
+      bool _enabled = false;
+      bool _cuda = false;
+      bool _prev_enabled = false; /**< state to restore */
+      at::ScalarType _prev_dtype = at::kFloat;
+    };
+
+    /**
+     * \brief floating point operations of the convolutions and matrix
+     * multiplications run by fn, as counted by the profiler
+     */
+    int64_t count_flops(const std::function<void()> &fn);
+
+    /**
+     * \brief recursively converts fp16 and bf16 tensors of a model output to
+     * fp32, e.g. after a forward pass under autocast
+     */
+    c10::IValue to_fp32(const c10::IValue &value);
+
     /** Copy weights from a torchscript module to a native module.
      * \param strict if false, some weights are allowed to mismatch, or be
      * missing in either copy source or copy destination. If true, an exception
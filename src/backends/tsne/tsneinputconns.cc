@@ -57,7 +57,7 @@ namespace dd
         throw;
       }
     _N = _txt.size();
-    _D = _vocab.size();
+    _D = _vocab->size();
     _X = dMatR::Zero(_N, _D);
     int i = 0;
     auto hit = _txt.begin();
@@ -71,8 +71,8 @@ namespace dd
             std::string key;
             double val;
             tbe->get_next_elt(key, val);
-            if ((wit = _vocab.find(key)) != _vocab.end())
-              _X(i, _vocab[key]._pos) = val;
+            if ((wit = _vocab->find(key)) != _vocab->end())
+              _X(i, (*wit).second._pos) = val;
           }
         ++i;
         ++hit;
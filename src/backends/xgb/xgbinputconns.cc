@@ -90,66 +90,87 @@ namespace dd
     return out;
   }
 
-  xgboost::DMatrix *
-  CSVXGBInputFileConn::create_from_mat(const std::vector<CSVline> &csvl)
+  xgboost::DMatrix *CSVXGBInputFileConn::create_from_lines(
+      const size_t &nrows,
+      const std::function<bool(std::string &, std::vector<double> &)>
+          &next_line)
   {
-    if (csvl.empty())
-      return nullptr;
     std::unique_ptr<xgboost::data::SimpleCSRSource> source(
         new xgboost::data::SimpleCSRSource());
     xgboost::data::SimpleCSRSource &mat = *source;
     bool nan_missing = xgboost::common::CheckNAN(_missing);
-    mat.info.num_row_ = csvl.size();
+    mat.info.num_row_ = nrows;
     mat.info.num_col_
         = feature_size() + 1; // XXX: +1 otherwise there's a mismatch in
                               // xgboost's simple_dmatrix.cc:151
-    auto hit = csvl.begin();
-    while (hit != csvl.end())
+    std::string id;
+    std::vector<double> v;
+    while (next_line(id, v))
       {
         long nelem = 0;
-        auto lit = _columns.begin();
-        for (int i = 0; i < (int)(*hit)._v.size(); i++)
+        for (int i = 0; i < (int)v.size(); i++)
           {
-            double v = (*hit)._v.at(i);
-            if (xgboost::common::CheckNAN(v) && !nan_missing)
-              throw InputConnectorBadParamException(
-                  "NaN value in input data matrix, and missing != NaN");
+            double val = v.at(i);
             std::vector<int>::iterator ipos;
             if (!_label_pos.empty()
                 && (ipos = std::find(_label_pos.begin(), _label_pos.end(), i))
                        != _label_pos.end())
               {
+                if (xgboost::common::CheckNAN(val))
+                  throw InputConnectorBadParamException(
+                      "NaN label in input data matrix");
                 int pos = std::distance(_label_pos.begin(), ipos);
-                mat.info.labels_.HostVector().push_back(v
+                mat.info.labels_.HostVector().push_back(val
                                                         + _label_offset[pos]);
               }
-            else if (i == _id_pos)
+            else if (i == _id_pos || xgboost::common::CheckNAN(val))
               {
-                ++lit;
+                // empty fields are NaN, left out of the row as missing
                 continue;
               }
-            else if (std::find(_label_pos.begin(), _label_pos.end(), i)
-                     == _label_pos.end())
+            else if (nan_missing || val != _missing)
               {
-                if (nan_missing || v != _missing)
-                  {
-                    mat.page_.data.HostVector().push_back(
-                        xgboost::Entry(i, v));
-                    ++nelem;
-                  }
+                mat.page_.data.HostVector().push_back(xgboost::Entry(i, val));
+                ++nelem;
               }
-            ++lit;
           }
         mat.page_.offset.HostVector().push_back(
             mat.page_.offset.HostVector().back() + nelem);
-        this->_ids.push_back((*hit)._str);
-        ++hit;
+        this->_ids.push_back(id);
       }
     mat.info.num_nonzero_ = mat.page_.data.HostVector().size();
     xgboost::DMatrix *out = xgboost::DMatrix::Create(std::move(source));
     return out;
   }
 
+  xgboost::DMatrix *CSVXGBInputFileConn::create_from_table(const CSVTable &table)
+  {
+    if (table.rows() == 0)
+      return nullptr;
+    size_t r = 0;
+    return create_from_lines(
+        table.rows(), [&](std::string &id, std::vector<double> &v) {
+          if (r == table.rows())
+            return false;
+          id = table._ids[r];
+          table.row(r, v);
+          ++r;
+          return true;
+        });
+  }
+
+  xgboost::DMatrix *CSVXGBInputFileConn::create_from_chunks(const int &test_id)
+  {
+    int nrows = test_id < 0 ? _chunks_lines : _tests_chunks_lines.at(test_id);
+    if (nrows == 0)
+      return nullptr;
+    CSVChunkReader reader = chunks_reader(test_id);
+    return create_from_lines(
+        nrows, [&](std::string &id, std::vector<double> &v) {
+          return next_chunk_line(reader, id, v);
+        });
+  }
+
   void CSVXGBInputFileConn::transform(const APIData &ad)
   {
     try
@@ -175,15 +196,33 @@ namespace dd
           }
       }
 
-    if (!_direct_csv)
+    if (!_direct_csv && !_chunks.empty())
       {
-        _m = std::shared_ptr<xgboost::DMatrix>(create_from_mat(_csvdata));
-        _csvdata.clear();
+        // streamed CSV, matrices are built chunk after chunk
+        if (_tests_chunks.size() > 1)
+          {
+            _logger->error(
+                "multiple test sets not supported by xgboost backend yet");
+            throw InputConnectorBadParamException(
+                "multiple test sets not supported by xgboost backend yet");
+          }
+        _m = std::shared_ptr<xgboost::DMatrix>(create_from_chunks());
+        if (!_tests_chunks.empty())
+          _mtest = std::shared_ptr<xgboost::DMatrix>(create_from_chunks(0));
+        remove_chunks();
         if (_m->Info().num_nonzero_ == 0)
           throw InputConnectorBadParamException(
               "no data could be found processing XGBoost CSV input");
+      }
+    else if (!_direct_csv)
+      {
+        _m = std::shared_ptr<xgboost::DMatrix>(create_from_table(_table));
+        _table.clear();
+        if (!_m || _m->Info().num_nonzero_ == 0)
+          throw InputConnectorBadParamException(
+              "no data could be found processing XGBoost CSV input");
         // MULTIPLE TEST SETS : we consider here only 1 test set
-        if (_csvdata_tests.size() > 1)
+        if (_tables_tests.size() > 1)
           {
             _logger->error(
                 "multiple test sets not supported by xgboost backend yet");
@@ -191,12 +230,11 @@ namespace dd
                 "multiple test sets not supported by xgboost backend yet");
           }
 
-        if (!_csvdata_tests.empty())
+        if (!_tables_tests.empty())
           {
             _mtest = std::shared_ptr<xgboost::DMatrix>(
-                create_from_mat(_csvdata_tests[0]));
-            _csvdata_tests[0].clear();
-            _csvdata_tests.clear();
+                create_from_table(_tables_tests[0]));
+            _tables_tests.clear();
           }
       }
     else
@@ -301,8 +339,8 @@ namespace dd
                                + "/model.fmap",
                            std::ios::binary);
         int nc = 0;
-        auto vit = this->_vocab.begin();
-        while (vit != this->_vocab.end())
+        auto vit = this->_vocab->begin();
+        while (vit != this->_vocab->end())
           {
             fmap << nc << "\t" << (*vit).first << "\tq\n";
             ++vit;
@@ -344,32 +382,21 @@ namespace dd
     mat.info.num_col_
         = feature_size() + 1; // XXX: +1 otherwise there's a mismatch in
                               // xgnoost's simple_dmatrix.cc:151
-    int nid = 0;
-    auto hit = txt.begin();
-    while (hit != txt.end())
-      {
-        long nelem = 0;
-        TxtBowEntry *tbe = static_cast<TxtBowEntry *>((*hit));
-        mat.info.labels_.HostVector().push_back(tbe->_target);
-        tbe->reset();
-        while (tbe->has_elt())
-          {
-            std::string key;
-            double v;
-            tbe->get_next_elt(key, v);
-            if (xgboost::common::CheckNAN(v) && !nan_missing)
-              throw InputConnectorBadParamException(
-                  "NaN value in input data matrix, and missing != NaN");
-            mat.page_.data.HostVector().push_back(
-                xgboost::Entry(_vocab[key]._pos, v));
-            ++nelem;
-          }
-        mat.page_.offset.HostVector().push_back(
-            mat.page_.offset.HostVector().back() + nelem);
-        this->_ids.push_back(std::to_string(nid));
-        ++nid;
-        ++hit;
-      }
+    CSRBatch csr;
+    to_csr(txt, csr);
+    for (float v : csr._values)
+      if (xgboost::common::CheckNAN(v) && !nan_missing)
+        throw InputConnectorBadParamException(
+            "NaN value in input data matrix, and missing != NaN");
+    mat.info.labels_.HostVector() = csr._labels;
+    auto &data = mat.page_.data.HostVector();
+    data.reserve(csr.nnz());
+    for (size_t i = 0; i < csr.nnz(); ++i)
+      data.push_back(xgboost::Entry(csr._indices[i], csr._values[i]));
+    auto &offset = mat.page_.offset.HostVector();
+    offset.insert(offset.end(), csr._indptr.begin() + 1, csr._indptr.end());
+    for (size_t nid = 0; nid < csr.rows(); ++nid)
+      this->_ids.push_back(std::to_string(nid));
     mat.info.num_nonzero_ = mat.page_.data.HostVector().size();
     xgboost::DMatrix *out = xgboost::DMatrix::Create(std::move(source));
     return out;
@@ -36,6 +36,8 @@
 #include <dmlc/build_config.h>
 #include <data/parser.h> // dmlc
 #include <xgboost/data.h>
+#include <functional>
+#include <limits>
 #pragma GCC diagnostic pop
 
 namespace dd
@@ -70,7 +72,8 @@ namespace dd
     }
 
     // parameters
-    float _missing; // = std::NAN; /**< represents missing values. */
+    float _missing = std::numeric_limits<
+        float>::quiet_NaN(); /**< represents missing values. */
   };
 
   class CSVXGBInputFileConn : public CSVInputFileConn, public XGBInputInterface
@@ -96,11 +99,41 @@ namespace dd
 
     void transform(const APIData &ad);
 
-    xgboost::DMatrix *create_from_mat(const std::vector<CSVline> &csvl);
+    /**
+     * \brief builds matrix from streamed CSV chunks
+     * @param test_id test set index, or -1 for training chunks
+     */
+    xgboost::DMatrix *create_from_chunks(const int &test_id = -1);
+
+    bool read_chunks() const override
+    {
+      return !_direct_csv;
+    }
+
+    bool columnar() const override
+    {
+      return !_direct_csv;
+    }
+
+    /**
+     * \brief builds matrix from a columnar table
+     */
+    xgboost::DMatrix *create_from_table(const CSVTable &table);
 
-  public:
     bool _direct_csv
         = false; /**< whether to use the xgboost built-in CSV reader. */
+
+  private:
+    /**
+     * \brief builds matrix from CSV lines
+     * @param nrows number of lines
+     * @param next_line fills up next line id and values, returns false once
+     *        all lines have been read
+     */
+    xgboost::DMatrix *create_from_lines(
+        const size_t &nrows,
+        const std::function<bool(std::string &, std::vector<double> &)>
+            &next_line);
   };
 
   class SVMXGBInputFileConn : public InputConnectorStrategy,
@@ -454,7 +454,7 @@ namespace dd
     TInputConnectorStrategy inputc(this->_inputc);
     APIData cad = ad;
 
-    this->_stats.transform_start();
+    auto transform_tstart = this->_stats.transform_start();
     try
       {
         inputc.transform(cad);
@@ -463,7 +463,7 @@ namespace dd
       {
         throw;
       }
-    this->_stats.transform_end();
+    this->_stats.transform_end(transform_tstart);
 
     // load existing model as needed
     if (!_learner)
@@ -21,8 +21,13 @@
 
 #include "csvinputfileconn.h"
 #include "utils/csv_parser.hpp"
+#include "utils/csv_block_parser.hpp"
 #include "utils/utils.hpp"
+#include <cstdio>
+#include <functional>
 #include <iomanip>
+#include <limits>
+#include <numeric>
 
 namespace dd
 {
@@ -70,12 +75,12 @@ namespace dd
         // scale on the fly in predict mode
         // in train mode, will be scaled into transform() after everything is
         // read
-        if (_cifc->_scale && !_cifc->_train)
+        if (_cifc->_scale && !_cifc->_train && !_cifc->columnar())
           _cifc->scale_vals(vals);
         if (!cid.empty())
           _cifc->add_train_csvline(cid, vals);
         else
-          _cifc->add_train_csvline(std::to_string(_cifc->_csvdata.size() + 1),
+          _cifc->add_train_csvline(std::to_string(_cifc->csv_rows() + 1),
                                    vals);
         ++l;
       }
@@ -83,18 +88,190 @@ namespace dd
     return 0;
   }
 
+  /*- CSVRunningStats -*/
+  void CSVRunningStats::add(const std::vector<double> &vals)
+  {
+    ++_count;
+    if (_count == 1)
+      {
+        _counts.assign(vals.size(), 0);
+        _min.assign(vals.size(), std::numeric_limits<double>::quiet_NaN());
+        _max = _min;
+        _mean.assign(vals.size(), 0.0);
+        _m2.assign(vals.size(), 0.0);
+      }
+    for (size_t j = 0; j < vals.size(); ++j)
+      {
+        const double v = vals[j];
+        if (std::isnan(v))
+          continue;
+        csv_update_bounds(v, _min[j], _max[j]);
+        const double delta = v - _mean[j];
+        _mean[j] += delta / ++_counts[j];
+        _m2[j] += delta * (v - _mean[j]);
+      }
+  }
+
+  void CSVRunningStats::merge(const CSVRunningStats &s)
+  {
+    if (s._count == 0)
+      return;
+    if (_count == 0)
+      {
+        *this = s;
+        return;
+      }
+    if (s._mean.size() != _mean.size())
+      throw InputConnectorBadParamException(
+          "cannot merge statistics over " + std::to_string(s._mean.size())
+          + " values with statistics over " + std::to_string(_mean.size())
+          + " values");
+    // pairwise update, Chan et al.
+    for (size_t j = 0; j < _mean.size(); ++j)
+      {
+        const double na = _counts[j];
+        const double nb = s._counts[j];
+        if (nb == 0)
+          continue;
+        csv_update_bounds(s._min[j], _min[j], _max[j]);
+        csv_update_bounds(s._max[j], _min[j], _max[j]);
+        const double n = na + nb;
+        const double delta = s._mean[j] - _mean[j];
+        _mean[j] += delta * nb / n;
+        _m2[j] += s._m2[j] + delta * delta * na * nb / n;
+        _counts[j] += s._counts[j];
+      }
+    _count += s._count;
+  }
+
+  std::vector<double> CSVRunningStats::variance() const
+  {
+    std::vector<double> variance(_m2.size(), 0.0);
+    for (size_t j = 0; j < _m2.size(); ++j)
+      if (_counts[j] > 0)
+        variance[j] = _m2[j] / _counts[j];
+    return variance;
+  }
+
+  /*- CSVChunkWriter -*/
+  void CSVChunkWriter::add(const std::string &id,
+                           const std::vector<double> &vals)
+  {
+    if (_ids.empty())
+      {
+        _ncols = vals.size();
+        _vals.reserve(_ncols * _chunk_size);
+      }
+    else if (vals.size() != _ncols)
+      throw InputConnectorBadParamException(
+          "CSV line " + id + " has " + std::to_string(vals.size())
+          + " values instead of " + std::to_string(_ncols));
+    _vals.insert(_vals.end(), vals.begin(), vals.end());
+    _ids.push_back(id);
+    ++_lines;
+    if (static_cast<int>(_ids.size()) >= _chunk_size)
+      flush();
+  }
+
+  void CSVChunkWriter::flush()
+  {
+    if (_ids.empty())
+      return;
+    std::string fname
+        = _prefix + "_" + std::to_string(_files.size()) + ".chunk";
+    std::ofstream out(fname, std::ios::binary);
+    if (!out.is_open())
+      throw InputConnectorBadParamException("failed opening chunk file "
+                                            + fname);
+    uint64_t nrows = _ids.size();
+    uint64_t ncols = _ncols;
+    out.write(reinterpret_cast<const char *>(&nrows), sizeof(nrows));
+    out.write(reinterpret_cast<const char *>(&ncols), sizeof(ncols));
+    std::vector<double> col(nrows);
+    for (size_t j = 0; j < _ncols; ++j)
+      {
+        for (size_t r = 0; r < nrows; ++r)
+          col[r] = _vals[r * _ncols + j];
+        out.write(reinterpret_cast<const char *>(col.data()),
+                  nrows * sizeof(double));
+      }
+    for (const std::string &id : _ids)
+      {
+        uint64_t len = id.size();
+        out.write(reinterpret_cast<const char *>(&len), sizeof(len));
+        out.write(id.data(), len);
+      }
+    if (!out.good())
+      throw InputConnectorBadParamException("failed writing chunk file "
+                                            + fname);
+    _files.push_back(fname);
+    _vals.clear();
+    _ids.clear();
+  }
+
+  /*- CSVChunkReader -*/
+  bool CSVChunkReader::load_chunk()
+  {
+    if (_next_file >= _files.size())
+      return false;
+    const std::string &fname = _files[_next_file++];
+    std::ifstream in(fname, std::ios::binary);
+    if (!in.is_open())
+      throw InputConnectorBadParamException("failed opening chunk file "
+                                            + fname);
+    uint64_t nrows = 0, ncols = 0;
+    in.read(reinterpret_cast<char *>(&nrows), sizeof(nrows));
+    in.read(reinterpret_cast<char *>(&ncols), sizeof(ncols));
+    _nrows = nrows;
+    _ncols = ncols;
+    _vals.resize(_nrows * _ncols);
+    in.read(reinterpret_cast<char *>(_vals.data()),
+            _vals.size() * sizeof(double));
+    _ids.resize(_nrows);
+    for (size_t r = 0; r < _nrows; ++r)
+      {
+        uint64_t len = 0;
+        in.read(reinterpret_cast<char *>(&len), sizeof(len));
+        _ids[r].resize(len);
+        in.read(&_ids[r][0], len);
+      }
+    if (!in.good())
+      throw InputConnectorBadParamException("failed reading chunk file "
+                                            + fname);
+    _order.resize(_nrows);
+    std::iota(_order.begin(), _order.end(), 0);
+    if (_g)
+      std::shuffle(_order.begin(), _order.end(), *_g);
+    _row = 0;
+    return true;
+  }
+
+  bool CSVChunkReader::next(std::string &id, std::vector<double> &vals)
+  {
+    while (_row >= _nrows)
+      if (!load_chunk())
+        return false;
+    const size_t r = _order[_row++];
+    id = _ids[r];
+    vals.resize(_ncols);
+    for (size_t j = 0; j < _ncols; ++j)
+      vals[j] = _vals[j * _nrows + r];
+    return true;
+  }
+
   /*- CSVInputFileConn -*/
   void CSVInputFileConn::update_category(const std::string &c,
                                          const std::string &val)
   {
-    std::unordered_map<std::string, CCategorical>::iterator hit;
-    if ((hit = _categoricals.find(c)) != _categoricals.end())
-      (*hit).second.add_cat(val);
+    std::unordered_map<std::string, CCategorical>::const_iterator hit;
+    if ((hit = _categoricals->find(c)) != _categoricals->end()
+        && (*hit).second.get_cat_num(val) < 0)
+      _categoricals.mut()[c].add_cat(val);
   }
 
   void CSVInputFileConn::update_columns()
   {
-    std::unordered_map<std::string, CCategorical>::iterator chit;
+    std::unordered_map<std::string, CCategorical>::const_iterator chit;
     auto lit = _columns.begin();
     std::list<std::string> ncolumns = _columns;
     auto nlit = ncolumns.begin();
@@ -102,7 +279,7 @@ namespace dd
       {
         if (is_category((*lit)))
           {
-            chit = _categoricals.find((*lit));
+            chit = _categoricals->find((*lit));
             auto hit = (*chit).second._vals.begin();
             while (hit != (*chit).second._vals.end())
               {
@@ -149,115 +326,170 @@ namespace dd
                                        std::string &column_id, int &nlines,
                                        const bool &test)
   {
-    std::string col;
-    std::unordered_set<int>::const_iterator hit;
-    std::stringstream sh(hline);
+    if (_line_parser.delim() != delim[0]
+        || _line_parser.quote() != _quote[0])
+      _line_parser = CSVBlockParser(delim[0], _quote[0]);
+    const char *p = hline.data();
+    const char *e = p + hline.size();
     int c = -1;
     auto lit = _columns.begin();
-    aria::csv::CsvParser parser = aria::csv::CsvParser(sh)
-                                      .delimiter(delim[0]) // default is ,
-                                      .quote(_quote[0]);   // default is"
-    for (auto &row : parser)
+    while (p < e)
       {
-        for (auto &col : row)
+        CSVBlockParser::Row row;
+        p = _line_parser.parse_record(p, e, row);
+        read_csv_row(row, vals, column_id, nlines, test, c, lit);
+      }
+    ++nlines;
+  }
+
+  void CSVInputFileConn::read_csv_fields(const std::vector<std::string> &row,
+                                         std::vector<double> &vals,
+                                         std::string &column_id, int &nlines,
+                                         const bool &test)
+  {
+    int c = -1;
+    auto lit = _columns.begin();
+    read_csv_row(row, vals, column_id, nlines, test, c, lit);
+    ++nlines;
+  }
+
+  int CSVInputFileConn::parse_csv_file(
+      const std::string &fname,
+      const std::function<void(const std::vector<std::string> &)> &f)
+  {
+    MappedFile csv_map(fname);
+    if (!csv_map.is_open())
+      throw InputConnectorBadParamException("cannot open file " + fname);
+    if (csv_map.size() == 0)
+      return 0;
+    CSVBlockParser parser = csv_parser();
+    CSVBlockParser::Row header;
+    const char *data = csv_map.data();
+    const char *end = data + csv_map.size();
+    const char *body = parser.parse_record(data, end, header);
+    return parser.parse(body, end - body, f);
+  }
+
+  void CSVInputFileConn::read_csv_row(const std::vector<std::string> &row,
+                                      std::vector<double> &vals,
+                                      std::string &column_id,
+                                      const int &nlines, const bool &test,
+                                      int &c,
+                                      std::list<std::string>::iterator &lit)
+  {
+    std::unordered_set<int>::const_iterator hit;
+    for (auto &col : row)
+      {
+        ++c;
+        std::string col_name;
+
+        // detect strings by looking for characters and for quotes
+        // convert to float unless it is string (ignore strings, aka
+        // categorical fields, for now)
+        if (!_columns.empty()) // in prediction mode, columns from header
+                               // are not mandatory
           {
-            ++c;
-            std::string col_name;
-
-            // detect strings by looking for characters and for quotes
-            // convert to float unless it is string (ignore strings, aka
-            // categorical fields, for now)
-            if (!_columns.empty()) // in prediction mode, columns from header
-                                   // are not mandatory
+            if ((hit = _ignored_columns_pos.find(c))
+                != _ignored_columns_pos.end())
               {
-                if ((hit = _ignored_columns_pos.find(c))
-                    != _ignored_columns_pos.end())
-                  {
-                    continue;
-                  }
-                col_name = (*lit);
-                if (_id_pos == c)
-                  {
-                    column_id = col;
-                  }
+                continue;
+              }
+            col_name = (*lit);
+            if (_id_pos == c)
+              {
+                column_id = col;
               }
-            try
+          }
+        try
+          {
+            double val = 0.0;
+            if (!col.empty())
               {
-                double val = 0.0;
-                if (!col.empty())
+                // one-hot vector encoding as required
+                if (!_columns.empty() && is_category(col_name))
                   {
-                    // one-hot vector encoding as required
-                    if (!_columns.empty() && is_category(col_name))
-                      {
-                        // - look up category
-                        std::unordered_map<std::string,
-                                           CCategorical>::const_iterator chit
-                            = _categoricals.find(col_name);
-                        int cnum = (*chit).second.get_cat_num(col);
-                        if (cnum < 0)
-                          {
-                            throw InputConnectorBadParamException(
-                                "unknown category " + col + " for variable "
-                                + col_name);
-                          }
-
-                        // - create one-hot vector
-                        int csize = (*chit).second._vals.size();
-                        std::vector<double> ohv = one_hot_vector(cnum, csize);
-                        vals.insert(vals.end(), ohv.begin(), ohv.end());
-                      }
-                    else
+                    // - look up category
+                    std::unordered_map<std::string,
+                                       CCategorical>::const_iterator chit
+                        = _categoricals->find(col_name);
+                    int cnum = (*chit).second.get_cat_num(col);
+                    if (cnum < 0)
                       {
-                        val = std::stod(col);
-                        vals.push_back(val);
+                        throw InputConnectorBadParamException(
+                            "unknown category " + col + " for variable "
+                            + col_name);
                       }
+
+                    // - create one-hot vector
+                    int csize = (*chit).second._vals.size();
+                    std::vector<double> ohv = one_hot_vector(cnum, csize);
+                    vals.insert(vals.end(), ohv.begin(), ohv.end());
+                  }
+                else
+                  {
+                    val = csv_stod(col);
+                    vals.push_back(val);
                   }
               }
-            catch (std::invalid_argument &e)
+            else if (columnar())
               {
-                // not a number, skip for now
-                if (column_id == col) // if id is string, replace with number /
-                  vals.push_back(c);
-                else if (std::find(_label_pos.begin(), _label_pos.end(), c)
-                         != _label_pos.end())
+                // missing value, kept in place, with a null one-hot vector
+                // for categorical variables
+                if (c == _id_pos)
+                  throw InputConnectorBadParamException(
+                      "line " + std::to_string(nlines) + ": empty id field");
+                if (std::find(_label_pos.begin(), _label_pos.end(), c)
+                    != _label_pos.end())
+                  throw InputConnectorBadParamException(
+                      "line " + std::to_string(nlines) + ": empty label "
+                      + col_name);
+                if (!_columns.empty() && is_category(col_name))
+                  vals.insert(vals.end(),
+                              _categoricals->at(col_name)._vals.size(), 0.0);
+                else
+                  vals.push_back(std::numeric_limits<double>::quiet_NaN());
+              }
+          }
+        catch (std::invalid_argument &e)
+          {
+            // not a number, skip for now
+            if (column_id == col) // if id is string, replace with number /
+              vals.push_back(c);
+            else if (std::find(_label_pos.begin(), _label_pos.end(), c)
+                     != _label_pos.end())
+              {
+                std::unordered_map<std::string, int>::iterator uit;
+                if ((uit = _hcorresp_r.find(col)) == _hcorresp_r.end())
                   {
-                    std::unordered_map<std::string, int>::iterator uit;
-                    if ((uit = _hcorresp_r.find(col)) == _hcorresp_r.end())
-                      {
-                        if (test)
-                          {
-                            throw InputConnectorBadParamException(
-                                "label " + col
-                                + " found in test set but not in train set");
-                          }
-                        int clsn = _hcorresp_r.size();
-                        vals.push_back(clsn);
-                        _hcorresp_r.insert(
-                            std::pair<std::string, int>(col, clsn));
-                        _hcorresp.insert(
-                            std::pair<int, std::string>(clsn, col));
-                      }
-                    else
+                    if (test)
                       {
-                        vals.push_back((*uit).second);
+                        throw InputConnectorBadParamException(
+                            "label " + col
+                            + " found in test set but not in train set");
                       }
+                    int clsn = _hcorresp_r.size();
+                    vals.push_back(clsn);
+                    _hcorresp_r.insert(std::pair<std::string, int>(col, clsn));
+                    _hcorresp.insert(std::pair<int, std::string>(clsn, col));
                   }
                 else
                   {
-                    _logger->error(
-                        "line {}: skipping column {} / not a number", nlines,
-                        col_name);
-                    _logger->error(hline);
-                    throw InputConnectorBadParamException(
-                        "column " + col_name
-                        + " is not a number, use categoricals or ignore "
-                          "parameters instead");
+                    vals.push_back((*uit).second);
                   }
               }
-            ++lit;
+            else
+              {
+                _logger->error("line {}: skipping column {} / not a number",
+                               nlines, col_name);
+                _logger->error(dd_utils::join(row, _delim[0]));
+                throw InputConnectorBadParamException(
+                    "column " + col_name
+                    + " is not a number, use categoricals or ignore "
+                      "parameters instead");
+              }
           }
+        ++lit;
       }
-    ++nlines;
   }
 
   void CSVInputFileConn::read_header(std::string &hline)
@@ -313,49 +545,34 @@ namespace dd
   void CSVInputFileConn::fillup_categoricals(std::ifstream &csv_file)
   {
     int l = 0;
+    csv_parser().parse(csv_file, [&](const CSVBlockParser::Row &row) {
+      auto hit = _columns.begin();
+      std::unordered_set<int>::const_iterator igit;
+      int cu = 0;
+      for (auto &col : row)
+        {
+          if (cu >= _detect_cols)
+            {
+              _logger->error("line {} has more columns than headers / this "
+                             "line: {} / header: {}",
+                             l, cu, _detect_cols);
+              _logger->error(dd_utils::join(row, _delim[0]));
+              throw InputConnectorBadParamException(
+                  "line has more columns than headers");
+            }
+          if ((igit = _ignored_columns_pos.find(cu))
+              != _ignored_columns_pos.end())
+            {
+              ++cu;
+              continue;
+            }
+          update_category((*hit), col);
+          ++hit;
+          ++cu;
+        }
+      ++l;
+    });
     std::string hline;
-    while (std::getline(csv_file, hline))
-      {
-        hline.erase(std::remove(hline.begin(), hline.end(), '\r'),
-                    hline.end());
-        std::vector<double> vals;
-        std::string cid;
-        std::string col;
-        auto hit = _columns.begin();
-        std::unordered_set<int>::const_iterator igit;
-        std::stringstream sh(hline);
-        int cu = 0;
-        // while (std::getline(sh, col, _delim[0]))
-        aria::csv::CsvParser parser = aria::csv::CsvParser(sh)
-                                          .delimiter(_delim[0]) // default is ,
-                                          .quote(_quote[0]);    // default is"
-        for (auto &row : parser)
-          {
-            for (auto &col : row)
-              {
-                if (cu >= _detect_cols)
-                  {
-                    _logger->error(
-                        "line {} has more columns than headers / this "
-                        "line: {} / header: {}",
-                        l, cu, _detect_cols);
-                    _logger->error(hline);
-                    throw InputConnectorBadParamException(
-                        "line has more columns than headers");
-                  }
-                if ((igit = _ignored_columns_pos.find(cu))
-                    != _ignored_columns_pos.end())
-                  {
-                    ++cu;
-                    continue;
-                  }
-                update_category((*hit), col);
-                ++hit;
-                ++cu;
-              }
-          }
-        ++l;
-      }
     csv_file.clear();
     csv_file.seekg(0, std::ios::beg);
     std::getline(csv_file, hline); // skip header line
@@ -365,23 +582,26 @@ namespace dd
   {
     int nlines = 0;
     std::string hline;
-    unsigned int nvals = 0;
-    while (std::getline(csv_file, hline))
-      {
-        hline.erase(std::remove(hline.begin(), hline.end(), '\r'),
-                    hline.end());
-        std::vector<double> vals;
-        std::string cid;
-        read_csv_line(hline, _delim, vals, cid, nlines, false);
-        nvals = vals.size();
-        if (nlines == 1)
-          _mean_vals = vals;
-        else
-          for (size_t j = 0; j < vals.size(); j++)
-            _mean_vals.at(j) += vals.at(j);
-      }
-    for (size_t j = 0; j < nvals; j++)
-      _mean_vals.at(j) /= nlines;
+    std::vector<int64_t> counts; // missing values are skipped
+    csv_parser().parse(csv_file, [&](const CSVBlockParser::Row &row) {
+      std::vector<double> vals;
+      std::string cid;
+      read_csv_fields(row, vals, cid, nlines, false);
+      if (nlines == 1)
+        {
+          _mean_vals.assign(vals.size(), 0.0);
+          counts.assign(vals.size(), 0);
+        }
+      for (size_t j = 0; j < vals.size(); j++)
+        if (!std::isnan(vals[j]))
+          {
+            _mean_vals.at(j) += vals[j];
+            ++counts.at(j);
+          }
+    });
+    for (size_t j = 0; j < counts.size(); j++)
+      if (counts[j] > 0)
+        _mean_vals.at(j) /= counts[j];
 
     csv_file.clear();
     csv_file.seekg(0, std::ios::beg);
@@ -395,26 +615,27 @@ namespace dd
   {
     int nlines = 0;
     std::string hline;
-    unsigned int nvals = 0;
+    unsigned int nvals = mean.size();
 
     _variance_vals.clear();
     _variance_vals.resize(mean.size(), 0.0);
-    while (std::getline(csv_file, hline))
-      {
-        hline.erase(std::remove(hline.begin(), hline.end(), '\r'),
-                    hline.end());
-        std::vector<double> vals;
-        std::string cid;
-        read_csv_line(hline, _delim, vals, cid, nlines, false);
+    std::vector<int64_t> counts(nvals, 0); // missing values are skipped
+    csv_parser().parse(csv_file, [&](const CSVBlockParser::Row &row) {
+      std::vector<double> vals;
+      std::string cid;
+      read_csv_fields(row, vals, cid, nlines, false);
 
-        for (size_t j = 0; j < vals.size(); j++)
-          _variance_vals.at(j)
-              += (vals.at(j) - mean.at(j)) * (vals.at(j) - mean.at(j));
-      }
+      for (size_t j = 0; j < vals.size(); j++)
+        if (!std::isnan(vals[j]))
+          {
+            _variance_vals.at(j)
+                += (vals[j] - mean.at(j)) * (vals[j] - mean.at(j));
+            ++counts.at(j);
+          }
+    });
     for (size_t j = 0; j < nvals; j++)
-      {
-        _variance_vals.at(j) /= nlines;
-      }
+      if (counts[j] > 0)
+        _variance_vals.at(j) /= counts[j];
 
     csv_file.clear();
     csv_file.seekg(0, std::ios::beg);
@@ -427,13 +648,15 @@ namespace dd
   {
     if (_min_vals.empty() && _max_vals.empty())
       if (_csvdata.size() > 0)
-        _min_vals = _max_vals = _csvdata.at(0)._v;
-    for (size_t i = 0; i < _csvdata.size(); ++i)
-      for (size_t j = 0; j < _csvdata.at(i)._v.size(); j++)
         {
-          _min_vals.at(j) = std::min(_csvdata.at(i)._v[j], _min_vals.at(j));
-          _max_vals.at(j) = std::max(_csvdata.at(i)._v[j], _max_vals.at(j));
+          _min_vals.assign(_csvdata.at(0)._v.size(),
+                           std::numeric_limits<double>::quiet_NaN());
+          _max_vals = _min_vals;
         }
+    for (size_t i = 0; i < _csvdata.size(); ++i)
+      for (size_t j = 0; j < _csvdata.at(i)._v.size(); j++)
+        csv_update_bounds(_csvdata.at(i)._v[j], _min_vals.at(j),
+                          _max_vals.at(j));
   }
 
   void CSVInputFileConn::find_mean()
@@ -442,56 +665,87 @@ namespace dd
       return;
     if (_csvdata.size() < 1)
       return;
-    _mean_vals = _csvdata.at(0)._v;
-    for (size_t i = 1; i < _csvdata.size(); ++i)
+    _mean_vals.assign(_csvdata.at(0)._v.size(), 0.0);
+    std::vector<int64_t> counts(_mean_vals.size(), 0);
+    for (size_t i = 0; i < _csvdata.size(); ++i)
       for (size_t j = 0; j < _csvdata.at(i)._v.size(); ++j)
-        _mean_vals.at(j) += _csvdata.at(i)._v.at(j);
-    for (size_t j = 0; j < _csvdata.at(0)._v.size(); ++j)
-      _mean_vals.at(j) /= _csvdata.size();
+        if (!std::isnan(_csvdata.at(i)._v[j]))
+          {
+            _mean_vals.at(j) += _csvdata.at(i)._v[j];
+            ++counts.at(j);
+          }
+    for (size_t j = 0; j < counts.size(); ++j)
+      if (counts[j] > 0)
+        _mean_vals.at(j) /= counts[j];
   }
 
   void CSVInputFileConn::find_variance()
   {
     _variance_vals.clear();
     _variance_vals.resize(_mean_vals.size(), 0.0);
+    std::vector<int64_t> counts(_mean_vals.size(), 0);
     for (size_t i = 0; i < _csvdata.size(); ++i)
       for (size_t j = 0; j < _csvdata.at(i)._v.size(); ++j)
-        _variance_vals.at(j) += (_csvdata.at(i)._v.at(j) - _mean_vals.at(j))
-                                * (_csvdata.at(i)._v.at(j) - _mean_vals.at(j));
-    for (size_t j = 0; j < _csvdata.at(0)._v.size(); ++j)
-      _variance_vals.at(j) /= _csvdata.size();
+        if (!std::isnan(_csvdata.at(i)._v[j]))
+          {
+            _variance_vals.at(j)
+                += (_csvdata.at(i)._v[j] - _mean_vals.at(j))
+                   * (_csvdata.at(i)._v[j] - _mean_vals.at(j));
+            ++counts.at(j);
+          }
+    for (size_t j = 0; j < counts.size(); ++j)
+      if (counts[j] > 0)
+        _variance_vals.at(j) /= counts[j];
   }
 
   void CSVInputFileConn::find_min_max(std::istream &csv_file)
   {
     int nlines = 0;
     std::string hline;
-    while (std::getline(csv_file, hline))
-      {
-        hline.erase(std::remove(hline.begin(), hline.end(), '\r'),
-                    hline.end());
-        std::vector<double> vals;
-        std::string cid;
-        read_csv_line(hline, _delim, vals, cid, nlines, false);
-        if (nlines == 1)
-          _min_vals = _max_vals = vals;
-        else
-          {
-            for (size_t j = 0; j < vals.size(); j++)
-              {
-                _min_vals.at(j) = std::min(vals.at(j), _min_vals.at(j));
-                _max_vals.at(j) = std::max(vals.at(j), _max_vals.at(j));
-              }
-          }
-      }
+    csv_parser().parse(csv_file, [&](const CSVBlockParser::Row &row) {
+      std::vector<double> vals;
+      std::string cid;
+      read_csv_fields(row, vals, cid, nlines, false);
+      if (nlines == 1)
+        {
+          _min_vals.assign(vals.size(),
+                           std::numeric_limits<double>::quiet_NaN());
+          _max_vals = _min_vals;
+        }
+      for (size_t j = 0; j < vals.size(); j++)
+        csv_update_bounds(vals[j], _min_vals.at(j), _max_vals.at(j));
+    });
     csv_file.clear();
     csv_file.seekg(0, std::ios::beg);
     std::getline(csv_file, hline); // skip header line
   }
 
+  int CSVInputFileConn::find_stats(std::istream &csv_file,
+                                   CSVRunningStats &stats)
+  {
+    int nlines = 0;
+    std::string hline;
+    csv_parser().parse(csv_file, [&](const CSVBlockParser::Row &row) {
+      std::vector<double> vals;
+      std::string cid;
+      read_csv_fields(row, vals, cid, nlines, false);
+      stats.add(vals);
+    });
+    csv_file.clear();
+    csv_file.seekg(0, std::ios::beg);
+    std::getline(csv_file, hline); // skip header line
+    return nlines;
+  }
+
   void CSVInputFileConn::read_csv(const std::string &fname,
                                   const bool &forbid_shuffle)
   {
+    if (_streaming && _train)
+      {
+        read_csv_stream(fname);
+        return;
+      }
+
     std::ifstream csv_file(fname, std::ios::binary);
     _logger->info("fname={} / open={}", fname, csv_file.is_open());
     if (!csv_file.is_open())
@@ -510,7 +764,7 @@ namespace dd
     // debug
 
     // categorical variables
-    if (_train && !_categoricals.empty())
+    if (_train && !_categoricals->empty())
       {
         fillup_categoricals(csv_file);
       }
@@ -530,33 +784,23 @@ namespace dd
       }
 
     // read data
-    while (std::getline(csv_file, hline))
-      {
-        hline.erase(std::remove(hline.begin(), hline.end(), '\r'),
-                    hline.end());
-        std::vector<double> vals;
-        std::string cid;
-        read_csv_line(hline, _delim, vals, cid, nlines, false);
-        if (_scale)
-          {
-            scale_vals(vals);
-          }
-        if (!_id.empty())
-          {
-            add_train_csvline(cid, vals);
-          }
-        else
-          add_train_csvline(std::to_string(nlines), vals);
-
-        // debug
-        /*std::cout << "csv data line #" << nlines << "= " << vals.size() <<
-          std::endl;
-          std::copy(vals.begin(),vals.end(),std::ostream_iterator<double>(std::cout,""));
-          std::cout << std::endl;*/
-        // debug
-      }
-    _logger->info("read {} lines from {}", nlines, fname);
     csv_file.close();
+    parse_csv_file(fname, [&](const std::vector<std::string> &row) {
+      std::vector<double> vals;
+      std::string cid;
+      read_csv_fields(row, vals, cid, nlines, false);
+      if (_scale && !columnar())
+        {
+          scale_vals(vals);
+        }
+      if (!_id.empty())
+        {
+          add_train_csvline(cid, vals);
+        }
+      else
+        add_train_csvline(std::to_string(nlines), vals);
+    });
+    _logger->info("read {} lines from {}", nlines, fname);
 
     // test file, if any.
     if (!_csv_test_fnames.empty())
@@ -565,56 +809,197 @@ namespace dd
         for (std::string csv_test_fname : _csv_test_fnames)
           {
             nlines = 0;
-            std::ifstream csv_test_file(csv_test_fname, std::ios::binary);
-            if (!csv_test_file.is_open())
-              throw InputConnectorBadParamException("cannot open test file "
-                                                    + fname);
-            std::getline(csv_test_file, hline); // skip header line
-            while (std::getline(csv_test_file, hline))
-              {
-                hline.erase(std::remove(hline.begin(), hline.end(), '\r'),
-                            hline.end());
-                std::vector<double> vals;
-                std::string cid;
-                read_csv_line(hline, _delim, vals, cid, nlines, true);
-                if (_scale)
-                  {
-                    scale_vals(vals);
-                  }
-                if (!_id.empty())
-                  add_test_csvline(test_set_id, cid, vals);
-                else
-                  add_test_csvline(test_set_id, std::to_string(nlines), vals);
-
-                // debug
-                /*std::cout << "csv test data line=";
-                  std::copy(vals.begin(),vals.end(),std::ostream_iterator<double>(std::cout,"
-                  ")); std::cout << std::endl;*/
-                // debug
-              }
+            parse_csv_file(
+                csv_test_fname, [&](const std::vector<std::string> &row) {
+                  std::vector<double> vals;
+                  std::string cid;
+                  read_csv_fields(row, vals, cid, nlines, true);
+                  if (_scale && !columnar())
+                    {
+                      scale_vals(vals);
+                    }
+                  if (!_id.empty())
+                    add_test_csvline(test_set_id, cid, vals);
+                  else
+                    add_test_csvline(test_set_id, std::to_string(nlines),
+                                     vals);
+                });
             _logger->info("read {} lines from {}", nlines,
                           _csv_test_fnames[test_set_id]);
-            csv_test_file.close();
             test_set_id++;
           }
       }
 
-    // shuffle before possible test data selection.
-    if (!forbid_shuffle)
-      shuffle_data(_csvdata);
+    if (columnar())
+      {
+        // columnar tables are scaled as a whole
+        if (_scale)
+          {
+            scale_table(_table);
+            for (CSVTable &table : _tables_tests)
+              scale_table(table);
+          }
+        if (!forbid_shuffle && _shuffle)
+          _table.shuffle(_g);
+        if (_csv_test_fnames.empty() && _test_split > 0)
+          {
+            _tables_tests.resize(1);
+            split_table(_table, _tables_tests[0]);
+            _logger->info("data split test size={} / remaining data size={}",
+                          _tables_tests[0].rows(), _table.rows());
+          }
+      }
+    else
+      {
+        // shuffle before possible test data selection.
+        if (!forbid_shuffle)
+          shuffle_data(_csvdata);
+
+        if (_csv_test_fnames.empty() && _test_split > 0)
+          {
+            std::vector<CSVline> testdata;
+            split_data(_csvdata, testdata);
+            _csvdata_tests.push_back(testdata);
+            _logger->info("data split test size={} / remaining data size={}",
+                          _csvdata_tests[0].size(), _csvdata.size());
+          }
+      }
+    if (!_ignored_columns.empty() || !_categoricals->empty())
+      update_columns();
+
+    write_corresp();
+  }
+
+  void CSVInputFileConn::read_csv_stream(const std::string &fname)
+  {
+    std::ifstream csv_file(fname, std::ios::binary);
+    _logger->info("fname={} / open={} / streaming", fname,
+                  csv_file.is_open());
+    if (!csv_file.is_open())
+      throw InputConnectorBadParamException("cannot open file " + fname);
+    std::string hline;
+    std::getline(csv_file, hline);
+    read_header(hline);
+
+    // categorical variables, requires a full pass
+    if (!_categoricals->empty())
+      fillup_categoricals(csv_file);
+
+    remove_chunks();
+    _chunks_lines = 0;
+    _tests_chunks_lines.clear();
+    std::string prefix = _model_repo.empty() ? std::string("csv_chunk")
+                                             : _model_repo + "/csv_chunk";
+    bool split = _csv_test_fnames.empty() && _test_split > 0.0;
+    std::bernoulli_distribution split_dist(split ? _test_split : 0.0);
+    CSVChunkWriter train_writer(prefix + "_train", _chunk_size);
+    CSVChunkWriter split_writer(prefix + "_test_0", _chunk_size);
+    CSVRunningStats stats;
 
-    if (_csv_test_fnames.empty() && _test_split > 0)
+    // single pass: parse, collect bounds and write chunks
+    csv_file.close();
+    auto read_rows = [&](const std::string &csv_fname, const bool &test,
+                         const std::function<void(const std::string &,
+                                                  const std::vector<double> &)>
+                             &sink) {
+      int nlines = 0;
+      parse_csv_file(csv_fname, [&](const std::vector<std::string> &row) {
+        std::vector<double> vals;
+        std::string cid;
+        read_csv_fields(row, vals, cid, nlines, test);
+        sink(_id.empty() ? std::to_string(nlines) : cid, vals);
+      });
+      return nlines;
+    };
+
+    int nlines = read_rows(
+        fname, false,
+        [&](const std::string &id, const std::vector<double> &vals) {
+          stats.add(vals);
+          if (split && split_dist(_g))
+            split_writer.add(id, vals);
+          else
+            train_writer.add(id, vals);
+        });
+    _logger->info("read {} lines from {}", nlines, fname);
+    train_writer.flush();
+    split_writer.flush();
+    _chunks = train_writer._files;
+    _chunks_lines = train_writer._lines;
+    if (split)
       {
-        std::vector<CSVline> testdata;
-        split_data(_csvdata, testdata);
-        _csvdata_tests.push_back(testdata);
+        _tests_chunks.push_back(split_writer._files);
+        _tests_chunks_lines.push_back(split_writer._lines);
         _logger->info("data split test size={} / remaining data size={}",
-                      _csvdata_tests[0].size(), _csvdata.size());
+                      split_writer._lines, train_writer._lines);
+      }
+
+    // test files, if any
+    for (size_t t = 0; t < _csv_test_fnames.size(); ++t)
+      {
+        CSVChunkWriter test_writer(prefix + "_test_" + std::to_string(t),
+                                   _chunk_size);
+        nlines = read_rows(
+            _csv_test_fnames[t], true,
+            [&](const std::string &id, const std::vector<double> &vals) {
+              test_writer.add(id, vals);
+            });
+        test_writer.flush();
+        _tests_chunks.push_back(test_writer._files);
+        _tests_chunks_lines.push_back(test_writer._lines);
+        _logger->info("read {} lines from {}", nlines, _csv_test_fnames[t]);
+      }
+
+    // scaling bounds, unless provided
+    if (_scale && _scale_type == MINMAX
+        && (_min_vals.empty() || _max_vals.empty()))
+      {
+        _min_vals = stats._min;
+        _max_vals = stats._max;
+      }
+    if (_scale && _scale_type == ZNORM
+        && (_mean_vals.empty() || _variance_vals.empty()))
+      {
+        _mean_vals = stats._mean;
+        _variance_vals = stats.variance();
       }
-    if (!_ignored_columns.empty() || !_categoricals.empty())
+
+    if (!_ignored_columns.empty() || !_categoricals->empty())
       update_columns();
 
-    // write corresp file
+    write_corresp();
+
+    // connectors that do not consume chunks directly get lines one by one
+    if (!read_chunks())
+      {
+        std::string id;
+        std::vector<double> vals;
+        CSVChunkReader reader = chunks_reader();
+        while (next_chunk_line(reader, id, vals))
+          add_train_csvline(id, vals);
+        for (size_t t = 0; t < _tests_chunks.size(); ++t)
+          {
+            CSVChunkReader test_reader = chunks_reader(t);
+            while (next_chunk_line(test_reader, id, vals))
+              add_test_csvline(t, id, vals);
+          }
+        remove_chunks();
+      }
+  }
+
+  void CSVInputFileConn::remove_chunks()
+  {
+    for (const std::string &f : _chunks)
+      remove(f.c_str());
+    _chunks.clear();
+    for (const std::vector<std::string> &files : _tests_chunks)
+      for (const std::string &f : files)
+        remove(f.c_str());
+    _tests_chunks.clear();
+  }
+
+  void CSVInputFileConn::write_corresp()
+  {
     std::ofstream correspf(_model_repo + "/" + _correspname, std::ios::binary);
     auto hit = _hcorresp.begin();
     while (hit != _hcorresp.end())
@@ -24,16 +24,35 @@
 
 #include "inputconnectorstrategy.h"
 #include "utils/fileops.hpp"
+#include "utils/shared_state.hpp"
+#include "utils/csv_block_parser.hpp"
+#include "csvtable.h"
 #include <fstream>
+#include <functional>
 #include <istream>
 #include <unordered_set>
 #include <algorithm>
+#include <cmath>
 #include <random>
 
 namespace dd
 {
   class CSVInputFileConn;
 
+  /**
+   * \brief widens [min_v,max_v] to v, missing values (NaN) are skipped and
+   *        bounds stay NaN until a value is seen
+   */
+  inline void csv_update_bounds(const double &v, double &min_v, double &max_v)
+  {
+    if (std::isnan(v))
+      return;
+    if (std::isnan(min_v) || v < min_v)
+      min_v = v;
+    if (std::isnan(max_v) || v > max_v)
+      max_v = v;
+  }
+
   /**
    * \brief fetched data element for CSV inputs
    */
@@ -79,6 +98,123 @@ namespace dd
     std::vector<double> _v; /**< csv line data */
   };
 
+  /**
+   * \brief per column statistics computed online in a single pass over the
+   *        data: min/max, and mean/variance with Welford's algorithm.
+   *        Missing values (NaN) are skipped, each column has its own count.
+   */
+  class CSVRunningStats
+  {
+  public:
+    /**
+     * \brief updates statistics with a data line
+     * @param vals line values, all lines are expected to have the same size
+     */
+    void add(const std::vector<double> &vals);
+
+    /**
+     * \brief merges statistics gathered over other lines
+     */
+    void merge(const CSVRunningStats &s);
+
+    /**
+     * \brief population variance, as used for znorm scaling
+     */
+    std::vector<double> variance() const;
+
+    int64_t _count = 0;            /**< number of lines */
+    std::vector<int64_t> _counts; /**< per column number of values */
+    std::vector<double> _min;
+    std::vector<double> _max;
+    std::vector<double> _mean;
+    std::vector<double> _m2; /**< sum of squared distances to the mean */
+  };
+
+  /**
+   * \brief writes CSV lines to disk as binary chunks of at most chunk_size
+   *        lines. In a chunk, values are stored column after column, then
+   *        line ids.
+   */
+  class CSVChunkWriter
+  {
+  public:
+    /**
+     * @param prefix chunk files are named prefix_<chunk number>.chunk
+     * @param chunk_size max number of lines per chunk
+     */
+    CSVChunkWriter(const std::string &prefix, const int &chunk_size)
+        : _prefix(prefix), _chunk_size(chunk_size)
+    {
+    }
+
+    ~CSVChunkWriter()
+    {
+    }
+
+    /**
+     * \brief adds a line, writes a chunk every chunk_size lines
+     */
+    void add(const std::string &id, const std::vector<double> &vals);
+
+    /**
+     * \brief writes pending lines as a last chunk
+     */
+    void flush();
+
+    std::vector<std::string> _files; /**< written chunk files. */
+    int _lines = 0;                  /**< total number of lines. */
+
+  private:
+    std::string _prefix;
+    int _chunk_size = 10000;
+    size_t _ncols = 0;
+    std::vector<double> _vals; /**< pending lines values, line by line */
+    std::vector<std::string> _ids;
+  };
+
+  /**
+   * \brief reads lines from chunk files, one chunk at a time, in order or
+   *        with chunks and lines within chunks shuffled
+   */
+  class CSVChunkReader
+  {
+  public:
+    CSVChunkReader(const std::vector<std::string> &files,
+                   std::mt19937 *g = nullptr)
+        : _files(files), _g(g)
+    {
+      if (_g)
+        std::shuffle(_files.begin(), _files.end(), *_g);
+    }
+
+    ~CSVChunkReader()
+    {
+    }
+
+    /**
+     * \brief reads next line
+     * @return false once all chunks have been read
+     */
+    bool next(std::string &id, std::vector<double> &vals);
+
+  private:
+    /**
+     * \brief loads next chunk in memory
+     * @return false if there is no chunk left
+     */
+    bool load_chunk();
+
+    std::vector<std::string> _files;
+    std::mt19937 *_g = nullptr; /**< shuffling generator, if any. */
+    size_t _next_file = 0;
+    size_t _nrows = 0;
+    size_t _ncols = 0;
+    std::vector<double> _vals; /**< current chunk, column after column */
+    std::vector<std::string> _ids;
+    std::vector<size_t> _order; /**< line reading order in chunk */
+    size_t _row = 0;
+  };
+
   /**
    * \brief Categorical values mapper.
    *        Categorical values are discrete sets that are converted to int
@@ -185,6 +321,16 @@ namespace dd
       if (ad_input.has("test_split"))
         _test_split = ad_input.get("test_split").get<double>();
 
+      if (ad_input.has("streaming"))
+        _streaming = ad_input.get("streaming").get<bool>();
+      if (ad_input.has("chunk_size"))
+        {
+          _chunk_size = ad_input.get("chunk_size").get<int>();
+          if (_chunk_size < 1)
+            throw InputConnectorBadParamException(
+                "chunk_size must be positive");
+        }
+
       // read categorical mapping, if any
       read_categoricals(ad_input);
 
@@ -261,7 +407,8 @@ namespace dd
           std::vector<std::string> vcats
               = ad_input.get("categoricals").get<std::vector<std::string>>();
           for (std::string v : vcats)
-            _categoricals.emplace(std::make_pair(v, CCategorical()));
+            if (!is_category(v))
+              _categoricals.mut().emplace(std::make_pair(v, CCategorical()));
         }
 
       // timeout
@@ -295,13 +442,19 @@ namespace dd
           for (std::string c : vcats)
             {
               APIData ad_cat = ad_cats.getobj(c);
-              CCategorical cc;
-              _categoricals.insert(std::make_pair(c, cc));
-              auto chit = _categoricals.find(c);
               std::vector<std::string> vcvals = ad_cat.list_keys();
+              // mapping is usually already known, e.g. at predict time
+              auto chit = _categoricals->find(c);
+              if (chit != _categoricals->end()
+                  && std::all_of(vcvals.begin(), vcvals.end(),
+                                 [&chit](const std::string &v) {
+                                   return (*chit).second.get_cat_num(v) >= 0;
+                                 }))
+                continue;
+              CCategorical &cc = _categoricals.mut()[c];
               for (std::string v : vcvals)
                 {
-                  (*chit).second.add_cat(v, ad_cat.get(v).get<int>());
+                  cc.add_cat(v, ad_cat.get(v).get<int>());
                 }
             }
         }
@@ -329,50 +482,119 @@ namespace dd
         {
           bool j_is_id
               = (_columns.empty() || _id.empty()) ? false : (*lit) == _id;
-          if (j_is_id)
-            {
-              ++lit;
-              continue;
-            }
-          if (_scale_type == MINMAX)
-            {
-              bool equal_bounds = (_max_vals.at(j) == _min_vals.at(j));
-              if (equal_bounds)
-                {
-                  ++lit;
-                  continue;
-                }
-            }
-          if (_dont_scale_labels)
-            {
-              bool j_is_label = false;
-              if (!_columns.empty()
-                  && std::find(_label_pos.begin(), _label_pos.end(), j)
-                         != _label_pos.end())
-                j_is_label = true;
-              if (j_is_label)
-                {
-                  ++lit;
-                  continue;
-                }
-            }
-          if (_scale_type == MINMAX)
+          double sub, div, add;
+          if (column_scaling(j, j_is_id, sub, div, add))
+            vals.at(j) = (vals.at(j) - sub) / div + add;
+          ++lit;
+        }
+    }
+
+    /**
+     * \brief sets up scaling of a columnar table, as scale_vals does for
+     *        lines
+     */
+    void scale_table(CSVTable &table)
+    {
+      const size_t width = table.width();
+      if ((_scale_type == MINMAX && width > _min_vals.size())
+          || (_scale_type == ZNORM && width > _mean_vals.size()))
+        throw InputConnectorBadParamException(
+            "number of values to scale (" + std::to_string(width)
+            + ") > number of scaling factors");
+      auto lit = _columns.begin();
+      for (size_t j = 0; j < width; j++)
+        {
+          bool j_is_id = (_columns.empty() || _id.empty()
+                          || lit == _columns.end())
+                             ? false
+                             : (*lit) == _id;
+          double sub, div, add;
+          if (column_scaling(j, j_is_id, sub, div, add))
+            table.set_scale(j, sub, div, add);
+          if (lit != _columns.end())
+            ++lit;
+        }
+    }
+
+    /**
+     * \brief computes scaling bounds from the columnar table, as
+     *        find_min_max(), find_mean() and find_variance() do from lines
+     */
+    void find_table_bounds()
+    {
+      if (_scale_type == MINMAX)
+        {
+          std::vector<double> min_vals, max_vals;
+          _table.min_max(min_vals, max_vals);
+          if (_min_vals.empty() && _max_vals.empty())
             {
-              vals.at(j) = (vals.at(j) - _min_vals.at(j))
-                           / (_max_vals.at(j) - _min_vals.at(j));
-              if (_scale_between_minus_half_and_half)
-                vals.at(j) = vals.at(j) - 0.5;
+              _min_vals = min_vals;
+              _max_vals = max_vals;
             }
-          else if (_scale_type == ZNORM)
+          else
+            for (size_t j = 0; j < min_vals.size(); ++j)
+              {
+                csv_update_bounds(min_vals[j], _min_vals.at(j),
+                                  _max_vals.at(j));
+                csv_update_bounds(max_vals[j], _min_vals.at(j),
+                                  _max_vals.at(j));
+              }
+        }
+      else if (_scale_type == ZNORM)
+        {
+          std::vector<double> mean_vals, variance_vals;
+          _table.mean_variance(mean_vals, variance_vals);
+          if (_mean_vals.empty())
+            _mean_vals = mean_vals;
+          // variance is around the scaling mean, that may be user provided
+          _variance_vals.resize(variance_vals.size());
+          for (size_t j = 0; j < variance_vals.size(); ++j)
             {
-              vals.at(j) = (vals.at(j) - _mean_vals.at(j))
-                           / (sqrt(_variance_vals.at(j)));
+              double d = mean_vals[j] - _mean_vals.at(j);
+              _variance_vals[j] = variance_vals[j] + d * d;
             }
-          else
-            throw InputConnectorBadParamException("unknwon scale type");
+        }
+    }
 
-          ++lit;
+    /**
+     * \brief scaling of value j of a CSV line, as (v - sub) / div + add
+     * @param j value index
+     * @param j_is_id whether value j is the line id
+     * @return false if value j is not to be scaled
+     */
+    bool column_scaling(const int &j, const bool &j_is_id, double &sub,
+                        double &div, double &add) const
+    {
+      if (j_is_id)
+        return false;
+      if (_scale_type == MINMAX)
+        {
+          bool equal_bounds = (_max_vals.at(j) == _min_vals.at(j));
+          if (equal_bounds)
+            return false;
+        }
+      if (_dont_scale_labels)
+        {
+          if (!_columns.empty()
+              && std::find(_label_pos.begin(), _label_pos.end(), j)
+                     != _label_pos.end())
+            return false;
+        }
+      if (_scale_type == MINMAX)
+        {
+          sub = _min_vals.at(j);
+          div = _max_vals.at(j) - _min_vals.at(j);
+          add = _scale_between_minus_half_and_half ? -0.5 : 0.0;
         }
+      else if (_scale_type == ZNORM)
+        {
+          sub = _mean_vals.at(j);
+          div = sqrt(_variance_vals.at(j));
+          add = 0.0;
+        }
+      else
+        throw InputConnectorBadParamException("unknwon scale type");
+      return true;
     }
 
     /**
@@ -397,6 +619,10 @@ namespace dd
                 throw InputConnectorBadParamException("unknown scale type: "
                                                       + stype);
             }
+          _user_min_vals = ad_input.has("min_vals");
+          _user_max_vals = ad_input.has("max_vals");
+          _user_mean_vals = ad_input.has("mean_vals");
+          _user_variance_vals = ad_input.has("variance_vals");
           if (_scale_type == MINMAX)
             {
               if (ad_input.has("min_vals"))
@@ -524,6 +750,26 @@ namespace dd
         }
     }
 
+    /**
+     * \brief uses _test_split value to split a columnar table
+     * @param table full dataset, in output reduced to size 1-_test_split
+     * @param table_test test dataset sink, in output of size _test_split
+     */
+    void split_table(CSVTable &table, CSVTable &table_test)
+    {
+      if (_test_split > 0.0)
+        table.split(std::floor(table.rows() * (1.0 - _test_split)),
+                    table_test);
+    }
+
+    /**
+     * \brief number of lines held in memory for training
+     */
+    size_t csv_rows() const
+    {
+      return columnar() ? _table.rows() : _csvdata.size();
+    }
+
     /**
      * \brief adds a CSV data value line to the training set
      * @param id
@@ -532,7 +778,10 @@ namespace dd
     virtual void add_train_csvline(const std::string &id,
                                    std::vector<double> &vals)
     {
-      _csvdata.emplace_back(id, std::move(vals));
+      if (columnar())
+        add_table_line(_table, id, vals);
+      else
+        _csvdata.emplace_back(id, std::move(vals));
     }
 
     /**
@@ -544,11 +793,59 @@ namespace dd
                                   const std::string &id,
                                   std::vector<double> &vals)
     {
+      if (columnar())
+        {
+          if (_tables_tests.size() <= test_set_id)
+            _tables_tests.resize(test_set_id + 1);
+          add_table_line(_tables_tests[test_set_id], id, vals);
+          return;
+        }
       if (_csvdata_tests.size() <= test_set_id)
         _csvdata_tests.resize(test_set_id + 1);
       _csvdata_tests[test_set_id].emplace_back(id, std::move(vals));
     }
 
+    /**
+     * \brief whether lines are stored in columnar tables (_table and
+     *        _tables_tests) instead of _csvdata and _csvdata_tests
+     */
+    virtual bool columnar() const
+    {
+      return false;
+    }
+
+    /**
+     * \brief adds a line to a columnar table, its layout is set from the
+     *        columns on first line
+     */
+    void add_table_line(CSVTable &table, const std::string &id,
+                        const std::vector<double> &vals)
+    {
+      if (!table.has_layout())
+        {
+          for (const std::string &col : _columns)
+            {
+              if (is_category(col))
+                table.add_categorical_column(
+                    _categoricals->at(col)._vals.size());
+              else
+                table.add_numerical_column();
+            }
+          if (table.width() != vals.size())
+            {
+              // columns are not known or already expanded
+              table = CSVTable();
+              for (size_t j = 0; j < vals.size(); ++j)
+                table.add_numerical_column();
+            }
+        }
+      if (!table.add_row(id, vals))
+        throw InputConnectorBadParamException(
+            "CSV line " + id + " has " + std::to_string(vals.size())
+            + " values that do not match the " + std::to_string(table.width())
+            + " expected values");
+    }
+
     /**
      * \brief input data transforms
      * @param ad APIData input object
@@ -599,7 +896,13 @@ namespace dd
                   ddcsv._ctype._adconf = ad_input;
                   ddcsv.read_element(_uris.at(i), this->_logger);
                 }
-              if (_scale)
+              if (_scale && columnar())
+                {
+                  find_table_bounds();
+                  serialize_bounds();
+                  scale_table(_table);
+                }
+              else if (_scale)
                 {
                   if (_scale_type == MINMAX)
                     {
@@ -619,19 +922,34 @@ namespace dd
                       scale_vals(_csvdata.at(j)._v);
                     }
                 }
-              shuffle_data(_csvdata);
-              if (_test_split > 0.0)
+              if (columnar())
+                {
+                  if (_shuffle)
+                    _table.shuffle(_g);
+                  if (_test_split > 0.0)
+                    {
+                      CSVTable table_split;
+                      split_table(_table, table_split);
+                      _tables_tests.insert(_tables_tests.begin(),
+                                           std::move(table_split));
+                    }
+                }
+              else
                 {
-                  std::vector<CSVline> testdata_split;
-                  split_data(_csvdata, testdata_split);
-                  // insert at first pos, so if user passses test sets + split,
-                  // splitted one is first
-                  _csvdata_tests.insert(_csvdata_tests.begin(),
-                                        testdata_split);
+                  shuffle_data(_csvdata);
+                  if (_test_split > 0.0)
+                    {
+                      std::vector<CSVline> testdata_split;
+                      split_data(_csvdata, testdata_split);
+                      // insert at first pos, so if user passses test sets +
+                      // split, splitted one is first
+                      _csvdata_tests.insert(_csvdata_tests.begin(),
+                                            testdata_split);
+                    }
                 }
               // std::cerr << "data split test size=" << _csvdata_test.size()
               // << " / remaining data size=" << _csvdata.size() << std::endl;
-              if (!_ignored_columns.empty() || !_categoricals.empty())
+              if (!_ignored_columns.empty() || !_categoricals->empty())
                 update_columns();
             }
         }
@@ -640,7 +958,7 @@ namespace dd
           for (size_t i = 0; i < _uris.size(); i++)
             {
               if (i == 0 && !fileops::file_exists(_uris.at(0))
-                  && (!_categoricals.empty()
+                  && (!_categoricals->empty()
                       || (ad_input.size() && !_id.empty()
                           && _uris.at(0).find(_delim)
                                  != std::string::
@@ -661,7 +979,11 @@ namespace dd
               ddcsv.read_element(_uris.at(i), this->_logger);
             }
         }
-      if (_csvdata.empty() && _db_fname.empty())
+      // lines are scaled on the fly in predict mode, or as a whole in
+      // columnar mode
+      if (!_train && _scale && columnar())
+        scale_table(_table);
+      if (csv_rows() == 0 && _chunks_lines == 0 && _db_fname.empty())
         throw InputConnectorBadParamException("no data could be found");
     }
 
@@ -692,6 +1014,49 @@ namespace dd
                        std::vector<double> &vals, std::string &column_id,
                        int &nlines, const bool &test);
 
+    /**
+     * \brief reads a parsed CSV line, fills up values and categorical
+     * variables as one-hot-vectors
+     * @param row CSV line fields
+     * @param vals vector to be filled up with CSV values
+     * @param column_id string to be filled up with the line id, if any
+     * @param nlines line counter, incremented
+     * @param test whether the line comes from a test file
+     */
+    void read_csv_fields(const std::vector<std::string> &row,
+                         std::vector<double> &vals, std::string &column_id,
+                         int &nlines, const bool &test);
+
+    /**
+     * \brief parser setup with the connector delimiter and quote
+     */
+    CSVBlockParser csv_parser() const
+    {
+      return CSVBlockParser(_delim[0], _quote[0]);
+    }
+
+    /**
+     * \brief maps a CSV file in memory, parses it in parallel and calls f on
+     * every line after the header, in file order
+     * @return number of lines
+     */
+    int parse_csv_file(
+        const std::string &fname,
+        const std::function<void(const std::vector<std::string> &)> &f);
+
+    /**
+     * \brief reads CSV row fields, fills up values and categorical variables
+     * as one-hot-vectors
+     * @param row CSV row fields
+     * @param c index of the last column read, updated
+     * @param lit iterator over _columns, updated
+     * @see read_csv_line
+     */
+    void read_csv_row(const std::vector<std::string> &row,
+                      std::vector<double> &vals, std::string &column_id,
+                      const int &nlines, const bool &test, int &c,
+                      std::list<std::string>::iterator &lit);
+
     /**
      * \brief reads a full CSV data file, calls read_csv_line
      * @param fname the CSV file name
@@ -700,13 +1065,67 @@ namespace dd
     void read_csv(const std::string &fname,
                   const bool &forbid_shuffle = false);
 
+    /**
+     * \brief reads a full CSV data file and its test files in a single pass
+     *        each, in constant memory: lines are written to chunk files on
+     *        disk while scaling bounds are computed online. Lines are scaled
+     *        when read back from chunks.
+     * @param fname the CSV file name
+     */
+    void read_csv_stream(const std::string &fname);
+
+    /**
+     * \brief whether the connector consumes data from chunks in streaming
+     *        mode. If not, lines are passed to add_train_csvline and
+     *        add_test_csvline once read.
+     */
+    virtual bool read_chunks() const
+    {
+      return false;
+    }
+
+    /**
+     * \brief reader over training (test_id < 0) or test chunks, shuffled
+     *        if requested
+     */
+    CSVChunkReader chunks_reader(const int &test_id = -1)
+    {
+      return CSVChunkReader(test_id < 0 ? _chunks : _tests_chunks.at(test_id),
+                            _shuffle && test_id < 0 ? &_g : nullptr);
+    }
+
+    /**
+     * \brief next line from chunks, scaled as required
+     * @return false once all lines have been read
+     */
+    bool next_chunk_line(CSVChunkReader &reader, std::string &id,
+                         std::vector<double> &vals)
+    {
+      if (!reader.next(id, vals))
+        return false;
+      if (_scale)
+        scale_vals(vals);
+      return true;
+    }
+
+    /**
+     * \brief removes chunk files from disk
+     */
+    void remove_chunks();
+
     int batch_size() const
     {
-      return _csvdata.size();
+      if (csv_rows() == 0)
+        return _chunks_lines;
+      return csv_rows();
     }
 
     int test_batch_size(unsigned int test_set_id) const
     {
+      if (test_set_id < _tests_chunks_lines.size())
+        return _tests_chunks_lines[test_set_id];
+      if (columnar())
+        return _tables_tests[test_set_id].rows();
       return _csvdata_tests[test_set_id].size();
     }
 
@@ -725,7 +1144,7 @@ namespace dd
     void response_params(APIData &out)
     {
       APIData adparams;
-      if (_scale || !_categoricals.empty())
+      if (_scale || !_categoricals->empty())
         {
           if (out.has("parameters"))
             {
@@ -754,11 +1173,11 @@ namespace dd
           else
             throw InputConnectorBadParamException("unknown scale type");
         }
-      if (!_categoricals.empty())
+      if (!_categoricals->empty())
         {
           APIData cats;
-          auto hit = _categoricals.begin();
-          while (hit != _categoricals.end())
+          auto hit = _categoricals->begin();
+          while (hit != _categoricals->end())
             {
               APIData adcat;
               auto chit = (*hit).second._vals.begin();
@@ -781,10 +1200,10 @@ namespace dd
      * @param c the CSV column
      * @return true if category, false otherwise
      */
-    bool is_category(const std::string &c)
+    bool is_category(const std::string &c) const
     {
       std::unordered_map<std::string, CCategorical>::const_iterator hit;
-      if ((hit = _categoricals.find(c)) != _categoricals.end())
+      if ((hit = _categoricals->find(c)) != _categoricals->end())
         return true;
       return false;
     }
@@ -869,6 +1288,15 @@ namespace dd
      */
     void find_min_max(std::istream &csv_file);
 
+    /**
+     * \brief gathers min/max/mean/variance of variables in one pass over a
+     *        CSV dataset
+     * @param csv_file CSV file stream
+     * @param stats statistics, updated with every line
+     * @return number of lines
+     */
+    int find_stats(std::istream &csv_file, CSVRunningStats &stats);
+
     /**
      * \brief removes min/max values for the CSV dataset variables
      */
@@ -921,6 +1349,8 @@ namespace dd
     std::unordered_map<std::string, int> _label_set;
     std::string _delim = ",";
     std::string _quote = "\"";
+    CSVBlockParser _line_parser; /**< single line parser, reset when the
+                                    delimiter or quote change */
     int _id_pos = -1;
     std::vector<int> _label_pos;    /**< column positions of the labels. */
     std::vector<int> _label_offset; /**< negative offset so that labels range
@@ -944,8 +1374,13 @@ namespace dd
     std::vector<double> _mean_vals; /**< mean used for auto-scaling data */
     std::vector<double>
         _variance_vals; /**< variance used for auto-scaling data */
+    bool _user_min_vals = false; /**< min_vals given as API parameter */
+    bool _user_max_vals = false; /**< max_vals given as API parameter */
+    bool _user_mean_vals = false; /**< mean_vals given as API parameter */
+    bool _user_variance_vals
+        = false; /**< variance_vals given as API parameter */
 
-    std::unordered_map<std::string, CCategorical>
+    SharedState<std::unordered_map<std::string, CCategorical>>
         _categoricals;       /**< auto-converted categorical variables */
     double _test_split = -1; /**< dataset test split ratio (optional). */
     int _detect_cols = -1;   /**< number of detected csv columns. */
@@ -957,10 +1392,27 @@ namespace dd
     std::string _boundsfname
         = "bounds.dat"; /**< variables min/max bounds filename. */
 
+    bool _streaming = false; /**< whether to read CSV files through disk
+                                chunks, in constant memory. */
+    int _chunk_size = 10000; /**< lines per chunk in streaming mode. */
+
     // data
     std::vector<CSVline> _csvdata;
     std::vector<std::vector<CSVline>> _csvdata_tests;
+    CSVTable _table; /**< training lines, in columnar mode. */
+    std::vector<CSVTable> _tables_tests; /**< test lines, in columnar mode. */
     std::string _db_fname;
+    std::vector<std::string> _chunks; /**< training chunk files. */
+    std::vector<std::vector<std::string>>
+        _tests_chunks;  /**< test chunk files, per test set. */
+    int _chunks_lines = 0; /**< lines in training chunks. */
+    std::vector<int> _tests_chunks_lines;
+
+  private:
+    /**
+     * \brief writes class number / class name correspondences to file
+     */
+    void write_corresp();
   };
 }
 
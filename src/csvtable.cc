@@ -0,0 +1,331 @@
+/**
+ * DeepDetect
+ * Copyright (c) 2023 Jolibrain
+ *
+ * This file is part of deepdetect.
+ *
+ * deepdetect is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * deepdetect is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with deepdetect.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "csvtable.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+
+namespace dd
+{
+  void CSVTable::Column::resize(const size_t &n)
+  {
+    if (_categorical)
+      _codes.resize(n);
+    else
+      _values.resize(n);
+    _valid.resize((n + 63) / 64);
+    if (n % 64)
+      _valid.back() &= (uint64_t(1) << (n % 64)) - 1;
+  }
+
+  CSVTable::Column CSVTable::Column::layout() const
+  {
+    Column col;
+    col._categorical = _categorical;
+    col._offset = _offset;
+    col._ncats = _ncats;
+    col._on = _on;
+    col._off = _off;
+    col._scaled = _scaled;
+    col._sub = _sub;
+    col._div = _div;
+    col._add = _add;
+    return col;
+  }
+
+  void CSVTable::add_numerical_column()
+  {
+    Column col;
+    col._offset = _col_of.size();
+    _col_of.push_back(_cols.size());
+    _cols.push_back(std::move(col));
+  }
+
+  void CSVTable::add_categorical_column(const int &ncats)
+  {
+    Column col;
+    col._categorical = true;
+    col._offset = _col_of.size();
+    col._ncats = ncats;
+    col._on.assign(ncats, 1.0);
+    col._off.assign(ncats, 0.0);
+    _col_of.insert(_col_of.end(), ncats, _cols.size());
+    _cols.push_back(std::move(col));
+  }
+
+  bool CSVTable::add_row(const std::string &id,
+                         const std::vector<double> &vals)
+  {
+    if (vals.size() != width())
+      return false;
+    // check categorical values first, so that a bad line leaves no trace
+    std::vector<int32_t> codes(_cols.size(), -1);
+    for (size_t c = 0; c < _cols.size(); ++c)
+      {
+        const Column &col = _cols[c];
+        if (!col._categorical)
+          continue;
+        for (int k = 0; k < col._ncats; ++k)
+          {
+            const double v = vals[col._offset + k];
+            if (v == 1.0 && codes[c] < 0)
+              codes[c] = k;
+            else if (v != 0.0)
+              return false;
+          }
+      }
+    const size_t r = rows();
+    for (size_t c = 0; c < _cols.size(); ++c)
+      {
+        Column &col = _cols[c];
+        if (col._categorical)
+          {
+            col._codes.push_back(codes[c]);
+            col.push_valid(r, codes[c] >= 0);
+          }
+        else
+          {
+            const double v = vals[col._offset];
+            col._values.push_back(v);
+            col.push_valid(r, !std::isnan(v));
+          }
+      }
+    _ids.push_back(id);
+    return true;
+  }
+
+  void CSVTable::row(const size_t &r, std::vector<double> &vals) const
+  {
+    vals.resize(width());
+    for (const Column &col : _cols)
+      {
+        if (col._categorical)
+          {
+            const int32_t code = col._codes[r];
+            for (int k = 0; k < col._ncats; ++k)
+              vals[col._offset + k] = k == code ? col._on[k] : col._off[k];
+          }
+        else if (col._scaled)
+          vals[col._offset] = (col._values[r] - col._sub) / col._div + col._add;
+        else
+          vals[col._offset] = col._values[r];
+      }
+  }
+
+  void CSVTable::min_max(std::vector<double> &min_vals,
+                         std::vector<double> &max_vals) const
+  {
+    const size_t n = rows();
+    min_vals.assign(width(), std::numeric_limits<double>::quiet_NaN());
+    max_vals.assign(width(), std::numeric_limits<double>::quiet_NaN());
+    for (const Column &col : _cols)
+      {
+        if (col._categorical)
+          {
+            std::vector<size_t> counts(col._ncats, 0);
+            for (size_t r = 0; r < n; ++r)
+              if (col._codes[r] >= 0)
+                ++counts[col._codes[r]];
+            for (int k = 0; k < col._ncats; ++k)
+              {
+                const double on = 1.0, off = 0.0;
+                size_t j = col._offset + k;
+                if (counts[k] == 0)
+                  min_vals[j] = max_vals[j] = off;
+                else if (counts[k] == n)
+                  min_vals[j] = max_vals[j] = on;
+                else
+                  {
+                    min_vals[j] = std::min(on, off);
+                    max_vals[j] = std::max(on, off);
+                  }
+              }
+            continue;
+          }
+        double mn = std::numeric_limits<double>::infinity();
+        double mx = -mn;
+        const double *v = col._values.data();
+        for (size_t r = 0; r < n; ++r)
+          if (!std::isnan(v[r]))
+            {
+              mn = std::min(mn, v[r]);
+              mx = std::max(mx, v[r]);
+            }
+        if (mn <= mx)
+          {
+            min_vals[col._offset] = mn;
+            max_vals[col._offset] = mx;
+          }
+      }
+  }
+
+  void CSVTable::mean_variance(std::vector<double> &mean_vals,
+                               std::vector<double> &variance_vals) const
+  {
+    const size_t n = rows();
+    mean_vals.assign(width(), 0.0);
+    variance_vals.assign(width(), 0.0);
+    if (n == 0)
+      return;
+    for (const Column &col : _cols)
+      {
+        if (col._categorical)
+          {
+            std::vector<size_t> counts(col._ncats, 0);
+            for (size_t r = 0; r < n; ++r)
+              if (col._codes[r] >= 0)
+                ++counts[col._codes[r]];
+            for (int k = 0; k < col._ncats; ++k)
+              {
+                const double p = static_cast<double>(counts[k]) / n;
+                size_t j = col._offset + k;
+                mean_vals[j] = p;
+                variance_vals[j] = p * (1.0 - p);
+              }
+            continue;
+          }
+        const double *v = col._values.data();
+        double sum = 0.0;
+        size_t nvalid = 0;
+        for (size_t r = 0; r < n; ++r)
+          if (!std::isnan(v[r]))
+            {
+              sum += v[r];
+              ++nvalid;
+            }
+        if (nvalid == 0)
+          continue;
+        const double mean = sum / nvalid;
+        double var = 0.0;
+        for (size_t r = 0; r < n; ++r)
+          if (!std::isnan(v[r]))
+            var += (v[r] - mean) * (v[r] - mean);
+        mean_vals[col._offset] = mean;
+        variance_vals[col._offset] = var / nvalid;
+      }
+  }
+
+  void CSVTable::set_scale(const size_t &j, const double &sub,
+                           const double &div, const double &add)
+  {
+    Column &col = _cols[_col_of.at(j)];
+    if (col._categorical)
+      {
+        const size_t k = j - col._offset;
+        col._on[k] = (1.0 - sub) / div + add;
+        col._off[k] = (0.0 - sub) / div + add;
+        return;
+      }
+    col._scaled = true;
+    col._sub = sub;
+    col._div = div;
+    col._add = add;
+  }
+
+  void CSVTable::permute(const std::vector<size_t> &order)
+  {
+    const size_t n = rows();
+    for (Column &col : _cols)
+      {
+        Column ncol;
+        ncol._categorical = col._categorical;
+        if (col._categorical)
+          ncol._codes.resize(n);
+        else
+          ncol._values.resize(n);
+        for (size_t r = 0; r < n; ++r)
+          {
+            const size_t s = order[r];
+            if (col._categorical)
+              ncol._codes[r] = col._codes[s];
+            else
+              ncol._values[r] = col._values[s];
+            ncol.push_valid(r, col.valid(s));
+          }
+        col._codes.swap(ncol._codes);
+        col._values.swap(ncol._values);
+        col._valid.swap(ncol._valid);
+      }
+    std::vector<std::string> ids(n);
+    for (size_t r = 0; r < n; ++r)
+      ids[r] = std::move(_ids[order[r]]);
+    _ids.swap(ids);
+  }
+
+  void CSVTable::shuffle(std::mt19937 &g)
+  {
+    std::vector<size_t> order(rows());
+    std::iota(order.begin(), order.end(), 0);
+    std::shuffle(order.begin(), order.end(), g);
+    permute(order);
+  }
+
+  void CSVTable::split(const size_t &n, CSVTable &tail)
+  {
+    if (!tail.has_layout())
+      {
+        for (const Column &col : _cols)
+          tail._cols.push_back(col.layout());
+        tail._col_of = _col_of;
+      }
+    const size_t nrows = rows();
+    for (size_t c = 0; c < _cols.size(); ++c)
+      {
+        Column &col = _cols[c];
+        Column &tcol = tail._cols.at(c);
+        size_t tr = tail.rows();
+        for (size_t r = n; r < nrows; ++r, ++tr)
+          {
+            if (col._categorical)
+              tcol._codes.push_back(col._codes[r]);
+            else
+              tcol._values.push_back(col._values[r]);
+            tcol.push_valid(tr, col.valid(r));
+          }
+        col.resize(std::min(n, nrows));
+      }
+    for (size_t r = n; r < nrows; ++r)
+      tail._ids.push_back(std::move(_ids[r]));
+    _ids.resize(std::min(n, nrows));
+  }
+
+  void CSVTable::clear()
+  {
+    for (Column &col : _cols)
+      {
+        col._values.clear();
+        col._codes.clear();
+        col._valid.clear();
+      }
+    _ids.clear();
+  }
+
+  size_t CSVTable::memory() const
+  {
+    size_t m = 0;
+    for (const Column &col : _cols)
+      m += col._values.size() * sizeof(double)
+           + col._codes.size() * sizeof(int32_t)
+           + col._valid.size() * sizeof(uint64_t);
+    return m;
+  }
+}
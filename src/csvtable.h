@@ -0,0 +1,187 @@
+/**
+ * DeepDetect
+ * Copyright (c) 2023 Jolibrain
+ *
+ * This file is part of deepdetect.
+ *
+ * deepdetect is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * deepdetect is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with deepdetect.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CSVTABLE_H
+#define CSVTABLE_H
+
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace dd
+{
+  /**
+   * \brief columnar storage of CSV lines. Lines come in and go out in their
+   * expanded form, i.e. with categorical variables as one-hot vectors, but
+   * are stored per column: numerical columns as contiguous values,
+   * categorical columns as one category index per line. Each column has a
+   * validity bitmap, missing values being NaN once expanded, or a null
+   * one-hot vector for categorical columns.
+   */
+  class CSVTable
+  {
+  public:
+    CSVTable()
+    {
+    }
+
+    ~CSVTable()
+    {
+    }
+
+    /**
+     * \brief appends a numerical column to the layout
+     */
+    void add_numerical_column();
+
+    /**
+     * \brief appends a categorical column to the layout
+     * @param ncats number of categories, i.e. one-hot vector size
+     */
+    void add_categorical_column(const int &ncats);
+
+    /**
+     * \brief whether a layout has been set
+     */
+    bool has_layout() const
+    {
+      return !_cols.empty();
+    }
+
+    /**
+     * \brief number of lines
+     */
+    size_t rows() const
+    {
+      return _ids.size();
+    }
+
+    /**
+     * \brief number of values in an expanded line
+     */
+    size_t width() const
+    {
+      return _col_of.size();
+    }
+
+    /**
+     * \brief appends an expanded line
+     * @return false if the line does not fit the layout
+     */
+    bool add_row(const std::string &id, const std::vector<double> &vals);
+
+    /**
+     * \brief expands line r into vals
+     */
+    void row(const size_t &r, std::vector<double> &vals) const;
+
+    /**
+     * \brief per expanded value min and max over valid unscaled values
+     */
+    void min_max(std::vector<double> &min_vals,
+                 std::vector<double> &max_vals) const;
+
+    /**
+     * \brief per expanded value mean and population variance over valid
+     * unscaled values
+     */
+    void mean_variance(std::vector<double> &mean_vals,
+                       std::vector<double> &variance_vals) const;
+
+    /**
+     * \brief sets scaling of expanded value j to (v - sub) / div + add.
+     * Values are stored unscaled and scaled when lines are expanded, so
+     * that scaling is set once per column, whatever the number of lines.
+     */
+    void set_scale(const size_t &j, const double &sub, const double &div,
+                   const double &add);
+
+    /**
+     * \brief reorders lines, line r becomes line order[r]
+     */
+    void permute(const std::vector<size_t> &order);
+
+    /**
+     * \brief shuffles lines
+     */
+    void shuffle(std::mt19937 &g);
+
+    /**
+     * \brief moves lines from index n onward to the end of tail, which gets
+     * this layout if it has none
+     */
+    void split(const size_t &n, CSVTable &tail);
+
+    /**
+     * \brief removes lines, keeps layout
+     */
+    void clear();
+
+    /**
+     * \brief approximate memory held by the data, in bytes
+     */
+    size_t memory() const;
+
+    std::vector<std::string> _ids; /**< line ids. */
+
+  private:
+    struct Column
+    {
+      bool _categorical = false;
+      size_t _offset = 0; /**< first expanded value index. */
+      int _ncats = 1;
+      std::vector<double> _values; /**< numerical values. */
+      std::vector<int32_t> _codes; /**< category indices, -1 if missing. */
+      std::vector<double> _on;  /**< scaled one-hot value of set category. */
+      std::vector<double> _off; /**< scaled one-hot value of others. */
+      bool _scaled = false;     /**< whether numerical values are scaled. */
+      double _sub = 0.0;
+      double _div = 1.0;
+      double _add = 0.0;
+      std::vector<uint64_t> _valid; /**< validity bitmap. */
+
+      bool valid(const size_t &r) const
+      {
+        return (_valid[r >> 6] >> (r & 63)) & 1;
+      }
+
+      void push_valid(const size_t &r, const bool &v)
+      {
+        if ((r & 63) == 0)
+          _valid.push_back(0);
+        if (v)
+          _valid[r >> 6] |= uint64_t(1) << (r & 63);
+      }
+
+      void resize(const size_t &n);
+
+      /**
+       * \brief same column with no lines
+       */
+      Column layout() const;
+    };
+
+    std::vector<Column> _cols;
+    std::vector<int> _col_of; /**< column of expanded value j. */
+  };
+}
+
+#endif
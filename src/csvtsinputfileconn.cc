@@ -21,6 +21,7 @@
 
 #include "csvtsinputfileconn.h"
 #include "utils/utils.hpp"
+#include <iomanip>
 
 namespace dd
 {
@@ -127,7 +128,7 @@ namespace dd
 
     //- read categoricals first if any as it affects the number of columns (and
     // thus bounds)
-    if (!_cifc->_categoricals.empty())
+    if (!_cifc->_categoricals->empty())
       {
         std::unordered_map<std::string, CCategorical> categoricals;
         for (auto fname : allfiles)
@@ -145,73 +146,56 @@ namespace dd
           }
       }
 
-    //- read bounds across all TS CSV files
+    //- read bounds across all TS CSV files, from per file statistics so
+    // that only files new or modified since last training are scanned
     if (_cifc->_scale)
       {
-        if (_cifc->_scale_type == MINMAX
-            && (_cifc->_min_vals.empty() || _cifc->_max_vals.empty()))
+        // bounds from a previous training are refreshed, bounds given as
+        // API parameters are kept as is
+        bool has_stats = _cifc->_train && _cifc->deserialize_file_stats();
+        bool fill_min = false, fill_max = false;
+        bool fill_mean = false, fill_variance = false;
+        if (_cifc->_scale_type == MINMAX)
           {
-            std::vector<double> min_vals(_cifc->_min_vals);
-            std::vector<double> max_vals(_cifc->_max_vals);
-            for (auto fname : allfiles)
-              {
-                csv_file = std::ifstream(fname, std::ios::binary);
-                if (!csv_file.is_open())
-                  throw InputConnectorBadParamException("cannot open file "
-                                                        + fname);
-                std::string hline;
-                std::getline(csv_file, hline); // skip header
-
-                //- read bounds min/max
-                _cifc->_min_vals.clear();
-                _cifc->_max_vals.clear();
-                _cifc->find_min_max(csv_file);
-                _cifc->merge_min_max(min_vals, max_vals);
-              }
-
-            //- update global bounds
-            _cifc->_min_vals = min_vals;
-            _cifc->_max_vals = max_vals;
-            _cifc->serialize_bounds();
+            fill_min = !_cifc->_user_min_vals
+                       && (has_stats || _cifc->_min_vals.empty());
+            fill_max = !_cifc->_user_max_vals
+                       && (has_stats || _cifc->_max_vals.empty());
           }
-        if (_cifc->_scale_type == ZNORM
-            && (_cifc->_mean_vals.empty() || _cifc->_variance_vals.empty()))
+        else if (_cifc->_scale_type == ZNORM)
           {
-            std::vector<double> mean_vals(_cifc->_min_vals.size(), 0.0);
-            std::vector<double> variance_vals(_cifc->_max_vals.size(), 0.0);
-            float running_weight = 0;
+            fill_mean = !_cifc->_user_mean_vals
+                        && (has_stats || _cifc->_mean_vals.empty());
+            fill_variance = !_cifc->_user_variance_vals
+                            && (has_stats || _cifc->_variance_vals.empty());
+          }
+        if (fill_min || fill_max || fill_mean || fill_variance)
+          {
+            CSVRunningStats stats;
             for (auto fname : allfiles)
-              {
-                csv_file = std::ifstream(fname, std::ios::binary);
-                if (!csv_file.is_open())
-                  throw InputConnectorBadParamException("cannot open file "
-                                                        + fname);
-                std::string hline;
-                std::getline(csv_file, hline); // skip header
+              stats.merge(_cifc->file_stats(fname));
 
-                float weight = (float)_cifc->find_mean(csv_file);
-
-                running_weight
-                    = _cifc->merge_mean(mean_vals, running_weight, weight);
-              }
-            for (auto fname : allfiles)
+            // forget about removed files
+            for (auto fit = _cifc->_file_stats.begin();
+                 fit != _cifc->_file_stats.end();)
               {
-                csv_file = std::ifstream(fname, std::ios::binary);
-                if (!csv_file.is_open())
-                  throw InputConnectorBadParamException("cannot open file "
-                                                        + fname);
-                std::string hline;
-                std::getline(csv_file, hline); // skip header
-
-                float weight
-                    = (float)_cifc->find_variance(csv_file, mean_vals);
-
-                running_weight = _cifc->merge_variance(variance_vals,
-                                                       running_weight, weight);
+                if (allfiles.find((*fit).first) == allfiles.end())
+                  fit = _cifc->_file_stats.erase(fit);
+                else
+                  ++fit;
               }
+            if (_cifc->_train)
+              _cifc->serialize_file_stats();
 
-            _cifc->_mean_vals = mean_vals;
-            _cifc->_variance_vals = variance_vals;
+            //- update global bounds
+            if (fill_min)
+              _cifc->_min_vals = stats._min;
+            if (fill_max)
+              _cifc->_max_vals = stats._max;
+            if (fill_mean)
+              _cifc->_mean_vals = stats._mean;
+            if (fill_variance)
+              _cifc->_variance_vals = stats.variance();
             _cifc->serialize_bounds();
           }
       }
@@ -355,7 +339,7 @@ namespace dd
   void CSVTSInputFileConn::response_params(APIData &out)
   {
     APIData adparams;
-    if (_scale || !_categoricals.empty())
+    if (_scale || !_categoricals->empty())
       {
         if (out.has("parameters"))
           {
@@ -437,12 +421,164 @@ namespace dd
       }
   }
 
+  const CSVRunningStats &
+  CSVTSInputFileConn::file_stats(const std::string &fname)
+  {
+    // seconds alone miss quick rewrites, size catches most of them
+    long int size = -1;
+    long long mtime = -1;
+    bool has_stat = fileops::file_size_modif(fname, size, mtime);
+    auto fit = _file_stats.find(fname);
+    if (fit != _file_stats.end() && has_stat && (*fit).second._size == size
+        && (*fit).second._mtime == mtime)
+      return (*fit).second._stats;
+
+    std::ifstream csv_file(fname, std::ios::binary);
+    if (!csv_file.is_open())
+      throw InputConnectorBadParamException("cannot open file " + fname);
+    std::string hline;
+    std::getline(csv_file, hline); // skip header
+    CSVFileStats &fstats = _file_stats[fname];
+    fstats._size = has_stat ? size : -1;
+    fstats._mtime = has_stat ? mtime : -1;
+    fstats._stats = CSVRunningStats();
+    int nlines = find_stats(csv_file, fstats._stats);
+    _logger->info("gathered statistics over {} lines of {}", nlines, fname);
+    return fstats._stats;
+  }
+
+  std::string CSVTSInputFileConn::stats_layout() const
+  {
+    std::vector<std::string> vars;
+    for (const std::string &col : _columns)
+      {
+        std::string var = col;
+        auto chit = _categoricals->find(col);
+        if (chit != _categoricals->end())
+          {
+            std::vector<std::string> cats((*chit).second._vals.size());
+            for (auto &v : (*chit).second._vals)
+              if (v.second >= 0 && v.second < static_cast<int>(cats.size()))
+                cats[v.second] = v.first;
+            var += "=" + dd_utils::join(cats, '|');
+          }
+        vars.push_back(var);
+      }
+    return dd_utils::join(vars, _delim[0]);
+  }
+
+  void CSVTSInputFileConn::serialize_file_stats()
+  {
+    if (_model_repo.empty())
+      return;
+    std::string statsfname = _model_repo + "/" + _statsfname;
+    std::ofstream out(statsfname);
+    if (!out.is_open())
+      throw InputConnectorBadParamException(
+          "failed opening for writing statistics file " + statsfname);
+    // full precision, so that merged statistics do not depend on caching
+    out << std::setprecision(17);
+    auto write_vals = [&out](const std::string &key,
+                             const std::vector<double> &vals) {
+      out << key << ":";
+      for (size_t i = 0; i < vals.size(); ++i)
+        out << (i > 0 ? " : " : " ") << vals[i];
+      out << std::endl;
+    };
+    out << "layout: " << stats_layout() << std::endl;
+    for (auto &fs : _file_stats)
+      {
+        const CSVRunningStats &stats = fs.second._stats;
+        out << "file: " << fs.first << std::endl;
+        out << "size: " << fs.second._size << std::endl;
+        out << "mtime: " << fs.second._mtime << std::endl;
+        out << "count: " << stats._count << std::endl;
+        write_vals("counts",
+                   std::vector<double>(stats._counts.begin(),
+                                       stats._counts.end()));
+        write_vals("min_vals", stats._min);
+        write_vals("max_vals", stats._max);
+        write_vals("mean_vals", stats._mean);
+        write_vals("m2_vals", stats._m2);
+      }
+  }
+
+  bool CSVTSInputFileConn::deserialize_file_stats()
+  {
+    _file_stats.clear();
+    std::string statsfname = _model_repo + "/" + _statsfname;
+    if (_model_repo.empty() || !fileops::file_exists(statsfname))
+      return false;
+    std::ifstream in(statsfname);
+    if (!in.is_open())
+      {
+        _logger->warn("statistics file {} detected but cannot be opened",
+                      statsfname);
+        return false;
+      }
+    std::string line;
+    CSVFileStats *fstats = nullptr;
+    auto read_vals = [](const std::vector<std::string> &tokens) {
+      std::vector<double> vals;
+      for (size_t i = 1; i < tokens.size(); ++i)
+        vals.push_back(std::atof(tokens.at(i).c_str()));
+      return vals;
+    };
+    while (getline(in, line))
+      {
+        // layout and file path may hold the delimiter
+        std::string key = line.substr(0, line.find(':'));
+        std::string value
+            = line.size() > key.size() + 2 ? line.substr(key.size() + 2) : "";
+        std::vector<std::string> tokens = dd_utils::split(line, ':');
+        if (key == "layout")
+          {
+            if (value != stats_layout())
+              {
+                _logger->info("variables changed, dropping statistics file {}",
+                              statsfname);
+                return false;
+              }
+          }
+        else if (key == "file")
+          fstats = &_file_stats[value];
+        else if (!fstats)
+          continue;
+        else if (key == "size")
+          fstats->_size = std::atol(value.c_str());
+        else if (key == "mtime")
+          fstats->_mtime = std::atoll(value.c_str());
+        else if (key == "count")
+          fstats->_stats._count = std::atoll(value.c_str());
+        else if (key == "counts")
+          {
+            std::vector<double> counts = read_vals(tokens);
+            fstats->_stats._counts.assign(counts.begin(), counts.end());
+          }
+        else if (key == "min_vals")
+          fstats->_stats._min = read_vals(tokens);
+        else if (key == "max_vals")
+          fstats->_stats._max = read_vals(tokens);
+        else if (key == "mean_vals")
+          fstats->_stats._mean = read_vals(tokens);
+        else if (key == "m2_vals")
+          fstats->_stats._m2 = read_vals(tokens);
+      }
+    // files without per column counts have no missing values
+    for (auto &fs : _file_stats)
+      if (fs.second._stats._counts.empty())
+        fs.second._stats._counts.assign(fs.second._stats._mean.size(),
+                                        fs.second._stats._count);
+    _logger->info("statistics loaded for {} files", _file_stats.size());
+    return true;
+  }
+
   void CSVTSInputFileConn::merge_categoricals(
       std::unordered_map<std::string, CCategorical> &categoricals)
   {
     std::unordered_map<std::string, CCategorical>::const_iterator chit
-        = _categoricals.begin();
-    while (chit != _categoricals.end())
+        = _categoricals->begin();
+    while (chit != _categoricals->end())
       {
         std::unordered_map<std::string, CCategorical>::iterator dchit;
         if ((dchit = categoricals.find((*chit).first)) != categoricals.end())
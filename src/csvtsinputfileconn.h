@@ -34,6 +34,17 @@ namespace dd
 
   class CSVTSInputFileConn;
 
+  /**
+   * \brief statistics of a CSV file, valid as long as the file is not
+   *        modified
+   */
+  struct CSVFileStats
+  {
+    long int _size = -1;   /**< file size in bytes. */
+    long long _mtime = -1; /**< file last modification time, in ns. */
+    CSVRunningStats _stats;
+  };
+
   /**
    * \brief fetched data element for timeseries
    */
@@ -105,6 +116,7 @@ namespace dd
 
       deserialize_bounds();
       CSVInputFileConn::fillup_parameters(ad_input);
+      _streaming = false; // series are required in memory
 
       // timeout
       this->set_timeout(ad_input);
@@ -167,6 +179,31 @@ namespace dd
     void merge_min_max(std::vector<double> &min_vals,
                        std::vector<double> &max_vals);
 
+    /**
+     * \brief statistics of a CSV file, from the cache if the file has not
+     *        changed since they were gathered, from a scan of the file
+     *        otherwise
+     * @param fname CSV filename
+     */
+    const CSVRunningStats &file_stats(const std::string &fname);
+
+    /**
+     * \brief description of the variables the statistics are gathered over,
+     *        cached statistics over another layout are dropped
+     */
+    std::string stats_layout() const;
+
+    /**
+     * \brief writes per file statistics to the model repository
+     */
+    void serialize_file_stats();
+
+    /**
+     * \brief reads per file statistics from the model repository
+     * @return true if successful, false otherwise
+     */
+    bool deserialize_file_stats();
+
     // read min max values, return false if not present
 
     /**
@@ -199,6 +236,11 @@ namespace dd
     std::vector<std::vector<std::vector<CSVline>>> _csvtsdata_tests;
     std::vector<std::string> _fnames;
     std::vector<std::vector<std::string>> _test_fnames;
+
+    std::unordered_map<std::string, CSVFileStats>
+        _file_stats; /**< per file statistics, by file path. */
+    std::string _statsfname
+        = "stats.dat"; /**< per file statistics filename. */
   };
 }
 
@@ -52,9 +52,15 @@ private:
 #pragma GCC diagnostic ignored "-Wsign-compare"
 #pragma GCC diagnostic ignored "-Wunused-parameter"
 #include <rapidjson/document.h>
+#include <rapidjson/stringbuffer.h>
+#include <rapidjson/writer.h>
 #pragma GCC diagnostic pop
 
 typedef rapidjson::Document JDoc;
 typedef rapidjson::Value JVal;
+typedef rapidjson::Writer<rapidjson::StringBuffer, rapidjson::UTF8<>,
+                          rapidjson::UTF8<>, rapidjson::CrtAllocator,
+                          rapidjson::kWriteNanAndInfFlag>
+    JWriter;
 
 #endif
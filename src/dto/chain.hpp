@@ -233,6 +233,13 @@ namespace dd
       DTO_INIT(ServiceChain, DTO)
 
       DTO_FIELD(Object<Chain>, chain);
+
+      DTO_FIELD_INFO(trace)
+      {
+        info->description
+            = "Return a Chrome trace event / Perfetto trace of the chain";
+      }
+      DTO_FIELD(Boolean, trace) = false;
     };
 
     // OUTPUT
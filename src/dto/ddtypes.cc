@@ -36,6 +36,9 @@ namespace dd
       const oatpp::ClassId
           DTOVectorClass<uint8_t>::CLASS_ID("vector<uint8_t>");
 
+      template <>
+      const oatpp::ClassId DTOVectorClass<int>::CLASS_ID("vector<int>");
+
       template <>
       const oatpp::ClassId DTOVectorClass<bool>::CLASS_ID("vector<bool>");
     }
@@ -34,6 +34,42 @@ namespace dd
   {
 #include OATPP_CODEGEN_BEGIN(DTO) ///< Begin DTO codegen section
 
+    class StageLatency : public oatpp::DTO
+    {
+      DTO_INIT(StageLatency, DTO /* extends */)
+
+      DTO_FIELD(Int64, count);
+      DTO_FIELD(Float64, p50_ms);
+      DTO_FIELD(Float64, p90_ms);
+      DTO_FIELD(Float64, p99_ms);
+      DTO_FIELD(Float64, p999_ms);
+      DTO_FIELD(Float64, max_ms);
+    };
+
+    class ServiceStats : public oatpp::DTO
+    {
+      DTO_INIT(ServiceStats, DTO /* extends */)
+
+      DTO_FIELD(Int32, inference_count);
+      DTO_FIELD(Int32, predict_success);
+      DTO_FIELD(Int32, predict_failure);
+      DTO_FIELD(Int32, predict_count);
+      DTO_FIELD(Float64, avg_batch_size);
+      DTO_FIELD(Float64, avg_predict_duration_ms);
+      DTO_FIELD(Float64, avg_transform_duration_ms);
+      DTO_FIELD(Float64, total_predict_duration_ms);
+      DTO_FIELD(Float64, total_transform_duration_ms);
+
+      DTO_FIELD_INFO(latencies)
+      {
+        info->description = "per stage latencies over current window: "
+                            "predict, transform, forward, output, "
+                            "serialization";
+      }
+      DTO_FIELD(Fields<Object<StageLatency>>, latencies);
+      DTO_FIELD(Float64, latency_window_s);
+    };
+
     class Service : public oatpp::DTO
     {
       DTO_INIT(Service, DTO /* extends */)
@@ -44,6 +80,7 @@ namespace dd
       DTO_FIELD(String, mltype);
       DTO_FIELD(Boolean, predict) = false;
       DTO_FIELD(Boolean, training) = false;
+      DTO_FIELD(Object<ServiceStats>, service_stats);
     };
 
     class InfoHead : public oatpp::DTO
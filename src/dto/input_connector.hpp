@@ -85,6 +85,16 @@ namespace dd
       }
       DTO_FIELD(Boolean, continuation) = false;
 
+      DTO_FIELD_INFO(series_ids)
+      {
+        info->description
+            = "with continuation, one id per posted series, in data order: "
+              "recurrent states are kept per series id between calls, so "
+              "that calls only hold new timesteps and series are batched "
+              "together";
+      }
+      DTO_FIELD(Vector<String>, series_ids);
+
       // image resizing on GPU
 #ifdef USE_CUDA_CV
       DTO_FIELD(Boolean, cuda);
@@ -45,6 +45,32 @@ namespace dd
       DTO_FIELD(Int32, test_batch_size) = 1;
     };
 
+    class Quantization : public oatpp::DTO
+    {
+      DTO_INIT(Quantization, DTO)
+
+      DTO_FIELD_INFO(mode)
+      {
+        info->description
+            = "int8 quantization mode: dynamic (activations quantized on the "
+              "fly) or static (activations ranges from calibration data)";
+      }
+      DTO_FIELD(String, mode) = "dynamic";
+
+      DTO_FIELD_INFO(engine)
+      {
+        info->description = "quantized engine: fbgemm (x86) or qnnpack (arm)";
+      }
+      DTO_FIELD(String, engine) = "fbgemm";
+
+      DTO_FIELD_INFO(calibration_batches)
+      {
+        info->description
+            = "number of batches used to observe activations, static mode";
+      }
+      DTO_FIELD(Int32, calibration_batches) = 10;
+    };
+
     class MLLib : public oatpp::DTO
     {
       DTO_INIT(MLLib, DTO /* extends */)
@@ -120,6 +146,57 @@ namespace dd
       };
       DTO_FIELD(String, datatype) = "fp32";
 
+      DTO_FIELD_INFO(amp)
+      {
+        info->description
+            = "Automatic mixed precision for training and prediction: bf16 "
+              "(CPU or GPU) or fp16 (GPU only). Empty or none to disable "
+              "(torch)";
+      };
+      DTO_FIELD(String, amp) = "";
+
+      DTO_FIELD_INFO(quantization)
+      {
+        info->description
+            = "Post-training int8 quantization of traced models for CPU "
+              "inference (torch)";
+      };
+      DTO_FIELD(Object<Quantization>, quantization);
+
+      DTO_FIELD_INFO(optimize_inference)
+      {
+        info->description
+            = "Freeze traced model and optimize its graph for inference "
+              "(conv/bn folding, operator fusion, mkldnn layouts on CPU) "
+              "(torch)";
+      };
+      DTO_FIELD(Boolean, optimize_inference) = false;
+
+      DTO_FIELD_INFO(warmup_iterations)
+      {
+        info->description
+            = "Number of forward passes of the warm-up run comparing "
+              "latencies of the traced and optimized models on the first "
+              "predict batch (torch)";
+      };
+      DTO_FIELD(Int32, warmup_iterations) = 5;
+
+      DTO_FIELD_INFO(continuation_cache_size)
+      {
+        info->description
+            = "Max number of series whose recurrent states are kept between "
+              "predict calls with continuation and series_ids (torch)";
+      };
+      DTO_FIELD(Int32, continuation_cache_size) = 1000;
+
+      DTO_FIELD_INFO(continuation_ttl)
+      {
+        info->description
+            = "Seconds a series recurrent state is kept after its last "
+              "predict call, 0 for no expiry (torch)";
+      };
+      DTO_FIELD(Int32, continuation_ttl) = 3600;
+
       DTO_FIELD_INFO(extract_layer)
       {
         info->description
@@ -46,9 +46,41 @@ namespace dd
       DTO_FIELD(Int32, best);
       DTO_FIELD(Int32, best_bbox) = -1;
       DTO_FIELD(Float32, nms_threshold) = 0.45;
+
+      DTO_FIELD_INFO(nms_per_class)
+      {
+        info->description = "whether non maximum suppression only applies "
+                            "between boxes of a same class";
+      };
+      DTO_FIELD(Boolean, nms_per_class) = false;
+
+      DTO_FIELD_INFO(nms_sigma)
+      {
+        info->description
+            = "if > 0, gaussian soft non maximum suppression: overlapping "
+              "boxes confidences are decayed by exp(-iou^2 / nms_sigma) "
+              "instead of boxes being removed";
+      };
+      DTO_FIELD(Float32, nms_sigma) = 0.0;
       DTO_FIELD(Vector<String>, confidences);
       DTO_FIELD(Int32, top_k) = -1;
 
+      DTO_FIELD_INFO(mask_encoding)
+      {
+        info->description
+            = "Segmentation only: encoding of the class map in vals, empty "
+              "for an array of classes, rle for [class, length, ...] runs in "
+              "row-major order, png for a base64 png image";
+      };
+      DTO_FIELD(String, mask_encoding) = "";
+
+      DTO_FIELD_INFO(float_precision)
+      {
+        info->description = "if >= 0, maximum number of decimals of floating "
+                            "point values in the JSON answer";
+      };
+      DTO_FIELD(Int32, float_precision) = -1;
+
       DTO_FIELD_INFO(image)
       {
         info->description = "wether to convert result to a cv::Mat (e.g. for "
@@ -68,6 +100,21 @@ namespace dd
       }
       DTO_FIELD(Vector<String>, measure) = Vector<String>::createShared();
 
+      DTO_FIELD_INFO(measure_exact)
+      {
+        info->description
+            = "Compute measures from all test predictions instead of "
+              "accumulating them batch after batch (torch)";
+      }
+      DTO_FIELD(Boolean, measure_exact) = false;
+
+      DTO_FIELD_INFO(auc_bins)
+      {
+        info->description = "Number of score bins of the accumulated auc, 0 "
+                            "for exact auc (torch)";
+      }
+      DTO_FIELD(Int32, auc_bins) = 10000;
+
       /* output unsupervised predict */
       DTO_FIELD_INFO(binarized)
       {
@@ -52,6 +52,13 @@ namespace dd
 
       DTO_FIELD(Boolean, has_mean_file) = false;
 
+      DTO_FIELD_INFO(trace)
+      {
+        info->description
+            = "Return a Chrome trace event / Perfetto trace of the call";
+      }
+      DTO_FIELD(Boolean, trace) = false;
+
     public:
       /// Whether this service predict is part of a chain call or not
       bool _chain = false;
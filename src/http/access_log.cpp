@@ -20,10 +20,121 @@
  */
 #include "access_log.hpp"
 
+#include <cmath>
+#include <cstdio>
+#include <ctime>
+#include <random>
+#include <rapidjson/stringbuffer.h>
+#include <rapidjson/writer.h>
+
 namespace dd
 {
   namespace http
   {
     thread_local AccessLogContext _context;
+
+    AccessLogger::AccessLogger(const std::shared_ptr<spdlog::logger> &logger,
+                               const bool &json, const double &sample_rate,
+                               const size_t &capacity)
+        : _logger(logger), _json(json), _sample_rate(sample_rate),
+          _entries(capacity)
+    {
+      _drainer = std::thread(&AccessLogger::drain_loop, this);
+    }
+
+    AccessLogger::~AccessLogger()
+    {
+      {
+        std::lock_guard<std::mutex> lock(_stop_mutex);
+        _stop = true;
+      }
+      _stop_cv.notify_one();
+      _drainer.join();
+      drain();
+    }
+
+    void AccessLogger::log(AccessLogEntry &&entry)
+    {
+      if (!_entries.try_push(std::move(entry)))
+        _dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    bool AccessLogger::sample(const int &code) const
+    {
+      if (!success(code) || _sample_rate >= 1.0)
+        return true;
+      if (_sample_rate <= 0.0)
+        return false;
+      static thread_local std::mt19937 g(std::random_device{}());
+      return std::uniform_real_distribution<double>(0.0, 1.0)(g)
+             < _sample_rate;
+    }
+
+    std::string AccessLogger::format(const AccessLogEntry &entry) const
+    {
+      if (!_json)
+        return entry.protocol + " \"" + entry.method + " " + entry.path
+               + "\" " + entry.service_name + " "
+               + std::to_string(entry.code) + " "
+               + std::to_string(static_cast<long>(entry.duration_ms)) + "ms";
+
+      // ISO 8601 UTC time, with milliseconds
+      std::time_t t = std::chrono::system_clock::to_time_t(entry.time);
+      std::tm tm;
+      gmtime_r(&t, &tm);
+      char tbuf[32];
+      size_t tlen = std::strftime(tbuf, sizeof(tbuf), "%Y-%m-%dT%H:%M:%S", &tm);
+      long ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                    entry.time.time_since_epoch())
+                    .count()
+                % 1000;
+      snprintf(tbuf + tlen, sizeof(tbuf) - tlen, ".%03ldZ", ms);
+
+      rapidjson::StringBuffer buffer;
+      rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+      writer.StartObject();
+      writer.Key("time");
+      writer.String(tbuf);
+      writer.Key("protocol");
+      writer.String(entry.protocol.c_str(), entry.protocol.size());
+      writer.Key("method");
+      writer.String(entry.method.c_str(), entry.method.size());
+      writer.Key("path");
+      writer.String(entry.path.c_str(), entry.path.size());
+      writer.Key("service");
+      writer.String(entry.service_name.c_str(), entry.service_name.size());
+      writer.Key("status");
+      writer.Int(entry.code);
+      writer.Key("duration_ms");
+      writer.Double(std::round(entry.duration_ms * 1e3) / 1e3);
+      writer.EndObject();
+      return std::string(buffer.GetString(), buffer.GetSize());
+    }
+
+    void AccessLogger::drain_loop()
+    {
+      while (!_stop)
+        {
+          drain();
+          std::unique_lock<std::mutex> lock(_stop_mutex);
+          _stop_cv.wait_for(lock, std::chrono::milliseconds(10),
+                            [this] { return _stop.load(); });
+        }
+    }
+
+    void AccessLogger::drain()
+    {
+      AccessLogEntry entry;
+      while (_entries.try_pop(entry))
+        {
+          if (success(entry.code))
+            _logger->info(format(entry));
+          else
+            _logger->error(format(entry));
+        }
+      uint64_t dropped = _dropped.exchange(0, std::memory_order_relaxed);
+      if (dropped > 0)
+        _logger->warn("access log buffer full, {} entries dropped", dropped);
+    }
   }
 }
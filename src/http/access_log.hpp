@@ -27,7 +27,13 @@
 #include "oatpp/web/server/interceptor/ResponseInterceptor.hpp"
 #include "oatpp/web/server/interceptor/RequestInterceptor.hpp"
 
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
 #include "dd_spdlog.h"
+#include "utils/ring_buffer.hpp"
 
 namespace dd
 {
@@ -53,17 +59,85 @@ namespace dd
       _context.service_name = service_name;
     }
 
+    /* One access log line, built on the request thread */
+    struct AccessLogEntry
+    {
+      std::chrono::time_point<std::chrono::system_clock> time;
+      std::string protocol;
+      std::string method;
+      std::string path;
+      std::string service_name;
+      int code = 0;
+      double duration_ms = 0.0;
+    };
+
+    /**
+     * \brief access logger: request threads push entries to a lock-free
+     * ring buffer, that a background thread drains, formats and logs in
+     * batches, so that logging does not add to request latency. Entries
+     * are dropped when the buffer is full, and their count logged.
+     */
+    class AccessLogger
+    {
+    public:
+      /**
+       * @param json whether to log JSON lines instead of text
+       * @param sample_rate fraction of successful requests that are logged,
+       *        failures always are
+       * @param capacity ring buffer size
+       */
+      AccessLogger(const std::shared_ptr<spdlog::logger> &logger,
+                   const bool &json, const double &sample_rate,
+                   const size_t &capacity = 65536);
+
+      ~AccessLogger();
+
+      /**
+       * \brief queues an entry, never blocks
+       */
+      void log(AccessLogEntry &&entry);
+
+      /**
+       * \brief formats an entry as a log line
+       */
+      std::string format(const AccessLogEntry &entry) const;
+
+      /**
+       * \brief whether a request with a given status is to be logged
+       */
+      bool sample(const int &code) const;
+
+      static bool success(const int &code)
+      {
+        return code == 200 || code == 201;
+      }
+
+    private:
+      void drain_loop();
+      void drain();
+
+      std::shared_ptr<spdlog::logger> _logger;
+      bool _json = false;
+      double _sample_rate = 1.0;
+      RingBuffer<AccessLogEntry> _entries;
+      std::atomic<uint64_t> _dropped{ 0 };
+      std::atomic<bool> _stop{ false };
+      std::mutex _stop_mutex;
+      std::condition_variable _stop_cv;
+      std::thread _drainer;
+    };
+
     class AccessLogResponseInterceptor
         : public oatpp::web::server::interceptor::ResponseInterceptor
     {
     private:
-      std::shared_ptr<spdlog::logger> _logger;
+      std::shared_ptr<AccessLogger> _access_logger;
 
     public:
       AccessLogResponseInterceptor(
-          const std::shared_ptr<spdlog::logger> &logger)
+          const std::shared_ptr<AccessLogger> &access_logger)
           : oatpp::web::server::interceptor::ResponseInterceptor(),
-            _logger(logger)
+            _access_logger(access_logger)
       {
       }
 
@@ -71,27 +145,24 @@ namespace dd
       intercept(const std::shared_ptr<IncomingRequest> &request,
                 const std::shared_ptr<OutgoingResponse> &response) override
       {
-
-        auto req = request->getStartingLine();
-        std::string access_log = req.protocol.toString() + " \""
-                                 + req.method.toString() + " "
-                                 + req.path.toString() + "\"";
-        access_log += " " + _context.service_name;
-
         auto outcode = response->getStatus().code;
+        if (!_access_logger->sample(outcode))
+          return response;
 
-        access_log += " " + std::to_string(outcode);
-
-        auto req_stop_time = std::chrono::steady_clock::now();
-        auto req_duration_ms
-            = std::chrono::duration_cast<std::chrono::milliseconds>(
-                req_stop_time - _context.req_start_time);
-        access_log += " " + std::to_string(req_duration_ms.count()) + "ms";
-
-        if (outcode == 200 || outcode == 201)
-          _logger->info(access_log);
-        else
-          _logger->error(access_log);
+        auto req = request->getStartingLine();
+        AccessLogEntry entry;
+        entry.time = std::chrono::system_clock::now();
+        entry.protocol = req.protocol.toString();
+        entry.method = req.method.toString();
+        entry.path = req.path.toString();
+        entry.service_name = _context.service_name;
+        entry.code = outcode;
+        entry.duration_ms
+            = std::chrono::duration_cast<
+                  std::chrono::duration<double, std::milli>>(
+                  std::chrono::steady_clock::now() - _context.req_start_time)
+                  .count();
+        _access_logger->log(std::move(entry));
 
         return response;
       }
@@ -33,6 +33,7 @@
 #include "oatpp-zlib/EncoderProvider.hpp"
 
 #include "http/access_log.hpp"
+#include "http/compression.hpp"
 #include "http/error_handler.hpp"
 #ifdef USE_OATPP_SWAGGER
 #include "http/swagger_component.hpp"
@@ -45,6 +46,10 @@
 DECLARE_string(host);
 DECLARE_uint32(port);
 DECLARE_string(allow_origin);
+DECLARE_string(access_log_format);
+DECLARE_double(access_log_sample_rate);
+DECLARE_int32(compression_level);
+DECLARE_int64(compression_min_size);
 
 class AppComponent
 {
@@ -110,15 +115,9 @@ public:
         = std::make_shared<oatpp::web::server::HttpProcessor::Components>(
             router);
 
-    /* Add content encoders */
-    auto encoders = std::make_shared<
-        oatpp::web::protocol::http::encoding::ProviderCollection>();
-
-    encoders->add(std::make_shared<oatpp::zlib::DeflateEncoderProvider>());
-    encoders->add(std::make_shared<oatpp::zlib::GzipEncoderProvider>());
-
     /* Set content encoders */
-    components->contentEncodingProviders = encoders;
+    components->contentEncodingProviders
+        = dd::http::make_encoders(FLAGS_compression_level);
 
     /* Add content decoders */
     auto decoders = std::make_shared<
@@ -138,8 +137,18 @@ public:
     /* Add AccessLogResponseInterceptor */
     connectionHandler->addRequestInterceptor(
         std::make_shared<dd::http::AccessLogRequestInterceptor>());
+    auto access_logger = std::make_shared<dd::http::AccessLogger>(
+        _logger, FLAGS_access_log_format == "json",
+        FLAGS_access_log_sample_rate);
     connectionHandler->addResponseInterceptor(
-        std::make_shared<dd::http::AccessLogResponseInterceptor>(_logger));
+        std::make_shared<dd::http::AccessLogResponseInterceptor>(
+            access_logger));
+
+    /* Leave small responses uncompressed */
+    if (FLAGS_compression_level != 0 && FLAGS_compression_min_size > 0)
+      connectionHandler->addResponseInterceptor(
+          std::make_shared<dd::http::CompressionThresholdInterceptor>(
+              FLAGS_compression_min_size));
 
     /* Add CORS interceptors */
     if (!FLAGS_allow_origin.empty())
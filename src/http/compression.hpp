@@ -0,0 +1,113 @@
+/**
+ * DeepDetect
+ * Copyright (c) 2023 Jolibrain
+ *
+ * This file is part of deepdetect.
+ *
+ * deepdetect is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * deepdetect is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with deepdetect.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef HTTP_COMPRESSION_HPP
+#define HTTP_COMPRESSION_HPP
+
+#include "oatpp/web/protocol/http/encoding/EncoderProvider.hpp"
+#include "oatpp/web/protocol/http/encoding/ProviderCollection.hpp"
+#include "oatpp/web/protocol/http/outgoing/Response.hpp"
+#include "oatpp/web/protocol/http/incoming/Request.hpp"
+#include "oatpp/web/server/interceptor/ResponseInterceptor.hpp"
+#include "oatpp-zlib/Processor.hpp"
+
+namespace dd
+{
+  namespace http
+  {
+    /* gzip or deflate response encoder with a given compression level,
+       the body is compressed while it is streamed, in chunks */
+    class LevelEncoderProvider
+        : public oatpp::web::protocol::http::encoding::EncoderProvider
+    {
+    private:
+      bool _gzip;
+      v_int32 _level;
+
+    public:
+      /**
+       * @param level zlib compression level, from 1 (fastest) to 9 (best),
+       *        -1 for zlib default
+       */
+      LevelEncoderProvider(const bool &gzip, const int &level)
+          : _gzip(gzip), _level(level)
+      {
+      }
+
+      oatpp::String getEncodingName() override
+      {
+        return _gzip ? "gzip" : "deflate";
+      }
+
+      std::shared_ptr<oatpp::data::buffer::Processor> getProcessor() override
+      {
+        return std::make_shared<oatpp::zlib::DeflateEncoder>(1024, _gzip,
+                                                             _level);
+      }
+    };
+
+    /* deflate and gzip encoders at a given level, none if level is 0 */
+    inline std::shared_ptr<
+        oatpp::web::protocol::http::encoding::ProviderCollection>
+    make_encoders(const int &level)
+    {
+      auto encoders = std::make_shared<
+          oatpp::web::protocol::http::encoding::ProviderCollection>();
+      if (level != 0)
+        {
+          encoders->add(std::make_shared<LevelEncoderProvider>(false, level));
+          encoders->add(std::make_shared<LevelEncoderProvider>(true, level));
+        }
+      return encoders;
+    }
+
+    /* Leaves responses smaller than a threshold uncompressed, compressing
+       them costs more than sending them. The encoder is selected from the
+       request Accept-Encoding after response interceptors, so it is
+       replaced here. */
+    class CompressionThresholdInterceptor
+        : public oatpp::web::server::interceptor::ResponseInterceptor
+    {
+    private:
+      v_int64 _min_size;
+
+    public:
+      CompressionThresholdInterceptor(const v_int64 &min_size)
+          : oatpp::web::server::interceptor::ResponseInterceptor(),
+            _min_size(min_size)
+      {
+      }
+
+      std::shared_ptr<OutgoingResponse>
+      intercept(const std::shared_ptr<IncomingRequest> &request,
+                const std::shared_ptr<OutgoingResponse> &response) override
+      {
+        auto body = response->getBody();
+        if (!body)
+          return response;
+        v_int64 size = body->getKnownSize();
+        if (size >= 0 && size < _min_size)
+          request->putOrReplaceHeader("Accept-Encoding", "identity");
+        return response;
+      }
+    };
+  }
+}
+#endif
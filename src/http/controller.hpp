@@ -79,6 +79,12 @@ public:
     bool status = false;
     if (qs_status)
       status = boost::lexical_cast<bool>(std::string(qs_status));
+    oatpp::String qs_reset_stats = queryParams.get("reset_stats");
+    bool reset_stats = false;
+    if (qs_reset_stats)
+      reset_stats
+          = status
+            && boost::lexical_cast<bool>(std::string(qs_reset_stats));
 
     auto hit = _oja->_mlservices.begin();
     while (hit != _oja->_mlservices.end())
@@ -86,7 +92,8 @@ public:
         // TODO(sileht): update visitor_info to return directly a Service()
         JDoc jd;
         jd.SetObject();
-        mapbox::util::apply_visitor(dd::visitor_info(status), (*hit).second)
+        mapbox::util::apply_visitor(dd::visitor_info(status, reset_stats),
+                                    (*hit).second)
             .toJDoc(jd);
         auto json_str = _oja->jrender(jd);
         auto service_info
@@ -99,6 +106,19 @@ public:
     return createDtoResponse(Status::CODE_200, info_resp);
   }
 
+  ENDPOINT_INFO(get_metrics)
+  {
+    info->summary = "Retrieve services and process metrics, in Prometheus "
+                    "text format";
+  }
+  ENDPOINT("GET", "metrics", get_metrics)
+  {
+    auto response = createResponse(Status::CODE_200, _oja->metrics());
+    response->putHeader(oatpp::web::protocol::http::Header::CONTENT_TYPE,
+                        "text/plain; version=0.0.4; charset=utf-8");
+    return response;
+  }
+
   ENDPOINT_INFO(get_service)
   {
     info->summary = "Retrieve a service detail";
@@ -154,10 +174,30 @@ public:
     info->addConsumes<Object<dd::DTO::ServicePredict>>("application/json");
   }
   ENDPOINT("POST", "predict", predict,
-           BODY_STRING(oatpp::String, predict_data))
-  {
-    auto janswer = _oja->service_predict(predict_data);
-    return _oja->jdoc_to_response(janswer);
+           BODY_STRING(oatpp::String, predict_data),
+           REQUEST(std::shared_ptr<IncomingRequest>, request))
+  {
+    // binary answers on demand, JSON otherwise
+    std::string accept;
+    auto accept_header = request->getHeader("Accept");
+    if (accept_header)
+      accept = accept_header->c_str();
+    dd::JsonAPI::RenderEncoding encoding = dd::JsonAPI::RENDER_JSON;
+    std::string content_type = "application/json";
+    if (accept.find("application/x-dd-tensor") != std::string::npos)
+      {
+        encoding = dd::JsonAPI::RENDER_TENSOR;
+        content_type = "application/x-dd-tensor";
+      }
+    else if (accept.find("application/msgpack") != std::string::npos
+             || accept.find("application/x-msgpack") != std::string::npos)
+      {
+        encoding = dd::JsonAPI::RENDER_MSGPACK;
+        content_type = "application/msgpack";
+      }
+    std::string rendered;
+    auto janswer = _oja->service_predict(predict_data, &rendered, encoding);
+    return _oja->jdoc_to_response(janswer, rendered, content_type);
   }
 
   ENDPOINT_INFO(get_train)
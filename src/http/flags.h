@@ -27,5 +27,22 @@
 DEFINE_string(host, "localhost", "host for running the server");
 DEFINE_uint32(port, 8080, "server port");
 DEFINE_string(allow_origin, "", "Access-Control-Allow-Origin for the server");
+DEFINE_string(access_log_format, "text",
+              "access log format, text or json (JSON lines)");
+DEFINE_int32(compression_level, -1,
+             "gzip and deflate response compression level, from 1 (fastest) "
+             "to 9 (best), -1 for zlib default, 0 to disable compression");
+// zlib levels, rejected at startup otherwise
+static bool validate_compression_level(const char *flagname, int32_t value)
+{
+  (void)flagname;
+  return value >= -1 && value <= 9;
+}
+DEFINE_validator(compression_level, &validate_compression_level);
+DEFINE_int64(compression_min_size, 1024,
+             "responses smaller than this many bytes are not compressed");
+DEFINE_double(access_log_sample_rate, 1.0,
+              "fraction of successful requests in the access log, failed "
+              "requests are always logged");
 
 #endif // HTTP_FLAGS_H
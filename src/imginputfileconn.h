@@ -46,6 +46,7 @@
 #include <random>
 
 #include "dto/input_connector.hpp"
+#include "trace.h"
 
 namespace dd
 {
@@ -881,6 +882,7 @@ namespace dd
 
     void transform(oatpp::Object<DTO::ServicePredict> input_dto)
     {
+      TraceSpan span("ImgInputFileConn::transform", "input");
 
       if (input_dto != nullptr) // [temporary] == nullptr if called from
                                 // transform(APIData)
@@ -1071,6 +1073,78 @@ namespace dd
                                      + segimg_res.rows * segimg_res.cols);
     }
 
+    /**
+     * \brief resizes a single channel map, e.g. a class map header over a
+     * tensor, nearest neighbor for class maps. Untouched when already at
+     * destination size.
+     */
+    static void img_resize_map(cv::Mat &map, const int height_dest,
+                               const int width_dest, bool resize_nn)
+    {
+      if (map.rows == height_dest && map.cols == width_dest)
+        return;
+      cv::Mat map_res;
+      cv::resize(map, map_res, cv::Size(width_dest, height_dest), 0, 0,
+                 resize_nn ? cv::INTER_NEAREST : cv::INTER_LINEAR);
+      map = map_res;
+    }
+
+    /**
+     * \brief single channel map values as doubles, converted once
+     */
+    static std::vector<double> map_to_vector(const cv::Mat &map)
+    {
+      std::vector<double> vals(map.total());
+      cv::Mat dmap(map.rows, map.cols, CV_64FC1, vals.data());
+      map.convertTo(dmap, CV_64F);
+      return vals;
+    }
+
+    /**
+     * \brief run-length encoding of a class map, as class, length pairs in
+     * row-major order
+     */
+    static std::vector<int> mask_to_rle(const cv::Mat &mask)
+    {
+      cv::Mat imask;
+      if (mask.depth() == CV_32S && mask.isContinuous())
+        imask = mask;
+      else
+        mask.convertTo(imask, CV_32S);
+      std::vector<int> rle;
+      const int *v = imask.ptr<int>();
+      size_t n = imask.total();
+      size_t i = 0;
+      while (i < n)
+        {
+          size_t j = i + 1;
+          while (j < n && v[j] == v[i])
+            ++j;
+          rle.push_back(v[i]);
+          rle.push_back(static_cast<int>(j - i));
+          i = j;
+        }
+      return rle;
+    }
+
+    /**
+     * \brief base64 png encoding of a class map, 8 bits or 16 bits
+     */
+    static std::string mask_to_png(const cv::Mat &mask)
+    {
+      cv::Mat pmask;
+      if (mask.depth() == CV_8U || mask.depth() == CV_16U)
+        pmask = mask;
+      else
+        mask.convertTo(pmask, CV_16U);
+      std::vector<uchar> buf;
+      if (!cv::imencode(".png", pmask, buf))
+        throw InputConnectorInternalException("failed encoding mask to png");
+      std::string b64;
+      Base64::Encode(std::string(buf.begin(), buf.end()), &b64);
+      return b64;
+    }
+
     // data
     std::vector<cv::Mat> _images;
     std::vector<cv::Mat> _orig_images; /**< stored upon request. */
@@ -32,6 +32,9 @@ DEFINE_string(service_start_list, "",
               "list of JSON calls to be executed at startup");
 DEFINE_bool(service_start_list_no_exit_on_failure, false,
             "do not exit on failure for any JSON calls executed at startup");
+DEFINE_double(trace_sample_rate, 0.0,
+              "fraction of predict and chain calls whose trace is written to "
+              "the traces directory of the service model repository");
 
 namespace dd
 {
@@ -373,9 +376,10 @@ namespace dd
     return buffer.GetString();
   }
 
-  JDoc JsonAPI::info(const std::string &jstr) const
+  JDoc JsonAPI::info(const std::string &jstr)
   {
     bool status = false;
+    bool reset_stats = false;
 
     if (!jstr.empty())
       {
@@ -394,6 +398,8 @@ namespace dd
             ad.fromRapidJson(d);
             if (ad.has("status"))
               status = ad.get("status").get<bool>();
+            if (ad.has("reset_stats"))
+              reset_stats = ad.get("reset_stats").get<bool>();
           }
         catch (RapidjsonException &e)
           {
@@ -432,8 +438,8 @@ namespace dd
     auto hit = _mlservices.begin();
     while (hit != _mlservices.end())
       {
-        APIData ad
-            = mapbox::util::apply_visitor(visitor_info(status), (*hit).second);
+        APIData ad = mapbox::util::apply_visitor(
+            visitor_info(status, status && reset_stats), (*hit).second);
         JVal jserv(rapidjson::kObjectType);
         ad.toJVal(jinfo, jserv);
         jservs.PushBack(jserv, jinfo.GetAllocator());
@@ -444,6 +450,16 @@ namespace dd
     return jinfo;
   }
 
+  std::string JsonAPI::metrics()
+  {
+    PrometheusWriter pw;
+    boost::shared_lock<boost::shared_mutex> lock(_mlservices_mtx);
+    for (auto &mls : _mlservices)
+      mapbox::util::apply_visitor(visitor_metrics(pw), mls.second);
+    pw.add_process_memory();
+    return pw.str();
+  }
+
   JDoc JsonAPI::service_create(const std::string &snamein,
                                const std::string &jstr)
   {
@@ -1041,7 +1057,54 @@ namespace dd
     return dd_not_found_404();
   }
 
-  JDoc JsonAPI::service_predict(const std::string &jstr)
+  template <typename Writer>
+  void JsonAPI::render_predict(Writer &writer, const JDoc &jpred,
+                               const std::string &sname,
+                               const APIData &out) const
+  {
+    writer.StartObject();
+    writer.Key("status");
+    jpred["status"].Accept(writer);
+    writer.Key("head");
+    writer.StartObject();
+    writer.Key("method");
+    writer.String("/predict");
+    writer.Key("service");
+    writer.String(sname.c_str(), sname.size());
+    if (out.has("dto"))
+      {
+        auto body = out.get("dto")
+                        .get<oatpp::Any>()
+                        .retrieve<oatpp::Object<DTO::PredictBody>>();
+        writer.Key("time");
+        writer.Double(body->time);
+        writer.EndObject();
+        writer.Key("body");
+        writer.StartObject();
+        writer.Key("predictions");
+        oatpp_utils::dtoWrite(body->predictions, writer);
+      }
+    else
+      {
+        writer.Key("time");
+        out.write(writer, "time");
+        writer.EndObject();
+        writer.Key("body");
+        writer.StartObject();
+        for (const char *key : { "predictions", "resources" })
+          if (out.has(key))
+            {
+              writer.Key(key);
+              out.write(writer, key);
+            }
+      }
+    writer.EndObject();
+    writer.EndObject();
+  }
+
+  JDoc JsonAPI::service_predict(const std::string &jstr,
+                                std::string *rendered,
+                                const RenderEncoding &encoding)
   {
     rapidjson::Document d;
     d.Parse<rapidjson::kParseNanAndInfFlag>(jstr.c_str());
@@ -1081,6 +1144,14 @@ namespace dd
         return dd_bad_request_400();
       }
 
+    // tracing, inline on demand, or sampled to model repository
+    bool trace_inline
+        = ad_data.has("trace") && ad_data.get("trace").get<bool>();
+    std::unique_ptr<Trace> trace;
+    if (trace_inline || Trace::sample(FLAGS_trace_sample_rate))
+      trace.reset(new Trace());
+    TraceScope trace_scope(trace.get());
+
     // prediction
     APIData out;
     try
@@ -1127,14 +1198,61 @@ namespace dd
       {
         return dd_internal_mllib_error_1007(e.what());
       }
+    auto serialization_tstart = ServiceStats::now();
+    APIData ad_output = ad_data.getobj("parameters").getobj("output");
+    bool has_measure = ad_output.has("measure");
+    if (rendered && !has_measure && !trace_inline && !ad_output.has("network")
+        && !(ad_output.has("template")
+             && !ad_output.get("template").get<std::string>().empty()))
+      {
+        // direct rendering, without intermediate document
+        JDoc jpred = dd_ok_200();
+        JVal jhead(rapidjson::kObjectType);
+        jhead.AddMember("method", "/predict", jpred.GetAllocator());
+        jhead.AddMember("service",
+                        JVal().SetString(sname.c_str(), jpred.GetAllocator()),
+                        jpred.GetAllocator());
+        jpred.AddMember("head", jhead, jpred.GetAllocator());
+        {
+          TraceSpan span("JsonAPI::render", "api");
+          if (encoding == RENDER_JSON)
+            {
+              rapidjson::StringBuffer buffer;
+              JWriter writer(buffer);
+              if (ad_output.has("float_precision")
+                  && ad_output.get("float_precision").get<int>() >= 0)
+                writer.SetMaxDecimalPlaces(
+                    ad_output.get("float_precision").get<int>());
+              render_predict(writer, jpred, sname, out);
+              rendered->assign(buffer.GetString(), buffer.GetSize());
+            }
+          else
+            {
+              MsgPackWriter writer(encoding == RENDER_TENSOR);
+              render_predict(writer, jpred, sname, out);
+              *rendered = writer.str();
+            }
+        }
+        this->add_stage_duration(
+            sname, ServiceStats::SERIALIZATION,
+            ServiceStats::elapsed_ms(serialization_tstart));
+        JVal jtrace;
+        trace_out(trace.get(), false, sname, jpred, jtrace);
+        return jpred;
+      }
+
     JDoc jpred = dd_ok_200();
     JVal jout(rapidjson::kObjectType);
-    if (out.has("dto"))
-      oatpp_utils::dtoToJVal(out.get("dto").get<oatpp::Any>(), jpred, jout);
-    else
-      out.toJVal(jpred, jout);
-    bool has_measure
-        = ad_data.getobj("parameters").getobj("output").has("measure");
+    {
+      TraceSpan span("JsonAPI::render", "api");
+      if (out.has("dto"))
+        oatpp_utils::dtoToJVal(out.get("dto").get<oatpp::Any>(), jpred,
+                               jout);
+      else
+        out.toJVal(jpred, jout);
+    }
+    this->add_stage_duration(sname, ServiceStats::SERIALIZATION,
+                             ServiceStats::elapsed_ms(serialization_tstart));
     JVal jhead(rapidjson::kObjectType);
     jhead.AddMember("method", "/predict", jpred.GetAllocator());
     rapidjson::Value service;
@@ -1154,6 +1272,7 @@ namespace dd
                       jpred.GetAllocator());
     if (jout.HasMember("resources"))
       jbody.AddMember("resources", jout["resources"], jpred.GetAllocator());
+    trace_out(trace.get(), trace_inline, sname, jpred, jbody);
     jpred.AddMember("body", jbody, jpred.GetAllocator());
     if (ad_data.getobj("parameters").getobj("output").has("template")
         && ad_data.getobj("parameters")
@@ -1508,6 +1627,15 @@ namespace dd
         return dd_bad_request_400();
       }
 
+    // tracing, inline on demand, or sampled to the model repository of
+    // the first service
+    bool trace_inline
+        = ad_data.has("trace") && ad_data.get("trace").get<bool>();
+    std::unique_ptr<Trace> trace;
+    if (trace_inline || Trace::sample(FLAGS_trace_sample_rate))
+      trace.reset(new Trace());
+    TraceScope trace_scope(trace.get());
+
     // chained predictions
     oatpp::Object<DTO::ChainBody> chain_body;
     try
@@ -1559,7 +1687,10 @@ namespace dd
 
     JDoc jpred = dd_ok_200();
     JVal jout(rapidjson::kObjectType);
-    oatpp_utils::dtoToJVal(chain_body, jpred, jout);
+    {
+      TraceSpan span("JsonAPI::render", "api");
+      oatpp_utils::dtoToJVal(chain_body, jpred, jout);
+    }
     JVal jhead(rapidjson::kObjectType);
     jhead.AddMember("method", "/chain", jpred.GetAllocator());
     jhead.AddMember("time", jout["time"], jpred.GetAllocator());
@@ -1568,10 +1699,54 @@ namespace dd
     if (jout.HasMember("predictions"))
       jbody.AddMember("predictions", jout["predictions"],
                       jpred.GetAllocator());
+    if (trace)
+      {
+        std::string sname;
+        for (const APIData &adc : ad_data.getobj("chain").getv("calls"))
+          if (adc.has("service"))
+            {
+              sname = adc.get("service").get<std::string>();
+              break;
+            }
+        trace_out(trace.get(), trace_inline, sname, jpred, jbody);
+      }
     jpred.AddMember("body", jbody, jpred.GetAllocator());
     return jpred;
   }
 
+  void JsonAPI::trace_out(const Trace *trace, const bool &inline_trace,
+                          const std::string &sname, JDoc &jd, JVal &jbody)
+  {
+    if (!trace)
+      return;
+    if (inline_trace)
+      {
+        APIData ad;
+        trace->to(ad);
+        JVal jtrace(rapidjson::kObjectType);
+        ad.toJVal(jd, jtrace);
+        jbody.AddMember("trace", jtrace, jd.GetAllocator());
+        return;
+      }
+    std::string repo = service_repository(sname);
+    if (repo.empty())
+      return;
+    std::string tdir = repo + "/traces";
+    if (!fileops::dir_exists(tdir) && !fileops::create_dir(tdir, 0755))
+      {
+        _logger->warn("could not create traces directory {}", tdir);
+        return;
+      }
+    long int tms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                       std::chrono::system_clock::now().time_since_epoch())
+                       .count();
+    static std::atomic<int> tcount(0);
+    std::string tfname = tdir + "/trace_" + std::to_string(tms) + "_"
+                         + std::to_string(tcount++) + ".json";
+    if (trace->write(tfname))
+      _logger->warn("could not write trace {}", tfname);
+  }
+
   int JsonAPI::store_json_blob(const std::string &model_repo,
                                const std::string &jstr,
                                const std::string &jfilename)
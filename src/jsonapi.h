@@ -92,12 +92,47 @@ namespace dd
 
     // resources
     // return a JSON document for every API call
-    JDoc info(const std::string &jstr) const;
+    JDoc info(const std::string &jstr);
+
+    /**
+     * \brief services and process metrics, in Prometheus text format
+     */
+    std::string metrics();
     JDoc service_create(const std::string &sname, const std::string &jstr);
     JDoc service_status(const std::string &sname);
     JDoc service_delete(const std::string &sname, const std::string &jstr);
 
-    JDoc service_predict(const std::string &jstr);
+    /**
+     * \brief encodings of directly rendered predict answers: JSON,
+     * MessagePack with float32 arrays, or MessagePack with arrays of doubles
+     * as bin blobs of little endian float32
+     */
+    enum RenderEncoding
+    {
+      RENDER_JSON,
+      RENDER_MSGPACK,
+      RENDER_TENSOR
+    };
+
+    /**
+     * \brief predict call
+     * @param jstr JSON call
+     * @param rendered if not null, answers are written directly to it, from
+     *        the prediction output, and the returned document only holds
+     *        status and head. Left empty when the answer needs the full JSON
+     *        document, e.g. for output templates.
+     * @param encoding rendered answer encoding
+     */
+    JDoc service_predict(const std::string &jstr,
+                         std::string *rendered = nullptr,
+                         const RenderEncoding &encoding = RENDER_JSON);
+
+    /**
+     * \brief writes a predict answer from the prediction output
+     */
+    template <typename Writer>
+    void render_predict(Writer &writer, const JDoc &jpred,
+                        const std::string &sname, const APIData &out) const;
 
     JDoc service_train(const std::string &jstr);
     JDoc service_train_status(const std::string &jstr);
@@ -105,6 +140,18 @@ namespace dd
 
     JDoc service_chain(const std::string &cname, const std::string &jstr);
 
+    /**
+     * \brief adds a call trace to the answer body, or writes it to the
+     * traces directory of a service model repository
+     * @param trace call trace, nothing is done if null
+     * @param inline_trace whether to add the trace to the answer body
+     * @param sname service whose repository holds written traces
+     * @param jd answer document
+     * @param jbody answer body
+     */
+    void trace_out(const Trace *trace, const bool &inline_trace,
+                   const std::string &sname, JDoc &jd, JVal &jbody);
+
     static int store_json_blob(const std::string &model_repo,
                                const std::string &jstr,
                                const std::string &jfilename = "");
@@ -128,7 +175,8 @@ namespace dd
   class visitor_info
   {
   public:
-    visitor_info(const bool &status) : _status(status)
+    visitor_info(const bool &status, const bool &reset_stats = false)
+        : _status(status), _reset_stats(reset_stats)
     {
     }
     ~visitor_info()
@@ -137,9 +185,33 @@ namespace dd
 
     template <typename T> APIData operator()(T &mllib)
     {
-      return mllib.info(_status);
+      APIData ad = mllib.info(_status);
+      if (_reset_stats)
+        mllib._stats.reset_window();
+      return ad;
     }
     bool _status = false;
+    bool _reset_stats = false; /**< starts a new latency window. */
+  };
+
+  /**
+   * \brief visitor class for service metrics call
+   */
+  class visitor_metrics
+  {
+  public:
+    visitor_metrics(PrometheusWriter &pw) : _pw(pw)
+    {
+    }
+    ~visitor_metrics()
+    {
+    }
+
+    template <typename T> void operator()(T &mllib)
+    {
+      mllib.metrics(_pw);
+    }
+    PrometheusWriter &_pw;
   };
 
   /**
@@ -0,0 +1,781 @@
+/**
+ * DeepDetect
+ * Copyright (c) 2023 Jolibrain
+ *
+ * This file is part of deepdetect.
+ *
+ * deepdetect is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * deepdetect is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with deepdetect.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MEASURE_ACCUMULATOR_H
+#define MEASURE_ACCUMULATOR_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "supervisedoutputconnector.h"
+
+namespace dd
+{
+  /**
+   * \brief test measures updated batch after batch, so that per sample
+   * predictions and targets are not kept until the end of the test. Measures
+   * are those of SupervisedOutput::measure, with the same values, except for
+   * auc that is computed from score histograms unless exact, and acc-k, that
+   * counts a sample when less than k classes score higher than its target.
+   * Accumulators over parts of a test set, e.g. from several threads, are
+   * merged.
+   */
+  class MeasureAccumulator
+  {
+  public:
+    enum Task
+    {
+      CLASSIFICATION,
+      SEGMENTATION,
+      REGRESSION,
+      TIMESERIE,
+      BBOX
+    };
+
+    /**
+     * @param measures requested measures, from output parameters
+     * @param nclasses number of classes, of regression targets or of
+     *        timeseries
+     * @param auc_bins number of score histogram bins for auc, 0 for exact
+     */
+    MeasureAccumulator(const Task &task,
+                       const std::vector<std::string> &measures,
+                       const int &nclasses, const int &auc_bins = 10000)
+        : _task(task), _nclasses(nclasses), _auc_bins(auc_bins)
+    {
+      auto has = [&measures](const std::string &m) {
+        return std::find(measures.begin(), measures.end(), m)
+               != measures.end();
+      };
+      if (_task == CLASSIFICATION)
+        {
+          for (const std::string &s : measures)
+            if (s.find("acc") != std::string::npos)
+              {
+                std::vector<std::string> sv = dd_utils::split(s, '-');
+                _acck.push_back(sv.size() == 2 ? std::atoi(sv.at(1).c_str())
+                                               : 1);
+              }
+          _acck_count.resize(_acck.size(), 0);
+          _f1 = has("f1") || has("f1full");
+          _f1full = has("f1full");
+          _cmdiag = has("cmdiag");
+          _cmfull = has("cmfull");
+          _mcc = has("mcc");
+          _mcll = has("mcll");
+          _auc = has("auc");
+          if (_f1 || _mcc)
+            _cm.resize(static_cast<size_t>(_nclasses) * _nclasses, 0);
+          if (_auc && _auc_bins > 0)
+            {
+              _auc_pos.resize(_auc_bins, 0);
+              _auc_neg.resize(_auc_bins, 0);
+            }
+        }
+      else if (_task == SEGMENTATION)
+        {
+          _segacc = has("acc");
+          _mean_acc.resize(_nclasses, 0.0);
+          _mean_acc_bs.resize(_nclasses, 0.0);
+          _mean_iou.resize(_nclasses, 0.0);
+          _mean_iou_bs.resize(_nclasses, 0.0);
+        }
+      else if (_task == REGRESSION)
+        {
+          SupervisedOutput::find_presence_and_thres("eucll", measures,
+                                                    _eucll, _eucll_thres);
+          _l1 = has("l1");
+          _percent = has("percent");
+          _eucll_all.resize(_nclasses, 0.0);
+          _eucll_thres_all.resize(_nclasses, 0.0);
+          _l1_all.resize(_nclasses, 0.0);
+          _percent_all.resize(_nclasses, 0.0);
+        }
+      else if (_task == TIMESERIE)
+        {
+          _ts_l1_all = has("L1_all");
+          _ts_l2_all = has("L2_all");
+          _ts_l1 = has("L1") || _ts_l1_all;
+          _ts_l2 = has("L2") || _ts_l2_all;
+          // L1 by default, as SupervisedOutput::measure
+          if (!_ts_l1 && !_ts_l2)
+            _ts_l1 = true;
+          for (TimeserieErrors *tse : { &_ts_l1_errors, &_ts_l2_errors })
+            {
+              tse->_mean.resize(_nclasses, 0.0);
+              tse->_max.resize(_nclasses, 0.0);
+              tse->_max_index.resize(_nclasses, 0);
+            }
+        }
+      else if (_task == BBOX)
+        _map = has("map");
+    }
+
+    /**
+     * \brief whether all requested measures can be accumulated, otherwise
+     * measures are to be computed from all predictions
+     */
+    static bool supports(const Task &task,
+                         const std::vector<std::string> &measures)
+    {
+      for (const std::string &s : measures)
+        {
+          bool ok = false;
+          if (task == CLASSIFICATION)
+            ok = s == "f1" || s == "f1full" || s == "cmdiag" || s == "cmfull"
+                 || s == "mcc" || s == "mcll" || s == "auc" || s == "acc"
+                 || s.compare(0, 4, "acc-") == 0;
+          else if (task == SEGMENTATION)
+            ok = s == "acc" || s == "meanacc" || s == "meaniou";
+          else if (task == REGRESSION)
+            ok = s == "eucll" || s.compare(0, 6, "eucll-") == 0 || s == "l1"
+                 || s == "percent";
+          else if (task == TIMESERIE)
+            ok = s == "L1" || s == "L2" || s == "L1_all" || s == "L2_all";
+          else if (task == BBOX)
+            ok = s == "map";
+          if (!ok)
+            return false;
+        }
+      return true;
+    }
+
+    /**
+     * \brief number of accumulated samples
+     */
+    int size() const
+    {
+      return _count;
+    }
+
+    /**
+     * \brief adds a classification sample
+     * @param probs nclasses probabilities
+     */
+    template <typename T> void add_classification(const T *probs, int target)
+    {
+      if (target < 0)
+        throw OutputConnectorBadParamException(
+            "negative supervised discrete target (e.g. wrong use of "
+            "label_offset ?");
+      else if (target >= _nclasses)
+        throw OutputConnectorBadParamException(
+            "target class has id " + std::to_string(target)
+            + " is higher than the number of classes "
+            + std::to_string(_nclasses)
+            + " (e.g. wrong number of classes specified with nclasses");
+      ++_count;
+      const T ptarget = probs[target];
+      int maxpr = 0;
+      int higher = 0;
+      for (int c = 0; c < _nclasses; ++c)
+        {
+          if (probs[c] > probs[maxpr])
+            maxpr = c;
+          higher += probs[c] > ptarget;
+        }
+      for (size_t k = 0; k < _acck.size(); ++k)
+        if (_acck[k] <= _nclasses && higher < _acck[k])
+          ++_acck_count[k];
+      if (!_cm.empty())
+        ++_cm[static_cast<size_t>(maxpr) * _nclasses + target];
+      if (_mcll)
+        _ll -= std::log(static_cast<double>(ptarget));
+      if (_auc)
+        {
+          double p1 = probs[1];
+          if (_auc_bins > 0)
+            {
+              int b = std::min(
+                  _auc_bins - 1,
+                  std::max(0, static_cast<int>(p1 * _auc_bins)));
+              ++(target == 1 ? _auc_pos : _auc_neg)[b];
+            }
+          else
+            {
+              _auc_preds.push_back(p1);
+              _auc_targets.push_back(target);
+            }
+        }
+    }
+
+    /**
+     * \brief adds a segmentation sample
+     * @param pred best class per pixel
+     * @param target class per pixel, values beyond nclasses are ignored
+     */
+    template <typename T>
+    void add_segmentation(const T *pred, const T *target, const size_t &size)
+    {
+      ++_count;
+      std::vector<int64_t> tp(_nclasses, 0);
+      std::vector<int64_t> fp(_nclasses, 0);
+      std::vector<int64_t> fn(_nclasses, 0);
+      int64_t correct = 0;
+      for (size_t i = 0; i < size; ++i)
+        {
+          const int64_t p = pred[i];
+          const int64_t t = target[i];
+          if (p == t)
+            {
+              ++correct;
+              if (t >= 0 && t < _nclasses)
+                ++tp[t];
+            }
+          else
+            {
+              if (p >= 0 && p < _nclasses)
+                ++fp[p];
+              if (t >= 0 && t < _nclasses)
+                ++fn[t];
+            }
+        }
+      _acc_v += correct / static_cast<double>(size);
+      for (int c = 0; c < _nclasses; ++c)
+        {
+          double c_total_targ = tp[c] + fn[c];
+          if (c_total_targ != 0)
+            {
+              _mean_acc[c] += tp[c] / c_total_targ;
+              _mean_acc_bs[c]++;
+              _mean_iou_bs[c]++;
+            }
+          if (tp[c] != 0)
+            _mean_iou[c] += tp[c] / static_cast<double>(fp[c] + tp[c] + fn[c]);
+        }
+    }
+
+    /**
+     * \brief adds a regression sample, of nclasses targets
+     */
+    template <typename T> void add_regression(const T *pred, const T *target)
+    {
+      ++_count;
+      double leucl = 0.0;
+      double leucl_thres = 0.0;
+      for (int j = 0; j < _nclasses; ++j)
+        {
+          double diff = std::fabs(static_cast<double>(pred[j]) - target[j]);
+          leucl += diff * diff;
+          _eucll_all[j] += diff * diff;
+          if (_eucll_thres >= 0 && diff >= _eucll_thres)
+            {
+              leucl_thres += diff * diff;
+              _eucll_thres_all[j] += diff * diff;
+            }
+          _l1_sum += diff / _nclasses;
+          _l1_all[j] += diff;
+          double reldiff = diff / (std::fabs(target[j]) + 1E-9);
+          _percent_sum += reldiff / _nclasses;
+          _percent_all[j] += reldiff;
+        }
+      _eucll_sum += std::sqrt(leucl) / _nclasses;
+      _eucll_thres_sum += std::sqrt(leucl_thres) / _nclasses;
+      // as SupervisedOutput::distl
+      for (int j = 0; j < _nclasses; ++j)
+        {
+          _eucll_all[j] = std::sqrt(_eucll_all[j]);
+          _eucll_thres_all[j] = std::sqrt(_eucll_thres_all[j]);
+        }
+    }
+
+    /**
+     * \brief adds a timeseries sample
+     * @param size timesteps x nclasses interleaved values
+     */
+    template <typename T>
+    void add_timeserie(const T *pred, const T *target, const size_t &size)
+    {
+      if (_ts_l1)
+        _ts_l1_errors.add(pred, target, size, _nclasses, _count == 0, true);
+      if (_ts_l2)
+        _ts_l2_errors.add(pred, target, size, _nclasses, _count == 0, false);
+      ++_count;
+    }
+
+    /**
+     * \brief adds detection statistics of a sample, per class true and false
+     * positives and number of positives, reduced to their average precision
+     */
+    void add_bbox(const std::vector<APIData> &vbad)
+    {
+      ++_count;
+      for (const APIData &ad : vbad)
+        {
+          std::vector<double> tp_d = ad.get("tp_d").get<std::vector<double>>();
+          std::vector<int> tp_i = ad.get("tp_i").get<std::vector<int>>();
+          std::vector<double> fp_d = ad.get("fp_d").get<std::vector<double>>();
+          std::vector<int> fp_i = ad.get("fp_i").get<std::vector<int>>();
+          int num_pos = ad.get("num_pos").get<int>();
+          int label = ad.get("label").get<int>();
+          std::vector<std::pair<double, int>> tp;
+          std::vector<std::pair<double, int>> fp;
+          for (size_t j = 0; j < tp_d.size(); j++)
+            tp.push_back(std::pair<double, int>(tp_d.at(j), tp_i.at(j)));
+          for (size_t j = 0; j < fp_d.size(); j++)
+            fp.push_back(std::pair<double, int>(fp_d.at(j), fp_i.at(j)));
+          if (tp.size() > 0 || fp.size() > 0 || num_pos > 0)
+            {
+              double local_ap = SupervisedOutput::compute_ap(tp, fp, num_pos);
+              _aps[label] += local_ap;
+              _aps_count[label] += 1;
+              _ap_sum += local_ap;
+              ++_ap_count;
+            }
+          else
+            {
+              _aps[label] += 0.0;
+              _aps_count[label] += 0;
+            }
+        }
+    }
+
+    /**
+     * \brief adds the samples of another accumulator, with same measures.
+     * Per target eucll and timeseries L2 errors are square rooted after
+     * every sample and are only summed.
+     */
+    void merge(const MeasureAccumulator &acc)
+    {
+      auto add = [](auto &a, const auto &b) {
+        for (size_t i = 0; i < a.size() && i < b.size(); ++i)
+          a[i] += b[i];
+      };
+      if (_task == TIMESERIE)
+        {
+          _ts_l1_errors.merge(acc._ts_l1_errors, _count == 0);
+          _ts_l2_errors.merge(acc._ts_l2_errors, _count == 0);
+        }
+      _count += acc._count;
+      add(_acck_count, acc._acck_count);
+      add(_cm, acc._cm);
+      _ll += acc._ll;
+      add(_auc_pos, acc._auc_pos);
+      add(_auc_neg, acc._auc_neg);
+      _auc_preds.insert(_auc_preds.end(), acc._auc_preds.begin(),
+                        acc._auc_preds.end());
+      _auc_targets.insert(_auc_targets.end(), acc._auc_targets.begin(),
+                          acc._auc_targets.end());
+      _acc_v += acc._acc_v;
+      add(_mean_acc, acc._mean_acc);
+      add(_mean_acc_bs, acc._mean_acc_bs);
+      add(_mean_iou, acc._mean_iou);
+      add(_mean_iou_bs, acc._mean_iou_bs);
+      _eucll_sum += acc._eucll_sum;
+      _eucll_thres_sum += acc._eucll_thres_sum;
+      _l1_sum += acc._l1_sum;
+      _percent_sum += acc._percent_sum;
+      add(_eucll_all, acc._eucll_all);
+      add(_eucll_thres_all, acc._eucll_thres_all);
+      add(_l1_all, acc._l1_all);
+      add(_percent_all, acc._percent_all);
+      for (auto ap : acc._aps)
+        _aps[ap.first] += ap.second;
+      for (auto apc : acc._aps_count)
+        _aps_count[apc.first] += apc.second;
+      _ap_sum += acc._ap_sum;
+      _ap_count += acc._ap_count;
+    }
+
+    /**
+     * \brief writes measures, with SupervisedOutput::measure names
+     * @param clnames class names, for confusion matrices
+     */
+    void to(APIData &meas_out, const std::vector<std::string> &clnames) const
+    {
+      if (_count == 0)
+        return;
+      const double count = static_cast<double>(_count);
+      if (_task == CLASSIFICATION)
+        classification_to(meas_out, clnames);
+      else if (_task == SEGMENTATION && _segacc)
+        {
+          std::vector<double> clacc = _mean_acc;
+          std::vector<double> cliou = _mean_iou;
+          double meanacc = 0.0;
+          double meaniou = 0.0;
+          int c_nclasses = 0;
+          for (int c = 0; c < _nclasses; c++)
+            {
+              if (_mean_acc_bs[c] > 0.0)
+                {
+                  clacc[c] /= _mean_acc_bs[c];
+                  cliou[c] /= _mean_iou_bs[c];
+                  c_nclasses++;
+                }
+              meanacc += clacc[c];
+              meaniou += cliou[c];
+            }
+          if (c_nclasses > 0)
+            {
+              meanacc /= static_cast<double>(c_nclasses);
+              meaniou /= static_cast<double>(c_nclasses);
+            }
+          meas_out.add("acc", _acc_v / count);
+          meas_out.add("meanacc", meanacc);
+          meas_out.add("meaniou", meaniou);
+          meas_out.add("clacc", clacc);
+          meas_out.add("cliou", cliou);
+        }
+      else if (_task == REGRESSION)
+        {
+          auto mean = [count](std::vector<double> v, const double &scale) {
+            for (double &d : v)
+              d *= scale / count;
+            return v;
+          };
+          if (_eucll)
+            {
+              std::vector<double> all = mean(_eucll_all, 1.0);
+              meas_out.add("eucll", _eucll_sum / count);
+              if (all.size() > 1)
+                for (size_t i = 0; i < all.size(); ++i)
+                  meas_out.add("eucll_" + std::to_string(i), all[i]);
+              if (_eucll_thres > 0)
+                {
+                  meas_out.add("eucll_no_" + std::to_string(_eucll_thres),
+                               _eucll_thres_sum / count);
+                  all = mean(_eucll_thres_all, 1.0);
+                  if (all.size() > 1)
+                    for (size_t i = 0; i < all.size(); ++i)
+                      meas_out.add("eucll_no_" + std::to_string(i) + "_"
+                                       + std::to_string(_eucll_thres),
+                                   all[i]);
+                }
+            }
+          if (_l1)
+            {
+              meas_out.add("l1", _l1_sum / count);
+              std::vector<double> all = mean(_l1_all, 1.0);
+              for (size_t i = 0; i < all.size(); ++i)
+                meas_out.add("l1_" + std::to_string(i), all[i]);
+            }
+          if (_percent)
+            {
+              meas_out.add("percent", _percent_sum * 100.0 / count);
+              std::vector<double> all = mean(_percent_all, 100.0);
+              for (size_t i = 0; i < all.size(); ++i)
+                meas_out.add("percent_" + std::to_string(i), all[i]);
+            }
+        }
+      else if (_task == TIMESERIE)
+        {
+          if (_ts_l1)
+            _ts_l1_errors.to(meas_out, "L1", _ts_l1_all, _nclasses);
+          if (_ts_l1 && !_ts_l2)
+            meas_out.add("eucll", _ts_l1_errors.mean_error(_nclasses));
+          if (_ts_l2)
+            {
+              _ts_l2_errors.to(meas_out, "L2", _ts_l2_all, _nclasses);
+              meas_out.add("eucll", _ts_l2_errors.mean_error(_nclasses));
+            }
+        }
+      else if (_task == BBOX && _map)
+        {
+          meas_out.add("map", _ap_count == 0 ? 0.0 : _ap_sum / _ap_count);
+          for (auto ap : _aps)
+            {
+              int apc = _aps_count.at(ap.first);
+              meas_out.add("map_" + std::to_string(ap.first),
+                           apc == 0 ? 0.0 : ap.second / apc);
+            }
+        }
+    }
+
+  private:
+    /**
+     * \brief per timeserie errors, as SupervisedOutput::timeSeriesErrors
+     */
+    struct TimeserieErrors
+    {
+      std::vector<double> _mean;
+      std::vector<double> _max;
+      std::vector<int> _max_index;
+      double _nts = 0.0;
+
+      template <typename T>
+      void add(const T *pred, const T *target, const size_t &size,
+               const int &timeseries, const bool &first, const bool &l1)
+      {
+        _nts += size;
+        const size_t duration = size / timeseries;
+        for (int s = 0; s < timeseries; ++s)
+          {
+            double bmax = 0.0;
+            int bmax_index = 0;
+            for (size_t t = 0; t < duration; ++t)
+              {
+                size_t i = t * timeseries + s;
+                double err
+                    = std::fabs(static_cast<double>(pred[i]) - target[i]);
+                if (!l1)
+                  err *= err;
+                if (t == 0 || err > bmax)
+                  {
+                    bmax = err;
+                    bmax_index = t;
+                  }
+                _mean[s] += err;
+              }
+            if (!l1)
+              _mean[s] = std::sqrt(_mean[s]);
+            if (first || bmax > _max[s])
+              {
+                _max[s] = bmax;
+                _max_index[s] = bmax_index;
+              }
+          }
+      }
+
+      void merge(const TimeserieErrors &tse, const bool &first)
+      {
+        _nts += tse._nts;
+        for (size_t s = 0; s < _mean.size(); ++s)
+          {
+            _mean[s] += tse._mean[s];
+            if (first || tse._max[s] > _max[s])
+              {
+                _max[s] = tse._max[s];
+                _max_index[s] = tse._max_index[s];
+              }
+          }
+      }
+
+      double mean_error(const int &timeseries) const
+      {
+        double mean_error = 0.0;
+        for (int s = 0; s < timeseries; ++s)
+          mean_error += _mean[s] / _nts * timeseries;
+        return mean_error / timeseries;
+      }
+
+      void to(APIData &meas_out, const std::string &name, const bool &all,
+              const int &timeseries) const
+      {
+        double max_error = _max[0];
+        for (int s = 0; s < timeseries; ++s)
+          {
+            max_error = std::max(max_error, _max[s]);
+            if (all)
+              {
+                meas_out.add(name + "_max_error_" + std::to_string(s),
+                             _max[s]);
+                meas_out.add(name + "_max_error_" + std::to_string(s)
+                                 + "_date",
+                             static_cast<double>(_max_index[s]));
+                meas_out.add(name + "_mean_error_" + std::to_string(s),
+                             _mean[s] / _nts * timeseries);
+              }
+          }
+        meas_out.add(name + "_max_error", max_error);
+        meas_out.add(name + "_mean_error", mean_error(timeseries));
+      }
+    };
+
+    void classification_to(APIData &meas_out,
+                           const std::vector<std::string> &clnames) const
+    {
+      const double count = static_cast<double>(_count);
+      for (size_t k = 0; k < _acck.size(); ++k)
+        {
+          std::string key = "acc";
+          if (_acck[k] > 1)
+            key += "-" + std::to_string(_acck[k]);
+          meas_out.add(key, _acck_count[k] / count);
+        }
+      if (_f1)
+        {
+          // as SupervisedOutput::mf1, rows are predictions, columns targets
+          const double eps = 1e-8;
+          const int n = _nclasses;
+          std::vector<double> csum(n, 0.0);
+          std::vector<double> rsum(n, 0.0);
+          double diag_sum = 0.0;
+          for (int p = 0; p < n; ++p)
+            for (int t = 0; t < n; ++t)
+              {
+                double v = _cm[static_cast<size_t>(p) * n + t];
+                csum[t] += v;
+                rsum[p] += v;
+                if (p == t)
+                  diag_sum += v;
+              }
+          std::vector<double> precisions(n), recalls(n), f1s(n), cmdiag(n);
+          double precision = 0.0, recall = 0.0, f1 = 0.0;
+          for (int c = 0; c < n; ++c)
+            {
+              double d = _cm[static_cast<size_t>(c) * n + c];
+              recalls[c] = d / (csum[c] + eps);
+              precisions[c] = d / (rsum[c] + eps);
+              f1s[c] = 2.0 * precisions[c] * recalls[c]
+                       / (precisions[c] + recalls[c] + eps);
+              cmdiag[c] = d / (csum[c] + eps);
+              precision += precisions[c];
+              recall += recalls[c];
+              f1 += f1s[c];
+            }
+          meas_out.add("f1", f1 / n);
+          meas_out.add("precision", precision / n);
+          meas_out.add("recall", recall / n);
+          meas_out.add("accp", diag_sum / count);
+          if (_f1full)
+            {
+              meas_out.add("precisions", precisions);
+              meas_out.add("recalls", recalls);
+              meas_out.add("f1s", f1s);
+              if (!_cmdiag)
+                meas_out.add("labels", clnames);
+            }
+          if (_cmdiag)
+            {
+              meas_out.add("cmdiag", cmdiag);
+              meas_out.add("labels", clnames);
+            }
+          if (_cmfull)
+            {
+              std::vector<APIData> cmdata;
+              for (int t = 0; t < n; t++)
+                {
+                  std::vector<double> cmrow(n);
+                  for (int p = 0; p < n; p++)
+                    {
+                      cmrow[p] = _cm[static_cast<size_t>(p) * n + t];
+                      if (csum[t] > 0)
+                        cmrow[p] /= csum[t];
+                    }
+                  APIData adrow;
+                  adrow.add(clnames.at(t), cmrow);
+                  cmdata.push_back(adrow);
+                }
+              meas_out.add("cmfull", cmdata);
+            }
+        }
+      if (_mcll)
+        meas_out.add("mcll", _ll / count);
+      if (_auc)
+        meas_out.add("auc", _auc_bins > 0 ? binned_auc()
+                                          : SupervisedOutput::auc(
+                                              _auc_preds, _auc_targets));
+      if (_mcc)
+        {
+          const int n = _nclasses;
+          double tp = _cm[0];
+          double tn = _cm[n + 1];
+          double fn = _cm[1];
+          double fp = _cm[n];
+          double den = (tp + fp) * (tp + fn) * (tn + fp) * (tn + fn);
+          if (den == 0.0)
+            den = 1.0;
+          meas_out.add("mcc", (tp * tn - fp * fn) / std::sqrt(den));
+        }
+    }
+
+    /**
+     * \brief auc with scores of a same bin as ties, as SupervisedOutput::auc
+     */
+    double binned_auc() const
+    {
+      double ones = 0.0;
+      double count = 0.0;
+      for (int b = 0; b < _auc_bins; ++b)
+        {
+          ones += _auc_pos[b];
+          count += _auc_pos[b] + _auc_neg[b];
+        }
+      if (ones == 0.0 || ones == count)
+        return 1;
+      double true_pos = ones;
+      double tp0 = ones;
+      double accum = 0.0;
+      for (int b = 0; b < _auc_bins; ++b)
+        {
+          true_pos -= _auc_pos[b];
+          accum += _auc_neg[b] * (true_pos + tp0);
+          tp0 = true_pos;
+        }
+      return accum / (2.0 * ones * (count - ones));
+    }
+
+    Task _task;
+    int _nclasses = 0;
+    int _auc_bins = 0;
+    int _count = 0; /**< number of samples. */
+
+    // classification
+    std::vector<int> _acck;
+    std::vector<int64_t> _acck_count;
+    bool _f1 = false;
+    bool _f1full = false;
+    bool _cmdiag = false;
+    bool _cmfull = false;
+    bool _mcc = false;
+    bool _mcll = false;
+    bool _auc = false;
+    std::vector<int64_t> _cm; /**< nclasses x nclasses, predictions first. */
+    double _ll = 0.0;
+    std::vector<int64_t> _auc_pos;
+    std::vector<int64_t> _auc_neg;
+    std::vector<double> _auc_preds; /**< exact auc. */
+    std::vector<double> _auc_targets;
+
+    // segmentation
+    bool _segacc = false;
+    double _acc_v = 0.0;
+    std::vector<double> _mean_acc;
+    std::vector<double> _mean_acc_bs;
+    std::vector<double> _mean_iou;
+    std::vector<double> _mean_iou_bs;
+
+    // regression
+    bool _eucll = false;
+    float _eucll_thres = -1;
+    bool _l1 = false;
+    bool _percent = false;
+    double _eucll_sum = 0.0;
+    double _eucll_thres_sum = 0.0;
+    double _l1_sum = 0.0;
+    double _percent_sum = 0.0;
+    std::vector<double> _eucll_all;
+    std::vector<double> _eucll_thres_all;
+    std::vector<double> _l1_all;
+    std::vector<double> _percent_all;
+
+    // timeseries
+    bool _ts_l1 = false;
+    bool _ts_l2 = false;
+    bool _ts_l1_all = false;
+    bool _ts_l2_all = false;
+    TimeserieErrors _ts_l1_errors;
+    TimeserieErrors _ts_l2_errors;
+
+    // detection
+    bool _map = false;
+    std::map<int, double> _aps;
+    std::map<int, int> _aps_count;
+    double _ap_sum = 0.0;
+    int _ap_count = 0;
+  };
+}
+
+#endif
@@ -38,6 +38,7 @@
 #include <boost/thread/lock_types.hpp>
 #include <unordered_map>
 #include <chrono>
+#include <cmath>
 #include <iostream>
 
 namespace dd
@@ -252,6 +253,48 @@ namespace dd
       return ad;
     }
 
+    /**
+     * \brief adds service metrics in Prometheus format
+     * @param pw metrics writer
+     */
+    void metrics(PrometheusWriter &pw) const
+    {
+      std::string labels = PrometheusWriter::label("service", _sname) + ","
+                           + PrometheusWriter::label("mllib", this->_libname);
+      this->_stats.to(pw, labels);
+
+      int running = 0;
+      double iteration = std::numeric_limits<double>::quiet_NaN();
+      double elapsed_s = 0.0;
+      {
+        std::lock_guard<std::mutex> lock(_tjobs_mutex);
+        for (const auto &tj : _training_jobs)
+          if (tj.second._status == 1)
+            {
+              ++running;
+              elapsed_s = std::chrono::duration<double>(
+                              std::chrono::system_clock::now()
+                              - tj.second._tstart)
+                              .count();
+            }
+      }
+      pw.declare("dd_training_jobs_running", "gauge",
+                 "Training jobs running.");
+      pw.add("dd_training_jobs_running", labels, running);
+      if (running > 0 && this->_tjob_running.load())
+        iteration = this->get_meas("iteration");
+      if (!std::isnan(iteration) && elapsed_s > 0.0)
+        {
+          pw.declare("dd_training_iteration", "gauge",
+                     "Current training iteration.");
+          pw.add("dd_training_iteration", labels, iteration);
+          pw.declare("dd_training_iterations_per_second", "gauge",
+                     "Training iterations per second since job start.");
+          pw.add("dd_training_iterations_per_second", labels,
+                 iteration / elapsed_s);
+        }
+    }
+
     /**
      * \brief get status of the service
      *        To be surcharged in related classes
@@ -505,7 +548,7 @@ namespace dd
         throw MLServiceLockException(
             "Predict call while training with an offline learning algorithm");
 
-      this->_stats.predict_start();
+      auto predict_tstart = this->_stats.predict_start();
 
       int err = 0;
       try
@@ -517,10 +560,10 @@ namespace dd
       catch (std::exception &e)
         {
           _train_mutex.unlock_shared();
-          this->_stats.predict_end(false);
+          this->_stats.predict_end(predict_tstart, false);
           throw;
         }
-      this->_stats.predict_end(true);
+      this->_stats.predict_end(predict_tstart, true);
 
       _train_mutex.unlock_shared();
       return err;
@@ -169,7 +169,9 @@ namespace dd
   }
 
   std::shared_ptr<oatpp::web::protocol::http::outgoing::Response>
-  OatppJsonAPI::jdoc_to_response(const JDoc &janswer) const
+  OatppJsonAPI::jdoc_to_response(const JDoc &janswer,
+                                 const std::string &rendered,
+                                 const std::string &content_type) const
   {
     // NOTE(sileht): Maybe not the best place to do this, but we need DTO in
     // all calls before doing it otherwise
@@ -182,6 +184,7 @@ namespace dd
 
     int outcode = janswer["status"]["code"].GetInt();
     std::string stranswer;
+    std::string answer_content_type = "application/json";
     // if output template, fillup with rendered template.
     if (janswer.HasMember("template"))
       {
@@ -190,6 +193,11 @@ namespace dd
         mustache::RenderTemplate(tpl, " ", janswer, &sg);
         stranswer = sg.str();
       }
+    else if (!rendered.empty())
+      {
+        stranswer = rendered;
+        answer_content_type = content_type;
+      }
     else
       {
         stranswer = jrender(janswer);
@@ -233,9 +241,9 @@ namespace dd
 
     auto response = oatpp::web::protocol::http::outgoing::ResponseFactory::
         createResponse(oatpp::web::protocol::http::Status(outcode, ""),
-                       stranswer.c_str());
+                       oatpp::String(stranswer)); // may be binary
     response->putHeader(oatpp::web::protocol::http::Header::CONTENT_TYPE,
-                        "application/json");
+                        answer_content_type.c_str());
 
     return response;
   }
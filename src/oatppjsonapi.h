@@ -46,7 +46,15 @@ namespace dd
     static void abort(int param);
     std::string
     uri_query_to_json(oatpp::web::protocol::http::QueryParams queryParams);
-    Response_ptr jdoc_to_response(const JDoc &janswer) const;
+    /**
+     * \brief HTTP response from a JSON answer
+     * @param rendered answer already rendered, if not empty
+     * @param content_type rendered answer content type
+     */
+    Response_ptr
+    jdoc_to_response(const JDoc &janswer, const std::string &rendered = "",
+                     const std::string &content_type
+                     = "application/json") const;
 
     oatpp::Object<DTO::Status>
     create_status_dto(const uint32_t &code, const std::string &msg,
@@ -21,6 +21,7 @@
  */
 
 #include <chrono>
+#include <sstream>
 
 #include "apidata.h"
 #include "service_stats.h"
@@ -30,66 +31,164 @@ namespace dd
 
   void ServiceStats::inc_inference_count(const int &l)
   {
-    _inference_count += l;
+    _counters.add(INFERENCE_COUNT, l);
+    int b = 0;
+    while (b < _nbatch_buckets - 1 && l > (1 << b))
+      ++b;
+    _batch_sizes.add(b);
+    _batch_sizes.add(_nbatch_buckets, l);
   }
-  void ServiceStats::transform_start()
+
+  void ServiceStats::transform_end(const time_point &tstart)
   {
-    _transform_tstart = std::chrono::steady_clock::now();
+    add_stage_duration(TRANSFORM, elapsed_ms(tstart));
   }
-  void ServiceStats::transform_end()
+
+  void ServiceStats::predict_end(const time_point &tstart, bool succeed)
   {
-    auto tend = std::chrono::steady_clock::now();
-    _transform_total_duration_ms += tend - _transform_tstart;
+    add_stage_duration(PREDICT, elapsed_ms(tstart));
+    _counters.add(succeed ? PREDICT_SUCCESS : PREDICT_FAILURE);
+    --_predict_inflight;
   }
 
-  void ServiceStats::predict_start()
+  void ServiceStats::add_stage_duration(const Stage &stage, const double &ms)
   {
-    _predict_tstart = std::chrono::steady_clock::now();
+    _latencies[stage].record(ms);
+    _stage_totals.add(2 * stage);
+    _stage_totals.add(2 * stage + 1, static_cast<uint64_t>(ms * 1e6));
   }
 
-  void ServiceStats::predict_end(bool succeed)
+  void ServiceStats::reset_window()
   {
     std::lock_guard<std::mutex> lock(_mutex);
-
-    if (succeed)
-      _predict_success++;
-    else
-      _predict_failure++;
-
-    auto tend = std::chrono::steady_clock::now();
-    _predict_total_duration_ms += tend - _predict_tstart;
-
-    int _predict_count = _predict_success + _predict_failure;
-    _avg_batch_size = _inference_count / static_cast<double>(_predict_count);
-    _avg_transform_duration_ms = _transform_total_duration_ms.count()
-                                 / static_cast<double>(_predict_count);
-    _avg_predict_duration_ms = _predict_total_duration_ms.count()
-                               / static_cast<double>(_predict_count);
+    for (LatencyHistogram &h : _latencies)
+      h.reset();
+    _window_tstart = now();
   }
 
+  static const char *stage_names[ServiceStats::NSTAGES]
+      = { "predict", "transform", "forward", "output", "serialization" };
+
   void ServiceStats::to(APIData &ad) const
   {
     std::lock_guard<std::mutex> lock(_mutex);
 
     APIData stats;
 
-    stats.add("inference_count", _inference_count);
-    stats.add("predict_success", _predict_success);
-    stats.add("predict_failure", _predict_failure);
-    stats.add("predict_count", _predict_success + _predict_failure);
-    stats.add("avg_batch_size", _avg_batch_size);
-    stats.add("avg_predict_duration_ms", _avg_predict_duration_ms);
-    stats.add("avg_transform_duration_ms", _avg_transform_duration_ms);
-    stats.add("avg_predict_duration_s", _avg_predict_duration_ms / 1000.0);
-    stats.add("avg_transform_duration_s", _avg_transform_duration_ms / 1000.0);
-    stats.add("total_predict_duration_ms", _predict_total_duration_ms.count());
-    stats.add("total_transform_duration_ms",
-              _transform_total_duration_ms.count());
+    int inference_count = _counters.value(INFERENCE_COUNT);
+    int predict_success = _counters.value(PREDICT_SUCCESS);
+    int predict_failure = _counters.value(PREDICT_FAILURE);
+    int predict_count = predict_success + predict_failure;
+    double predict_total_duration_ms
+        = _stage_totals.value(2 * PREDICT + 1) / 1e6;
+    double transform_total_duration_ms
+        = _stage_totals.value(2 * TRANSFORM + 1) / 1e6;
+    double avg_batch_size = -1;
+    double avg_predict_duration_ms = -1;
+    double avg_transform_duration_ms = -1;
+    if (predict_count > 0)
+      {
+        avg_batch_size = inference_count / static_cast<double>(predict_count);
+        avg_predict_duration_ms
+            = predict_total_duration_ms / static_cast<double>(predict_count);
+        avg_transform_duration_ms
+            = transform_total_duration_ms / static_cast<double>(predict_count);
+      }
+
+    stats.add("inference_count", inference_count);
+    stats.add("predict_success", predict_success);
+    stats.add("predict_failure", predict_failure);
+    stats.add("predict_count", predict_count);
+    stats.add("avg_batch_size", avg_batch_size);
+    stats.add("avg_predict_duration_ms", avg_predict_duration_ms);
+    stats.add("avg_transform_duration_ms", avg_transform_duration_ms);
+    stats.add("avg_predict_duration_s", avg_predict_duration_ms / 1000.0);
+    stats.add("avg_transform_duration_s", avg_transform_duration_ms / 1000.0);
+    stats.add("total_predict_duration_ms", predict_total_duration_ms);
+    stats.add("total_transform_duration_ms", transform_total_duration_ms);
+
+    APIData latencies;
+    for (int s = 0; s < NSTAGES; ++s)
+      {
+        const LatencyHistogram &h = _latencies[s];
+        std::vector<double> pcts = h.percentiles({ 0.5, 0.9, 0.99, 0.999 });
+        APIData lat;
+        lat.add("count", static_cast<long int>(h.count()));
+        lat.add("p50_ms", pcts[0]);
+        lat.add("p90_ms", pcts[1]);
+        lat.add("p99_ms", pcts[2]);
+        lat.add("p999_ms", pcts[3]);
+        lat.add("max_ms", h.max());
+        latencies.add(stage_names[s], lat);
+      }
+    stats.add("latencies", latencies);
+    stats.add("latency_window_s",
+              std::chrono::duration<double>(now() - _window_tstart).count());
 
     // FIXME(sileht): to deprecate
-    stats.add("avg_predict_duration", _avg_predict_duration_ms / 1000.0);
-    stats.add("avg_transform_duration", _avg_transform_duration_ms / 1000.0);
+    stats.add("avg_predict_duration", avg_predict_duration_ms / 1000.0);
+    stats.add("avg_transform_duration", avg_transform_duration_ms / 1000.0);
 
     ad.add("service_stats", stats);
   }
+
+  void ServiceStats::to(PrometheusWriter &pw, const std::string &labels) const
+  {
+    pw.declare("dd_predict_requests_total", "counter",
+               "Predict calls, by outcome.");
+    pw.add("dd_predict_requests_total",
+           labels + "," + PrometheusWriter::label("outcome", "success"),
+           _counters.value(PREDICT_SUCCESS));
+    pw.add("dd_predict_requests_total",
+           labels + "," + PrometheusWriter::label("outcome", "failure"),
+           _counters.value(PREDICT_FAILURE));
+
+    pw.declare("dd_predict_inflight", "gauge",
+               "Predict calls being served or waiting.");
+    pw.add("dd_predict_inflight", labels, _predict_inflight.load());
+
+    pw.declare("dd_inference_samples_total", "counter",
+               "Samples through the model.");
+    pw.add("dd_inference_samples_total", labels,
+           _counters.value(INFERENCE_COUNT));
+
+    pw.declare("dd_batch_size", "histogram", "Model forward batch sizes.");
+    uint64_t cum = 0;
+    for (int b = 0; b < _nbatch_buckets; ++b)
+      {
+        cum += _batch_sizes.value(b);
+        std::string le = b < _nbatch_buckets - 1 ? std::to_string(1 << b)
+                                                 : std::string("+Inf");
+        pw.add("dd_batch_size",
+               labels + "," + PrometheusWriter::label("le", le), cum,
+               "_bucket");
+      }
+    pw.add("dd_batch_size", labels, _batch_sizes.value(_nbatch_buckets),
+           "_sum");
+    pw.add("dd_batch_size", labels, cum, "_count");
+
+    // quantiles are over the current window, sum and count since start
+    pw.declare("dd_stage_duration_seconds", "summary",
+               "Predict stage durations.");
+    for (int s = 0; s < NSTAGES; ++s)
+      {
+        std::string slabels
+            = labels + "," + PrometheusWriter::label("stage", stage_names[s]);
+        static const std::vector<double> qs = { 0.5, 0.9, 0.99, 0.999 };
+        std::vector<double> pcts = _latencies[s].percentiles(qs);
+        for (size_t q = 0; q < qs.size(); ++q)
+          {
+            std::ostringstream qstr;
+            qstr << qs[q];
+            pw.add("dd_stage_duration_seconds",
+                   slabels + ","
+                       + PrometheusWriter::label("quantile", qstr.str()),
+                   pcts[q] / 1e3);
+          }
+        pw.add("dd_stage_duration_seconds", slabels,
+               _stage_totals.value(2 * s + 1) / 1e9, "_sum");
+        pw.add("dd_stage_duration_seconds", slabels,
+               _stage_totals.value(2 * s), "_count");
+      }
+  }
 }
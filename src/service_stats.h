@@ -26,66 +26,132 @@
 #include <mutex>
 
 #include "apidata.h"
+#include "utils/latency_histogram.hpp"
+#include "utils/prometheus.hpp"
+#include "utils/sharded_counters.hpp"
 
 namespace dd
 {
+  /**
+   * \brief service statistics: counters, averages, and per stage latency
+   * histograms over a resettable window. Stage timings are request scoped,
+   * i.e. every call holds its own start time, so that concurrent predict
+   * calls do not interfere. Counters are sharded atomics, so that recording
+   * takes no lock.
+   */
   class ServiceStats
   {
 
   public:
-    ServiceStats()
+    typedef std::chrono::steady_clock::time_point time_point;
+
+    /**
+     * \brief predict call stages with a latency histogram
+     */
+    enum Stage
+    {
+      PREDICT = 0,   /**< whole predict call. */
+      TRANSFORM,     /**< input connector transform. */
+      FORWARD,       /**< model forward passes. */
+      OUTPUT,        /**< output connector. */
+      SERIALIZATION, /**< rendering of the output. */
+      NSTAGES
+    };
+
+    ServiceStats() : _window_tstart(std::chrono::steady_clock::now())
     {
     }
 
     ServiceStats(ServiceStats &stats)
+        : _counters(stats._counters), _stage_totals(stats._stage_totals),
+          _batch_sizes(stats._batch_sizes), _latencies(stats._latencies),
+          _window_tstart(stats._window_tstart)
     {
       // NOTE(sileht) : Do we really want to have all stats copied ?
-      _inference_count = stats._inference_count;
-
-      _predict_success = stats._predict_success;
-      _predict_failure = stats._predict_failure;
-      _predict_tstart = stats._predict_tstart;
-
-      _transform_tstart = stats._transform_tstart;
-
-      _avg_batch_size = stats._avg_batch_size;
-      _avg_predict_duration_ms = stats._avg_predict_duration_ms;
-      _avg_transform_duration_ms = stats._avg_transform_duration_ms;
     }
 
     ~ServiceStats()
     {
     }
 
+    /**
+     * \brief counts samples of a forward batch
+     */
     void inc_inference_count(const int &l);
 
-    void transform_start();
-    void transform_end();
+    /**
+     * \brief start time of a stage, to be handed back at stage end
+     */
+    static time_point now()
+    {
+      return std::chrono::steady_clock::now();
+    }
 
-    void predict_start();
-    void predict_end(bool succeed);
+    /**
+     * \brief milliseconds elapsed since tstart
+     */
+    static double elapsed_ms(const time_point &tstart)
+    {
+      return std::chrono::duration<double, std::milli>(now() - tstart)
+          .count();
+    }
 
-    void to(APIData &ad) const;
+    time_point transform_start() const
+    {
+      return now();
+    }
+    void transform_end(const time_point &tstart);
 
-  private:
-    int _inference_count = 0;
+    time_point predict_start()
+    {
+      ++_predict_inflight;
+      return now();
+    }
+    void predict_end(const time_point &tstart, bool succeed);
 
-    int _predict_success = 0;
-    int _predict_failure = 0;
+    /**
+     * \brief records the duration of a stage for one predict call
+     */
+    void add_stage_duration(const Stage &stage, const double &ms);
 
-    std::chrono::steady_clock::time_point _predict_tstart;
-    std::chrono::duration<double, std::milli> _predict_total_duration_ms
-        = std::chrono::milliseconds(0);
+    /**
+     * \brief starts a new latency window, counters and averages are kept
+     */
+    void reset_window();
 
-    std::chrono::steady_clock::time_point _transform_tstart;
-    std::chrono::duration<double, std::milli> _transform_total_duration_ms
-        = std::chrono::milliseconds(0);
+    void to(APIData &ad) const;
 
-    double _avg_batch_size = -1;
-    double _avg_predict_duration_ms = -1;
-    double _avg_transform_duration_ms = -1;
+    /**
+     * \brief adds counters, stage latencies and batch sizes as Prometheus
+     * metrics
+     * @param labels service labels
+     */
+    void to(PrometheusWriter &pw, const std::string &labels) const;
 
-    mutable std::mutex _mutex; /**< mutex for converting to APIData. */
+  private:
+    enum Counter
+    {
+      INFERENCE_COUNT = 0,
+      PREDICT_SUCCESS,
+      PREDICT_FAILURE,
+      NCOUNTERS
+    };
+
+    static const int _nbatch_buckets
+        = 12; /**< powers of two up to 1024, then +Inf. */
+
+    ShardedCounters _counters = ShardedCounters(NCOUNTERS);
+    ShardedCounters _stage_totals
+        = ShardedCounters(2 * NSTAGES); /**< per stage count and ns. */
+    ShardedCounters _batch_sizes
+        = ShardedCounters(_nbatch_buckets + 1); /**< buckets, then sum. */
+    std::atomic<int> _predict_inflight{ 0 };
+
+    std::vector<LatencyHistogram> _latencies = std::vector<LatencyHistogram>(
+        NSTAGES); /**< per stage latencies over current window. */
+    time_point _window_tstart; /**< current window start. */
+
+    mutable std::mutex _mutex; /**< mutex around window start. */
   };
 };
 
@@ -28,6 +28,7 @@
 
 #include <mapbox/variant.hpp>
 #include <boost/exception/diagnostic_information.hpp>
+#include <boost/thread/shared_mutex.hpp>
 #include "mlservice.h"
 #include "apidata.h"
 #include "inputconnectorstrategy.h"
@@ -40,6 +41,7 @@
 #include "chain.h"
 #include "chain_actions.h"
 #include "resources.h"
+#include "trace.h"
 #include "dto/service_predict.hpp"
 #include "dto/chain.hpp"
 #include "dto/stream.hpp"
@@ -233,6 +235,40 @@ namespace dd
       return mapbox::util::apply_visitor(v, mllib);
     }
 
+    /**
+     * \brief service mllib._stats.add_stage_duration() visitor class
+     */
+    class v_add_stage_duration
+    {
+    public:
+      ServiceStats::Stage _stage;
+      double _ms;
+
+      template <typename T> void operator()(T &mllib)
+      {
+        mllib._stats.add_stage_duration(_stage, _ms);
+      }
+    };
+    template <typename T>
+    static void add_stage_duration(T &mllib, const ServiceStats::Stage &stage,
+                                   const double &ms)
+    {
+      visitor_mllib::v_add_stage_duration v{ stage, ms };
+      mapbox::util::apply_visitor(v, mllib);
+    }
+
+    /**
+     * \brief service model repository visitor class
+     */
+    class v_model_repo
+    {
+    public:
+      template <typename T> std::string operator()(T &mllib)
+      {
+        return mllib._mlmodel._repo;
+      }
+    };
+
     /**
      * \brief service mllib.train_job() visitor class
      */
@@ -404,7 +440,7 @@ namespace dd
       try
         {
           visitor_mllib::init(mls, ad);
-          std::lock_guard<std::mutex> lock(_mlservices_mtx);
+          boost::unique_lock<boost::shared_mutex> lock(_mlservices_mtx);
           _mlservices.insert(
               std::pair<std::string, mls_variant_type>(sname, std::move(mls)));
         }
@@ -441,7 +477,7 @@ namespace dd
      */
     bool remove_service(const std::string &sname, const APIData &ad)
     {
-      std::lock_guard<std::mutex> lock(_mlservices_mtx);
+      boost::unique_lock<boost::shared_mutex> lock(_mlservices_mtx);
       auto hit = _mlservices.begin();
       if ((hit = _mlservices.find(sname)) != _mlservices.end())
         {
@@ -493,6 +529,35 @@ namespace dd
       return _mlservices.end();
     }
 
+    /**
+     * \brief records the duration of a predict stage that runs outside of
+     * the service, e.g. output serialization
+     * @param sname service name
+     * @param stage predict stage
+     * @param ms duration in milliseconds
+     */
+    void add_stage_duration(const std::string &sname,
+                            const ServiceStats::Stage &stage, const double &ms)
+    {
+      auto hit = get_service_it(sname);
+      if (hit != _mlservices.end())
+        visitor_mllib::add_stage_duration((*hit).second, stage, ms);
+    }
+
+    /**
+     * \brief model repository of a service
+     * @param sname service name
+     * @return repository, empty if service does not exist
+     */
+    std::string service_repository(const std::string &sname)
+    {
+      auto hit = get_service_it(sname);
+      if (hit == _mlservices.end())
+        return "";
+      return mapbox::util::apply_visitor(visitor_mllib::v_model_repo(),
+                                         (*hit).second);
+    }
+
     /**
      * \brief checks whether a service exists
      * @param sname service name
@@ -624,6 +689,7 @@ namespace dd
 
       int status = 0;
       auto llog = spdlog::get(sname);
+      TraceSpan span("Services::predict", "service", sname);
       try
         {
           auto hit = get_service_it(sname);
@@ -731,6 +797,7 @@ namespace dd
                       int &npredicts)
     {
       std::string sname = adc.get("service").get<std::string>();
+      TraceSpan span("Services::chain_service", "chain", sname);
       chain_logger->info("[" + std::to_string(chain_pos)
                          + "] / executing predict on service " + sname);
 
@@ -925,7 +992,11 @@ namespace dd
       chain_logger->info("[" + std::to_string(chain_pos)
                          + "] / executing action " + action_type);
       ChainActionFactory caf(adc);
-      caf.apply_action(action_type, prev_data, cdata, chain_logger);
+      {
+        TraceSpan span("ChainActionFactory::apply_action", "chain",
+                       action_type);
+        caf.apply_action(action_type, prev_data, cdata, chain_logger);
+      }
 
       // replace prev_data in cdata for prec_pred_id
       cdata.add_model_data(prec_pred_id, prev_data);
@@ -1104,6 +1175,7 @@ namespace dd
                       int &npredicts)
     {
       std::string sname = call_dto->service;
+      TraceSpan span("Services::chain_service", "chain", sname);
       chain_logger->info("[" + std::to_string(chain_pos)
                          + "] / executing predict on service " + sname);
 
@@ -1306,7 +1378,11 @@ namespace dd
       chain_logger->info("[" + std::to_string(chain_pos)
                          + "] / executing action " + action_type);
       ChainActionFactory caf(call_dto);
-      caf.apply_action(action_type, prev_data, cdata, chain_logger);
+      {
+        TraceSpan span("ChainActionFactory::apply_action", "chain",
+                       action_type);
+        caf.apply_action(action_type, prev_data, cdata, chain_logger);
+      }
 
       // replace prev_data in cdata for prec_pred_id
       cdata.add_model_data(prec_pred_id, prev_data);
@@ -1565,8 +1641,9 @@ namespace dd
         _resources; /**< container of instanciated resources */
 
   protected:
-    std::mutex _mlservices_mtx; /**< mutex around adding/removing services. */
-    std::mutex _resources_mtx;  /**< mutex around adding/removing resources. */
+    boost::shared_mutex
+        _mlservices_mtx; /**< mutex around adding/removing services. */
+    std::mutex _resources_mtx; /**< mutex around adding/removing resources. */
   };
 }
 
@@ -24,6 +24,7 @@
 #define TS_METRICS_EPSILON 1E-2
 
 #include "dto/output_connector.hpp"
+#include "trace.h"
 
 template <typename T>
 bool SortScorePairDescend(const std::pair<double, T> &pair1,
@@ -254,7 +255,7 @@ namespace dd
         {
           for (size_t i = 0; i < _vvcats.size(); i++)
             {
-              sup_result sresult = _vvcats.at(i);
+              const sup_result &sresult = _vvcats.at(i);
               sup_result bsresult(sresult._label, sresult._loss);
 #ifdef USE_SIMSEARCH
               bsresult._index_uri = sresult._index_uri;
@@ -288,7 +289,7 @@ namespace dd
         {
           for (size_t i = 0; i < _vvcats.size(); i++)
             {
-              sup_result sresult = _vvcats.at(i);
+              const sup_result &sresult = _vvcats.at(i);
               sup_result bsresult(sresult._label, sresult._loss);
 #ifdef USE_SIMSEARCH
               bsresult._index_uri = sresult._index_uri;
@@ -410,6 +411,7 @@ namespace dd
     void finalize(oatpp::Object<DTO::OutputConnector> output_params,
                   APIData &ad_out, MLModel *mlm)
     {
+      TraceSpan span("SupervisedOutput::finalize", "output");
 #ifndef USE_SIMSEARCH
       (void)mlm;
 #endif
@@ -737,10 +739,6 @@ namespace dd
                         const std::string test_name = "")
     {
       APIData meas_out;
-      bool tloss = ad_res.has("train_loss");
-      bool lr = ad_res.has("learning_rate");
-      bool loss = ad_res.has("loss");
-      bool iter = ad_res.has("iteration");
       bool regression = ad_res.has("regression");
       bool segmentation = ad_res.has("segmentation");
       bool multilabel = ad_res.has("multilabel");
@@ -1318,15 +1316,27 @@ namespace dd
                 }
             }
         }
-      if (loss)
+      add_measure(meas_out, ad_res, out, test_id, test_name);
+    }
+
+    /**
+     * \brief adds computed measures to the output, with losses and
+     * iteration from results
+     * @param meas_out measures of a test set
+     */
+    static void add_measure(APIData &meas_out, const APIData &ad_res,
+                            APIData &out, size_t test_id = 0,
+                            const std::string test_name = "")
+    {
+      if (ad_res.has("loss"))
         meas_out.add("loss",
                      ad_res.get("loss")
                          .get<double>()); // 'universal', comes from algorithm
-      if (tloss)
+      if (ad_res.has("train_loss"))
         meas_out.add("train_loss", ad_res.get("train_loss").get<double>());
-      if (iter)
+      if (ad_res.has("iteration"))
         meas_out.add("iteration", ad_res.get("iteration").get<double>());
-      if (lr)
+      if (ad_res.has("learning_rate"))
         meas_out.add("learning_rate",
                      ad_res.get("learning_rate").get<double>());
 
@@ -1622,17 +1632,6 @@ namespace dd
     static std::map<std::string, double>
     acc(const APIData &ad, const std::vector<std::string> &measures)
     {
-      struct acc_comp
-      {
-        acc_comp(const std::vector<double> &v) : _v(v)
-        {
-        }
-        bool operator()(double a, double b)
-        {
-          return _v[a] > _v[b];
-        }
-        const std::vector<double> _v;
-      };
       std::map<std::string, double> accs;
       std::vector<int> vacck;
       for (auto s : measures)
@@ -1658,17 +1657,15 @@ namespace dd
                   = bad.get("pred").get<std::vector<double>>();
               if (k - 1 >= static_cast<int>(predictions.size()))
                 continue; // ignore instead of error
-              std::vector<int> predk(predictions.size());
-              for (size_t j = 0; j < predictions.size(); j++)
-                predk[j] = j;
-              std::partial_sort(predk.begin(), predk.begin() + k - 1,
-                                predk.end(), acc_comp(predictions));
-              for (int l = 0; l < k; l++)
-                if (predk.at(l) == bad.get("target").get<double>())
-                  {
-                    acc++;
-                    break;
-                  }
+              // correct when less than k classes score higher than the
+              // target, as MeasureAccumulator
+              double ptarget = predictions.at(
+                  static_cast<int>(bad.get("target").get<double>()));
+              int higher = 0;
+              for (double p : predictions)
+                higher += p > ptarget;
+              if (higher < k)
+                acc++;
             }
           std::string key = "acc";
           if (k > 1)
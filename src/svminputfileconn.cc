@@ -48,7 +48,7 @@ namespace dd
   {
     if (!_cifc)
       return -1;
-    std::unordered_map<int, double> vals;
+    std::vector<std::pair<int, double>> vals;
     int label = -1;
     // int nlines = 0;
     _cifc->read_svm_line(content, vals, label);
@@ -71,13 +71,13 @@ namespace dd
               }
           }
           }*/
-    _cifc->add_train_svmline(label, vals, 0);
+    _cifc->add_train_svmline(label, std::move(vals), 0);
     return 0;
   }
 
-  void SVMInputFileConn::read_svm_line(const std::string &content,
-                                       std::unordered_map<int, double> &vals,
-                                       int &label)
+  void SVMInputFileConn::read_svm_line(
+      const std::string &content, std::vector<std::pair<int, double>> &vals,
+      int &label)
   {
     bool fpos = true;
     std::string col;
@@ -97,8 +97,7 @@ namespace dd
               {
                 int fid = std::stoi(res.at(0));
                 if ((fit = _fids.find(fid)) != _fids.end())
-                  vals.insert(
-                      std::pair<int, double>(fid, std::stod(res.at(1))));
+                  vals.emplace_back(fid, std::stod(res.at(1)));
               }
           }
         catch (std::invalid_argument &e)
@@ -115,6 +114,19 @@ namespace dd
     if (vals.empty())
       throw InputConnectorBadParamException(
           "Issue while reading svm example (index might be out of bounds)");
+
+    // sort by feature id, first value wins on duplicates
+    std::stable_sort(vals.begin(), vals.end(),
+                     [](const std::pair<int, double> &a,
+                        const std::pair<int, double> &b) {
+                       return a.first < b.first;
+                     });
+    vals.erase(std::unique(vals.begin(), vals.end(),
+                           [](const std::pair<int, double> &a,
+                              const std::pair<int, double> &b) {
+                             return a.first == b.first;
+                           }),
+               vals.end());
   }
 
   void SVMInputFileConn::read_svm(const APIData &ad, const std::string &fname)
@@ -166,14 +178,14 @@ namespace dd
     int tnlines = 0;
     while (std::getline(svm_file, hline))
       {
-        std::unordered_map<int, double> vals;
+        std::vector<std::pair<int, double>> vals;
         int label;
         read_svm_line(hline, vals, label);
         if (train_lines == 0 || (train_lines > 0 && nlines < train_lines))
-          add_train_svmline(label, vals, nlines);
+          add_train_svmline(label, std::move(vals), nlines);
         else
           {
-            add_test_svmline(label, vals, tnlines);
+            add_test_svmline(label, std::move(vals), tnlines);
             ++tnlines;
           }
         ++nlines;
@@ -191,10 +203,10 @@ namespace dd
           {
             hline.erase(std::remove(hline.begin(), hline.end(), '\r'),
                         hline.end());
-            std::unordered_map<int, double> vals;
+            std::vector<std::pair<int, double>> vals;
             int label;
             read_svm_line(hline, vals, label);
-            add_test_svmline(label, vals, tnlines);
+            add_test_svmline(label, std::move(vals), tnlines);
             ++tnlines;
           }
         svm_test_file.close();
@@ -58,15 +58,16 @@ namespace dd
   class SVMline
   {
   public:
-    SVMline(const int &label, const std::unordered_map<int, double> &v)
-        : _label(label), _v(v)
+    SVMline(const int &label, std::vector<std::pair<int, double>> v)
+        : _label(label), _v(std::move(v))
     {
     }
     ~SVMline()
     {
     }
-    int _label;                         /**< svm line label. */
-    std::unordered_map<int, double> _v; /**< svm line data */
+    int _label; /**< svm line label. */
+    std::vector<std::pair<int, double>>
+        _v; /**< svm line data, as (<fid,val>) sorted by fid */
   };
 
   class SVMInputFileConn : public InputConnectorStrategy
@@ -216,7 +217,7 @@ namespace dd
     }
 
     virtual void add_train_svmline(const int &label,
-                                   const std::unordered_map<int, double> &vals,
+                                   std::vector<std::pair<int, double>> vals,
                                    const int &count)
     {
       (void)count;
@@ -224,7 +225,7 @@ namespace dd
     }
 
     virtual void add_test_svmline(const int &label,
-                                  const std::unordered_map<int, double> &vals,
+                                  std::vector<std::pair<int, double>> vals,
                                   const int &count)
     {
       (void)count;
@@ -233,7 +234,7 @@ namespace dd
 
     void read_svm(const APIData &ad, const std::string &fname);
     void read_svm_line(const std::string &content,
-                       std::unordered_map<int, double> &vals, int &label);
+                       std::vector<std::pair<int, double>> &vals, int &label);
 
     int batch_size() const
     {
@@ -0,0 +1,106 @@
+/**
+ * DeepDetect
+ * Copyright (c) 2023 Jolibrain
+ *
+ * This file is part of deepdetect.
+ *
+ * deepdetect is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * deepdetect is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with deepdetect.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <fstream>
+#include <random>
+
+#include "apidata.h"
+#include "trace.h"
+
+namespace dd
+{
+  thread_local Trace *Trace::_current = nullptr;
+
+  void Trace::add(const char *name, const char *cat, const std::string &detail,
+                  const time_point &tstart, const time_point &tend)
+  {
+    TraceEvent ev;
+    ev._name = name;
+    ev._cat = cat;
+    ev._detail = detail;
+    ev._ts = std::chrono::duration_cast<std::chrono::microseconds>(tstart
+                                                                   - _tstart)
+                 .count();
+    ev._dur
+        = std::chrono::duration_cast<std::chrono::microseconds>(tend - tstart)
+              .count();
+    std::lock_guard<std::mutex> lock(_mutex);
+    std::thread::id id = std::this_thread::get_id();
+    auto tit = std::find(_threads.begin(), _threads.end(), id);
+    ev._tid = tit - _threads.begin() + 1;
+    if (tit == _threads.end())
+      _threads.push_back(id);
+    _events.push_back(std::move(ev));
+  }
+
+  void Trace::to(APIData &ad) const
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    std::vector<APIData> vad;
+    for (const TraceEvent &ev : _events)
+      {
+        APIData ead;
+        ead.add("name", ev._name);
+        ead.add("cat", ev._cat);
+        ead.add("ph", std::string("X"));
+        ead.add("ts", static_cast<long int>(ev._ts));
+        ead.add("dur", static_cast<long int>(ev._dur));
+        ead.add("pid", 1);
+        ead.add("tid", ev._tid);
+        if (!ev._detail.empty())
+          {
+            APIData args;
+            args.add("detail", ev._detail);
+            ead.add("args", args);
+          }
+        vad.push_back(ead);
+      }
+    ad.add("traceEvents", vad);
+    ad.add("displayTimeUnit", std::string("ms"));
+  }
+
+  int Trace::write(const std::string &fname) const
+  {
+    APIData ad;
+    to(ad);
+    JDoc jd;
+    jd.SetObject();
+    ad.toJDoc(jd);
+    rapidjson::StringBuffer buffer;
+    rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+    jd.Accept(writer);
+    std::ofstream out(fname);
+    if (!out.is_open())
+      return 1;
+    out << buffer.GetString() << std::endl;
+    return 0;
+  }
+
+  bool Trace::sample(const double &rate)
+  {
+    if (rate <= 0.0)
+      return false;
+    if (rate >= 1.0)
+      return true;
+    static thread_local std::mt19937 g(std::random_device{}());
+    return std::uniform_real_distribution<double>(0.0, 1.0)(g) < rate;
+  }
+}
@@ -0,0 +1,177 @@
+/**
+ * DeepDetect
+ * Copyright (c) 2023 Jolibrain
+ *
+ * This file is part of deepdetect.
+ *
+ * deepdetect is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * deepdetect is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with deepdetect.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace dd
+{
+  class APIData;
+
+  /**
+   * \brief timed span of a trace
+   */
+  struct TraceEvent
+  {
+    std::string _name;
+    std::string _cat;
+    int64_t _ts = 0;  /**< start, in us from trace start. */
+    int64_t _dur = 0; /**< duration, in us. */
+    int _tid = 0;
+    std::string _detail; /**< optional detail, e.g. service name. */
+  };
+
+  /**
+   * \brief request trace, i.e. spans recorded while the trace is active on
+   * a thread, exported in Chrome trace event format, that Perfetto and
+   * chrome://tracing read
+   */
+  class Trace
+  {
+  public:
+    typedef std::chrono::steady_clock::time_point time_point;
+
+    Trace() : _tstart(std::chrono::steady_clock::now())
+    {
+    }
+
+    ~Trace()
+    {
+    }
+
+    /**
+     * \brief adds a span
+     */
+    void add(const char *name, const char *cat, const std::string &detail,
+             const time_point &tstart, const time_point &tend);
+
+    /**
+     * \brief number of spans
+     */
+    size_t size() const
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      return _events.size();
+    }
+
+    /**
+     * \brief trace events as a data object
+     */
+    void to(APIData &ad) const;
+
+    /**
+     * \brief writes trace events as JSON
+     * @return 0 if ok
+     */
+    int write(const std::string &fname) const;
+
+    /**
+     * \brief trace active on this thread, if any
+     */
+    static Trace *current()
+    {
+      return _current;
+    }
+
+    /**
+     * \brief whether a call is to be traced, given sample rate in [0,1]
+     */
+    static bool sample(const double &rate);
+
+  private:
+    friend class TraceScope;
+
+    time_point _tstart;
+    std::vector<TraceEvent> _events;
+    std::vector<std::thread::id> _threads; /**< tid is index + 1. */
+    mutable std::mutex _mutex;
+
+    static thread_local Trace *_current;
+  };
+
+  /**
+   * \brief activates a trace on the current thread for its lifetime
+   */
+  class TraceScope
+  {
+  public:
+    TraceScope(Trace *trace) : _prev(Trace::_current)
+    {
+      Trace::_current = trace;
+    }
+
+    ~TraceScope()
+    {
+      Trace::_current = _prev;
+    }
+
+  private:
+    Trace *_prev = nullptr;
+  };
+
+  /**
+   * \brief span recorded into the active trace, if any, when it goes out of
+   * scope. Costs a thread local read when no trace is active.
+   */
+  class TraceSpan
+  {
+  public:
+    TraceSpan(const char *name, const char *cat = "dd")
+        : _trace(Trace::current()), _name(name), _cat(cat)
+    {
+      if (_trace)
+        _tstart = std::chrono::steady_clock::now();
+    }
+
+    /**
+     * @param detail span detail, e.g. service name
+     */
+    TraceSpan(const char *name, const char *cat, const std::string &detail)
+        : TraceSpan(name, cat)
+    {
+      if (_trace)
+        _detail = detail;
+    }
+
+    TraceSpan(const TraceSpan &) = delete;
+
+    ~TraceSpan()
+    {
+      if (_trace)
+        _trace->add(_name, _cat, _detail, _tstart,
+                    std::chrono::steady_clock::now());
+    }
+
+  private:
+    Trace *_trace = nullptr;
+    const char *_name = nullptr;
+    const char *_cat = nullptr;
+    std::string _detail;
+    Trace::time_point _tstart;
+  };
+}
+
+#endif
@@ -23,61 +23,151 @@
 #include "utils/fileops.hpp"
 #include "utils/utils.hpp"
 #include <boost/tokenizer.hpp>
+#include <algorithm>
 #include <iostream>
+#include <map>
 
 namespace dd
 {
 
-  void WordPieceTokenizer::append_input(const std::string &word)
+  WordPieceTrie::WordPieceTrie(
+      const std::unordered_map<std::string, Word> &vocab,
+      const std::string &prefix)
   {
-    int start = 0;
-    std::vector<std::string> subtokens;
-    bool is_bad = false;
-
-    while (start < static_cast<int>(word.size()))
+    // build with per node maps, then flatten with children in byte order
+    std::vector<std::map<unsigned char, uint32_t>> children(1);
+    std::vector<int> values(1, -1);
+    std::vector<bool> terminal(1, false);
+    for (auto const &v : vocab)
       {
-        int end = word.size();
-        std::string cur_substr = "";
-        while (start < end)
+        const std::string &key = v.first;
+        if (key.size() <= prefix.size()
+            || key.compare(0, prefix.size(), prefix) != 0)
+          continue;
+        uint32_t node = 0;
+        for (size_t i = prefix.size(); i < key.size(); ++i)
           {
-            std::string substr = word.substr(start, end - start);
-            if (start > 0)
+            unsigned char c = static_cast<unsigned char>(key[i]);
+            auto cit = children[node].find(c);
+            if (cit == children[node].end())
               {
-                substr = _suffix_start + substr;
+                uint32_t child = children.size();
+                children[node].emplace(c, child);
+                children.emplace_back();
+                values.push_back(-1);
+                terminal.push_back(false);
+                node = child;
               }
             else
-              {
-                substr = _word_start + substr;
-              }
-            if (in_vocab(substr))
-              {
-                cur_substr = substr;
-                break;
-              }
-            --end;
+              node = cit->second;
           }
-        if (cur_substr == "")
+        if (!terminal[node])
+          ++_ntokens;
+        values[node] = v.second._pos;
+        terminal[node] = true;
+      }
+
+    _first_edge.reserve(children.size() + 1);
+    _labels.reserve(children.size() - 1);
+    _targets.reserve(children.size() - 1);
+    for (auto const &ch : children)
+      {
+        _first_edge.push_back(_labels.size());
+        for (auto const &e : ch)
           {
-            is_bad = true;
-            break;
+            _labels.push_back(e.first);
+            _targets.push_back(e.second);
           }
-        subtokens.push_back(cur_substr);
-        start = end;
       }
+    _first_edge.push_back(_labels.size());
+    _values = std::move(values);
+    _terminal = std::move(terminal);
+  }
 
-    if (is_bad)
+  int WordPieceTrie::longest_match(const char *s, size_t len,
+                                   size_t &match_len) const
+  {
+    uint32_t node = 0;
+    int pos = -1;
+    match_len = 0;
+    for (size_t i = 0; i < len; ++i)
       {
-        _tokens.push_back(_unk_token);
+        unsigned char c = static_cast<unsigned char>(s[i]);
+        auto first = _labels.begin() + _first_edge[node];
+        auto last = _labels.begin() + _first_edge[node + 1];
+        auto eit = std::lower_bound(first, last, c);
+        if (eit == last || *eit != c)
+          break;
+        node = _targets[eit - _labels.begin()];
+        if (_terminal[node])
+          {
+            match_len = i + 1;
+            pos = _values[node];
+          }
       }
-    else
+    return pos;
+  }
+
+  void WordPieceTokenizer::compile()
+  {
+    const std::unordered_map<std::string, Word> &vocab = *_ctfc->_vocab;
+    _word_trie = std::make_shared<const WordPieceTrie>(vocab, _word_start);
+    _suffix_trie
+        = std::make_shared<const WordPieceTrie>(vocab, _suffix_start);
+    auto uit = vocab.find(_unk_token);
+    _unk_pos = uit != vocab.end() ? uit->second._pos : -1;
+    _compiled_vocab_size = vocab.size();
+  }
+
+  void WordPieceTokenizer::update()
+  {
+    if (!_word_trie || _compiled_vocab_size != _ctfc->_vocab->size())
+      compile();
+  }
+
+  void WordPieceTokenizer::append_input(const std::string &word)
+  {
+    update();
+
+    size_t ntokens = _tokens.size();
+    size_t start = 0;
+    while (start < word.size())
       {
-        _tokens.insert(_tokens.end(), subtokens.begin(), subtokens.end());
+        const WordPieceTrie &trie = start > 0 ? *_suffix_trie : *_word_trie;
+        size_t len = 0;
+        int pos = trie.longest_match(word.data() + start, word.size() - start,
+                                     len);
+        if (len == 0)
+          {
+            // word cannot be cut into pieces
+            _tokens.resize(ntokens);
+            _ids.resize(ntokens);
+            _tokens.push_back(_unk_token);
+            _ids.push_back(_unk_pos);
+            return;
+          }
+        const std::string &prefix = start > 0 ? _suffix_start : _word_start;
+        std::string token;
+        token.reserve(prefix.size() + len);
+        token.append(prefix).append(word, start, len);
+        _tokens.push_back(std::move(token));
+        _ids.push_back(pos);
+        start += len;
       }
   }
 
+  void WordPieceTokenizer::tokenize(const std::vector<std::string> &words)
+  {
+    update();
+    _tokens.reserve(_tokens.size() + words.size());
+    _ids.reserve(_ids.size() + words.size());
+    for (const std::string &word : words)
+      append_input(word);
+  }
+
   bool WordPieceTokenizer::in_vocab(const std::string &tok)
   {
-    return _ctfc->_vocab.find(tok) != _ctfc->_vocab.end();
+    return _ctfc->_vocab->find(tok) != _ctfc->_vocab->end();
   }
 
   /*- DDTxt -*/
@@ -215,39 +305,57 @@ namespace dd
           }
       }
 
-    // parse content
-    // XXX: parallelize with openmp -> requires thread safe parse_content
-    for (std::pair<std::string, int> &p : lfiles)
+    // parse content, files are read and parsed in parallel, by chunks
+    const size_t chunk_size = 1024;
+    for (size_t c = 0; c < lfiles.size(); c += chunk_size)
       {
-        std::ifstream txt_file(p.first);
-        if (!txt_file.is_open())
-          throw InputConnectorBadParamException("cannot open file " + p.first);
-        std::stringstream buffer;
-        buffer << txt_file.rdbuf();
-        std::string ct = buffer.str();
-        _ctfc->parse_content(ct, p.second, test_id);
+        size_t chunk_end = std::min(lfiles.size(), c + chunk_size);
+        std::vector<std::string> contents(chunk_end - c);
+        std::vector<float> targets(chunk_end - c);
+        std::string failed_file;
+#pragma omp parallel for
+        for (size_t i = c; i < chunk_end; ++i)
+          {
+            std::ifstream txt_file(lfiles[i].first);
+            if (!txt_file.is_open())
+              {
+#pragma omp critical
+                failed_file = lfiles[i].first;
+                continue;
+              }
+            std::stringstream buffer;
+            buffer << txt_file.rdbuf();
+            contents[i - c] = buffer.str();
+            targets[i - c] = lfiles[i].second;
+          }
+        if (!failed_file.empty())
+          throw InputConnectorBadParamException("cannot open file "
+                                                + failed_file);
+        _ctfc->parse_contents(contents, targets, test_id);
       }
 
     // post-processing
-    size_t initial_vocab_size = _ctfc->_vocab.size();
+    size_t initial_vocab_size = _ctfc->_vocab->size();
     if (_ctfc->_generate_vocab && _ctfc->_train && !test_dir)
       {
-        auto vhit = _ctfc->_vocab.begin();
-        while (vhit != _ctfc->_vocab.end())
+        std::unordered_map<std::string, Word> &vocab = _ctfc->_vocab.mut();
+        auto vhit = vocab.begin();
+        while (vhit != vocab.end())
           {
             if ((*vhit).second._total_count < _ctfc->_min_count)
-              vhit = _ctfc->_vocab.erase(vhit);
+              vhit = vocab.erase(vhit);
             else
               ++vhit;
           }
       }
     if (_ctfc->_train && !test_dir
-        && initial_vocab_size != _ctfc->_vocab.size())
+        && initial_vocab_size != _ctfc->_vocab->size())
       {
         // update pos
         int pos = 0;
-        auto vhit = _ctfc->_vocab.begin();
-        while (vhit != _ctfc->_vocab.end())
+        std::unordered_map<std::string, Word> &vocab = _ctfc->_vocab.mut();
+        auto vhit = vocab.begin();
+        while (vhit != vocab.end())
           {
             (*vhit).second._pos = pos;
             ++pos;
@@ -256,43 +364,36 @@ namespace dd
       }
 
     if (_ctfc->_generate_vocab && !_ctfc->_characters && !test_dir
-        && (initial_vocab_size != _ctfc->_vocab.size() || _ctfc->_tfidf))
+        && (initial_vocab_size != _ctfc->_vocab->size() || _ctfc->_tfidf))
       {
         // clearing up the corpus + tfidf
-        std::unordered_map<std::string, Word>::iterator whit;
+        std::unordered_map<std::string, Word>::const_iterator whit;
         for (TxtEntry<double> *te : _ctfc->_txt)
           {
             TxtBowEntry *tbe = static_cast<TxtBowEntry *>(te);
-            auto hit = tbe->_v.begin();
-            while (hit != tbe->_v.end())
+            auto kit = tbe->_v.begin();
+            for (auto hit = tbe->_v.begin(); hit != tbe->_v.end(); ++hit)
               {
-                if ((whit = _ctfc->_vocab.find((*hit).first))
-                    != _ctfc->_vocab.end())
-                  {
-                    if (_ctfc->_tfidf)
-                      {
-                        Word w = (*whit).second;
-                        (*hit).second
-                            = (std::log(
-                                  1.0
-                                  + (*hit).second
-                                        / static_cast<double>(w._total_count)))
-                              * std::log(
-                                  _ctfc->_txt.size()
-                                      / static_cast<double>(w._total_docs)
-                                  + 1.0);
-                        // std::cerr << "tfidf feature w=" << (*hit).first << "
-                        // / val=" << (*hit).second << std::endl;
-                      }
-                    ++hit;
-                  }
-                else
+                if ((whit = _ctfc->_vocab->find((*hit).first))
+                    == _ctfc->_vocab->end())
+                  continue; // removing word
+                if (_ctfc->_tfidf)
                   {
-                    // std::cerr << "removing ws=" << (*hit).first <<
-                    // std::endl;
-                    hit = tbe->_v.erase(hit);
+                    const Word &w = (*whit).second;
+                    (*hit).second
+                        = (std::log(1.0
+                                    + (*hit).second
+                                          / static_cast<double>(
+                                              w._total_count)))
+                          * std::log(_ctfc->_txt.size()
+                                         / static_cast<double>(w._total_docs)
+                                     + 1.0);
                   }
+                if (kit != hit)
+                  *kit = std::move(*hit);
+                ++kit;
               }
+            tbe->_v.erase(kit, tbe->_v.end());
           }
       }
 
@@ -310,7 +411,7 @@ namespace dd
         correspf.close();
       }
 
-    _logger->info("vocabulary size={}", _ctfc->_vocab.size());
+    _logger->info("vocabulary size={}", _ctfc->_vocab->size());
 
     return 0;
   }
@@ -319,179 +420,269 @@ namespace dd
   void TxtInputFileConn::parse_content(const std::string &content,
                                        const float &target, int test_id)
   {
-    if (!_train && content.empty())
-      throw InputConnectorBadParamException("no text data found");
+    parse_contents(std::vector<std::string>(1, content),
+                   std::vector<float>(1, target), test_id);
+  }
+
+  void TxtInputFileConn::parse_contents(
+      const std::vector<std::string> &contents,
+      const std::vector<float> &targets, int test_id)
+  {
     std::vector<std::string> cts;
-    if (_sentences)
+    std::vector<float> cts_targets;
+    for (size_t i = 0; i < contents.size(); ++i)
       {
-        boost::char_separator<char> sep("\n");
-        boost::tokenizer<boost::char_separator<char>> tokens(content, sep);
-        for (std::string s : tokens)
-          cts.push_back(s);
+        const std::string &content = contents[i];
+        float target = i < targets.size() ? targets[i] : -1;
+        if (!_train && content.empty())
+          throw InputConnectorBadParamException("no text data found");
+        if (_sentences)
+          {
+            boost::char_separator<char> sep("\n");
+            boost::tokenizer<boost::char_separator<char>> tokens(content, sep);
+            for (std::string s : tokens)
+              {
+                cts.push_back(s);
+                cts_targets.push_back(target);
+              }
+          }
+        else
+          {
+            cts.push_back(content);
+            cts_targets.push_back(target);
+          }
       }
-    else
+
+    // vocabulary is read-only while documents are processed, vocabulary
+    // counts are gathered per thread and merged afterwards
+    if (_wordpiece_tokens && !_characters)
+      _wordpiece_tokenizer.update();
+    bool count_words = _train && !_characters && !_ordered_words;
+    std::vector<TxtEntry<double> *> entries(cts.size(), nullptr);
+    WordCounts counts;
+#pragma omp parallel if (cts.size() > 1)
+    {
+      WordPieceTokenizer tokenizer(_wordpiece_tokenizer);
+      WordCounts thread_counts;
+#pragma omp for schedule(dynamic)
+      for (size_t i = 0; i < cts.size(); ++i)
+        entries[i] = build_entry(std::move(cts[i]), cts_targets[i], tokenizer,
+                                 count_words ? &thread_counts : nullptr, i);
+#pragma omp critical
       {
-        cts.push_back(content);
+        for (auto &tc : thread_counts)
+          {
+            WordCount &wc = counts[tc.first];
+            wc._count += tc.second._count;
+            wc._docs += tc.second._docs;
+            wc._first = std::min(wc._first, tc.second._first);
+          }
       }
-    for (std::string ct : cts)
+    }
+    if (count_words)
+      update_vocab(counts);
+
+    std::vector<TxtEntry<double> *> &txt
+        = test_id < 0 ? _txt : _tests_txt[static_cast<size_t>(test_id)];
+    txt.insert(txt.end(), entries.begin(), entries.end());
+    if (_characters)
+      std::cerr << "\rloaded text samples=" << _txt.size();
+  }
+
+  TxtEntry<double> *
+  TxtInputFileConn::build_entry(std::string ct, const float &target,
+                                WordPieceTokenizer &tokenizer,
+                                WordCounts *counts, uint64_t doc) const
+  {
+    if (_lower_case)
+      std::transform(ct.begin(), ct.end(), ct.begin(), ::tolower);
+    if (!_characters)
       {
-        if (_lower_case)
-          std::transform(ct.begin(), ct.end(), ct.begin(), ::tolower);
-        if (!_characters)
+        std::vector<std::string> tokens;
+        if (_punctuation_tokens)
           {
-            std::unordered_map<std::string, Word>::iterator vhit;
-            std::vector<std::string> tokens;
-            if (_punctuation_tokens)
+            boost::char_separator<char> sep("\n\t\f\r ");
+            boost::tokenizer<boost::char_separator<char>> tokenizer(ct, sep);
+
+            // Split punctuation
+            auto is_punct = [](char i) {
+              return (i >= 33 && i <= 47) || (i >= 58 && i <= 64)
+                     || (i >= 91 && i <= 96) || (i >= 123 && i <= 126);
+            };
+            for (std::string token : tokenizer)
               {
-                boost::char_separator<char> sep("\n\t\f\r ");
-                boost::tokenizer<boost::char_separator<char>> tokenizer(ct,
-                                                                        sep);
-
-                // Split punctuation
-                auto is_punct = [](char i) {
-                  return (i >= 33 && i <= 47) || (i >= 58 && i <= 64)
-                         || (i >= 91 && i <= 96) || (i >= 123 && i <= 126);
-                };
-                for (std::string token : tokenizer)
+                int start = 0;
+                for (int i = 0; i < static_cast<int>(token.size()); ++i)
                   {
-                    int start = 0;
-                    for (int i = 0; i < static_cast<int>(token.size()); ++i)
+                    if (is_punct(token[i]))
                       {
-                        if (is_punct(token[i]))
-                          {
-                            if (i != start)
-                              tokens.push_back(token.substr(start, i - start));
-                            tokens.push_back(token.substr(i, 1));
-                            start = i + 1;
-                          }
+                        if (i != start)
+                          tokens.push_back(token.substr(start, i - start));
+                        tokens.push_back(token.substr(i, 1));
+                        start = i + 1;
                       }
-                    if (start != static_cast<int>(token.size()))
-                      tokens.push_back(token.substr(start));
                   }
+                if (start != static_cast<int>(token.size()))
+                  tokens.push_back(token.substr(start));
               }
-            else
-              {
-                boost::char_separator<char> sep(
-                    "\n\t\f\r ,.;:`'!?)(-|><^·&\"\\/{}#$–=+");
-                boost::tokenizer<boost::char_separator<char>> tokenizer(ct,
-                                                                        sep);
-                tokens.insert(tokens.end(), tokenizer.begin(),
-                              tokenizer.end());
-              }
-            if (_wordpiece_tokens)
-              {
-                _wordpiece_tokenizer.reset();
-                for (const std::string &token : tokens)
-                  {
-                    _wordpiece_tokenizer.append_input(token);
-                  }
-                tokens = std::move(_wordpiece_tokenizer._tokens);
-                _wordpiece_tokenizer._tokens = std::vector<std::string>();
-              }
+          }
+        else
+          {
+            boost::char_separator<char> sep(
+                "\n\t\f\r ,.;:`'!?)(-|><^·&\"\\/{}#$–=+");
+            boost::tokenizer<boost::char_separator<char>> tokenizer(ct, sep);
+            tokens.insert(tokens.end(), tokenizer.begin(), tokenizer.end());
+          }
+        std::vector<int64_t> ids;
+        if (_wordpiece_tokens)
+          {
+            tokenizer.reset();
+            tokenizer.tokenize(tokens);
+            tokens = std::move(tokenizer._tokens);
+            ids = std::move(tokenizer._ids);
+            tokenizer._tokens = std::vector<std::string>();
+            tokenizer._ids = std::vector<int64_t>();
+          }
 
-            if (_ordered_words)
+        if (_ordered_words)
+          {
+            TxtOrderedWordsEntry *towe = new TxtOrderedWordsEntry(target);
+            towe->_v = std::move(tokens);
+            towe->_ids = std::move(ids);
+            return towe;
+          }
+
+        // words are gathered contiguously, with a local index for unicity
+        TxtBowEntry *tbe = new TxtBowEntry(target);
+        std::unordered_map<std::string, size_t> wpos;
+        uint64_t rank = doc << 32;
+        for (std::string &w : tokens)
+          {
+            if (static_cast<int>(w.length()) < _min_word_length)
+              continue;
+            auto wit = wpos.find(w);
+            if (wit == wpos.end())
               {
-                TxtOrderedWordsEntry *towe = new TxtOrderedWordsEntry(target);
-                for (std::string w : tokens)
+                if (counts)
                   {
-                    towe->add_word(w);
+                    WordCount &wc = (*counts)[w];
+                    ++wc._count;
+                    ++wc._docs;
+                    wc._first = std::min(wc._first, rank);
                   }
-
-                if (test_id < 0)
-                  _txt.push_back(towe);
-                else
-                  _tests_txt[static_cast<size_t>(test_id)].push_back(towe);
+                wpos.emplace(w, tbe->_v.size());
+                tbe->_v.emplace_back(std::move(w), 1.0);
               }
             else
               {
-                TxtBowEntry *tbe = new TxtBowEntry(target);
-                for (std::string w : tokens)
-                  {
-                    if (static_cast<int>(w.length()) < _min_word_length)
-                      continue;
-
-                    // check and fillup vocab.
-                    int pos = -1;
-                    if ((vhit = _vocab.find(w)) == _vocab.end())
-                      {
-                        if (_train)
-                          {
-                            pos = _vocab.size();
-                            _vocab.emplace(std::make_pair(w, Word(pos)));
-                          }
-                      }
-                    else
-                      {
-                        if (_train)
-                          {
-                            (*vhit).second._total_count++;
-                            if (!tbe->has_word(w))
-                              (*vhit).second._total_docs++;
-                          }
-                      }
-                    tbe->add_word(w, 1.0, _count);
-                  }
-                if (test_id < 0)
-                  _txt.push_back(tbe);
-                else
-                  _tests_txt[static_cast<size_t>(test_id)].push_back(tbe);
+                if (counts)
+                  ++(*counts)[w]._count;
+                if (_count)
+                  tbe->_v[(*wit).second].second += 1.0;
               }
+            ++rank;
           }
-        else // character-level features
+        return tbe;
+      }
+
+    // character-level features
+    if (_seq_forward)
+      std::reverse(ct.begin(), ct.end());
+    TxtCharEntry *tce = new TxtCharEntry(target);
+    std::unordered_map<uint32_t, int>::const_iterator whit;
+    boost::char_separator<char> sep("\n\t\f\r");
+    boost::tokenizer<boost::char_separator<char>> tokens(ct, sep);
+    int seq = 0;
+    bool prev_space = false;
+    for (std::string w : tokens)
+      {
+        char *str = (char *)w.c_str();
+        char *str_i = str;
+        char *end = str + strlen(str) + 1;
+        do
           {
-            if (_seq_forward)
-              std::reverse(ct.begin(), ct.end());
-            TxtCharEntry *tce = new TxtCharEntry(target);
-            std::unordered_map<uint32_t, int>::const_iterator whit;
-            boost::char_separator<char> sep("\n\t\f\r");
-            boost::tokenizer<boost::char_separator<char>> tokens(ct, sep);
-            int seq = 0;
-            bool prev_space = false;
-            for (std::string w : tokens)
+            uint32_t c = 0;
+            try
               {
-                char *str = (char *)w.c_str();
-                char *str_i = str;
-                char *end = str + strlen(str) + 1;
-                do
+                c = utf8::next(str_i, end);
+              }
+            catch (...)
+              {
+                _logger->error("Invalid UTF-8 character in {}", w);
+                c = 0;
+                ++str_i;
+              }
+            if (c == 0)
+              continue;
+            if ((whit = _alphabet->find(c)) == _alphabet->end())
+              {
+                if (!prev_space)
                   {
-                    uint32_t c = 0;
-                    try
-                      {
-                        c = utf8::next(str_i, end);
-                      }
-                    catch (...)
-                      {
-                        _logger->error("Invalid UTF-8 character in {}", w);
-                        c = 0;
-                        ++str_i;
-                      }
-                    if (c == 0)
-                      continue;
-                    if ((whit = _alphabet.find(c)) == _alphabet.end())
-                      {
-                        if (!prev_space)
-                          {
-                            tce->add_char(' ');
-                            seq++;
-                            prev_space = true;
-                          }
-                      }
-                    else
-                      {
-                        tce->add_char(c);
-                        seq++;
-                        prev_space = false;
-                      }
+                    tce->add_char(' ');
+                    seq++;
+                    prev_space = true;
                   }
-                while (str_i < end && seq < _sequence);
               }
-            if (test_id < 0)
-              _txt.push_back(tce);
             else
-              _tests_txt[static_cast<size_t>(test_id)].push_back(tce);
-            std::cerr << "\rloaded text samples=" << _txt.size();
+              {
+                tce->add_char(c);
+                seq++;
+                prev_space = false;
+              }
+          }
+        while (str_i < end && seq < _sequence);
+      }
+    return tce;
+  }
+
+  void TxtInputFileConn::update_vocab(const WordCounts &counts)
+  {
+    std::unordered_map<std::string, Word> &vocab = _vocab.mut();
+    std::vector<std::pair<uint64_t, const std::string *>> new_words;
+    for (auto const &wc : counts)
+      {
+        auto vhit = vocab.find(wc.first);
+        if (vhit == vocab.end())
+          new_words.emplace_back(wc.second._first, &wc.first);
+        else
+          {
+            (*vhit).second._total_count += wc.second._count;
+            (*vhit).second._total_docs += wc.second._docs;
           }
       }
+    std::sort(new_words.begin(), new_words.end());
+    for (auto const &nw : new_words)
+      {
+        const WordCount &wc = counts.at(*nw.second);
+        int pos = vocab.size();
+        vocab.emplace(*nw.second, Word(pos, wc._count, wc._docs));
+      }
+  }
+
+  void TxtInputFileConn::to_csr(const std::vector<TxtEntry<double> *> &txt,
+                                CSRBatch &csr) const
+  {
+    size_t nnz = 0;
+    for (TxtEntry<double> *te : txt)
+      nnz += static_cast<TxtBowEntry *>(te)->size();
+    csr._ncols = _vocab->size();
+    csr.reserve(csr.rows() + txt.size(), csr.nnz() + nnz);
+    std::unordered_map<std::string, Word>::const_iterator wit;
+    std::vector<std::pair<int, float>> row;
+    for (TxtEntry<double> *te : txt)
+      {
+        TxtBowEntry *tbe = static_cast<TxtBowEntry *>(te);
+        row.clear();
+        for (auto const &w : tbe->_v)
+          if ((wit = _vocab->find(w.first)) != _vocab->end())
+            row.emplace_back((*wit).second._pos,
+                             static_cast<float>(w.second));
+        // bag of words is unordered, columns are sorted within each row
+        std::sort(row.begin(), row.end());
+        for (auto const &v : row)
+          csr.add_value(v.first, v.second);
+        csr.end_row(tbe->_target);
+      }
   }
 
   void TxtInputFileConn::serialize_vocab()
@@ -503,7 +694,7 @@ namespace dd
     if (!out.is_open())
       throw InputConnectorBadParamException("failed opening vocabulary file "
                                             + vocabfname);
-    for (auto const &p : _vocab)
+    for (auto const &p : *_vocab)
       {
         out << p.first << delim << p.second._pos << std::endl;
       }
@@ -531,6 +722,7 @@ namespace dd
       throw InputConnectorBadParamException("failed opening vocabulary file "
                                             + vocabfname);
     std::string line;
+    std::unordered_map<std::string, Word> &vocab = _vocab.mut();
     while (getline(in, line))
       {
         std::vector<std::string> tokens = dd_utils::split(line, _vocab_sep);
@@ -539,15 +731,17 @@ namespace dd
                                                 + vocabfname);
         std::string key = tokens.at(0);
         int pos = std::atoi(tokens.at(1).c_str());
-        _vocab.emplace(std::make_pair(key, Word(pos)));
+        vocab.emplace(std::make_pair(key, Word(pos)));
       }
-    _logger->info("loaded vocabulary of size={}", _vocab.size());
+    _logger->info("loaded vocabulary of size={}", vocab.size());
+    if (_wordpiece_tokens)
+      _wordpiece_tokenizer.compile();
   }
 
   void TxtInputFileConn::build_alphabet()
   {
-    _alphabet.clear();
-    auto hit = _alphabet.begin();
+    std::unordered_map<uint32_t, int> alphabet;
+    auto hit = alphabet.begin();
     int pos = 0;
     char *str = (char *)_alphabet_str.c_str();
     char *str_i = str;
@@ -555,13 +749,14 @@ namespace dd
     do
       {
         uint32_t c = utf8::next(str_i, end);
-        if ((hit = _alphabet.find(c)) == _alphabet.end())
+        if ((hit = alphabet.find(c)) == alphabet.end())
           {
-            _alphabet.insert(std::pair<uint32_t, int>(c, pos));
+            alphabet.insert(std::pair<uint32_t, int>(c, pos));
             ++pos;
           }
       }
     while (str_i < end);
+    _alphabet = std::move(alphabet);
   }
 
   void
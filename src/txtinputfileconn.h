@@ -23,8 +23,11 @@
 #define TXTINPUTFILECONN_H
 
 #include "inputconnectorstrategy.h"
+#include "utils/csr_batch.hpp"
+#include "utils/shared_state.hpp"
 #include <algorithm>
 #include <cmath>
+#include <limits>
 #include <random>
 #include "utf8.h"
 
@@ -120,19 +123,19 @@ namespace dd
 
     void add_word(const std::string &str, const double &v, const bool &count)
     {
-      std::unordered_map<std::string, double>::iterator hit;
-      if ((hit = _v.find(str)) != _v.end())
+      auto hit = find_word(str);
+      if (hit != _v.end())
         {
           if (count)
             (*hit).second += v;
         }
       else
-        _v.insert(std::pair<std::string, double>(str, v));
+        _v.emplace_back(str, v);
     }
 
     bool has_word(const std::string &str)
     {
-      return _v.count(str);
+      return find_word(str) != _v.end();
     }
 
     void reset()
@@ -160,8 +163,20 @@ namespace dd
       return _v.size();
     }
 
-    std::unordered_map<std::string, double> _v; /**< words as (<pos,val>). */
-    std::unordered_map<std::string, double>::iterator _vit;
+    std::vector<std::pair<std::string, double>>
+        _v; /**< words as (<word,val>), unique, in order of first occurence,
+               stored contiguously. */
+    std::vector<std::pair<std::string, double>>::iterator _vit;
+
+  private:
+    std::vector<std::pair<std::string, double>>::iterator
+    find_word(const std::string &str)
+    {
+      return std::find_if(_v.begin(), _v.end(),
+                          [&str](const std::pair<std::string, double> &p) {
+                            return p.first == str;
+                          });
+    }
   };
 
   class TxtCharEntry : public TxtEntry<double>
@@ -256,6 +271,45 @@ namespace dd
 
     std::vector<std::string> _v;
     std::vector<std::string>::iterator _vit;
+    std::vector<int64_t> _ids; /**< vocabulary positions of _v, filled by the
+                                  wordpiece tokenizer */
+  };
+
+  /**
+   * \brief trie over vocabulary tokens starting with a given prefix (prefix
+   * removed), compiled into flat arrays with sorted children, for longest
+   * prefix matching without allocation
+   */
+  class WordPieceTrie
+  {
+  public:
+    WordPieceTrie(const std::unordered_map<std::string, Word> &vocab,
+                  const std::string &prefix);
+
+    /**
+     * \brief finds the longest token that is a prefix of [s, s + len)
+     * \param match_len length of the token, 0 if none
+     * \return vocabulary position of the token
+     */
+    int longest_match(const char *s, size_t len, size_t &match_len) const;
+
+    /**
+     * \brief number of tokens in the trie
+     */
+    size_t size() const
+    {
+      return _ntokens;
+    }
+
+  private:
+    std::vector<uint32_t>
+        _first_edge; /**< per node, first outgoing edge, nodes + 1 items */
+    std::vector<unsigned char> _labels; /**< per edge, byte */
+    std::vector<uint32_t> _targets;     /**< per edge, child node */
+    std::vector<int> _values; /**< per node, vocabulary position of the token
+                                 ending at this node, or -1 */
+    std::vector<bool> _terminal; /**< per node, whether a token ends here */
+    size_t _ntokens = 0;
   };
 
   /** Tokenizer that uses greedy longest-match-first search to cut words
@@ -264,6 +318,7 @@ namespace dd
   {
   public:
     std::vector<std::string> _tokens;
+    std::vector<int64_t> _ids; /**< vocabulary positions of _tokens */
     TxtInputFileConn *_ctfc = nullptr;
 
     WordPieceTokenizer()
@@ -273,10 +328,27 @@ namespace dd
     void reset()
     {
       _tokens.clear();
+      _ids.clear();
     }
 
+    /**
+     * \brief builds vocabulary tries, done once the vocabulary is loaded,
+     * tries are shared among copies of the tokenizer
+     */
+    void compile();
+
+    /**
+     * \brief compiles tries if the vocabulary changed since last compile
+     */
+    void update();
+
     void append_input(const std::string &word);
 
+    /**
+     * \brief cuts a batch of words into pieces appended to _tokens and _ids
+     */
+    void tokenize(const std::vector<std::string> &words);
+
   public:
     bool in_vocab(const std::string &tok);
 
@@ -286,6 +358,11 @@ namespace dd
         = ""; /**< Tokens corresponding to word or word beggining in the
                  vocabulary are prefixed by this */
     std::string _unk_token = "[UNK]";
+
+    std::shared_ptr<const WordPieceTrie> _word_trie; /**< word beginnings */
+    std::shared_ptr<const WordPieceTrie> _suffix_trie; /**< word suffixes */
+    int _unk_pos = -1;              /**< position of the unknown token */
+    size_t _compiled_vocab_size = 0; /**< vocabulary size tries are built on */
   };
 
   class TxtInputFileConn : public InputConnectorStrategy
@@ -362,7 +439,7 @@ namespace dd
         _punctuation_tokens = ad_input.get("punctuation_tokens").get<bool>();
       if (ad_input.has("alphabet"))
         _alphabet_str = ad_input.get("alphabet").get<std::string>();
-      if (_characters)
+      if (_characters && (ad_input.has("alphabet") || _alphabet->empty()))
         build_alphabet();
       if (ad_input.has("sequence"))
         _sequence = ad_input.get("sequence").get<int>();
@@ -376,7 +453,7 @@ namespace dd
     int feature_size() const
     {
       // total number of words in training set for BOW
-      return _vocab.size();
+      return _vocab->size();
     }
 
     int batch_size() const
@@ -403,12 +480,27 @@ namespace dd
             }
         }
 
-      if (_alphabet.empty() && _characters)
+      if (_alphabet->empty() && _characters)
         build_alphabet();
 
-      if (!_characters && (!_train || _ordered_words) && _vocab.empty())
+      if (!_characters && (!_train || _ordered_words) && _vocab->empty())
         deserialize_vocab();
 
+      // documents to predict from memory are tokenized as a single batch
+      auto in_mem = [](const std::string &uri) {
+        return uri.rfind("https://", 0) != 0 && uri.rfind("http://", 0) != 0
+               && uri.rfind("file://", 0) != 0 && !fileops::file_exists(uri);
+      };
+      if (!_train && !_sentences && _uris.size() > 1
+          && std::all_of(_uris.begin(), _uris.end(), in_mem))
+        {
+          size_t first = _txt.size();
+          parse_contents(_uris, std::vector<float>());
+          for (size_t i = 0; i < _uris.size(); ++i)
+            _txt[first + i]->_uri = _uris[i];
+          return;
+        }
+
       DataEl<DDTxt> dtxt(this->_input_timeout);
       dtxt._ctype._ctfc = this;
       if (dtxt.read_element(_uris[0], this->_logger, -1)
@@ -499,10 +591,57 @@ namespace dd
     }
 
     // text tokenization for BOW
-    virtual void parse_content(const std::string &content,
-                               const float &target = -1, int test_id = -1);
+    void parse_content(const std::string &content, const float &target = -1,
+                       int test_id = -1);
     // test -1 for train, 0 ,1  ... for test_id
 
+    /**
+     * \brief tokenization of a batch of documents, processed in parallel,
+     * entries are appended in order and the vocabulary is updated as if
+     * documents were parsed one after the other
+     */
+    virtual void parse_contents(const std::vector<std::string> &contents,
+                                const std::vector<float> &targets,
+                                int test_id = -1);
+
+  protected:
+    /**
+     * \brief occurences of a word in a batch of documents
+     */
+    struct WordCount
+    {
+      int _count = 0; /**< total occurences */
+      int _docs = 0;  /**< number of documents containing the word */
+      uint64_t _first
+          = std::numeric_limits<uint64_t>::max(); /**< rank of first
+                                                     occurence */
+    };
+    typedef std::unordered_map<std::string, WordCount> WordCounts;
+
+    /**
+     * \brief builds the entry of a single document, thread safe
+     * \param tokenizer wordpiece tokenizer owned by the calling thread
+     * \param counts if not null, receives occurences of the document words
+     * \param doc index of the document in the batch, for word ranks
+     */
+    TxtEntry<double> *build_entry(std::string ct, const float &target,
+                                  WordPieceTokenizer &tokenizer,
+                                  WordCounts *counts, uint64_t doc) const;
+
+    /**
+     * \brief adds batch word counts to vocabulary, new words are given
+     * positions by order of first occurence
+     */
+    void update_vocab(const WordCounts &counts);
+
+  public:
+    /**
+     * \brief appends bag of words entries to a CSR batch, with vocabulary
+     * positions as indices, out of vocabulary words are skipped
+     */
+    void to_csr(const std::vector<TxtEntry<double> *> &txt,
+                CSRBatch &csr) const;
+
     // serialization of vocabulary
     void serialize_vocab();
     void deserialize_vocab(const bool &required = true);
@@ -535,7 +674,7 @@ namespace dd
     bool _punctuation_tokens = false; /**< accept punctuation tokens. */
     std::string _alphabet_str = "abcdefghijklmnopqrstuvwxyz0123456789,;.!?:'"
                                 "\"/\\|_@#$%^&*~`+-=<>()[]{}";
-    std::unordered_map<uint32_t, int>
+    SharedState<std::unordered_map<uint32_t, int>>
         _alphabet; /**< character-level alphabet. */
     int _sequence
         = 60; /**< sequence size when using character-level features. */
@@ -544,8 +683,9 @@ namespace dd
 
     // internals
     bool _generate_vocab = true;
-    std::unordered_map<std::string, Word>
-        _vocab; /**< string to word stats, including word */
+    SharedState<std::unordered_map<std::string, Word>>
+        _vocab; /**< string to word stats, including word, shared by copies
+                   of the connector */
     std::string _vocabfname = "vocab.dat";
     std::string _correspname = "corresp.txt";
     char _vocab_sep = ','; /**< vocabulary separator */
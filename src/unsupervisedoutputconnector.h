@@ -41,10 +41,11 @@ namespace dd
     {
     }
 
-    UnsupervisedResult(const std::string &uri, const std::vector<double> &vals,
+    UnsupervisedResult(const std::string &uri, std::vector<double> vals,
                        const UnsupervisedExtra &extra = UnsupervisedExtra(),
                        const std::string &meta_uri = "")
-        : _uri(uri), _vals(vals), _extra(extra), _meta_uri(meta_uri)
+        : _uri(uri), _vals(std::move(vals)), _extra(extra),
+          _meta_uri(meta_uri)
     {
     }
 
@@ -79,6 +80,7 @@ namespace dd
     std::vector<double> _vals;
     std::vector<bool> _bvals;
     std::string _str;
+    std::vector<int> _ivals; /**< e.g. run-length encoded mask. */
     std::vector<cv::Mat> _images;
 #ifdef USE_SIMSEARCH
     bool _indexed = false;
@@ -129,7 +131,7 @@ namespace dd
     void add_results(const std::vector<APIData> &vrad)
     {
       std::unordered_map<std::string, int>::iterator hit;
-      for (APIData ad : vrad)
+      for (const APIData &ad : vrad)
         {
           std::string uri = ad.get("uri").get<std::string>();
           if (!ad.has("vals"))
@@ -140,10 +142,15 @@ namespace dd
             }
 
           std::vector<double> vals;
-          if (!ad.get("vals").is<std::vector<cv::Mat>>())
-            {
-              vals = ad.get("vals").get<std::vector<double>>();
-            }
+          std::vector<int> ivals;
+          std::string str;
+          ad_variant_type advals = ad.get("vals");
+          if (advals.is<std::vector<double>>())
+            vals = std::move(advals.get<std::vector<double>>());
+          else if (advals.is<std::vector<int>>()) // encoded mask
+            ivals = std::move(advals.get<std::vector<int>>());
+          else if (advals.is<std::string>())
+            str = std::move(advals.get<std::string>());
           if ((hit = _vres.find(uri)) == _vres.end())
             {
               _vres.insert(std::pair<std::string, int>(uri, _vvres.size()));
@@ -177,11 +184,14 @@ namespace dd
                 meta_uri = ad.get("index_uri").get<std::string>();
               else if (ad.has("meta_uri"))
                 meta_uri = ad.get("meta_uri").get<std::string>();
-              _vvres.push_back(UnsupervisedResult(uri, vals, extra, meta_uri));
-              if (ad.get("vals").is<std::vector<cv::Mat>>())
+              _vvres.push_back(
+                  UnsupervisedResult(uri, std::move(vals), extra, meta_uri));
+              _vvres.back()._ivals = std::move(ivals);
+              _vvres.back()._str = std::move(str);
+              if (advals.is<std::vector<cv::Mat>>())
                 {
                   _vvres.back()._images
-                      = ad.get("vals").get<std::vector<cv::Mat>>();
+                      = advals.get<std::vector<cv::Mat>>();
                 }
             }
         }
@@ -322,10 +332,12 @@ namespace dd
           pred_dto->uri = _vvres.at(i)._uri.c_str();
           if (_vvres.at(i)._images.size() != 0)
             pred_dto->_images = _vvres.at(i)._images;
-          if (_bool_binarized)
+          if (!_vvres.at(i)._ivals.empty())
+            pred_dto->vals = DTO::DTOVector<int>(_vvres.at(i)._ivals);
+          else if (_bool_binarized)
             pred_dto->vals
                 = DTO::DTOVector<bool>(std::move(_vvres.at(i)._bvals));
-          else if (_string_binarized)
+          else if (_string_binarized || !_vvres.at(i)._str.empty())
             pred_dto->vals = oatpp::String(_vvres.at(i)._str.c_str());
           else
             pred_dto->vals
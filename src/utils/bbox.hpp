@@ -22,6 +22,10 @@
 #ifndef DD_UTILS_BBOX_HPP
 #define DD_UTILS_BBOX_HPP
 
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <unordered_map>
 #include <vector>
 
 namespace dd
@@ -62,75 +66,210 @@ namespace dd
       return ainter / (a1 + a2 - ainter);
     }
 
-    /** bboxes: list of bboxes in the format { xmin, ymin, xmax, ymax } sorted
-     * by decreasing confidence
-     *
-     * picked: vector used as output containing indices of bboxes kept by nms.
+    /**
+     * \brief boxes as a structure of arrays, so that overlaps of one box
+     * with all others are computed over contiguous coordinates
+     */
+    template <typename T> struct BBoxes
+    {
+      std::vector<T> _xmin;
+      std::vector<T> _ymin;
+      std::vector<T> _xmax;
+      std::vector<T> _ymax;
+      std::vector<T> _areas;
+      std::vector<T> _scores;
+      std::vector<int> _classes;
+
+      size_t size() const
+      {
+        return _xmin.size();
+      }
+
+      void reserve(const size_t &n)
+      {
+        _xmin.reserve(n);
+        _ymin.reserve(n);
+        _xmax.reserve(n);
+        _ymax.reserve(n);
+        _areas.reserve(n);
+        _scores.reserve(n);
+        _classes.reserve(n);
+      }
+
+      void push_back(const T &xmin, const T &ymin, const T &xmax,
+                     const T &ymax, const T &score = T(1), const int &cls = 0)
+      {
+        _xmin.push_back(xmin);
+        _ymin.push_back(ymin);
+        _xmax.push_back(xmax);
+        _ymax.push_back(ymax);
+        _areas.push_back((xmax - xmin) * (ymax - ymin));
+        _scores.push_back(score);
+        _classes.push_back(cls);
+      }
+    };
+
+    /**
+     * \brief intersection over union of box i with boxes from index from,
+     * written to out[from:]. Branchless so that the loop vectorizes.
      */
     template <typename T>
-    inline void nms_sorted_bboxes(const std::vector<std::vector<T>> &bboxes,
-                                  std::vector<size_t> &picked, T nms_threshold)
+    inline void ious(const BBoxes<T> &bboxes, const size_t &i,
+                     const size_t &from, T *out)
+    {
+      const T xmin = bboxes._xmin[i];
+      const T ymin = bboxes._ymin[i];
+      const T xmax = bboxes._xmax[i];
+      const T ymax = bboxes._ymax[i];
+      const T area = bboxes._areas[i];
+      const T *xmins = bboxes._xmin.data();
+      const T *ymins = bboxes._ymin.data();
+      const T *xmaxs = bboxes._xmax.data();
+      const T *ymaxs = bboxes._ymax.data();
+      const T *areas = bboxes._areas.data();
+      const size_t n = bboxes.size();
+      for (size_t j = from; j < n; ++j)
+        {
+          T w = std::max(T(0), std::min(xmax, xmaxs[j])
+                                   - std::max(xmin, xmins[j]));
+          T h = std::max(T(0), std::min(ymax, ymaxs[j])
+                                   - std::max(ymin, ymins[j]));
+          T inter = w * h;
+          out[j] = inter / (area + areas[j] - inter);
+        }
+    }
+
+    /**
+     * \brief greedy non maximum suppression
+     * @param bboxes boxes sorted by decreasing score
+     * @param picked indices of kept boxes, by decreasing score
+     * @param per_class whether only boxes of a same class suppress each other
+     * @param sigma if > 0, gaussian soft-nms: instead of being removed,
+     *        boxes scores are decayed by exp(-iou^2 / sigma), and updated in
+     *        place. nms_threshold is then unused.
+     * @param score_threshold boxes below this score are not kept
+     * @param max_picked if > 0, maximum number of kept boxes
+     */
+    template <typename T>
+    inline void nms_sorted_bboxes(BBoxes<T> &bboxes,
+                                  std::vector<size_t> &picked,
+                                  const T &nms_threshold,
+                                  const bool &per_class = false,
+                                  const T &sigma = T(0),
+                                  const T &score_threshold = T(0),
+                                  const int &max_picked = -1)
     {
       picked.clear();
       const size_t n = bboxes.size();
+      const bool soft = sigma > T(0);
+      std::vector<T> overlaps(n);
+      std::vector<char> removed(n, 0);
+      T *scores = bboxes._scores.data();
+      const int *classes = bboxes._classes.data();
 
-      for (size_t i = 0; i < n; i++)
+      for (size_t p = 0; p < n; ++p)
         {
-          const std::vector<T> &bbox_a = bboxes[i];
-
-          bool keep = true;
-          for (size_t j = 0; j < picked.size(); j++)
+          size_t i = p;
+          if (soft)
             {
-              const std::vector<T> &bbox_b = bboxes[picked[j]];
-
-              // intersection over union
-              auto iou = bbox_utils::iou(bbox_a, bbox_b);
-              if (iou > nms_threshold)
-                keep = false;
+              // decayed scores are no longer sorted
+              i = n;
+              for (size_t j = 0; j < n; ++j)
+                if (!removed[j] && (i == n || scores[j] > scores[i]))
+                  i = j;
+              if (i == n || scores[i] < score_threshold)
+                break;
             }
+          else if (removed[i] || scores[i] < score_threshold)
+            continue;
+          removed[i] = 1;
+          picked.push_back(i);
+          if (max_picked > 0
+              && picked.size() >= static_cast<size_t>(max_picked))
+            break;
 
-          if (keep)
-            picked.push_back(i);
+          const size_t from = soft ? 0 : i + 1;
+          bbox_utils::ious(bboxes, i, from, overlaps.data());
+          for (size_t j = from; j < n; ++j)
+            {
+              if (removed[j] || (per_class && classes[j] != classes[i]))
+                continue;
+              if (soft)
+                scores[j] *= std::exp(-overlaps[j] * overlaps[j] / sigma);
+              else if (overlaps[j] > nms_threshold)
+                removed[j] = 1;
+            }
         }
     }
 
+    /** bboxes: list of bboxes in the format { xmin, ymin, xmax, ymax } sorted
+     * by decreasing confidence
+     *
+     * picked: vector used as output containing indices of bboxes kept by nms.
+     */
+    template <typename T>
+    inline void nms_sorted_bboxes(const std::vector<std::vector<T>> &bboxes,
+                                  std::vector<size_t> &picked, T nms_threshold)
+    {
+      BBoxes<T> sbboxes;
+      sbboxes.reserve(bboxes.size());
+      for (const std::vector<T> &bbox : bboxes)
+        sbboxes.push_back(bbox[0], bbox[1], bbox[2], bbox[3]);
+      nms_sorted_bboxes(sbboxes, picked, nms_threshold);
+    }
+
+    /**
+     * \brief non maximum suppression of bounding boxes data objects, with
+     * their probabilities and categories
+     * @param best_bbox if > 0, maximum number of kept boxes
+     * @param per_class whether only boxes of a same category suppress each
+     * other
+     * @param sigma if > 0, gaussian soft-nms, probabilities are decayed
+     */
     inline void nms_sorted_bboxes(std::vector<APIData> &bboxes,
                                   std::vector<double> &probs,
                                   std::vector<std::string> &cats,
-                                  double nms_threshold, int best_bbox)
+                                  double nms_threshold, int best_bbox,
+                                  bool per_class = false, double sigma = 0.0,
+                                  double score_threshold = 0.0)
     {
-      std::vector<std::vector<double>> sorted_boxes;
-      std::vector<size_t> picked;
-
+      BBoxes<double> sbboxes;
+      sbboxes.reserve(bboxes.size());
+      std::unordered_map<std::string, int> cat_ids;
       for (size_t l = 0; l < bboxes.size(); ++l)
         {
-          std::vector<double> bbox_vec{ bboxes[l].get("xmin").get<double>(),
-                                        bboxes[l].get("ymin").get<double>(),
-                                        bboxes[l].get("xmax").get<double>(),
-                                        bboxes[l].get("ymax").get<double>() };
-          sorted_boxes.push_back(bbox_vec);
+          int cls = 0;
+          if (per_class)
+            cls = cat_ids.emplace(cats.at(l), static_cast<int>(cat_ids.size()))
+                      .first->second;
+          sbboxes.push_back(bboxes[l].get("xmin").get<double>(),
+                            bboxes[l].get("ymin").get<double>(),
+                            bboxes[l].get("xmax").get<double>(),
+                            bboxes[l].get("ymax").get<double>(), probs.at(l),
+                            cls);
         }
       // We assume that bboxes are already sorted in model output
 
-      bbox_utils::nms_sorted_bboxes(sorted_boxes, picked, nms_threshold);
+      std::vector<size_t> picked;
+      bbox_utils::nms_sorted_bboxes(sbboxes, picked, nms_threshold, per_class,
+                                    sigma, score_threshold, best_bbox);
       std::vector<APIData> nbboxes;
       std::vector<double> nprobs;
       std::vector<std::string> ncats;
+      nbboxes.reserve(picked.size());
+      nprobs.reserve(picked.size());
+      ncats.reserve(picked.size());
 
       for (size_t pick : picked)
         {
-          nbboxes.push_back(bboxes.at(pick));
-          nprobs.push_back(probs.at(pick));
-          ncats.push_back(cats.at(pick));
-
-          if (best_bbox > 0
-              && nbboxes.size() >= static_cast<size_t>(best_bbox))
-            break;
+          nbboxes.push_back(std::move(bboxes.at(pick)));
+          nprobs.push_back(sbboxes._scores.at(pick));
+          ncats.push_back(std::move(cats.at(pick)));
         }
 
-      bboxes = nbboxes;
-      probs = nprobs;
-      cats = ncats;
+      bboxes = std::move(nbboxes);
+      probs = std::move(nprobs);
+      cats = std::move(ncats);
     }
   }
 }
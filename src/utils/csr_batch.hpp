@@ -0,0 +1,106 @@
+/**
+ * DeepDetect
+ * Copyright (c) 2023 Jolibrain
+ *
+ * This file is part of deepdetect.
+ *
+ * deepdetect is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * deepdetect is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with deepdetect.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DD_UTILS_CSR_BATCH_HPP
+#define DD_UTILS_CSR_BATCH_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace dd
+{
+  /**
+   * \brief batch of sparse samples in compressed sparse row format: values
+   * of row r are stored in [_indptr[r], _indptr[r + 1]) of _indices and
+   * _values, sorted by column index when filled by the input connectors.
+   */
+  class CSRBatch
+  {
+  public:
+    CSRBatch()
+    {
+    }
+
+    CSRBatch(const int64_t &ncols) : _ncols(ncols)
+    {
+    }
+
+    void reserve(const size_t &rows, const size_t &nnz)
+    {
+      _indptr.reserve(rows + 1);
+      _labels.reserve(rows);
+      _indices.reserve(nnz);
+      _values.reserve(nnz);
+    }
+
+    /**
+     * \brief adds a value to the current row
+     */
+    void add_value(const int &index, const float &value)
+    {
+      _indices.push_back(index);
+      _values.push_back(value);
+    }
+
+    /**
+     * \brief closes the current row, with values added since last call
+     */
+    void end_row(const float &label)
+    {
+      _indptr.push_back(_indices.size());
+      _labels.push_back(label);
+    }
+
+    size_t rows() const
+    {
+      return _indptr.size() - 1;
+    }
+
+    size_t nnz() const
+    {
+      return _indices.size();
+    }
+
+    /**
+     * \brief number of values in row r
+     */
+    int64_t row_nnz(const size_t &r) const
+    {
+      return _indptr[r + 1] - _indptr[r];
+    }
+
+    void clear()
+    {
+      _indptr.assign(1, 0);
+      _indices.clear();
+      _values.clear();
+      _labels.clear();
+    }
+
+    int64_t _ncols = 0;                   /**< feature size */
+    std::vector<int64_t> _indptr = { 0 }; /**< row offsets, rows + 1 items */
+    std::vector<int> _indices;            /**< column of every value */
+    std::vector<float> _values;
+    std::vector<float> _labels; /**< one per row */
+  };
+}
+
+#endif
@@ -0,0 +1,443 @@
+/**
+ * DeepDetect
+ * Copyright (c) 2023 Jolibrain
+ *
+ * This file is part of deepdetect.
+ *
+ * deepdetect is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * deepdetect is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with deepdetect.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DD_UTILS_CSV_BLOCK_PARSER_HPP
+#define DD_UTILS_CSV_BLOCK_PARSER_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <string>
+#include <thread>
+#include <vector>
+#ifndef WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#include <fstream>
+#include <iterator>
+#endif
+
+namespace dd
+{
+  /**
+   * \brief read-only view of a whole file, memory mapped when available
+   */
+  class MappedFile
+  {
+  public:
+    MappedFile(const std::string &fname)
+    {
+#ifndef WIN32
+      _fd = ::open(fname.c_str(), O_RDONLY);
+      if (_fd < 0)
+        return;
+      struct stat st;
+      if (fstat(_fd, &st) == 0)
+        _size = st.st_size;
+      _open = true;
+      if (_size == 0)
+        return;
+      void *m = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, _fd, 0);
+      if (m == MAP_FAILED)
+        {
+          _open = false;
+          _size = 0;
+          return;
+        }
+      madvise(m, _size, MADV_SEQUENTIAL);
+      _data = static_cast<const char *>(m);
+#else
+      std::ifstream in(fname, std::ios::binary);
+      if (!in.is_open())
+        return;
+      _buf.assign(std::istreambuf_iterator<char>(in),
+                  std::istreambuf_iterator<char>());
+      _data = _buf.data();
+      _size = _buf.size();
+      _open = true;
+#endif
+    }
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    ~MappedFile()
+    {
+#ifndef WIN32
+      if (_data)
+        munmap(const_cast<char *>(_data), _size);
+      if (_fd >= 0)
+        ::close(_fd);
+#endif
+    }
+
+    bool is_open() const
+    {
+      return _open;
+    }
+
+    const char *data() const
+    {
+      return _data;
+    }
+
+    size_t size() const
+    {
+      return _size;
+    }
+
+  private:
+    const char *_data = nullptr;
+    size_t _size = 0;
+    bool _open = false;
+#ifndef WIN32
+    int _fd = -1;
+#else
+    std::string _buf;
+#endif
+  };
+
+  /**
+   * \brief CSV parser over memory blocks. Input is cut into blocks at record
+   * boundaries, blocks are split into fields in parallel, and rows are handed
+   * back in input order. Records without quotes go through a memchr based
+   * fast path. As with csv::CsvParser, a quote opens a quoted field at the
+   * start of a field only, elsewhere it is a plain character. Quoted fields
+   * may hold delimiters and newlines, with doubled quotes as escapes.
+   * Carriage returns outside quotes and empty lines are dropped.
+   */
+  class CSVBlockParser
+  {
+  public:
+    typedef std::vector<std::string> Row;
+
+    CSVBlockParser(const char &delim = ',', const char &quote = '"',
+                   const size_t &block_size = 1 << 20)
+        : _delim(delim), _quote(quote), _block_size(block_size)
+    {
+      static const unsigned int ncpus
+          = std::max(1u, std::thread::hardware_concurrency());
+      _group_size = 4 * ncpus;
+    }
+
+    char delim() const
+    {
+      return _delim;
+    }
+
+    char quote() const
+    {
+      return _quote;
+    }
+
+    /**
+     * \brief parses a single record
+     * @return start of next record
+     */
+    const char *parse_record(const char *p, const char *e, Row &row) const
+    {
+      const char *nl
+          = static_cast<const char *>(std::memchr(p, '\n', e - p));
+      const char *le = nl ? nl : e;
+      if (!std::memchr(p, _quote, le - p))
+        {
+          const char *re = le;
+          while (re > p && re[-1] == '\r')
+            --re;
+          const char *f = p;
+          while (true)
+            {
+              const char *d
+                  = static_cast<const char *>(std::memchr(f, _delim, re - f));
+              if (!d)
+                {
+                  row.emplace_back(f, re - f);
+                  break;
+                }
+              row.emplace_back(f, d - f);
+              f = d + 1;
+            }
+          return nl ? nl + 1 : e;
+        }
+
+      // quoted fields, record may span several lines
+      std::string field;
+      bool in_quote = false;
+      bool field_start = true;
+      const char *c = p;
+      while (c < e)
+        {
+          const char ch = *c++;
+          if (in_quote)
+            {
+              if (ch != _quote)
+                field += ch;
+              else if (c < e && *c == _quote)
+                {
+                  field += _quote;
+                  ++c;
+                }
+              else
+                in_quote = false;
+            }
+          else if (ch == _quote && field_start)
+            {
+              in_quote = true;
+              field_start = false;
+            }
+          else if (ch == _delim)
+            {
+              row.push_back(field);
+              field.clear();
+              field_start = true;
+            }
+          else if (ch == '\n')
+            break;
+          else if (ch != '\r')
+            {
+              field += ch;
+              field_start = false;
+            }
+        }
+      row.push_back(field);
+      return c;
+    }
+
+    /**
+     * \brief end of the record starting at p, with the quoting rules of
+     * parse_record
+     * @return start of next record
+     */
+    const char *record_end(const char *p, const char *e) const
+    {
+      bool field_start = true;
+      while (p < e)
+        {
+          const char ch = *p++;
+          if (ch == _quote && field_start)
+            {
+              // quoted section, up to its closing quote
+              while (true)
+                {
+                  const char *q = static_cast<const char *>(
+                      std::memchr(p, _quote, e - p));
+                  if (!q)
+                    return e;
+                  p = q + 1;
+                  if (p < e && *p == _quote)
+                    ++p;
+                  else
+                    break;
+                }
+              field_start = false;
+            }
+          else if (ch == '\n')
+            return p;
+          else
+            field_start = (ch == _delim);
+        }
+      return e;
+    }
+
+    /**
+     * \brief parses all records in [b,e)
+     */
+    void parse_block(const char *b, const char *e, std::vector<Row> &rows) const
+    {
+      while (b < e)
+        {
+          Row row;
+          b = parse_record(b, e, row);
+          if (row.size() == 1 && row[0].empty())
+            continue;
+          rows.push_back(std::move(row));
+        }
+    }
+
+    /**
+     * \brief end of the first record ending at or after target
+     * @param start a record start, before target
+     */
+    size_t next_boundary(const char *d, const size_t &start,
+                         const size_t &target, const size_t &size,
+                         const bool &has_quotes) const
+    {
+      if (target >= size)
+        return size;
+      if (!has_quotes)
+        {
+          const char *nl = static_cast<const char *>(
+              std::memchr(d + target, '\n', size - target));
+          return nl ? nl - d + 1 : size;
+        }
+      // records are walked from the start one, since only quotes at field
+      // starts tell whether a newline ends a record
+      const char *e = d + size;
+      const char *r = d + start;
+      do
+        r = record_end(r, e);
+      while (r < e && r <= d + target);
+      return r - d;
+    }
+
+    /**
+     * \brief parses [data,data+size) and calls f on every row, in order.
+     * Blocks are parsed by groups, so that memory stays bounded.
+     * @return number of rows
+     */
+    template <typename F>
+    size_t parse(const char *data, const size_t &size, F &&f) const
+    {
+      size_t nrows = 0;
+      if (size == 0)
+        return nrows;
+      const bool has_quotes = std::memchr(data, _quote, size) != nullptr;
+      std::vector<size_t> bounds;
+      std::vector<std::vector<Row>> rows;
+      size_t start = 0;
+      while (start < size)
+        {
+          bounds.assign(1, start);
+          while (bounds.size() <= _group_size && bounds.back() < size)
+            bounds.push_back(next_boundary(data, bounds.back(),
+                                           bounds.back() + _block_size, size,
+                                           has_quotes));
+          const int nblocks = bounds.size() - 1;
+          rows.clear();
+          rows.resize(nblocks);
+#pragma omp parallel for schedule(dynamic)
+          for (int b = 0; b < nblocks; ++b)
+            parse_block(data + bounds[b], data + bounds[b + 1], rows[b]);
+          for (std::vector<Row> &brows : rows)
+            for (Row &row : brows)
+              {
+                f(row);
+                ++nrows;
+              }
+          start = bounds.back();
+        }
+      return nrows;
+    }
+
+    /**
+     * \brief parses a stream from its current position, reading it by
+     * groups of blocks
+     * @return number of rows
+     */
+    template <typename F> size_t parse(std::istream &in, F &&f) const
+    {
+      size_t nrows = 0;
+      const bool has_quotes = true;
+      std::string buf;
+      size_t len = 0;
+      const size_t read_size = _block_size * _group_size;
+      while (in)
+        {
+          buf.resize(len + read_size);
+          in.read(&buf[len], read_size);
+          len += in.gcount();
+          // complete records only, the rest goes with next read
+          size_t end = len;
+          if (in)
+            {
+              size_t b = 0, nb = 0;
+              while ((nb = next_boundary(buf.data(), b, b, len, has_quotes))
+                     < len)
+                b = nb;
+              end = b;
+              if (end == 0)
+                continue; // record larger than read size
+            }
+          nrows += parse(buf.data(), end, f);
+          buf.erase(0, end);
+          len -= end;
+        }
+      return nrows;
+    }
+
+  private:
+    char _delim = ',';
+    char _quote = '"';
+    size_t _block_size = 1 << 20; /**< parsing block size, in bytes */
+    size_t _group_size = 4; /**< blocks parsed concurrently */
+  };
+
+  /**
+   * \brief string to double, with a fast path for plain decimal numbers,
+   * i.e. those that are exactly rounded from a 53 bits integer and a power of
+   * ten up to 1e22. Other inputs go through std::stod, so that accepted
+   * inputs and errors are unchanged.
+   */
+  inline double csv_stod(const std::string &s)
+  {
+    static const double pow10[]
+        = { 1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,
+            1e8,  1e9,  1e10, 1e11, 1e12, 1e13, 1e14, 1e15,
+            1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+    const char *p = s.data();
+    const char *e = p + s.size();
+    bool neg = false;
+    if (p < e && (*p == '-' || *p == '+'))
+      neg = (*p++ == '-');
+    uint64_t m = 0;
+    int ndigits = 0, exp10 = 0;
+    while (p < e && *p >= '0' && *p <= '9')
+      {
+        m = m * 10 + (*p++ - '0');
+        ++ndigits;
+      }
+    if (p < e && *p == '.')
+      {
+        ++p;
+        while (p < e && *p >= '0' && *p <= '9')
+          {
+            m = m * 10 + (*p++ - '0');
+            ++ndigits;
+            --exp10;
+          }
+      }
+    if (p < e && (*p == 'e' || *p == 'E') && ndigits > 0)
+      {
+        ++p;
+        bool eneg = false;
+        if (p < e && (*p == '-' || *p == '+'))
+          eneg = (*p++ == '-');
+        int x = 0;
+        const char *xd = p;
+        while (p < e && *p >= '0' && *p <= '9' && x < 1000)
+          x = x * 10 + (*p++ - '0');
+        if (p == xd)
+          return std::stod(s);
+        exp10 += eneg ? -x : x;
+      }
+    if (p != e || ndigits == 0 || ndigits > 19 || m > (uint64_t(1) << 53)
+        || exp10 < -22 || exp10 > 22)
+      return std::stod(s);
+    double v = static_cast<double>(m);
+    v = exp10 < 0 ? v / pow10[-exp10] : v * pow10[exp10];
+    return neg ? -v : v;
+  }
+}
+
+#endif
@@ -25,6 +25,7 @@
 #include <fstream>
 #include <iostream>
 #include <unordered_set>
+#include <vector>
 #include <sys/stat.h>
 #include <stdio.h>
 #include <boost/filesystem.hpp>
@@ -79,6 +80,18 @@ namespace dd
       return boost::filesystem::last_write_time(p);
     }
 
+    static bool file_size_modif(const std::string &fname, long int &size,
+                                long long &mtime_ns)
+    {
+      boost::system::error_code ec;
+      boost::filesystem::path p(fname);
+      size = boost::filesystem::file_size(p, ec);
+      if (ec)
+        return false;
+      mtime_ns = boost::filesystem::last_write_time(p, ec) * 1000000000LL;
+      return !ec;
+    }
+
     static int clear_directory(const std::string &repo)
     {
       assert(false);
@@ -172,6 +185,20 @@ namespace dd
         return -1;
     }
 
+    /**
+     * \brief file size in bytes and last modification time in nanoseconds
+     */
+    static bool file_size_modif(const std::string &fname, long int &size,
+                                long long &mtime_ns)
+    {
+      struct stat bstat;
+      if (stat(fname.c_str(), &bstat) != 0)
+        return false;
+      size = bstat.st_size;
+      mtime_ns = bstat.st_mtim.tv_sec * 1000000000LL + bstat.st_mtim.tv_nsec;
+      return true;
+    }
+
     static int list_directory(const std::string &repo, const bool &files,
                               const bool &dirs, const bool &sub_files,
                               std::unordered_set<std::string> &lfiles)
@@ -292,6 +319,34 @@ namespace dd
       return 0;
     }
 
+    /**
+     * 64 bits FNV-1a hash of file content, as an hexadecimal string,
+     * empty if the file cannot be read
+     */
+    static std::string file_hash(const std::string &fname)
+    {
+      std::ifstream in(fname, std::ios::binary);
+      if (!in.is_open())
+        return "";
+      uint64_t h = 14695981039346656037ULL;
+      std::vector<char> buf(1 << 16);
+      while (in)
+        {
+          in.read(buf.data(), buf.size());
+          std::streamsize n = in.gcount();
+          for (std::streamsize i = 0; i < n; ++i)
+            {
+              h ^= static_cast<unsigned char>(buf[i]);
+              h *= 1099511628211ULL;
+            }
+        }
+      static const char digits[] = "0123456789abcdef";
+      std::string hex(16, '0');
+      for (int i = 15; i >= 0; --i, h >>= 4)
+        hex[i] = digits[h & 0xf];
+      return hex;
+    }
+
     static int remove_file(const std::string &repo, const std::string &f)
     {
       std::string fn = repo + "/" + f;
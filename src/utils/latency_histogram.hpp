@@ -0,0 +1,190 @@
+/**
+ * DeepDetect
+ * Copyright (c) 2023 Jolibrain
+ *
+ * This file is part of deepdetect.
+ *
+ * deepdetect is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * deepdetect is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with deepdetect.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DD_UTILS_LATENCY_HISTOGRAM_HPP
+#define DD_UTILS_LATENCY_HISTOGRAM_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "utils/sharded_counters.hpp"
+
+namespace dd
+{
+  /**
+   * \brief lock-free latency histogram, with log-linear buckets in the
+   * spirit of HDR histograms: values are recorded in microseconds, exactly
+   * up to 32us, then with 16 buckets per power of two, i.e. within 1/16 of
+   * the value, up to ~19 hours. Counts are sharded per recording thread so
+   * that concurrent predict calls do not contend.
+   */
+  class LatencyHistogram
+  {
+  public:
+    static const int _sub_bits = 5;
+    static const int _max_bits = 36; /**< values clamped below 2^36 us. */
+    static const int _nbuckets
+        = (1 << _sub_bits) + (_max_bits - _sub_bits) * (1 << (_sub_bits - 1));
+
+    LatencyHistogram() : _counts(_nbuckets + 1)
+    {
+    }
+
+    LatencyHistogram(const LatencyHistogram &h)
+        : _counts(h._counts), _max(h._max.load(std::memory_order_relaxed))
+    {
+    }
+
+    LatencyHistogram &operator=(const LatencyHistogram &) = delete;
+
+    /**
+     * \brief records a duration
+     */
+    void record(const double &ms)
+    {
+      uint64_t us = ms > 0.0 ? static_cast<uint64_t>(std::llround(ms * 1e3))
+                             : 0;
+      us = std::min(us, (uint64_t(1) << _max_bits) - 1);
+      _counts.add(bucket(us));
+      _counts.add(_nbuckets, us);
+      uint64_t m = _max.load(std::memory_order_relaxed);
+      while (us > m
+             && !_max.compare_exchange_weak(m, us, std::memory_order_relaxed))
+        ;
+    }
+
+    /**
+     * \brief clears all counts, concurrent records may or may not be kept
+     */
+    void reset()
+    {
+      _counts.reset();
+      _max.store(0, std::memory_order_relaxed);
+    }
+
+    /**
+     * \brief counts merged over shards
+     * @param counts per bucket counts
+     * @return total count
+     */
+    uint64_t merge(std::vector<uint64_t> &counts) const
+    {
+      uint64_t total = 0;
+      counts.resize(_nbuckets);
+      for (int b = 0; b < _nbuckets; ++b)
+        {
+          counts[b] = _counts.value(b);
+          total += counts[b];
+        }
+      return total;
+    }
+
+    /**
+     * \brief number of recorded values
+     */
+    uint64_t count() const
+    {
+      std::vector<uint64_t> counts;
+      return merge(counts);
+    }
+
+    /**
+     * \brief sum of recorded values, in milliseconds
+     */
+    double sum() const
+    {
+      return _counts.value(_nbuckets) / 1e3;
+    }
+
+    /**
+     * \brief largest recorded value, in milliseconds
+     */
+    double max() const
+    {
+      return _max.load(std::memory_order_relaxed) / 1e3;
+    }
+
+    /**
+     * \brief values at given quantiles, in milliseconds, reported as the
+     * highest value of their bucket and at most the largest recorded value
+     * @param qs quantiles in [0,1]
+     */
+    std::vector<double> percentiles(const std::vector<double> &qs) const
+    {
+      std::vector<uint64_t> counts;
+      uint64_t total = merge(counts);
+      std::vector<double> vals(qs.size(), 0.0);
+      if (total == 0)
+        return vals;
+      double m = max();
+      for (size_t i = 0; i < qs.size(); ++i)
+        {
+          uint64_t rank = static_cast<uint64_t>(std::ceil(qs[i] * total));
+          rank = std::max(rank, uint64_t(1));
+          uint64_t cum = 0;
+          int b = 0;
+          for (; b < _nbuckets - 1; ++b)
+            {
+              cum += counts[b];
+              if (cum >= rank)
+                break;
+            }
+          vals[i] = std::min(bucket_max(b) / 1e3, m);
+        }
+      return vals;
+    }
+
+    /**
+     * \brief bucket of a value in microseconds
+     */
+    static int bucket(const uint64_t &us)
+    {
+      if (us < (uint64_t(1) << _sub_bits))
+        return static_cast<int>(us);
+      int msb = 63 - __builtin_clzll(us);
+      int shift = msb - _sub_bits + 1;
+      return (1 << _sub_bits) + (msb - _sub_bits) * (1 << (_sub_bits - 1))
+             + static_cast<int>((us >> shift) - (1 << (_sub_bits - 1)));
+    }
+
+    /**
+     * \brief highest value in microseconds that falls into bucket b
+     */
+    static uint64_t bucket_max(const int &b)
+    {
+      if (b < (1 << _sub_bits))
+        return b;
+      int k = b - (1 << _sub_bits);
+      int msb = k / (1 << (_sub_bits - 1)) + _sub_bits;
+      uint64_t sub = k % (1 << (_sub_bits - 1)) + (1 << (_sub_bits - 1));
+      int shift = msb - _sub_bits + 1;
+      return ((sub + 1) << shift) - 1;
+    }
+
+  private:
+    ShardedCounters _counts; /**< per bucket counts, then sum. */
+    std::atomic<uint64_t> _max{ 0 };
+  };
+}
+
+#endif
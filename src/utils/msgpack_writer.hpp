@@ -0,0 +1,301 @@
+/**
+ * DeepDetect
+ * Copyright (c) 2023 Jolibrain
+ *
+ * This file is part of deepdetect.
+ *
+ * deepdetect is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * deepdetect is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with deepdetect.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DD_UTILS_MSGPACK_WRITER_HPP
+#define DD_UTILS_MSGPACK_WRITER_HPP
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace dd
+{
+  /**
+   * \brief MessagePack writer, with the same SAX interface as rapidjson
+   * writers so that answers are rendered by the same code in both formats.
+   * Maps and arrays are written with 32 bits headers, whose sizes are
+   * filled when closed. Arrays of doubles are written as float32, either as
+   * MessagePack arrays or, with raw_float_arrays, as bin blobs of little
+   * endian float32.
+   */
+  class MsgPackWriter
+  {
+  public:
+    MsgPackWriter(const bool &raw_float_arrays = false)
+        : _raw_float_arrays(raw_float_arrays)
+    {
+    }
+
+    /**
+     * \brief rendered bytes
+     */
+    const std::string &str() const
+    {
+      return _buf;
+    }
+
+    bool Null()
+    {
+      value();
+      _buf.push_back(static_cast<char>(0xc0));
+      return true;
+    }
+
+    bool Bool(bool b)
+    {
+      value();
+      _buf.push_back(static_cast<char>(b ? 0xc3 : 0xc2));
+      return true;
+    }
+
+    bool Int(int i)
+    {
+      return Int64(i);
+    }
+
+    bool Uint(unsigned u)
+    {
+      return Uint64(u);
+    }
+
+    bool Int64(int64_t i)
+    {
+      if (i >= 0)
+        return Uint64(static_cast<uint64_t>(i));
+      value();
+      if (i >= -32)
+        _buf.push_back(static_cast<char>(i));
+      else if (i >= INT32_MIN)
+        {
+          _buf.push_back(static_cast<char>(0xd2));
+          put_be(static_cast<uint32_t>(static_cast<int32_t>(i)), 4);
+        }
+      else
+        {
+          _buf.push_back(static_cast<char>(0xd3));
+          put_be(static_cast<uint64_t>(i), 8);
+        }
+      return true;
+    }
+
+    bool Uint64(uint64_t u)
+    {
+      value();
+      if (u < 128)
+        _buf.push_back(static_cast<char>(u));
+      else if (u <= UINT32_MAX)
+        {
+          _buf.push_back(static_cast<char>(0xce));
+          put_be(u, 4);
+        }
+      else
+        {
+          _buf.push_back(static_cast<char>(0xcf));
+          put_be(u, 8);
+        }
+      return true;
+    }
+
+    bool Double(double d)
+    {
+      value();
+      uint64_t bits;
+      std::memcpy(&bits, &d, sizeof(bits));
+      _buf.push_back(static_cast<char>(0xcb));
+      put_be(bits, 8);
+      return true;
+    }
+
+    bool RawNumber(const char *str, size_t length, bool copy = false)
+    {
+      (void)copy;
+      return Double(std::stod(std::string(str, length)));
+    }
+
+    bool String(const char *str)
+    {
+      return String(str, std::strlen(str));
+    }
+
+    bool String(const char *str, size_t length, bool copy = false)
+    {
+      (void)copy;
+      value();
+      if (length < 32)
+        _buf.push_back(static_cast<char>(0xa0 | length));
+      else if (length <= UINT8_MAX)
+        {
+          _buf.push_back(static_cast<char>(0xd9));
+          put_be(length, 1);
+        }
+      else if (length <= UINT16_MAX)
+        {
+          _buf.push_back(static_cast<char>(0xda));
+          put_be(length, 2);
+        }
+      else
+        {
+          _buf.push_back(static_cast<char>(0xdb));
+          put_be(length, 4);
+        }
+      _buf.append(str, length);
+      return true;
+    }
+
+    bool Key(const char *str)
+    {
+      return Key(str, std::strlen(str));
+    }
+
+    bool Key(const char *str, size_t length, bool copy = false)
+    {
+      ++_containers.back()._size;
+      _in_key = true;
+      String(str, length, copy);
+      _in_key = false;
+      return true;
+    }
+
+    bool StartObject()
+    {
+      return start(0xdf);
+    }
+
+    bool EndObject(size_t member_count = 0)
+    {
+      (void)member_count;
+      return end();
+    }
+
+    bool StartArray()
+    {
+      return start(0xdd);
+    }
+
+    bool EndArray(size_t element_count = 0)
+    {
+      (void)element_count;
+      return end();
+    }
+
+    /**
+     * \brief array of doubles, written as float32
+     */
+    template <typename Vec> void FloatArray(const Vec &vd)
+    {
+      size_t n = vd.size();
+      if (_raw_float_arrays)
+        {
+          value();
+          _buf.push_back(static_cast<char>(0xc6));
+          put_be(n * 4, 4);
+        }
+      else
+        {
+          start(0xdd);
+          _containers.back()._size = n;
+        }
+      for (size_t i = 0; i < n; ++i)
+        {
+          float f = static_cast<float>(vd[i]);
+          uint32_t bits;
+          std::memcpy(&bits, &f, sizeof(bits));
+          if (_raw_float_arrays)
+            for (int b = 0; b < 4; ++b)
+              _buf.push_back(static_cast<char>((bits >> (8 * b)) & 0xff));
+          else
+            {
+              _buf.push_back(static_cast<char>(0xca));
+              put_be(bits, 4);
+            }
+        }
+      if (!_raw_float_arrays)
+        end();
+    }
+
+  private:
+    struct Container
+    {
+      size_t _offset;    /**< header position. */
+      uint32_t _size;    /**< number of elements, or pairs. */
+      bool _map;
+    };
+
+    void value()
+    {
+      if (!_in_key && !_containers.empty() && !_containers.back()._map)
+        ++_containers.back()._size;
+    }
+
+    bool start(const unsigned char &type)
+    {
+      value();
+      _containers.push_back({ _buf.size(), 0, type == 0xdf });
+      _buf.push_back(static_cast<char>(type));
+      put_be(0, 4);
+      return true;
+    }
+
+    bool end()
+    {
+      Container c = _containers.back();
+      _containers.pop_back();
+      for (int b = 0; b < 4; ++b)
+        _buf[c._offset + 1 + b]
+            = static_cast<char>((c._size >> (8 * (3 - b))) & 0xff);
+      return true;
+    }
+
+    void put_be(const uint64_t &v, const int &nbytes)
+    {
+      for (int b = nbytes - 1; b >= 0; --b)
+        _buf.push_back(static_cast<char>((v >> (8 * b)) & 0xff));
+    }
+
+    std::string _buf;
+    std::vector<Container> _containers;
+    bool _in_key = false;
+    bool _raw_float_arrays = false;
+  };
+
+  /**
+   * \brief writes an array of doubles with a rapidjson writer
+   */
+  template <typename Writer, typename Vec>
+  inline void write_double_array(Writer &writer, const Vec &vd)
+  {
+    writer.StartArray();
+    for (size_t i = 0; i < vd.size(); ++i)
+      writer.Double(vd[i]);
+    writer.EndArray();
+  }
+
+  /**
+   * \brief writes an array of doubles as float32
+   */
+  template <typename Vec>
+  inline void write_double_array(MsgPackWriter &writer, const Vec &vd)
+  {
+    writer.FloatArray(vd);
+  }
+}
+
+#endif
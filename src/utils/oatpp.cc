@@ -23,6 +23,7 @@
 #include <iostream>
 
 #include "dto/ddtypes.hpp"
+#include "utils/msgpack_writer.hpp"
 
 namespace dd
 {
@@ -40,6 +41,8 @@ namespace dd
                                    DTO::vectorDeserialize<double>);
       deser->setDeserializerMethod(DTO::DTOVector<uint8_t>::Class::CLASS_ID,
                                    DTO::vectorDeserialize<uint8_t>);
+      deser->setDeserializerMethod(DTO::DTOVector<int>::Class::CLASS_ID,
+                                   DTO::vectorDeserialize<int>);
       deser->setDeserializerMethod(DTO::DTOVector<bool>::Class::CLASS_ID,
                                    DTO::vectorDeserialize<bool>);
       auto ser = object_mapper->getSerializer();
@@ -49,6 +52,8 @@ namespace dd
                                DTO::vectorSerialize<double>);
       ser->setSerializerMethod(DTO::DTOVector<uint8_t>::Class::CLASS_ID,
                                DTO::vectorSerialize<uint8_t>);
+      ser->setSerializerMethod(DTO::DTOVector<int>::Class::CLASS_ID,
+                               DTO::vectorSerialize<int>);
       ser->setSerializerMethod(DTO::DTOVector<bool>::Class::CLASS_ID,
                                DTO::vectorSerialize<bool>);
 
@@ -162,6 +167,16 @@ namespace dd
               jval.PushBack(vec->at(i), jdoc.GetAllocator());
             }
         }
+      else if (polymorph.getValueType()
+               == DTO::DTOVector<int>::Class::getType())
+        {
+          auto vec = polymorph.cast<DTO::DTOVector<int>>();
+          jval = JVal(rapidjson::kArrayType);
+          for (size_t i = 0; i < vec->size(); ++i)
+            {
+              jval.PushBack(vec->at(i), jdoc.GetAllocator());
+            }
+        }
       else if (polymorph.getValueType()
                == DTO::DTOVector<bool>::Class::getType())
         {
@@ -264,5 +279,187 @@ namespace dd
                                    + "\": type not recognised");
         }
     }
+
+    /** Whether a DTO value is null, including through Any */
+    static bool isNull(const oatpp::Void &polymorph)
+    {
+      if (polymorph == nullptr)
+        return true;
+      if (polymorph.getValueType() == oatpp::Any::Class::getType())
+        return static_cast<oatpp::data::mapping::type::AnyHandle *>(
+                   polymorph.get())
+                   ->ptr
+               == nullptr;
+      return false;
+    }
+
+    template <typename Writer>
+    void dtoWrite(const oatpp::Void &polymorph, Writer &writer,
+                  bool ignore_null)
+    {
+      if (isNull(polymorph))
+        {
+          writer.Null();
+        }
+      else if (polymorph.getValueType() == oatpp::Any::Class::getType())
+        {
+          auto anyHandle
+              = static_cast<oatpp::data::mapping::type::AnyHandle *>(
+                  polymorph.get());
+          dtoWrite(oatpp::Void(anyHandle->ptr, anyHandle->type), writer,
+                    ignore_null);
+        }
+      else if (polymorph.getValueType() == oatpp::String::Class::getType())
+        {
+          auto str = polymorph.cast<oatpp::String>();
+          writer.String(str->c_str(), str->size());
+        }
+      else if (polymorph.getValueType() == oatpp::Int32::Class::getType())
+        {
+          int32_t i = polymorph.cast<oatpp::Int32>();
+          writer.Int(i);
+        }
+      else if (polymorph.getValueType() == oatpp::UInt32::Class::getType())
+        {
+          uint32_t i = polymorph.cast<oatpp::UInt32>();
+          writer.Uint(i);
+        }
+      else if (polymorph.getValueType() == oatpp::Int64::Class::getType())
+        {
+          int64_t i = polymorph.cast<oatpp::Int64>();
+          writer.Int64(i);
+        }
+      else if (polymorph.getValueType() == oatpp::UInt64::Class::getType())
+        {
+          uint64_t i = polymorph.cast<oatpp::UInt64>();
+          writer.Uint64(i);
+        }
+      else if (polymorph.getValueType() == oatpp::Float32::Class::getType())
+        {
+          float f = polymorph.cast<oatpp::Float32>();
+          writer.Double(f);
+        }
+      else if (polymorph.getValueType() == oatpp::Float64::Class::getType())
+        {
+          double f = polymorph.cast<oatpp::Float64>();
+          writer.Double(f);
+        }
+      else if (polymorph.getValueType() == oatpp::Boolean::Class::getType())
+        {
+          bool b = polymorph.cast<oatpp::Boolean>();
+          writer.Bool(b);
+        }
+      else if (polymorph.getValueType()
+               == DTO::DTOVector<double>::Class::getType())
+        {
+          auto vec = polymorph.cast<DTO::DTOVector<double>>();
+          write_double_array(writer, *vec);
+        }
+      else if (polymorph.getValueType()
+               == DTO::DTOVector<uint8_t>::Class::getType())
+        {
+          auto vec = polymorph.cast<DTO::DTOVector<uint8_t>>();
+          writer.StartArray();
+          for (size_t i = 0; i < vec->size(); ++i)
+            writer.Uint(vec->at(i));
+          writer.EndArray();
+        }
+      else if (polymorph.getValueType()
+               == DTO::DTOVector<int>::Class::getType())
+        {
+          auto vec = polymorph.cast<DTO::DTOVector<int>>();
+          writer.StartArray();
+          for (size_t i = 0; i < vec->size(); ++i)
+            writer.Int(vec->at(i));
+          writer.EndArray();
+        }
+      else if (polymorph.getValueType()
+               == DTO::DTOVector<bool>::Class::getType())
+        {
+          auto vec = polymorph.cast<DTO::DTOVector<bool>>();
+          writer.StartArray();
+          for (size_t i = 0; i < vec->size(); ++i)
+            writer.Bool(vec->at(i));
+          writer.EndArray();
+        }
+      else if (polymorph.getValueType()->classId.id
+                   == oatpp::data::mapping::type::__class::AbstractVector::
+                          CLASS_ID.id
+               || polymorph.getValueType()->classId.id
+                      == oatpp::data::mapping::type::__class::AbstractList::
+                             CLASS_ID.id)
+        {
+          auto poly_dispatch
+              = static_cast<const oatpp::data::mapping::type::__class::
+                                Collection::PolymorphicDispatcher *>(
+                  polymorph.getValueType()->polymorphicDispatcher);
+          writer.StartArray();
+          for (auto it = poly_dispatch->beginIteration(polymorph);
+               !it->finished(); it->next())
+            dtoWrite(it->get(), writer, ignore_null);
+          writer.EndArray();
+        }
+      else if (polymorph.getValueType()->classId.id
+               == oatpp::data::mapping::type::__class::AbstractPairList::
+                      CLASS_ID.id)
+        {
+          writer.StartObject();
+          auto fields = staticCast<oatpp::AbstractFields>(polymorph);
+          for (auto const &field : *fields)
+            {
+              if (ignore_null && isNull(field.second))
+                continue;
+              writer.Key(field.first->c_str(), field.first->size());
+              dtoWrite(field.second, writer, ignore_null);
+            }
+          writer.EndObject();
+        }
+      else if (polymorph.getValueType()->classId.id
+               == oatpp::data::mapping::type::__class::AbstractUnorderedMap::
+                      CLASS_ID.id)
+        {
+          writer.StartObject();
+          auto fields = staticCast<oatpp::AbstractUnorderedFields>(polymorph);
+          for (auto const &field : *fields)
+            {
+              if (ignore_null && isNull(field.second))
+                continue;
+              writer.Key(field.first->c_str(), field.first->size());
+              dtoWrite(field.second, writer, ignore_null);
+            }
+          writer.EndObject();
+        }
+      else if (polymorph.getValueType()->classId.id
+               == oatpp::data::mapping::type::__class::AbstractObject::CLASS_ID
+                      .id)
+        {
+          writer.StartObject();
+          auto dispatcher
+              = static_cast<const oatpp::data::mapping::type::__class::
+                                AbstractObject::PolymorphicDispatcher *>(
+                  polymorph.getValueType()->polymorphicDispatcher);
+          auto fields = dispatcher->getProperties()->getList();
+          auto object = static_cast<oatpp::BaseObject *>(polymorph.get());
+          for (auto const &field : fields)
+            {
+              auto val = field->get(object);
+              if (ignore_null && isNull(val))
+                continue;
+              writer.Key(field->name);
+              dtoWrite(val, writer, ignore_null);
+            }
+          writer.EndObject();
+        }
+      else
+        {
+          std::string type_name = polymorph.getValueType()->classId.name;
+          throw std::runtime_error("dtoWrite: \"" + type_name
+                                   + "\": type not recognised");
+        }
+    }
+
+    template void dtoWrite<JWriter>(const oatpp::Void &, JWriter &, bool);
+    template void dtoWrite<MsgPackWriter>(const oatpp::Void &,
+                                          MsgPackWriter &, bool);
   }
 }
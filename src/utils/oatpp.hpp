@@ -69,6 +69,12 @@ namespace dd
                    bool ignore_null = true);
     void dtoToJVal(const oatpp::Void &polymorph, JDoc &jdoc, JVal &jval,
                    bool ignore_null = true);
+
+    /** Write a DTO to a JSON or MessagePack writer, without building an
+     * intermediate document */
+    template <typename Writer>
+    void dtoWrite(const oatpp::Void &polymorph, Writer &writer,
+                  bool ignore_null = true);
   }
 }
 
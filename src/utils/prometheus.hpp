@@ -0,0 +1,162 @@
+/**
+ * DeepDetect
+ * Copyright (c) 2023 Jolibrain
+ *
+ * This file is part of deepdetect.
+ *
+ * deepdetect is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * deepdetect is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with deepdetect.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DD_UTILS_PROMETHEUS_HPP
+#define DD_UTILS_PROMETHEUS_HPP
+
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#ifndef WIN32
+#include <unistd.h>
+#endif
+
+namespace dd
+{
+  /**
+   * \brief Prometheus text exposition format writer. Samples are grouped
+   * by metric family, whatever the order they are added in, since every
+   * family must be contiguous in the output.
+   */
+  class PrometheusWriter
+  {
+  public:
+    /**
+     * \brief declares a metric family, once
+     * @param type counter, gauge, summary or histogram
+     */
+    void declare(const std::string &name, const std::string &type,
+                 const std::string &help)
+    {
+      Family &f = family(name);
+      f._type = type;
+      f._help = help;
+    }
+
+    /**
+     * \brief adds a sample to a family
+     * @param labels comma separated labels, e.g. from label()
+     * @param suffix sample name suffix, e.g. _sum or _bucket
+     */
+    void add(const std::string &name, const std::string &labels,
+             const double &value, const std::string &suffix = "")
+    {
+      std::ostringstream sample;
+      sample << name << suffix;
+      if (!labels.empty())
+        sample << "{" << labels << "}";
+      sample << " ";
+      if (std::isnan(value))
+        sample << "NaN";
+      else if (std::isinf(value))
+        sample << (value > 0 ? "+Inf" : "-Inf");
+      else
+        {
+          sample.precision(15);
+          sample << value;
+        }
+      family(name)._samples.push_back(sample.str());
+    }
+
+    /**
+     * \brief exposition text
+     */
+    std::string str() const
+    {
+      std::ostringstream out;
+      for (const std::string &name : _order)
+        {
+          const Family &f = _families.at(name);
+          if (!f._help.empty())
+            out << "# HELP " << name << " " << f._help << "\n";
+          if (!f._type.empty())
+            out << "# TYPE " << name << " " << f._type << "\n";
+          for (const std::string &s : f._samples)
+            out << s << "\n";
+        }
+      return out.str();
+    }
+
+    /**
+     * \brief label with escaped value
+     */
+    static std::string label(const std::string &key, const std::string &value)
+    {
+      std::string l = key + "=\"";
+      for (char c : value)
+        {
+          if (c == '\\' || c == '"')
+            l += '\\';
+          if (c == '\n')
+            l += "\\n";
+          else
+            l += c;
+        }
+      return l + "\"";
+    }
+
+    /**
+     * \brief adds process resident and virtual memory, from /proc
+     */
+    void add_process_memory()
+    {
+#ifndef WIN32
+      std::ifstream statm("/proc/self/statm");
+      long vsize = 0, rss = 0;
+      if (!(statm >> vsize >> rss))
+        return;
+      long page = sysconf(_SC_PAGESIZE);
+      declare("process_resident_memory_bytes", "gauge",
+              "Resident memory size in bytes.");
+      add("process_resident_memory_bytes", "",
+          static_cast<double>(rss) * page);
+      declare("process_virtual_memory_bytes", "gauge",
+              "Virtual memory size in bytes.");
+      add("process_virtual_memory_bytes", "",
+          static_cast<double>(vsize) * page);
+#endif
+    }
+
+  private:
+    struct Family
+    {
+      std::string _type;
+      std::string _help;
+      std::vector<std::string> _samples;
+    };
+
+    Family &family(const std::string &name)
+    {
+      auto hit = _families.find(name);
+      if (hit != _families.end())
+        return (*hit).second;
+      _order.push_back(name);
+      return _families[name];
+    }
+
+    std::vector<std::string> _order; /**< families in order of appearance. */
+    std::unordered_map<std::string, Family> _families;
+  };
+}
+
+#endif
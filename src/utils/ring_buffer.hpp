@@ -0,0 +1,137 @@
+/**
+ * DeepDetect
+ * Copyright (c) 2023 Jolibrain
+ *
+ * This file is part of deepdetect.
+ *
+ * deepdetect is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * deepdetect is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with deepdetect.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DD_UTILS_RING_BUFFER_HPP
+#define DD_UTILS_RING_BUFFER_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+namespace dd
+{
+  /**
+   * \brief bounded lock-free multi-producer multi-consumer queue, after
+   * D. Vyukov's: every slot carries a sequence number telling whether it is
+   * free for the producer or ready for the consumer of a given position.
+   * Pushing to a full buffer fails instead of blocking.
+   */
+  template <typename T> class RingBuffer
+  {
+  public:
+    /**
+     * @param capacity rounded up to a power of two
+     */
+    RingBuffer(const size_t &capacity)
+    {
+      _capacity = 2;
+      while (_capacity < capacity)
+        _capacity <<= 1;
+      _mask = _capacity - 1;
+      _slots.reset(new Slot[_capacity]);
+      for (size_t i = 0; i < _capacity; ++i)
+        _slots[i]._seq.store(i, std::memory_order_relaxed);
+    }
+
+    RingBuffer(const RingBuffer &) = delete;
+    RingBuffer &operator=(const RingBuffer &) = delete;
+
+    size_t capacity() const
+    {
+      return _capacity;
+    }
+
+    /**
+     * \brief pushes a value
+     * @return false if the buffer is full, value is left untouched
+     */
+    bool try_push(T &&value)
+    {
+      size_t pos = _tail.load(std::memory_order_relaxed);
+      Slot *slot;
+      while (true)
+        {
+          slot = &_slots[pos & _mask];
+          size_t seq = slot->_seq.load(std::memory_order_acquire);
+          std::ptrdiff_t diff = static_cast<std::ptrdiff_t>(seq)
+                                - static_cast<std::ptrdiff_t>(pos);
+          if (diff == 0)
+            {
+              if (_tail.compare_exchange_weak(pos, pos + 1,
+                                              std::memory_order_relaxed))
+                break;
+            }
+          else if (diff < 0)
+            return false;
+          else
+            pos = _tail.load(std::memory_order_relaxed);
+        }
+      slot->_value = std::move(value);
+      slot->_seq.store(pos + 1, std::memory_order_release);
+      return true;
+    }
+
+    /**
+     * \brief pops the oldest value
+     * @return false if the buffer is empty
+     */
+    bool try_pop(T &value)
+    {
+      size_t pos = _head.load(std::memory_order_relaxed);
+      Slot *slot;
+      while (true)
+        {
+          slot = &_slots[pos & _mask];
+          size_t seq = slot->_seq.load(std::memory_order_acquire);
+          std::ptrdiff_t diff = static_cast<std::ptrdiff_t>(seq)
+                                - static_cast<std::ptrdiff_t>(pos + 1);
+          if (diff == 0)
+            {
+              if (_head.compare_exchange_weak(pos, pos + 1,
+                                              std::memory_order_relaxed))
+                break;
+            }
+          else if (diff < 0)
+            return false;
+          else
+            pos = _head.load(std::memory_order_relaxed);
+        }
+      value = std::move(slot->_value);
+      slot->_seq.store(pos + _capacity, std::memory_order_release);
+      return true;
+    }
+
+  private:
+    struct Slot
+    {
+      std::atomic<size_t> _seq;
+      T _value;
+    };
+
+    size_t _capacity = 0;
+    size_t _mask = 0;
+    std::unique_ptr<Slot[]> _slots;
+    alignas(64) std::atomic<size_t> _tail{ 0 }; /**< next push position. */
+    alignas(64) std::atomic<size_t> _head{ 0 }; /**< next pop position. */
+  };
+}
+
+#endif
@@ -0,0 +1,131 @@
+/**
+ * DeepDetect
+ * Copyright (c) 2023 Jolibrain
+ *
+ * This file is part of deepdetect.
+ *
+ * deepdetect is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * deepdetect is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with deepdetect.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DD_UTILS_SHARDED_COUNTERS_HPP
+#define DD_UTILS_SHARDED_COUNTERS_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+
+namespace dd
+{
+  /**
+   * \brief fixed set of lock-free counters for hot paths. Every counter is
+   * split over shards, threads are given shards in turn and only add to
+   * their own with relaxed atomics, so that concurrent threads seldom share
+   * a cache line. Values are summed over shards when read.
+   */
+  class ShardedCounters
+  {
+  public:
+    static const int _nshards = 8;
+
+    ShardedCounters(const size_t &n)
+        : _n(n), _stride((n + 7) / 8 * 8),
+          _buf(new std::atomic<uint64_t>[_nshards * _stride + 7]),
+          _counts(align(_buf.get()))
+    {
+      reset();
+    }
+
+    ShardedCounters(const ShardedCounters &sc)
+        : _n(sc._n), _stride(sc._stride),
+          _buf(new std::atomic<uint64_t>[_nshards * _stride + 7]),
+          _counts(align(_buf.get()))
+    {
+      for (size_t i = 0; i < _nshards * _stride; ++i)
+        _counts[i].store(sc._counts[i].load(std::memory_order_relaxed),
+                         std::memory_order_relaxed);
+    }
+
+    ShardedCounters &operator=(const ShardedCounters &) = delete;
+
+    /**
+     * \brief number of counters
+     */
+    size_t size() const
+    {
+      return _n;
+    }
+
+    /**
+     * \brief adds v to counter i
+     */
+    void add(const size_t &i, const uint64_t &v = 1)
+    {
+      _counts[shard_index() * _stride + i].fetch_add(
+          v, std::memory_order_relaxed);
+    }
+
+    /**
+     * \brief value of counter i
+     */
+    uint64_t value(const size_t &i) const
+    {
+      uint64_t v = 0;
+      for (int s = 0; s < _nshards; ++s)
+        v += _counts[s * _stride + i].load(std::memory_order_relaxed);
+      return v;
+    }
+
+    /**
+     * \brief sets all counters to zero, concurrent additions may or may not
+     * be kept
+     */
+    void reset()
+    {
+      for (size_t i = 0; i < _nshards * _stride; ++i)
+        _counts[i].store(0, std::memory_order_relaxed);
+    }
+
+    /**
+     * \brief shard of the calling thread
+     */
+    static int shard_index()
+    {
+      static std::atomic<int> next_shard(0);
+      thread_local int shard = next_shard.fetch_add(1) % _nshards;
+      return shard;
+    }
+
+  private:
+    /**
+     * \brief first 64 bytes boundary in buffer, new[] only guarantees
+     * alignof(std::max_align_t) before C++17
+     */
+    static std::atomic<uint64_t> *align(std::atomic<uint64_t> *buf)
+    {
+      uintptr_t p = reinterpret_cast<uintptr_t>(buf);
+      size_t skip = (64 - p % 64) % 64 / sizeof(std::atomic<uint64_t>);
+      return buf + skip;
+    }
+
+    size_t _n = 0;
+    size_t _stride = 0; /**< shard size, rounded to 64 bytes. */
+    std::unique_ptr<std::atomic<uint64_t>[]>
+        _buf; /**< storage, with room for alignment. */
+    std::atomic<uint64_t> *_counts
+        = nullptr; /**< shards, aligned on 64 bytes. */
+  };
+}
+
+#endif
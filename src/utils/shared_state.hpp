@@ -0,0 +1,99 @@
+/**
+ * DeepDetect
+ * Copyright (c) 2023 Jolibrain
+ *
+ * This file is part of deepdetect.
+ *
+ * deepdetect is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * deepdetect is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with deepdetect.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DD_UTILS_SHARED_STATE_HPP
+#define DD_UTILS_SHARED_STATE_HPP
+
+#include <memory>
+#include <utility>
+
+namespace dd
+{
+  /**
+   * \brief connector data that is read-only once the service is set up
+   * (vocabulary, categorical values, ...). Copies of a connector, e.g. one
+   * per predict call, share the same data, which is copied only on first
+   * modification through mut(), typically while training.
+   */
+  template <typename T> class SharedState
+  {
+  public:
+    SharedState() : _data(std::make_shared<T>())
+    {
+    }
+
+    SharedState(const T &data) : _data(std::make_shared<T>(data))
+    {
+    }
+
+    SharedState &operator=(const T &data)
+    {
+      _data = std::make_shared<T>(data);
+      return *this;
+    }
+
+    SharedState &operator=(T &&data)
+    {
+      _data = std::make_shared<T>(std::move(data));
+      return *this;
+    }
+
+    const T &operator*() const
+    {
+      return *_data;
+    }
+
+    const T *operator->() const
+    {
+      return _data.get();
+    }
+
+    /**
+     * \brief immutable data, may outlive this object
+     */
+    std::shared_ptr<const T> get() const
+    {
+      return _data;
+    }
+
+    /**
+     * \brief mutable data, copied first if shared with other objects
+     */
+    T &mut()
+    {
+      if (_data.use_count() > 1)
+        _data = std::make_shared<T>(*_data);
+      return *_data;
+    }
+
+    /**
+     * \brief whether data is shared with other objects
+     */
+    bool shared() const
+    {
+      return _data.use_count() > 1;
+    }
+
+  private:
+    std::shared_ptr<T> _data;
+  };
+}
+
+#endif
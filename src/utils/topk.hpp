@@ -0,0 +1,64 @@
+/**
+ * DeepDetect
+ * Copyright (c) 2023 Jolibrain
+ *
+ * This file is part of deepdetect.
+ *
+ * deepdetect is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * deepdetect is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with deepdetect.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DD_UTILS_TOPK_HPP
+#define DD_UTILS_TOPK_HPP
+
+#include <algorithm>
+#include <numeric>
+#include <vector>
+
+namespace dd
+{
+  namespace topk_utils
+  {
+    /**
+     * \brief indices of the k largest values of every row of a contiguous
+     * row-major matrix, sorted by decreasing value. Only the k best are
+     * sorted, after a partial selection.
+     * @param probs rows x cols values
+     * @param k clamped to cols
+     * @param indices rows x k output indices, row-major
+     */
+    template <typename T>
+    inline void topk(const T *probs, const size_t &rows, const size_t &cols,
+                     size_t k, std::vector<int> &indices)
+    {
+      k = std::min(k, cols);
+      indices.resize(rows * k);
+      std::vector<int> idx(cols);
+      for (size_t r = 0; r < rows; ++r)
+        {
+          const T *row = probs + r * cols;
+          auto greater = [row](const int &a, const int &b) {
+            return row[a] > row[b] || (row[a] == row[b] && a < b);
+          };
+          std::iota(idx.begin(), idx.end(), 0);
+          if (k < cols)
+            std::nth_element(idx.begin(), idx.begin() + k, idx.end(),
+                             greater);
+          std::sort(idx.begin(), idx.begin() + k, greater);
+          std::copy(idx.begin(), idx.begin() + k, indices.begin() + r * k);
+        }
+    }
+  }
+}
+
+#endif // DD_UTILS_TOPK_HPP
@@ -68,6 +68,19 @@ namespace dd
       return elems;
     }
 
+    inline std::string join(const std::vector<std::string> &elems,
+                            char delim)
+    {
+      std::string s;
+      for (size_t i = 0; i < elems.size(); ++i)
+        {
+          if (i > 0)
+            s += delim;
+          s += elems[i];
+        }
+      return s;
+    }
+
     inline std::string trim_spaces(const std::string &item)
     {
       const std::string WHITESPACE = " \n\r\t\f\v";
@@ -583,7 +583,7 @@ TEST(caffelib, configure_convnet_template_n_1D)
   ASSERT_EQ("MemoryData", lparam->type());
   ASSERT_EQ(1, lparam->mutable_memory_data_param()->channels());
   ASSERT_EQ(tcif._sequence, lparam->mutable_memory_data_param()->height());
-  ASSERT_EQ(tcif._alphabet.size(),
+  ASSERT_EQ(tcif._alphabet->size(),
             lparam->mutable_memory_data_param()->width());
   lparam = net_param.mutable_layer(2);
   ASSERT_EQ("Convolution", lparam->type());
@@ -607,7 +607,7 @@ TEST(caffelib, configure_convnet_template_n_1D)
   ASSERT_EQ("MemoryData", lparam->type());
   ASSERT_EQ(1, lparam->mutable_memory_data_param()->channels());
   ASSERT_EQ(tcif._sequence, lparam->mutable_memory_data_param()->height());
-  ASSERT_EQ(tcif._alphabet.size(),
+  ASSERT_EQ(tcif._alphabet->size(),
             lparam->mutable_memory_data_param()->width());
   lparam = deploy_net_param.mutable_layer(1);
   ASSERT_EQ("Convolution", lparam->type());
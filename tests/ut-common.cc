@@ -20,9 +20,18 @@
  */
 
 #include <iostream>
+#include <thread>
 #include <gtest/gtest.h>
 
+#include "apidata.h"
 #include "utils/utils.hpp"
+#include "utils/bbox.hpp"
+#include "utils/latency_histogram.hpp"
+#include "utils/msgpack_writer.hpp"
+#include "utils/prometheus.hpp"
+#include "utils/ring_buffer.hpp"
+#include "utils/topk.hpp"
+#include "trace.h"
 
 using namespace dd;
 
@@ -36,3 +45,188 @@ TEST(common, trim_spaces)
             dd_utils::trim_spaces("  test_name test_name\t"));
   ASSERT_EQ("", dd_utils::trim_spaces("   \n  "));
 }
+
+TEST(common, latency_histogram)
+{
+  // buckets are exact below 32us, within 1/16 above
+  for (uint64_t us : { 0ul, 1ul, 31ul, 32ul, 33ul, 1000ul, 123456ul })
+    {
+      int b = LatencyHistogram::bucket(us);
+      ASSERT_GE(LatencyHistogram::bucket_max(b), us);
+      ASSERT_LE(LatencyHistogram::bucket_max(b), us + us / 16);
+      if (b > 0)
+        {
+          ASSERT_LT(LatencyHistogram::bucket_max(b - 1), us);
+        }
+    }
+  ASSERT_EQ(LatencyHistogram::_nbuckets - 1,
+            LatencyHistogram::bucket((uint64_t(1) << 36) - 1));
+
+  LatencyHistogram h;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; ++t)
+    threads.emplace_back([&h]() {
+      for (int i = 1; i <= 1000; ++i)
+        h.record(i / 10.0);
+    });
+  for (std::thread &t : threads)
+    t.join();
+  ASSERT_EQ(4000u, h.count());
+  ASSERT_DOUBLE_EQ(100.0, h.max());
+  std::vector<double> pcts = h.percentiles({ 0.5, 0.9, 0.99, 1.0 });
+  ASSERT_NEAR(50.0, pcts[0], 50.0 / 16);
+  ASSERT_NEAR(90.0, pcts[1], 90.0 / 16);
+  ASSERT_NEAR(99.0, pcts[2], 99.0 / 16);
+  ASSERT_DOUBLE_EQ(100.0, pcts[3]);
+
+  LatencyHistogram hc(h);
+  ASSERT_EQ(4000u, hc.count());
+  h.reset();
+  ASSERT_EQ(0u, h.count());
+  ASSERT_EQ(0.0, h.percentiles({ 0.5 })[0]);
+}
+
+TEST(common, prometheus_writer)
+{
+  PrometheusWriter pw;
+  pw.declare("dd_a_total", "counter", "A.");
+  pw.add("dd_a_total", PrometheusWriter::label("service", "s\"1"), 1);
+  pw.add("dd_b", "", 0.5);
+  pw.add("dd_a_total", PrometheusWriter::label("service", "s2"), 2);
+  ASSERT_EQ("# HELP dd_a_total A.\n# TYPE dd_a_total counter\n"
+            "dd_a_total{service=\"s\\\"1\"} 1\n"
+            "dd_a_total{service=\"s2\"} 2\ndd_b 0.5\n",
+            pw.str());
+}
+
+TEST(common, msgpack_writer)
+{
+  MsgPackWriter mpw;
+  mpw.StartObject();
+  mpw.Key("a");
+  mpw.Int(-1);
+  mpw.Key("b");
+  mpw.StartArray();
+  mpw.Uint(200);
+  mpw.Bool(true);
+  mpw.Null();
+  mpw.EndArray();
+  mpw.Key("c");
+  write_double_array(mpw, std::vector<double>{ 1.0 });
+  mpw.EndObject();
+  ASSERT_EQ(std::string("\xdf\x00\x00\x00\x03"
+                        "\xa1"
+                        "a\xff"
+                        "\xa1"
+                        "b\xdd\x00\x00\x00\x03\xce\x00\x00\x00\xc8\xc3\xc0"
+                        "\xa1"
+                        "c\xdd\x00\x00\x00\x01\xca\x3f\x80\x00\x00",
+                        34),
+            mpw.str());
+
+  // arrays of doubles as little endian float32 blobs
+  MsgPackWriter mpt(true);
+  write_double_array(mpt, std::vector<double>{ 1.0, -2.0 });
+  ASSERT_EQ(std::string("\xc6\x00\x00\x00\x08"
+                        "\x00\x00\x80\x3f\x00\x00\x00\xc0",
+                        13),
+            mpt.str());
+}
+
+TEST(common, ring_buffer)
+{
+  RingBuffer<std::string> rb(3);
+  ASSERT_EQ(4u, rb.capacity());
+  for (int i = 0; i < 4; ++i)
+    ASSERT_TRUE(rb.try_push(std::to_string(i)));
+  ASSERT_FALSE(rb.try_push("4"));
+  std::string v;
+  ASSERT_TRUE(rb.try_pop(v));
+  ASSERT_EQ("0", v);
+
+  // concurrent producers, single consumer
+  RingBuffer<int> rbi(1024);
+  std::vector<std::thread> producers;
+  for (int t = 0; t < 4; ++t)
+    producers.emplace_back([&rbi, t] {
+      for (int i = 0; i < 10000; ++i)
+        while (!rbi.try_push(t * 10000 + i))
+          std::this_thread::yield();
+    });
+  // values are checked once producers are joined
+  std::vector<int> popped;
+  popped.reserve(40000);
+  int i;
+  while (popped.size() < 40000)
+    if (rbi.try_pop(i))
+      popped.push_back(i);
+  for (std::thread &t : producers)
+    t.join();
+  ASSERT_FALSE(rbi.try_pop(i));
+  // values of each producer come out in order
+  std::vector<int> last(4, -1);
+  for (int v : popped)
+    {
+      ASSERT_GT(v % 10000, last[v / 10000]);
+      last[v / 10000] = v % 10000;
+    }
+  for (int l : last)
+    ASSERT_EQ(9999, l);
+}
+
+TEST(common, trace)
+{
+  {
+    TraceSpan span("untraced");
+  }
+  Trace trace;
+  {
+    TraceScope scope(&trace);
+    ASSERT_EQ(&trace, Trace::current());
+    TraceSpan span("outer", "test", "detail");
+    {
+      TraceSpan inner("inner");
+    }
+    std::thread t([] { TraceSpan span("other thread"); });
+    t.join();
+    ASSERT_EQ(1u, trace.size());
+  }
+  ASSERT_EQ(nullptr, Trace::current());
+  ASSERT_EQ(2u, trace.size());
+  ASSERT_FALSE(Trace::sample(0.0));
+  ASSERT_TRUE(Trace::sample(1.0));
+}
+
+TEST(common, topk)
+{
+  std::vector<float> probs{ 0.1, 0.5, 0.2, 0.2, 0.7, 0.1, 0.1, 0.1 };
+  std::vector<int> ids;
+  topk_utils::topk(probs.data(), 2, 4, 3, ids);
+  ASSERT_EQ((std::vector<int>{ 1, 2, 3, 0, 1, 2 }), ids);
+  topk_utils::topk(probs.data(), 1, 8, 10, ids);
+  ASSERT_EQ(8u, ids.size());
+  ASSERT_EQ(4, ids[0]);
+}
+
+TEST(common, bbox_nms)
+{
+  bbox_utils::BBoxes<float> bboxes;
+  bboxes.push_back(0, 0, 10, 10, 0.9, 0);
+  bboxes.push_back(1, 1, 11, 11, 0.8, 1);
+  bboxes.push_back(50, 50, 60, 60, 0.7, 0);
+  bboxes.push_back(0, 0, 10, 9, 0.6, 0);
+  std::vector<size_t> picked;
+  bbox_utils::nms_sorted_bboxes(bboxes, picked, 0.5f);
+  ASSERT_EQ((std::vector<size_t>{ 0, 2 }), picked);
+  bbox_utils::nms_sorted_bboxes(bboxes, picked, 0.5f, true);
+  ASSERT_EQ((std::vector<size_t>{ 0, 1, 2 }), picked);
+  bbox_utils::nms_sorted_bboxes(bboxes, picked, 0.5f, false, 0.0f, 0.0f, 1);
+  ASSERT_EQ(1u, picked.size());
+
+  // soft-nms keeps overlapping boxes, with decayed scores
+  bbox_utils::nms_sorted_bboxes(bboxes, picked, 0.5f, false, 0.5f);
+  ASSERT_EQ(4u, picked.size());
+  ASSERT_EQ(2u, picked[1]);
+  ASSERT_FLOAT_EQ(0.7, bboxes._scores[2]);
+  ASSERT_LT(bboxes._scores[1], 0.8 * 0.5);
+}
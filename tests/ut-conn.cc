@@ -163,7 +163,8 @@ TEST(outputconn, acck)
   std::map<std::string, double> accs = so.acc(res_ad, measures);
   ASSERT_EQ(0.5, accs["acc"]);
   ASSERT_EQ(0.75, accs["acc-2"]);
-  ASSERT_EQ(1.0, accs["acc-3"]);
+  // last target is 4th best
+  ASSERT_EQ(0.75, accs["acc-3"]);
 }
 
 TEST(outputconn, auc)
@@ -691,8 +692,8 @@ TEST(inputconn, csv_read_categoricals)
   cifc._logger = spdlog::stdout_logger_mt("test5");
   cifc._train = true;
   cifc.read_categoricals(ap);
-  ASSERT_EQ(23, cifc._categoricals.size());
-  CCategorical cc = cifc._categoricals["odor"];
+  ASSERT_EQ(23, cifc._categoricals->size());
+  CCategorical cc = cifc._categoricals->at("odor");
   ASSERT_EQ(9, cc._vals.size());
 }
 
@@ -733,6 +734,249 @@ TEST(inputconn, csv_ignore)
   remove("test.csv");
 }
 
+TEST(inputconn, csv_streaming)
+{
+  std::string header = "id,val1,val2,val3";
+  std::ofstream of("test_stream.csv");
+  of << header << std::endl;
+  of << "1,2590,56,2" << std::endl;
+  of << "2,4000,25,10" << std::endl;
+  of << "3,3295,40.5,6" << std::endl;
+  of.close();
+  std::vector<std::string> vdata = { "test_stream.csv" };
+  APIData ad;
+  ad.add("data", vdata);
+  APIData pad, pinp;
+  pinp.add("label", std::string("val3"));
+  pinp.add("scale", true);
+  pinp.add("scale_type", std::string("znorm"));
+  pinp.add("streaming", true);
+  pinp.add("chunk_size", 2);
+  std::vector<APIData> vpinp = { pinp };
+  pad.add("input", vpinp);
+  std::vector<APIData> vpad = { pad };
+  ad.add("parameters", vpad);
+  CSVInputFileConn cifc;
+  cifc._logger = spdlog::stdout_logger_mt("test_streaming");
+  cifc._train = true;
+  try
+    {
+      cifc.transform(ad);
+    }
+  catch (std::exception &e)
+    {
+      std::cerr << "exception=" << e.what() << std::endl;
+      ASSERT_FALSE(true);
+    }
+  // bounds computed in a single pass
+  ASSERT_NEAR(2, cifc._mean_vals[0], 1e-9);
+  ASSERT_NEAR(3295, cifc._mean_vals[1], 1e-9);
+  ASSERT_NEAR(40.5, cifc._mean_vals[2], 1e-9);
+  ASSERT_NEAR(331350, cifc._variance_vals[1], 1e-6);
+  ASSERT_NEAR(480.5 / 3.0, cifc._variance_vals[2], 1e-6);
+
+  // lines replayed from chunks, scaled, in order
+  ASSERT_EQ(3, cifc._csvdata.size());
+  ASSERT_EQ(3, cifc.batch_size());
+  ASSERT_TRUE(cifc._chunks.empty());
+  ASSERT_EQ("3", cifc._csvdata[2]._str);
+  ASSERT_NEAR(0, cifc._csvdata[2]._v[1], 1e-9);
+  ASSERT_NEAR(0, cifc._csvdata[2]._v[2], 1e-9);
+  ASSERT_EQ(6, cifc._csvdata[2]._v[3]);
+  ASSERT_NEAR(-cifc._csvdata[1]._v[1], cifc._csvdata[0]._v[1], 1e-9);
+  remove("test_stream.csv");
+}
+
+TEST(inputconn, csv_block_parser)
+{
+  std::string data = "1,a,2.5\r\n\n2,\"b,\"\"c\"\"\",3\n"
+                     "3,\"multi\nline\",-1e3\n4,,5";
+  std::vector<CSVBlockParser::Row> expected
+      = { { "1", "a", "2.5" },
+          { "2", "b,\"c\"", "3" },
+          { "3", "multi\nline", "-1e3" },
+          { "4", "", "5" } };
+  // tiny blocks, so that block boundaries fall within quoted fields
+  for (size_t block_size : { 1, 4, 1 << 20 })
+    {
+      CSVBlockParser parser(',', '"', block_size);
+      std::vector<CSVBlockParser::Row> rows;
+      size_t nrows = parser.parse(
+          data.data(), data.size(),
+          [&](const CSVBlockParser::Row &row) { rows.push_back(row); });
+      ASSERT_EQ(4, nrows);
+      ASSERT_EQ(expected, rows);
+
+      std::stringstream sdata(data);
+      rows.clear();
+      parser.parse(sdata, [&](const CSVBlockParser::Row &row) {
+        rows.push_back(row);
+      });
+      ASSERT_EQ(expected, rows);
+    }
+
+  // a quote within a field is a plain character, and does not swallow the
+  // following records
+  std::string mdata = "a\"b,12\" pipe\n1,2\n\"x\"\"\"y,3\n";
+  std::vector<CSVBlockParser::Row> mexpected
+      = { { "a\"b", "12\" pipe" }, { "1", "2" }, { "x\"y", "3" } };
+  for (size_t block_size : { 1, 4, 1 << 20 })
+    {
+      CSVBlockParser parser(',', '"', block_size);
+      std::vector<CSVBlockParser::Row> rows;
+      parser.parse(mdata.data(), mdata.size(),
+                   [&](const CSVBlockParser::Row &row) {
+                     rows.push_back(row);
+                   });
+      ASSERT_EQ(mexpected, rows);
+    }
+
+  ASSERT_EQ(-1000.0, csv_stod("-1e3"));
+  ASSERT_EQ(0.1, csv_stod("0.1"));
+  ASSERT_EQ(std::stod("123456789012345678901"),
+            csv_stod("123456789012345678901"));
+  ASSERT_THROW(csv_stod("abc"), std::invalid_argument);
+}
+
+TEST(inputconn, csv_table)
+{
+  // one numerical column, one categorical column with 2 categories
+  CSVTable table;
+  table.add_numerical_column();
+  table.add_categorical_column(2);
+  ASSERT_EQ(3, table.width());
+  ASSERT_TRUE(table.add_row("1", { 1.0, 1.0, 0.0 }));
+  ASSERT_TRUE(table.add_row("2", { 3.0, 0.0, 1.0 }));
+  ASSERT_TRUE(table.add_row(
+      "3", { std::numeric_limits<double>::quiet_NaN(), 0.0, 0.0 }));
+  ASSERT_FALSE(table.add_row("4", { 1.0, 1.0, 1.0 }));
+  ASSERT_FALSE(table.add_row("4", { 1.0, 1.0 }));
+  ASSERT_EQ(3, table.rows());
+
+  std::vector<double> min_vals, max_vals, mean_vals, variance_vals;
+  table.min_max(min_vals, max_vals);
+  ASSERT_EQ(std::vector<double>({ 1.0, 0.0, 0.0 }), min_vals);
+  ASSERT_EQ(std::vector<double>({ 3.0, 1.0, 1.0 }), max_vals);
+  table.mean_variance(mean_vals, variance_vals);
+  ASSERT_EQ(2.0, mean_vals[0]);
+  ASSERT_EQ(1.0, variance_vals[0]);
+  ASSERT_NEAR(1.0 / 3.0, mean_vals[1], 1e-9);
+  ASSERT_NEAR(2.0 / 9.0, variance_vals[1], 1e-9);
+
+  // scaling is applied on expansion
+  table.set_scale(0, 1.0, 2.0, 0.0);
+  table.set_scale(1, 0.0, 2.0, 0.0);
+  std::vector<double> vals;
+  table.row(1, vals);
+  ASSERT_EQ(std::vector<double>({ 1.0, 0.0, 1.0 }), vals);
+  table.row(0, vals);
+  ASSERT_EQ(std::vector<double>({ 0.0, 0.5, 0.0 }), vals);
+  table.row(2, vals);
+  ASSERT_TRUE(std::isnan(vals[0]));
+
+  CSVTable test;
+  table.split(2, test);
+  ASSERT_EQ(2, table.rows());
+  ASSERT_EQ(1, test.rows());
+  ASSERT_EQ("3", test._ids[0]);
+  test.row(0, vals);
+  ASSERT_TRUE(std::isnan(vals[0]));
+  ASSERT_EQ(0.0, vals[1]);
+
+  table.permute({ 1, 0 });
+  ASSERT_EQ("2", table._ids[0]);
+  table.row(0, vals);
+  ASSERT_EQ(std::vector<double>({ 1.0, 0.0, 1.0 }), vals);
+}
+
+class ColumnarCSVInputFileConn : public CSVInputFileConn
+{
+public:
+  bool columnar() const override
+  {
+    return true;
+  }
+};
+
+TEST(inputconn, csv_missing_values)
+{
+  // missing values do not count in statistics
+  const double nan = std::numeric_limits<double>::quiet_NaN();
+  CSVRunningStats stats, stats2;
+  stats.add({ nan, 1.0 });
+  stats.add({ 2.0, 3.0 });
+  stats2.add({ 4.0, nan });
+  stats.merge(stats2);
+  ASSERT_EQ(3, stats._count);
+  ASSERT_EQ(std::vector<int64_t>({ 2, 2 }), stats._counts);
+  ASSERT_EQ(std::vector<double>({ 2.0, 1.0 }), stats._min);
+  ASSERT_EQ(std::vector<double>({ 4.0, 3.0 }), stats._max);
+  ASSERT_EQ(std::vector<double>({ 3.0, 2.0 }), stats._mean);
+  ASSERT_EQ(std::vector<double>({ 1.0, 1.0 }), stats.variance());
+
+  std::ofstream of("test_missing.csv");
+  of << "id,val1,val2,val3" << std::endl;
+  of << "1,,5,0" << std::endl;
+  of << "2,3,,1" << std::endl;
+  of << "3,1,7,0" << std::endl;
+  of.close();
+  for (std::string scale_type : { "minmax", "znorm" })
+    {
+      std::vector<std::string> vdata = { "test_missing.csv" };
+      APIData ad;
+      ad.add("data", vdata);
+      APIData pad, pinp;
+      pinp.add("label", std::string("val3"));
+      pinp.add("scale", true);
+      pinp.add("scale_type", scale_type);
+      std::vector<APIData> vpinp = { pinp };
+      pad.add("input", vpinp);
+      std::vector<APIData> vpad = { pad };
+      ad.add("parameters", vpad);
+      ColumnarCSVInputFileConn cifc;
+      cifc._logger = spdlog::stdout_logger_mt("test_missing_" + scale_type);
+      cifc._train = true;
+      try
+        {
+          cifc.transform(ad);
+        }
+      catch (std::exception &e)
+        {
+          std::cerr << "exception=" << e.what() << std::endl;
+          ASSERT_FALSE(true);
+        }
+      if (scale_type == "minmax")
+        {
+          ASSERT_EQ(1.0, cifc._min_vals[1]);
+          ASSERT_EQ(3.0, cifc._max_vals[1]);
+          ASSERT_EQ(5.0, cifc._min_vals[2]);
+          ASSERT_EQ(7.0, cifc._max_vals[2]);
+        }
+      else
+        {
+          ASSERT_EQ(2.0, cifc._mean_vals[1]);
+          ASSERT_EQ(1.0, cifc._variance_vals[1]);
+          ASSERT_EQ(6.0, cifc._mean_vals[2]);
+          ASSERT_EQ(1.0, cifc._variance_vals[2]);
+        }
+
+      // values are scaled, missing values stay missing
+      ASSERT_EQ(3, cifc._table.rows());
+      const double lo = scale_type == "minmax" ? 0.0 : -1.0;
+      std::vector<double> vals;
+      cifc._table.row(0, vals);
+      ASSERT_TRUE(std::isnan(vals[1]));
+      ASSERT_EQ(lo, vals[2]);
+      cifc._table.row(1, vals);
+      ASSERT_EQ(1.0, vals[1]);
+      ASSERT_TRUE(std::isnan(vals[2]));
+      cifc._table.row(2, vals);
+      ASSERT_EQ(lo, vals[1]);
+      ASSERT_EQ(1.0, vals[2]);
+    }
+  remove("test_missing.csv");
+}
+
 TEST(inputconn, csvts_basic)
 {
   std::string header = "target,cap-shape,cap-surface,cap-color,bruises";
@@ -788,6 +1032,85 @@ TEST(inputconn, csvts_basic)
   fileops::remove_dir("csvts");
 }
 
+TEST(inputconn, csvts_file_stats)
+{
+  std::string header = "val1,val2";
+  fileops::create_dir("csvts", 0777);
+  fileops::create_dir("csvts_repo", 0777);
+  std::ofstream of1("csvts/ts1.csv");
+  of1 << header << std::endl << "1,10" << std::endl << "2,20" << std::endl;
+  of1.close();
+  std::ofstream of2("csvts/ts2.csv");
+  of2 << header << std::endl << "3,-5" << std::endl << "4,7" << std::endl;
+  of2.close();
+  std::vector<std::string> vdata = { "csvts" };
+  APIData ad;
+  ad.add("data", vdata);
+  APIData pad, pinp;
+  pinp.add("scale", true);
+  std::vector<APIData> vpinp = { pinp };
+  pad.add("input", vpinp);
+  std::vector<APIData> vpad = { pad };
+  ad.add("parameters", vpad);
+  CSVTSInputFileConn cifc;
+  cifc._logger = spdlog::stdout_logger_mt("test_csvts_file_stats");
+  cifc._model_repo = "csvts_repo";
+  cifc._train = true;
+  cifc.transform(ad);
+  ASSERT_EQ(2, cifc._file_stats.size());
+  ASSERT_EQ(std::vector<double>({ 1, -5 }), cifc._min_vals);
+  ASSERT_EQ(std::vector<double>({ 4, 20 }), cifc._max_vals);
+  ASSERT_TRUE(fileops::file_exists("csvts_repo/stats.dat"));
+
+  // a new file: bounds are updated, statistics of others come from cache
+  std::ofstream of3("csvts/ts3.csv");
+  of3 << header << std::endl << "0,30" << std::endl << "5,0" << std::endl;
+  of3.close();
+  CSVTSInputFileConn cifc2;
+  cifc2._logger = cifc._logger;
+  cifc2._model_repo = "csvts_repo";
+  cifc2._train = true;
+  cifc2.transform(ad);
+  ASSERT_EQ(3, cifc2._file_stats.size());
+  ASSERT_EQ(2, cifc2._file_stats["csvts/ts1.csv"]._stats._count);
+  ASSERT_NEAR(1.5, cifc2._file_stats["csvts/ts1.csv"]._stats._mean[0], 1e-9);
+  ASSERT_EQ(std::vector<double>({ 0, -5 }), cifc2._min_vals);
+  ASSERT_EQ(std::vector<double>({ 5, 30 }), cifc2._max_vals);
+
+  // unchanged file is a cache hit, a rewritten file is scanned again
+  cifc2._file_stats["csvts/ts1.csv"]._stats._count = 42;
+  ASSERT_EQ(42, cifc2.file_stats("csvts/ts1.csv")._count);
+  std::ofstream of1b("csvts/ts1.csv");
+  of1b << header << std::endl
+       << "1,10" << std::endl
+       << "2,20" << std::endl
+       << "3,30" << std::endl;
+  of1b.close();
+  ASSERT_EQ(3, cifc2.file_stats("csvts/ts1.csv")._count);
+
+  // bounds given as parameters are not overwritten by the statistics
+  APIData ad3, pad3, pinp3;
+  ad3.add("data", vdata);
+  pinp3.add("scale", true);
+  pinp3.add("min_vals", std::vector<double>({ -1, -10 }));
+  std::vector<APIData> vpinp3 = { pinp3 };
+  pad3.add("input", vpinp3);
+  std::vector<APIData> vpad3 = { pad3 };
+  ad3.add("parameters", vpad3);
+  CSVTSInputFileConn cifc3;
+  cifc3._logger = cifc._logger;
+  cifc3._model_repo = "csvts_repo";
+  cifc3._train = true;
+  cifc3.transform(ad3);
+  ASSERT_EQ(std::vector<double>({ -1, -10 }), cifc3._min_vals);
+  ASSERT_EQ(std::vector<double>({ 5, 30 }), cifc3._max_vals);
+
+  fileops::clear_directory("csvts");
+  fileops::remove_dir("csvts");
+  fileops::clear_directory("csvts_repo");
+  fileops::remove_dir("csvts_repo");
+}
+
 TEST(inputconn, csvts_error)
 {
   std::string header = "target,cap-shape,cap-surface,cap-color,bruises";
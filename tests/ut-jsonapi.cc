@@ -234,6 +234,33 @@ TEST(jsonapi, service_status)
   ASSERT_GE(
       jd["body"]["service_stats"]["total_transform_duration_ms"].GetDouble(),
       0);
+  ASSERT_TRUE(jd["body"]["service_stats"].HasMember("latencies"));
+  auto &jlat = jd["body"]["service_stats"]["latencies"];
+  ASSERT_EQ(jlat["predict"]["count"].GetInt(), 1);
+  ASSERT_GT(jlat["predict"]["p50_ms"].GetDouble(), 0);
+  ASSERT_GE(jlat["predict"]["p999_ms"].GetDouble(),
+            jlat["predict"]["p50_ms"].GetDouble());
+  ASSERT_EQ(jlat["serialization"]["count"].GetInt(), 0);
+
+  // reading with reset_stats starts a new window
+  japi.info("{\"status\":true,\"reset_stats\":true}");
+  jstatstr = japi.jrender(japi.service_status(sname));
+  jd.Parse<rapidjson::kParseNanAndInfFlag>(jstatstr.c_str());
+  ASSERT_EQ(
+      jd["body"]["service_stats"]["latencies"]["predict"]["count"].GetInt(),
+      0);
+  ASSERT_EQ(jd["body"]["service_stats"]["predict_count"].GetInt(), 1);
+
+  std::string metrics = japi.metrics();
+  ASSERT_NE(metrics.find("# TYPE dd_predict_requests_total counter"),
+            std::string::npos);
+  ASSERT_NE(metrics.find("dd_predict_requests_total{service=\"" + sname
+                         + "\",mllib=\"caffe\",outcome=\"failure\"} 1"),
+            std::string::npos);
+  ASSERT_NE(metrics.find("dd_stage_duration_seconds_count{service=\""
+                         + sname
+                         + "\",mllib=\"caffe\",stage=\"predict\"} 1"),
+            std::string::npos);
 }
 
 TEST(jsonapi, service_purge)
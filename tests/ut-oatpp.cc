@@ -25,6 +25,7 @@
 #include "oatpp-test/UnitTest.hpp"
 
 #include "ut-oatpp.h"
+#include "http/access_log.hpp"
 
 const std::string serv
     = "very_long_label_service_name_with_😀_inside_and_some_MAJ";
@@ -570,6 +571,60 @@ void test_predict(std::shared_ptr<DedeApiTestClient> client)
   ASSERT_EQ(response->getStatusCode(), 200);
 }
 
+// run with compression level 6 and compression_min_size 1024
+void test_compression(std::shared_ptr<DedeApiTestClient> client)
+{
+  // small response is left uncompressed
+  auto response = client->get_info_encoded("gzip");
+  ASSERT_EQ(response->getStatusCode(), 200);
+  ASSERT_TRUE(response->getHeader("Content-Encoding") == nullptr);
+  auto message = response->readBodyToString();
+  ASSERT_TRUE(message != nullptr);
+  ASSERT_TRUE(message->size() < 1024);
+
+  std::string mnist_repo = "../examples/caffe/mnist/";
+  std::string serv_put
+      = "{\"mllib\":\"caffe\",\"description\":\"my "
+        "classifier\",\"type\":\"supervised\",\"model\":{\"repository\":\""
+        + mnist_repo
+        + "\"},\"parameters\":{\"input\":{\"connector\":\"image\"},\"mllib\":{"
+          "\"nclasses\":10}}}";
+  response = client->put_services(serv.c_str(), serv_put.c_str());
+  ASSERT_EQ(response->getStatusCode(), 201);
+  std::string train_post
+      = "{\"service\":\"" + serv
+        + "\",\"async\":false,\"parameters\":{\"mllib\":{\"gpu\":true,"
+          "\"solver\":{\"iterations\":"
+        + iterations_mnist + ",\"snapshot_prefix\":\"" + mnist_repo
+        + "/mylenet\"}}}}";
+  response = client->post_train(train_post.c_str());
+  ASSERT_EQ(response->getStatusCode(), 201);
+
+  // large predict response is gzip encoded
+  std::string data;
+  for (int i = 0; i < 20; ++i)
+    data += std::string(i > 0 ? "," : "") + "\"" + mnist_repo
+            + "/sample_digit.png\"";
+  std::string predict_post
+      = "{\"service\":\"" + serv
+        + "\",\"parameters\":{\"mllib\":{\"gpu\":true},\"input\":{\"bw\":true,"
+          "\"width\":28,\"height\":28},\"output\":{\"best\":10}},\"data\":["
+        + data + "]}";
+  response = client->post_predict_encoded("gzip", predict_post.c_str());
+  ASSERT_EQ(response->getStatusCode(), 200);
+  ASSERT_TRUE(response->getHeader("Content-Encoding") == "gzip");
+  message = response->readBodyToString();
+  ASSERT_TRUE(message != nullptr);
+  ASSERT_TRUE(message->size() >= 1024);
+  JDoc jd;
+  jd.Parse<rapidjson::kParseNanAndInfFlag>(message->c_str());
+  ASSERT_TRUE(!jd.HasParseError());
+  ASSERT_EQ(20, jd["body"]["predictions"].Size());
+
+  response = client->delete_services(serv.c_str(), "lib");
+  ASSERT_EQ(response->getStatusCode(), 200);
+}
+
 #define OATPP_DEDE_TEST(FUNC)                                                 \
   TEST(oatpp_jsonapi, FUNC)                                                   \
   {                                                                           \
@@ -582,6 +637,56 @@ void test_predict(std::shared_ptr<DedeApiTestClient> client)
 
 OATPP_DEDE_TEST(test_info);
 
+TEST(oatpp_jsonapi, access_logger)
+{
+  auto logger = spdlog::stdout_logger_mt("test_access_logger");
+  dd::http::AccessLogEntry entry;
+  entry.time = std::chrono::system_clock::time_point(
+      std::chrono::milliseconds(86400000 + 1234));
+  entry.protocol = "HTTP/1.1";
+  entry.method = "POST";
+  entry.path = "/predict";
+  entry.service_name = "serv";
+  entry.code = 200;
+  entry.duration_ms = 12.3456;
+
+  // text
+  dd::http::AccessLogger text_logger(logger, false, 1.0);
+  ASSERT_EQ("HTTP/1.1 \"POST /predict\" serv 200 12ms",
+            text_logger.format(entry));
+
+  // JSON lines
+  dd::http::AccessLogger json_logger(logger, true, 1.0);
+  entry.path = "/predict?\"quoted\"";
+  std::string line = json_logger.format(entry);
+  ASSERT_EQ(std::string::npos, line.find('\n'));
+  JDoc jd;
+  jd.Parse(line.c_str());
+  ASSERT_FALSE(jd.HasParseError());
+  ASSERT_EQ("1970-01-02T00:00:01.234Z", std::string(jd["time"].GetString()));
+  ASSERT_EQ("HTTP/1.1", std::string(jd["protocol"].GetString()));
+  ASSERT_EQ("POST", std::string(jd["method"].GetString()));
+  ASSERT_EQ(entry.path, std::string(jd["path"].GetString()));
+  ASSERT_EQ("serv", std::string(jd["service"].GetString()));
+  ASSERT_EQ(200, jd["status"].GetInt());
+  ASSERT_NEAR(12.346, jd["duration_ms"].GetDouble(), 1e-9);
+
+  // sampling applies to successful requests only
+  dd::http::AccessLogger none_logger(logger, false, 0.0);
+  ASSERT_FALSE(none_logger.sample(200));
+  ASSERT_FALSE(none_logger.sample(201));
+  ASSERT_TRUE(none_logger.sample(400));
+  ASSERT_TRUE(none_logger.sample(500));
+  ASSERT_TRUE(text_logger.sample(200));
+  dd::http::AccessLogger half_logger(logger, false, 0.5);
+  int sampled = 0;
+  for (int i = 0; i < 10000; ++i)
+    sampled += half_logger.sample(200);
+  ASSERT_GT(sampled, 4500);
+  ASSERT_LT(sampled, 5500);
+  ASSERT_TRUE(half_logger.sample(404));
+}
+
 #ifdef USE_CAFFE
 
 OATPP_DEDE_TEST(test_services);
@@ -590,4 +695,14 @@ OATPP_DEDE_TEST(test_multiservices);
 OATPP_DEDE_TEST(test_concurrency);
 OATPP_DEDE_TEST(test_predict);
 
+TEST(oatpp_jsonapi, test_compression)
+{
+  oatpp::base::Environment::init();
+  DedeControllerTest *test
+      = new DedeControllerTest("test_compression", test_compression, 6, 1024);
+  test->run(1);
+  delete test;
+  oatpp::base::Environment::destroy();
+}
+
 #endif
@@ -31,18 +31,37 @@
 #include "oatpp/web/client/ApiClient.hpp"
 #include "oatpp/web/server/HttpConnectionHandler.hpp"
 #include "oatpp/web/client/HttpRequestExecutor.hpp"
+#include "oatpp/web/protocol/http/incoming/SimpleBodyDecoder.hpp"
 #include "oatpp/network/virtual_/client/ConnectionProvider.hpp"
 #include "oatpp/network/virtual_/server/ConnectionProvider.hpp"
 #include "oatpp/network/virtual_/Interface.hpp"
 #include "oatpp/parser/json/mapping/ObjectMapper.hpp"
 #include "oatpp-test/web/ClientServerTestRunner.hpp"
+#include "oatpp-zlib/EncoderProvider.hpp"
 
 #include "oatppjsonapi.h"
+#include "http/compression.hpp"
 #include "http/controller.hpp"
 
 class TestComponent
 {
+private:
+  int _compression_level;
+  v_int64 _compression_min_size;
+
 public:
+  /**
+   * @param compression_level response compression level, 0 to disable
+   * @param compression_min_size responses smaller than this are not
+   *        compressed
+   */
+  TestComponent(const int &compression_level = 0,
+                const v_int64 &compression_min_size = 0)
+      : _compression_level(compression_level),
+        _compression_min_size(compression_min_size)
+  {
+  }
+
   OATPP_CREATE_COMPONENT(std::shared_ptr<oatpp::network::virtual_::Interface>,
                          virtualInterface)
   ([] {
@@ -75,10 +94,23 @@ public:
 
   OATPP_CREATE_COMPONENT(std::shared_ptr<oatpp::network::ConnectionHandler>,
                          serverConnectionHandler)
-  ([] {
+  ([this] {
     OATPP_COMPONENT(std::shared_ptr<oatpp::web::server::HttpRouter>,
                     router); // get Router component
-    return oatpp::web::server::HttpConnectionHandler::createShared(router);
+    auto components
+        = std::make_shared<oatpp::web::server::HttpProcessor::Components>(
+            router);
+    components->contentEncodingProviders
+        = dd::http::make_encoders(_compression_level);
+    auto connectionHandler
+        = std::make_shared<oatpp::web::server::HttpConnectionHandler>(
+            components);
+    if (_compression_level != 0 && _compression_min_size > 0)
+      connectionHandler->addResponseInterceptor(
+          std::make_shared<dd::http::CompressionThresholdInterceptor>(
+              _compression_min_size));
+    return std::static_pointer_cast<oatpp::network::ConnectionHandler>(
+        connectionHandler);
   }());
 
   OATPP_CREATE_COMPONENT(std::shared_ptr<oatpp::data::mapping::ObjectMapper>,
@@ -116,6 +148,11 @@ class DedeApiTestClient : public oatpp::web::client::ApiClient
            QUERY(Int16, job))
   API_CALL("POST", "/predict", post_predict,
            BODY_STRING(oatpp::String, predict_data))
+  API_CALL("GET", "/info", get_info_encoded,
+           HEADER(String, accept_encoding, "Accept-Encoding"))
+  API_CALL("POST", "/predict", post_predict_encoded,
+           HEADER(String, accept_encoding, "Accept-Encoding"),
+           BODY_STRING(oatpp::String, predict_data))
 };
 
 typedef std::function<void(std::shared_ptr<DedeApiTestClient>)>
@@ -128,17 +165,23 @@ class DedeControllerTest : public oatpp::test::UnitTest
 
 public:
   OatppUnitTestFunc oatpp_unit_test_func;
+  int compression_level;
+  v_int64 compression_min_size;
 
   DedeControllerTest(const char *testTAG,
-                     const OatppUnitTestFunc oatpp_unit_test_func)
-      : UnitTest(testTAG), oatpp_unit_test_func(oatpp_unit_test_func)
+                     const OatppUnitTestFunc oatpp_unit_test_func,
+                     const int &compression_level = 0,
+                     const v_int64 &compression_min_size = 0)
+      : UnitTest(testTAG), oatpp_unit_test_func(oatpp_unit_test_func),
+        compression_level(compression_level),
+        compression_min_size(compression_min_size)
   {
   }
 
   void onRun()
   {
     dd::OatppJsonAPI oja;
-    TestComponent component;
+    TestComponent component(compression_level, compression_min_size);
     oatpp::test::web::ClientServerTestRunner runner;
     std::shared_ptr<oatpp::data::mapping::ObjectMapper> defaultObjectMapper
         = oatpp::parser::json::mapping::ObjectMapper::createShared();
@@ -151,9 +194,17 @@ public:
               clientConnectionProvider);
           OATPP_COMPONENT(std::shared_ptr<oatpp::data::mapping::ObjectMapper>,
                           objectMapper);
+          // client decodes compressed responses
+          auto decoders = std::make_shared<
+              oatpp::web::protocol::http::encoding::ProviderCollection>();
+          decoders->add(
+              std::make_shared<oatpp::zlib::DeflateDecoderProvider>());
+          decoders->add(std::make_shared<oatpp::zlib::GzipDecoderProvider>());
           auto requestExecutor
               = oatpp::web::client::HttpRequestExecutor::createShared(
-                  clientConnectionProvider);
+                  clientConnectionProvider, nullptr,
+                  std::make_shared<oatpp::web::protocol::http::incoming::
+                                       SimpleBodyDecoder>(decoders));
           auto client
               = DedeApiTestClient::createShared(requestExecutor, objectMapper);
 
@@ -26,9 +26,14 @@
 #include "txtinputfileconn.h"
 #include <gtest/gtest.h>
 #include <stdio.h>
+#include <fstream>
 #include <iostream>
 #include <numeric>
+#include <thread>
 #include "backends/torch/native/templates/nbeats.h"
+#include "backends/torch/torchutils.h"
+#include "backends/torch/torchstatecache.h"
+#include "measure_accumulator.h"
 #include <torch/torch.h>
 #include <rapidjson/istreamwrapper.h>
 
@@ -160,6 +165,33 @@ TEST(torchapi, service_predict)
   ASSERT_TRUE(jd["body"]["predictions"][0]["classes"][0]["prob"].GetDouble()
               > 0.3);
 
+  // direct rendering, with float precision
+  jpredictstr
+      = "{\"service\":\"imgserv\",\"parameters\":{\"input\":{\"height\":224,"
+        "\"width\":224},\"output\":{\"best\":1,\"float_precision\":2}},"
+        "\"data\":[\""
+        + incept_repo + "cat.jpg\"]}";
+  std::string rendered;
+  JDoc jhead = japi.service_predict(jpredictstr, &rendered);
+  ASSERT_EQ(200, jhead["status"]["code"]);
+  ASSERT_EQ("imgserv", std::string(jhead["head"]["service"].GetString()));
+  std::cout << "rendered=" << rendered << std::endl;
+  JDoc jdr;
+  jdr.Parse<rapidjson::kParseNanAndInfFlag>(rendered.c_str());
+  ASSERT_TRUE(!jdr.HasParseError());
+  ASSERT_EQ(200, jdr["status"]["code"]);
+  ASSERT_TRUE(jdr["head"].HasMember("time"));
+  ASSERT_EQ(cl1,
+            jdr["body"]["predictions"][0]["classes"][0]["cat"].GetString());
+  ASSERT_NEAR(
+      jd["body"]["predictions"][0]["classes"][0]["prob"].GetDouble(),
+      jdr["body"]["predictions"][0]["classes"][0]["prob"].GetDouble(), 0.01);
+  size_t prob_pos = rendered.find("\"prob\":");
+  ASSERT_TRUE(prob_pos != std::string::npos);
+  std::string prob_str = rendered.substr(
+      prob_pos + 7, rendered.find_first_of(",}", prob_pos) - prob_pos - 7);
+  ASSERT_LE(prob_str.size() - prob_str.find('.'), 3u);
+
   // confidence threshold
   jpredictstr
       = "{\"service\":\"imgserv\",\"parameters\":{\"input\":{\"height\":224,"
@@ -205,6 +237,186 @@ TEST(torchapi, service_predict)
   ASSERT_EQ(cl_dog, "n02096051 Airedale, Airedale terrier");
 }
 
+TEST(torchapi, service_predict_quantized_dynamic)
+{
+  // create service, traced model is quantized at creation
+  JsonAPI japi;
+  std::string sname = "imgserv";
+  std::string jstr
+      = "{\"mllib\":\"torch\",\"description\":\"resnet-50\",\"type\":"
+        "\"supervised\",\"model\":{\"repository\":\""
+        + incept_repo
+        + "\"},\"parameters\":{\"input\":{\"connector\":\"image\",\"height\":"
+          "224,\"width\":224,\"rgb\":true,\"scale\":0.0039},\"mllib\":{"
+          "\"nclasses\":1000,\"quantization\":{\"mode\":\"dynamic\","
+          "\"engine\":\"fbgemm\"}}}}";
+  std::string jcreatestr = jstr;
+  std::string joutstr = japi.jrender(japi.service_create(sname, jstr));
+  ASSERT_EQ(created_str, joutstr);
+  std::string qfile = incept_repo + "/quantized_dynamic_fbgemm.qpt";
+  ASSERT_TRUE(fileops::file_exists(qfile));
+
+  // predict
+  std::string jpredictstr
+      = "{\"service\":\"imgserv\",\"parameters\":{\"input\":{\"height\":224,"
+        "\"width\":224},\"output\":{\"best\":1}},\"data\":[\""
+        + incept_repo + "cat.jpg\"]}";
+  joutstr = japi.jrender(japi.service_predict(jpredictstr));
+  JDoc jd;
+  std::cout << "joutstr=" << joutstr << std::endl;
+  jd.Parse<rapidjson::kParseNanAndInfFlag>(joutstr.c_str());
+  ASSERT_TRUE(!jd.HasParseError());
+  ASSERT_EQ(200, jd["status"]["code"]);
+  std::string cl1
+      = jd["body"]["predictions"][0]["classes"][0]["cat"].GetString();
+  ASSERT_TRUE(cl1 == "n02123045 tabby, tabby cat");
+
+  joutstr = japi.jrender(japi.service_status(sname));
+  jd.Parse(joutstr.c_str());
+  ASSERT_TRUE(jd["body"]["model_stats"]["params"].GetInt64() > 0);
+  ASSERT_TRUE(jd["body"]["model_stats"]["flops"].GetInt64() > 0);
+
+  // quantized model is reloaded from repository
+  jstr = "{\"clear\":\"mem\"}";
+  joutstr = japi.jrender(japi.service_delete(sname, jstr));
+  ASSERT_EQ(ok_str, joutstr);
+  long int qfile_time = fileops::file_last_modif(qfile);
+  joutstr = japi.jrender(japi.service_create(sname, jcreatestr));
+  ASSERT_EQ(created_str, joutstr);
+  ASSERT_EQ(qfile_time, fileops::file_last_modif(qfile));
+  joutstr = japi.jrender(japi.service_predict(jpredictstr));
+  jd.Parse<rapidjson::kParseNanAndInfFlag>(joutstr.c_str());
+  ASSERT_EQ(200, jd["status"]["code"]);
+
+  jstr = "{\"clear\":\"mem\"}";
+  joutstr = japi.jrender(japi.service_delete(sname, jstr));
+  ASSERT_EQ(ok_str, joutstr);
+  remove(qfile.c_str());
+}
+
+TEST(torchapi, service_predict_quantized_static)
+{
+  // create service, static quantization waits for calibration
+  JsonAPI japi;
+  std::string sname = "imgserv";
+  std::string jstr
+      = "{\"mllib\":\"torch\",\"description\":\"image\",\"type\":"
+        "\"supervised\",\"model\":{\"repository\":\""
+        + resnet50_train_repo
+        + "\"},\"parameters\":{\"input\":{\"connector\":\"image\","
+          "\"width\":224,\"height\":224,\"db\":false},\"mllib\":{"
+          "\"nclasses\":2,\"finetuning\":true,\"quantization\":{"
+          "\"mode\":\"static\","
+          "\"engine\":\"fbgemm\"}}}}";
+  std::string joutstr = japi.jrender(japi.service_create(sname, jstr));
+  ASSERT_EQ(created_str, joutstr);
+  std::string qfile = resnet50_train_repo + "/quantized_static_fbgemm.qpt";
+  ASSERT_FALSE(fileops::file_exists(qfile));
+
+  // calibrate on a few batches of training data
+  std::string jtrainstr
+      = "{\"service\":\"imgserv\",\"async\":false,\"parameters\":{"
+        "\"mllib\":{\"quantization\":{\"mode\":\"static\",\"engine\":"
+        "\"fbgemm\",\"calibration_batches\":2},\"net\":{\"batch_size\":"
+        "2}},\"input\":{\"db\":false,\"shuffle\":true}},\"data\":[\""
+        + resnet50_train_data + "\",\"" + resnet50_test_data + "\"]}";
+  joutstr = japi.jrender(japi.service_train(jtrainstr));
+  JDoc jd;
+  std::cout << "joutstr=" << joutstr << std::endl;
+  jd.Parse<rapidjson::kParseNanAndInfFlag>(joutstr.c_str());
+  ASSERT_TRUE(!jd.HasParseError());
+  ASSERT_EQ(201, jd["status"]["code"]);
+  ASSERT_TRUE(fileops::file_exists(qfile));
+
+  joutstr = japi.jrender(japi.service_status(sname));
+  jd.Parse(joutstr.c_str());
+  ASSERT_TRUE(jd["body"]["model_stats"]["flops"].GetInt64() > 0);
+
+  // predict with the quantized model
+  std::string jpredictstr
+      = "{\"service\":\"imgserv\",\"parameters\":{\"output\":{\"best\":"
+        "1}},\"data\":[\""
+        + resnet50_test_image + "\"]}";
+  joutstr = japi.jrender(japi.service_predict(jpredictstr));
+  jd.Parse<rapidjson::kParseNanAndInfFlag>(joutstr.c_str());
+  ASSERT_TRUE(!jd.HasParseError());
+  ASSERT_EQ(200, jd["status"]["code"]);
+  ASSERT_TRUE(jd["body"]["predictions"][0]["classes"][0]["prob"].GetDouble()
+              > 0.0);
+
+  jstr = "{\"clear\":\"mem\"}";
+  joutstr = japi.jrender(japi.service_delete(sname, jstr));
+  ASSERT_EQ(ok_str, joutstr);
+  remove(qfile.c_str());
+}
+
+TEST(torchapi, service_predict_optimized)
+{
+  // create service, traced model is frozen and optimized at creation
+  JsonAPI japi;
+  std::string sname = "imgserv";
+  std::string jstr
+      = "{\"mllib\":\"torch\",\"description\":\"resnet-50\",\"type\":"
+        "\"supervised\",\"model\":{\"repository\":\""
+        + incept_repo
+        + "\"},\"parameters\":{\"input\":{\"connector\":\"image\",\"height\":"
+          "224,\"width\":224,\"rgb\":true,\"scale\":0.0039},\"mllib\":{"
+          "\"nclasses\":1000,\"optimize_inference\":true,"
+          "\"warmup_iterations\":2}}}";
+  std::string jcreatestr = jstr;
+  std::string joutstr = japi.jrender(japi.service_create(sname, jstr));
+  ASSERT_EQ(created_str, joutstr);
+
+  auto find_ofile = [&]() {
+    std::unordered_set<std::string> lfiles;
+    fileops::list_directory(incept_repo, true, false, false, lfiles);
+    for (const std::string &f : lfiles)
+      if (f.find("optimized_") != std::string::npos
+          && f.find(".opt") != std::string::npos)
+        return f;
+    return std::string();
+  };
+  std::string ofile = find_ofile();
+  ASSERT_FALSE(ofile.empty());
+
+  // predict, first call runs the warm-up
+  std::string jpredictstr
+      = "{\"service\":\"imgserv\",\"parameters\":{\"input\":{\"height\":224,"
+        "\"width\":224},\"output\":{\"best\":1}},\"data\":[\""
+        + incept_repo + "cat.jpg\"]}";
+  for (int i = 0; i < 2; ++i)
+    {
+      joutstr = japi.jrender(japi.service_predict(jpredictstr));
+      JDoc jd;
+      std::cout << "joutstr=" << joutstr << std::endl;
+      jd.Parse<rapidjson::kParseNanAndInfFlag>(joutstr.c_str());
+      ASSERT_TRUE(!jd.HasParseError());
+      ASSERT_EQ(200, jd["status"]["code"]);
+      std::string cl1
+          = jd["body"]["predictions"][0]["classes"][0]["cat"].GetString();
+      ASSERT_TRUE(cl1 == "n02123045 tabby, tabby cat");
+    }
+
+  // frozen model is reloaded from repository
+  jstr = "{\"clear\":\"mem\"}";
+  joutstr = japi.jrender(japi.service_delete(sname, jstr));
+  ASSERT_EQ(ok_str, joutstr);
+  long int ofile_time = fileops::file_last_modif(ofile);
+  joutstr = japi.jrender(japi.service_create(sname, jcreatestr));
+  ASSERT_EQ(created_str, joutstr);
+  ASSERT_EQ(ofile, find_ofile());
+  ASSERT_EQ(ofile_time, fileops::file_last_modif(ofile));
+  joutstr = japi.jrender(japi.service_predict(jpredictstr));
+  JDoc jd;
+  jd.Parse<rapidjson::kParseNanAndInfFlag>(joutstr.c_str());
+  ASSERT_EQ(200, jd["status"]["code"]);
+
+  jstr = "{\"clear\":\"mem\"}";
+  joutstr = japi.jrender(japi.service_delete(sname, jstr));
+  ASSERT_EQ(ok_str, joutstr);
+  remove(ofile.c_str());
+}
+
 TEST(torchapi, service_predict_native_bw)
 {
   // Predict greyscale image with native model should work
@@ -429,6 +641,36 @@ TEST(torchapi, service_predict_segmentation)
   ASSERT_TRUE(confs.IsArray());
   ASSERT_TRUE(preds.Size() == 500 * 374);
   ASSERT_TRUE(confs.Size() == 500 * 374);
+
+  // run-length encoded mask
+  jpredictstr = "{\"service\":\"segserv\",\"parameters\":{"
+                "\"input\":{\"height\":224,"
+                "\"width\":224},\"output\":{\"segmentation\":true, "
+                "\"mask_encoding\":\"rle\"}},\"data\":[\""
+                + seg_repo + "cat.jpg\"]}";
+  joutstr = japi.jrender(japi.service_predict(jpredictstr));
+  jd.Parse<rapidjson::kParseNanAndInfFlag>(joutstr.c_str());
+  ASSERT_TRUE(!jd.HasParseError());
+  ASSERT_EQ(200, jd["status"]["code"]);
+  auto &rle = jd["body"]["predictions"][0]["vals"];
+  ASSERT_TRUE(rle.IsArray());
+  ASSERT_EQ(0, rle.Size() % 2);
+  int rle_total = 0;
+  for (size_t i = 1; i < rle.Size(); i += 2)
+    rle_total += rle[i].GetInt();
+  ASSERT_EQ(500 * 374, rle_total);
+
+  // png mask
+  jpredictstr = "{\"service\":\"segserv\",\"parameters\":{"
+                "\"input\":{\"height\":224,"
+                "\"width\":224},\"output\":{\"segmentation\":true, "
+                "\"mask_encoding\":\"png\"}},\"data\":[\""
+                + seg_repo + "cat.jpg\"]}";
+  joutstr = japi.jrender(japi.service_predict(jpredictstr));
+  jd.Parse<rapidjson::kParseNanAndInfFlag>(joutstr.c_str());
+  ASSERT_TRUE(!jd.HasParseError());
+  ASSERT_EQ(200, jd["status"]["code"]);
+  ASSERT_TRUE(jd["body"]["predictions"][0]["vals"].IsString());
 }
 
 TEST(torchapi, service_predict_txt_classification)
@@ -475,13 +717,13 @@ TEST(inputconn, txt_tokenize_ordered_words)
   tifc._wordpiece_tokens = true;
   tifc._punctuation_tokens = true;
 
-  tifc._vocab["every"] = Word();
-  tifc._vocab["##ing"] = Word();
-  tifc._vocab["##thing"] = Word();
-  tifc._vocab["fine"] = Word();
-  tifc._vocab[","] = Word();
-  tifc._vocab["?"] = Word();
-  tifc._vocab["right"] = Word();
+  tifc._vocab.mut()["every"] = Word();
+  tifc._vocab.mut()["##ing"] = Word();
+  tifc._vocab.mut()["##thing"] = Word();
+  tifc._vocab.mut()["fine"] = Word();
+  tifc._vocab.mut()[","] = Word();
+  tifc._vocab.mut()["?"] = Word();
+  tifc._vocab.mut()["right"] = Word();
 
   tifc.parse_content(str, 1);
   TxtOrderedWordsEntry &towe
@@ -491,6 +733,295 @@ TEST(inputconn, txt_tokenize_ordered_words)
   ASSERT_EQ(tokens, towe._v);
 }
 
+TEST(inputconn, txt_wordpiece_trie)
+{
+  TxtInputFileConn tifc;
+  tifc._vocab.mut()["[UNK]"] = Word(0);
+  tifc._vocab.mut()["un"] = Word(1);
+  tifc._vocab.mut()["una"] = Word(2);
+  tifc._vocab.mut()["##ffable"] = Word(3);
+  tifc._vocab.mut()["##ff"] = Word(4);
+  tifc._vocab.mut()["##able"] = Word(5);
+  tifc._vocab.mut()["##s"] = Word(6);
+  tifc._vocab.mut()["é"] = Word(7);
+
+  WordPieceTokenizer &wpt = tifc._wordpiece_tokenizer;
+  wpt.compile();
+  ASSERT_EQ(8, wpt._word_trie->size()); // all tokens may start a word
+  ASSERT_EQ(4, wpt._suffix_trie->size());
+
+  // longest match first: una + ##ffable, then un + ##s, unknown word
+  wpt.tokenize({ "unaffable", "uns", "unx", "é" });
+  std::vector<std::string> tokens{ "una", "##ffable", "un", "##s", "[UNK]",
+                                   "é" };
+  std::vector<int64_t> ids{ 2, 3, 1, 6, 0, 7 };
+  ASSERT_EQ(tokens, wpt._tokens);
+  ASSERT_EQ(ids, wpt._ids);
+
+  // vocabulary update recompiles tries
+  tifc._vocab.mut()["unx"] = Word(8);
+  wpt.reset();
+  wpt.append_input("unx");
+  ASSERT_EQ(std::vector<int64_t>{ 8 }, wpt._ids);
+}
+
+TEST(inputconn, txt_shared_vocab)
+{
+  TxtInputFileConn tifc;
+  tifc._vocab.mut()["word"] = Word(0);
+
+  // per request copies share the vocabulary
+  TxtInputFileConn tifc_req(tifc);
+  ASSERT_EQ(tifc._vocab.get(), tifc_req._vocab.get());
+  ASSERT_TRUE(tifc._vocab.shared());
+
+  // until modified
+  tifc_req._vocab.mut()["other"] = Word(1);
+  ASSERT_NE(tifc._vocab.get(), tifc_req._vocab.get());
+  ASSERT_EQ(1, tifc._vocab->size());
+  ASSERT_EQ(2, tifc_req._vocab->size());
+}
+
+TEST(inputconn, txt_parse_contents_parallel)
+{
+  std::vector<std::string> docs;
+  std::vector<float> targets;
+  for (int i = 0; i < 200; ++i)
+    {
+      docs.push_back("document number " + std::to_string(i)
+                     + " shares words with document "
+                     + std::to_string(i % 7) + " and words "
+                     + std::to_string(i % 13));
+      targets.push_back(i % 2);
+    }
+
+  // batch, parsed in parallel
+  TxtInputFileConn tifc;
+  tifc._train = true;
+  tifc._min_word_length = 1;
+  tifc.parse_contents(docs, targets);
+
+  // one document at a time
+  TxtInputFileConn tifc_seq;
+  tifc_seq._train = true;
+  tifc_seq._min_word_length = 1;
+  for (size_t i = 0; i < docs.size(); ++i)
+    tifc_seq.parse_content(docs[i], targets[i]);
+
+  ASSERT_EQ(tifc_seq._vocab->size(), tifc._vocab->size());
+  for (auto const &w : *tifc_seq._vocab)
+    {
+      const Word &pw = tifc._vocab->at(w.first);
+      ASSERT_EQ(w.second._pos, pw._pos);
+      ASSERT_EQ(w.second._total_count, pw._total_count);
+      ASSERT_EQ(w.second._total_docs, pw._total_docs);
+    }
+  ASSERT_EQ(2, tifc._vocab->at("document")._total_count
+                   / tifc._vocab->at("document")._total_docs);
+
+  ASSERT_EQ(docs.size(), tifc._txt.size());
+  for (size_t i = 0; i < docs.size(); ++i)
+    {
+      TxtBowEntry *tbe = static_cast<TxtBowEntry *>(tifc._txt[i]);
+      TxtBowEntry *tbe_seq = static_cast<TxtBowEntry *>(tifc_seq._txt[i]);
+      ASSERT_EQ(targets[i], tbe->_target);
+      ASSERT_EQ(tbe_seq->_v, tbe->_v);
+    }
+}
+
+TEST(inputconn, txt_predict_batch)
+{
+  TxtInputFileConn tifc;
+  tifc._logger = spdlog::get("test_txt_predict")
+                     ? spdlog::get("test_txt_predict")
+                     : spdlog::stdout_logger_mt("test_txt_predict");
+  tifc._min_word_length = 1;
+  tifc._vocab.mut()["sparse"] = Word(0);
+  tifc._vocab.mut()["rows"] = Word(1);
+
+  // in memory documents to predict are parsed as one batch, in order
+  std::vector<std::string> docs = { "sparse rows", "rows", "sparse sparse" };
+  APIData ad;
+  ad.add("data", docs);
+  tifc.transform(ad);
+  ASSERT_EQ(docs.size(), tifc._txt.size());
+  for (size_t i = 0; i < docs.size(); ++i)
+    ASSERT_EQ(docs[i], tifc._txt[i]->_uri);
+  TxtBowEntry *tbe = static_cast<TxtBowEntry *>(tifc._txt[2]);
+  ASSERT_EQ(1, tbe->size());
+  ASSERT_EQ("sparse", tbe->_v[0].first);
+  ASSERT_EQ(2, tbe->_v[0].second);
+}
+
+TEST(inputconn, txt_csr_batch)
+{
+  TxtInputFileConn tifc;
+  tifc._min_word_length = 1;
+  tifc._vocab.mut()["sparse"] = Word(0);
+  tifc._vocab.mut()["rows"] = Word(1);
+  tifc._vocab.mut()["words"] = Word(2);
+  tifc.parse_contents({ "sparse words, sparse rows", "unknown", "rows" },
+                      { 1, 0, 2 });
+
+  CSRBatch csr;
+  tifc.to_csr(tifc._txt, csr);
+  ASSERT_EQ(3, csr.rows());
+  ASSERT_EQ(4, csr.nnz());
+  ASSERT_EQ(0, csr.row_nnz(1)); // out of vocabulary
+  std::vector<float> labels{ 1, 0, 2 };
+  ASSERT_EQ(labels, csr._labels);
+
+  ASSERT_EQ(3, csr._ncols);
+
+  // columns are sorted within each row
+  std::vector<int64_t> indptr{ 0, 3, 3, 4 };
+  ASSERT_EQ(indptr, csr._indptr);
+  std::vector<int> indices{ 0, 1, 2, 1 };
+  ASSERT_EQ(indices, csr._indices);
+  std::vector<float> values{ 2, 1, 1, 1 };
+  ASSERT_EQ(values, csr._values);
+}
+
+TEST(inputconn, csvts_windows)
+{
+  // 8 timesteps of (a, b, output) = (t, 10t, 100t)
+  fileops::create_dir("csvts_windows", 0777);
+  std::ofstream of("csvts_windows/ts.csv");
+  of << "a,b,output" << std::endl;
+  for (int t = 0; t < 8; ++t)
+    of << t << "," << 10 * t << "," << 100 * t << std::endl;
+  of.close();
+  // window over rows [start, start + length) of some columns, copied the
+  // way windows used to be stored
+  auto copied_window
+      = [](int start, int length, const std::vector<int> &cols) {
+          std::vector<at::Tensor> rows;
+          for (int t = start; t < start + length; ++t)
+            {
+              std::vector<float> row;
+              for (int c : cols)
+                row.push_back(t * std::pow(10.f, c));
+              rows.push_back(torch::tensor(row));
+            }
+          return torch::stack(rows);
+        };
+  // every expected window is served, whatever the order
+  auto has_window = [](const at::Tensor &batch, const at::Tensor &w) {
+    for (int64_t i = 0; i < batch.size(0); ++i)
+      if (torch::equal(batch[i], w))
+        return true;
+    return false;
+  };
+  auto fill = [](CSVTSTorchInputFileConn &inputc, APIData &ad_input) {
+    inputc._train = true;
+    inputc._logger = spdlog::get("test_csvts_windows")
+                         ? spdlog::get("test_csvts_windows")
+                         : spdlog::stdout_logger_mt("test_csvts_windows");
+    APIData ad, ad_param;
+    ad.add("data", std::vector<std::string>({ "csvts_windows" }));
+    ad_input.add("connector", std::string("csvts"));
+    ad_input.add("label", std::vector<std::string>({ "output" }));
+    ad_input.add("separator", std::string(","));
+    ad_param.add("input", ad_input);
+    ad.add("parameters", ad_param);
+    inputc.transform(ad);
+    inputc._dataset.reset(false);
+  };
+
+  // labels: windows at 0 and 3, last partial window at 5
+  CSVTSTorchInputFileConn inputc;
+  APIData ad_input;
+  ad_input.add("timesteps", 3);
+  ad_input.add("offset", 3);
+  fill(inputc, ad_input);
+  ASSERT_EQ(3, inputc._dataset.cache_size());
+  TorchBatch batch = inputc._dataset.get_batch({ 3 }).value();
+  ASSERT_EQ(std::vector<int64_t>({ 3, 3, 2 }), batch.data[0].sizes().vec());
+  ASSERT_EQ(std::vector<int64_t>({ 3, 3, 1 }), batch.target[0].sizes().vec());
+  for (int start : { 0, 3, 5 })
+    {
+      ASSERT_TRUE(
+          has_window(batch.data[0], copied_window(start, 3, { 0, 1 })));
+      ASSERT_TRUE(has_window(batch.target[0], copied_window(start, 3, { 2 })));
+    }
+
+  // split keeps windows over the shared series
+  TorchDataset split = inputc._dataset.split(0.0, 0.6);
+  ASSERT_EQ(2, split.cache_size());
+  split.reset(false);
+  batch = split.get_batch({ 2 }).value();
+  ASSERT_EQ(std::vector<int64_t>({ 2, 3, 2 }), batch.data[0].sizes().vec());
+
+  // forecast: windows at 0 and 2, last partial window at 3
+  CSVTSTorchInputFileConn finputc;
+  APIData fad_input;
+  fad_input.add("backcast_timesteps", 3);
+  fad_input.add("forecast_timesteps", 2);
+  fad_input.add("offset", 2);
+  fill(finputc, fad_input);
+  ASSERT_EQ(3, finputc._dataset.cache_size());
+  batch = finputc._dataset.get_batch({ 3 }).value();
+  for (int start : { 0, 2, 3 })
+    {
+      ASSERT_TRUE(
+          has_window(batch.data[0], copied_window(start, 3, { 0, 1, 2 })));
+      ASSERT_TRUE(has_window(batch.target[0],
+                             copied_window(start + 3, 2, { 0, 1, 2 })));
+    }
+
+  fileops::clear_directory("csvts_windows");
+  fileops::remove_dir("csvts_windows");
+}
+
+TEST(inputconn, txt_wordpiece_throughput)
+{
+  // synthetic vocabulary of word beginnings and suffixes
+  TxtInputFileConn tifc;
+  std::mt19937 rng(42);
+  std::uniform_int_distribution<int> letter('a', 'z');
+  std::uniform_int_distribution<int> length(2, 6);
+  auto rand_str = [&]() {
+    std::string str(length(rng), 'a');
+    for (char &c : str)
+      c = letter(rng);
+    return str;
+  };
+  std::unordered_map<std::string, Word> &vocab = tifc._vocab.mut();
+  vocab["[UNK]"] = Word(0);
+  std::vector<std::string> starts, suffixes;
+  for (int i = 0; i < 20000; ++i)
+    {
+      starts.push_back(rand_str());
+      suffixes.push_back(rand_str());
+      vocab.emplace(starts.back(), Word(vocab.size()));
+      vocab.emplace("##" + suffixes.back(), Word(vocab.size()));
+    }
+
+  // corpus of words made of one to three pieces
+  std::vector<std::string> corpus;
+  std::uniform_int_distribution<int> piece(0, 19999);
+  for (int i = 0; i < 500000; ++i)
+    {
+      std::string word = starts[piece(rng)];
+      for (int p = length(rng) / 3; p > 0; --p)
+        word += suffixes[piece(rng)];
+      corpus.push_back(word);
+    }
+
+  WordPieceTokenizer &wpt = tifc._wordpiece_tokenizer;
+  wpt.compile();
+  auto tstart = std::chrono::steady_clock::now();
+  wpt.tokenize(corpus);
+  double elapsed = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - tstart)
+                       .count();
+  std::cout << "wordpiece: " << corpus.size() << " words, "
+            << wpt._tokens.size() << " tokens in " << elapsed << "s, "
+            << wpt._tokens.size() / elapsed << " tokens/s" << std::endl;
+  ASSERT_GE(wpt._tokens.size(), corpus.size());
+  ASSERT_EQ(wpt._tokens.size(), wpt._ids.size());
+}
+
 TEST(torchapi, load_weights_native_model)
 {
   APIData template_params;
@@ -713,6 +1244,258 @@ TEST(torchapi, map_false_negative)
               std::numeric_limits<float>::epsilon());
   ASSERT_NEAR(out.getobj("measure").get("map_2").get<double>(), 0.,
               std::numeric_limits<float>::epsilon());
+
+  // same map when accumulated
+  MeasureAccumulator macc(MeasureAccumulator::BBOX, { "map" },
+                          torchlib._nclasses);
+  macc.add_bbox(vbad);
+  APIData meas_out;
+  macc.to(meas_out, { "0", "1", "2" });
+  ASSERT_NEAR(meas_out.get("map").get<double>(), 0.5,
+              std::numeric_limits<float>::epsilon());
+  ASSERT_NEAR(meas_out.get("map_1").get<double>(), 1.,
+              std::numeric_limits<float>::epsilon());
+}
+
+TEST(torchapi, measure_accumulator)
+{
+  // accumulated measures are those computed from all predictions
+  int nclasses = 3;
+  std::vector<std::string> measures
+      = { "acc", "acc-2", "f1", "mcll", "auc", "mcc", "cmdiag" };
+  torch::manual_seed(0);
+  torch::Tensor probs = torch::softmax(torch::randn({ 64, nclasses }), 1);
+  torch::Tensor labels = torch::randint(nclasses, { 64 }, torch::kLong);
+  auto probs_acc = probs.accessor<float, 2>();
+  auto labels_acc = labels.accessor<int64_t, 1>();
+
+  // two halves of the test set, merged
+  MeasureAccumulator macc(MeasureAccumulator::CLASSIFICATION, measures,
+                          nclasses, 0);
+  MeasureAccumulator macc2(MeasureAccumulator::CLASSIFICATION, measures,
+                           nclasses, 0);
+  APIData ad_res;
+  for (int j = 0; j < probs.size(0); ++j)
+    {
+      (j < 32 ? macc : macc2)
+          .add_classification(probs.data_ptr<float>() + j * nclasses,
+                              labels_acc[j]);
+      APIData bad;
+      std::vector<double> pred;
+      for (int c = 0; c < nclasses; ++c)
+        pred.push_back(probs_acc[j][c]);
+      bad.add("pred", pred);
+      bad.add("target", static_cast<double>(labels_acc[j]));
+      ad_res.add(std::to_string(j), bad);
+    }
+  macc.merge(macc2);
+  ASSERT_EQ(macc.size(), 64);
+
+  std::vector<std::string> clnames = { "0", "1", "2" };
+  ad_res.add("clnames", clnames);
+  ad_res.add("nclasses", nclasses);
+  ad_res.add("batch_size", 64);
+  APIData ad_out;
+  ad_out.add("measure", measures);
+  APIData out;
+  SupervisedOutput::measure(ad_res, ad_out, out, 0, "test");
+  APIData exact = out.getobj("measure");
+  APIData meas_out;
+  macc.to(meas_out, clnames);
+  for (std::string m :
+       { "acc", "acc-2", "f1", "precision", "recall", "mcll", "auc", "mcc" })
+    ASSERT_NEAR(meas_out.get(m).get<double>(), exact.get(m).get<double>(),
+                1e-6)
+        << m;
+  auto cmdiag = meas_out.get("cmdiag").get<std::vector<double>>();
+  auto exact_cmdiag = exact.get("cmdiag").get<std::vector<double>>();
+  ASSERT_EQ(cmdiag.size(), exact_cmdiag.size());
+  for (size_t c = 0; c < cmdiag.size(); ++c)
+    ASSERT_NEAR(cmdiag[c], exact_cmdiag[c], 1e-6);
+
+  // segmentation, class per pixel
+  int64_t pred_data[] = { 0, 1, 2, 2, 0, 0, 1, 1 };
+  int64_t target_data[] = { 0, 1, 1, 2, 0, 2, 1, 1 };
+  MeasureAccumulator smacc(MeasureAccumulator::SEGMENTATION,
+                           { "acc", "meanacc", "meaniou" }, nclasses);
+  APIData ad_seg;
+  for (int j = 0; j < 2; ++j)
+    {
+      smacc.add_segmentation(pred_data + j * 4, target_data + j * 4, 4);
+      APIData bad;
+      bad.add("pred", std::vector<double>(pred_data + j * 4,
+                                          pred_data + (j + 1) * 4));
+      bad.add("target", std::vector<double>(target_data + j * 4,
+                                            target_data + (j + 1) * 4));
+      ad_seg.add(std::to_string(j), bad);
+    }
+  ad_seg.add("clnames", clnames);
+  ad_seg.add("nclasses", nclasses);
+  ad_seg.add("segmentation", true);
+  ad_seg.add("batch_size", 2);
+  ad_out.add("measure", std::vector<std::string>{ "acc", "meanacc",
+                                                  "meaniou" });
+  APIData seg_out;
+  SupervisedOutput::measure(ad_seg, ad_out, seg_out, 0, "test");
+  exact = seg_out.getobj("measure");
+  meas_out = APIData();
+  smacc.to(meas_out, clnames);
+  for (std::string m : { "acc", "meanacc", "meaniou" })
+    ASSERT_NEAR(meas_out.get(m).get<double>(), exact.get(m).get<double>(),
+                1e-6)
+        << m;
+
+  // binary auc from score histograms (default) and exact
+  torch::Tensor bprobs = torch::softmax(torch::randn({ 256, 2 }), 1);
+  torch::Tensor blabels = torch::randint(2, { 256 }, torch::kLong);
+  auto blabels_acc = blabels.accessor<int64_t, 1>();
+  MeasureAccumulator binned(MeasureAccumulator::CLASSIFICATION, { "auc" },
+                            2);
+  MeasureAccumulator exact_auc(MeasureAccumulator::CLASSIFICATION, { "auc" },
+                               2, 0);
+  for (int j = 0; j < bprobs.size(0); ++j)
+    {
+      binned.add_classification(bprobs.data_ptr<float>() + j * 2,
+                                blabels_acc[j]);
+      exact_auc.add_classification(bprobs.data_ptr<float>() + j * 2,
+                                   blabels_acc[j]);
+    }
+  APIData binned_out, exact_auc_out;
+  binned.to(binned_out, { "0", "1" });
+  exact_auc.to(exact_auc_out, { "0", "1" });
+  ASSERT_NEAR(binned_out.get("auc").get<double>(),
+              exact_auc_out.get("auc").get<double>(), 1e-3);
+
+  // regression, two targets
+  std::vector<std::string> reg_measures = { "eucll", "l1", "percent" };
+  torch::Tensor rpred = torch::randn({ 16, 2 });
+  torch::Tensor rtarget = torch::randn({ 16, 2 });
+  MeasureAccumulator racc(MeasureAccumulator::REGRESSION, reg_measures, 2);
+  MeasureAccumulator racc2(MeasureAccumulator::REGRESSION, reg_measures, 2);
+  APIData ad_reg;
+  for (int j = 0; j < rpred.size(0); ++j)
+    {
+      const float *p = rpred.data_ptr<float>() + j * 2;
+      const float *t = rtarget.data_ptr<float>() + j * 2;
+      (j < 8 ? racc : racc2).add_regression(p, t);
+      APIData bad;
+      bad.add("pred", std::vector<double>(p, p + 2));
+      bad.add("target", std::vector<double>(t, t + 2));
+      ad_reg.add(std::to_string(j), bad);
+    }
+  racc.merge(racc2);
+  ad_reg.add("regression", true);
+  ad_reg.add("clnames", std::vector<std::string>{ "0", "1" });
+  ad_reg.add("nclasses", 2);
+  ad_reg.add("batch_size", static_cast<int>(rpred.size(0)));
+  ad_out.add("measure", reg_measures);
+  APIData reg_out;
+  SupervisedOutput::measure(ad_reg, ad_out, reg_out, 0, "test");
+  exact = reg_out.getobj("measure");
+  meas_out = APIData();
+  racc.to(meas_out, clnames);
+  for (std::string m : { "eucll", "eucll_0", "eucll_1", "l1", "l1_0", "l1_1",
+                         "percent", "percent_0", "percent_1" })
+    ASSERT_NEAR(meas_out.get(m).get<double>(), exact.get(m).get<double>(),
+                1e-6)
+        << m;
+
+  // timeseries, 2 series over 5 timesteps, L1 by default
+  int nseries = 2;
+  torch::Tensor tpred = torch::randn({ 6, 5, nseries });
+  torch::Tensor ttarget = torch::randn({ 6, 5, nseries });
+  for (std::vector<std::string> ts_measures :
+       { std::vector<std::string>{ "L1_all", "L2_all" },
+         std::vector<std::string>{} })
+    {
+      MeasureAccumulator tacc(MeasureAccumulator::TIMESERIE, ts_measures,
+                              nseries);
+      MeasureAccumulator tacc2(MeasureAccumulator::TIMESERIE, ts_measures,
+                               nseries);
+      APIData ad_ts;
+      for (int j = 0; j < tpred.size(0); ++j)
+        {
+          const float *p = tpred.data_ptr<float>() + j * 5 * nseries;
+          const float *t = ttarget.data_ptr<float>() + j * 5 * nseries;
+          (j < 3 ? tacc : tacc2).add_timeserie(p, t, 5 * nseries);
+          APIData bad;
+          bad.add("pred", std::vector<double>(p, p + 5 * nseries));
+          bad.add("target", std::vector<double>(t, t + 5 * nseries));
+          ad_ts.add(std::to_string(j), bad);
+        }
+      tacc.merge(tacc2);
+      ad_ts.add("timeserie", true);
+      ad_ts.add("timeseries", nseries);
+      ad_ts.add("batch_size", static_cast<int>(tpred.size(0)));
+      APIData ad_ts_out;
+      ad_ts_out.add("measure", ts_measures);
+      APIData ts_out;
+      SupervisedOutput::measure(ad_ts, ad_ts_out, ts_out, 0, "test");
+      exact = ts_out.getobj("measure");
+      meas_out = APIData();
+      tacc.to(meas_out, clnames);
+      std::vector<std::string> ts_keys
+          = { "eucll", "L1_max_error", "L1_mean_error" };
+      if (!ts_measures.empty())
+        for (std::string k :
+             { "L2_max_error", "L2_mean_error", "L1_mean_error_0",
+               "L1_max_error_1", "L1_max_error_1_date", "L2_mean_error_1",
+               "L2_max_error_0", "L2_max_error_0_date" })
+          ts_keys.push_back(k);
+      else
+        ASSERT_FALSE(meas_out.has("L2_mean_error"));
+      for (const std::string &m : ts_keys)
+        ASSERT_NEAR(meas_out.get(m).get<double>(), exact.get(m).get<double>(),
+                    1e-6)
+            << m;
+    }
+}
+
+TEST(torchapi, state_cache)
+{
+  TorchStateCache cache(2, 0);
+  // no state yet: zero states from the model
+  ASSERT_TRUE(cache.gather({ "a", "b" }).empty());
+
+  // lstm states are [num_layers, batch, hidden]
+  TorchRNNStates states;
+  states["lstm"] = std::make_tuple(torch::arange(8.0).reshape({ 1, 2, 4 }),
+                                   -torch::arange(8.0).reshape({ 1, 2, 4 }));
+  cache.scatter({ "a", "b" }, states);
+  ASSERT_EQ(2, cache.size());
+
+  // batch in another order, with an unknown series
+  TorchRNNStates batch = cache.gather({ "b", "c", "a" });
+  ASSERT_EQ(1, batch.size());
+  torch::Tensor h = std::get<0>(batch["lstm"]);
+  torch::Tensor c = std::get<1>(batch["lstm"]);
+  ASSERT_EQ(std::vector<int64_t>({ 1, 3, 4 }), h.sizes().vec());
+  ASSERT_TRUE(torch::equal(h[0][0], torch::arange(4.0, 8.0)));
+  ASSERT_TRUE(torch::equal(h[0][1], torch::zeros(4)));
+  ASSERT_TRUE(torch::equal(c[0][2], -torch::arange(4.0)));
+
+  // least recently used series is evicted
+  cache.scatter({ "b", "c", "a" }, batch);
+  ASSERT_EQ(2, cache.size());
+  batch = cache.gather({ "b", "c" });
+  ASSERT_TRUE(
+      torch::equal(std::get<0>(batch["lstm"])[0][0], torch::zeros(4)));
+  ASSERT_TRUE(
+      torch::equal(std::get<0>(batch["lstm"])[0][1], torch::zeros(4)));
+  batch = cache.gather({ "a" });
+  ASSERT_TRUE(
+      torch::equal(std::get<0>(batch["lstm"])[0][0], torch::arange(4.0)));
+
+  // expired series are evicted
+  TorchStateCache::Clock::time_point now;
+  TorchStateCache ttl_cache(10, 1, [&now]() { return now; });
+  ttl_cache.scatter({ "a" }, cache.gather({ "a" }));
+  ASSERT_EQ(1, ttl_cache.size());
+  now += std::chrono::milliseconds(900);
+  ASSERT_FALSE(ttl_cache.gather({ "a" }).empty());
+  now += std::chrono::milliseconds(1100);
+  ASSERT_TRUE(ttl_cache.gather({ "a" }).empty());
+  ASSERT_EQ(0, ttl_cache.size());
 }
 
 // Training tests
@@ -3550,6 +4333,113 @@ TEST(torchapi, service_train_ttransformer_forecast)
   rmdir(csvts_nbeats_repo.c_str());
 }
 
+TEST(torchapi, service_train_ttransformer_forecast_bf16)
+{
+  JsonAPI japi;
+  std::string csvts_data = sinus + "train";
+  std::string csvts_test = sinus + "test";
+  std::string csvts_predict = sinus + "predict";
+  std::string str_min_vals, str_max_vals;
+
+  // same training in fp32 and under bf16 autocast
+  auto train = [&](const std::string &amp, double &l1, double &duration) {
+    torch::manual_seed(torch_seed);
+    std::string sname = "ttransformer_" + amp;
+    std::string repo = "ttransformer_" + amp;
+    mkdir(repo.c_str(), 0777);
+    std::string jstr
+        = "{\"mllib\":\"torch\",\"description\":\"ttransformer\",\"type\":"
+          "\"supervised\",\"model\":{\"repository\":\""
+          + repo
+          + "\"},\"parameters\":{\"input\":{\"connector\":\"csvts\","
+            "\"forecast_timesteps\":10,\"ignore\":[\"output\"],\"backcast_"
+            "timesteps\":40},\"mllib\":"
+            "{\"template\":\"ttransformer\",\"template_params\":{\"embed\": "
+            "{\"layers\": 2,\"activation\": "
+            "\"relu\",\"dim\": 2,\"type\": \"step\",\"dropout\": "
+            "0.0},\"encoder\":{\"heads\": 1,\"layers\": 2,\"hidden_dim\": "
+            "2,\"dropout\": 0.0},\"positional_encoding\":{\"type\": "
+            "\"naive\",\"learn\": false,\"dropout\": "
+            "0.0},\"decoder\":{\"type\": "
+            "\"simple\",\"dropout\": 0.0,\"layers\": 1}},"
+            "\"loss\":\"L1\""
+          + (amp == "fp32" ? "" : ",\"amp\":\"" + amp + "\"") + "}}}";
+    std::string joutstr = japi.jrender(japi.service_create(sname, jstr));
+    ASSERT_EQ(created_str, joutstr);
+
+    std::string jtrainstr
+        = "{\"service\":\"" + sname
+          + "\",\"async\":false,\"parameters\":{\"input\":{\"seed\":12345,"
+            "\"shuffle\":true,"
+            "\"separator\":\",\",\"scale\":true,\"offset\":10,\"backcast_"
+            "timesteps\":40,\"forecast_timesteps\":"
+            "10,\"ignore\":[\"output\"]},\"mllib\":{\"gpu\":false,\"solver\":{"
+            "\"iterations\":"
+          + iterations_ttransformer_cpu
+          + ",\"test_interval\":10,\"base_lr\":0.1,\"snapshot\":500,\"test_"
+            "initialization\":false,\"solver_type\":\"ADAM\"},\"net\":{"
+            "\"batch_size\":2,\"test_batch_"
+            "size\":10}},\"output\":{\"measure\":[\"L1_all\",\"L2_all\"]}},"
+            "\"data\":[\""
+          + csvts_data + "\",\"" + csvts_test + "\"]}";
+    joutstr = japi.jrender(japi.service_train(jtrainstr));
+    std::cout << "joutstr=" << joutstr << std::endl;
+    JDoc jd;
+    jd.Parse(joutstr.c_str());
+    ASSERT_TRUE(!jd.HasParseError());
+    ASSERT_EQ(201, jd["status"]["code"].GetInt());
+    ASSERT_TRUE(jd["body"]["measure"].HasMember("train_loss"));
+    ASSERT_TRUE(
+        std::isfinite(jd["body"]["measure"]["train_loss"].GetDouble()));
+    ASSERT_TRUE(jd["body"]["measure"].HasMember("L1_mean_error"));
+    l1 = jd["body"]["measure"]["L1_mean_error"].GetDouble();
+    duration = jd["body"]["measure"]["batch_duration_ms"].GetDouble();
+    str_min_vals = japi.jrender(jd["body"]["parameters"]["input"]["min_vals"]);
+    str_max_vals = japi.jrender(jd["body"]["parameters"]["input"]["max_vals"]);
+    std::cout << amp << " L1_mean_error=" << l1
+              << " batch_duration_ms=" << duration << std::endl;
+  };
+  double l1_fp32 = 0.0, l1_bf16 = 0.0, duration_fp32 = 0.0,
+         duration_bf16 = 0.0;
+  train("fp32", l1_fp32, duration_fp32);
+  train("bf16", l1_bf16, duration_bf16);
+
+  // bf16 keeps fp32 master weights, accuracy stays within tolerance
+  ASSERT_TRUE(std::isfinite(l1_bf16));
+  ASSERT_NEAR(l1_fp32, l1_bf16, std::max(0.05, 0.25 * l1_fp32));
+
+  //  predict
+  std::string sname = "ttransformer_bf16";
+  std::string jpredictstr = "{\"service\":\"" + sname
+                            + "\",\"parameters\":{\"input\":{\"backcast_"
+                              "timesteps\":40,\"connector\":"
+                              "\"csvts\",\"scale\":true,\"forecast_"
+                              "timesteps\":10,\"ignore\":[\"output\"],"
+                              "\"continuation\":"
+                              "true,\"min_vals\":"
+                            + str_min_vals + ",\"max_vals\":" + str_max_vals
+                            + "},\"output\":{}},\"data\":[\"" + csvts_predict
+                            + "\"]}";
+  std::string joutstr = japi.jrender(japi.service_predict(jpredictstr));
+  std::cout << "joutstr=" << joutstr << std::endl;
+  JDoc jd;
+  jd.Parse(joutstr.c_str());
+  ASSERT_TRUE(!jd.HasParseError());
+  ASSERT_EQ(200, jd["status"]["code"]);
+  ASSERT_EQ(jd["body"]["predictions"][0]["series"].Size(), 10);
+  ASSERT_TRUE(std::isfinite(
+      jd["body"]["predictions"][0]["series"][0]["out"][0].GetDouble()));
+
+  //  remove services
+  for (std::string amp : { "fp32", "bf16" })
+    {
+      joutstr = japi.jrender(
+          japi.service_delete("ttransformer_" + amp, "{\"clear\":\"full\"}"));
+      ASSERT_EQ(ok_str, joutstr);
+      rmdir(("ttransformer_" + amp).c_str());
+    }
+}
+
 #if !defined(CPU_ONLY)
 
 TEST(torchapi, service_train_csvts_nbeats_gpu)
@@ -3698,7 +4588,8 @@ TEST(torchapi, service_train_csvts_nbeats_multigpu)
           "\"shuffle\":true,"
           "\"separator\":\",\",\"scale\":true,\"backcast_timesteps\":50,"
           "\"forecast_timesteps\":50,\"ignore\":["
-          "\"output\"]},\"mllib\":{\"gpu\":true,\"gpuid\":[0, 1],\"solver\":{"
+          "\"output\"]},\"mllib\":{\"gpu\":true,\"gpuid\":[0, 1],"
+          "\"bucket_size_mb\":0.05,\"solver\":{"
           "\"iterations\":"
         + iterations_nbeats_gpu
         + ",\"test_interval\":100,\"base_lr\":0.001,\"snapshot\":500,\"test_"
@@ -3723,6 +4614,8 @@ TEST(torchapi, service_train_csvts_nbeats_multigpu)
   ASSERT_TRUE(jd.HasMember("body"));
   ASSERT_TRUE(jd["body"]["measure"].HasMember("train_loss"));
   ASSERT_TRUE(fabs(jd["body"]["measure"]["train_loss"].GetDouble()) > 0);
+  ASSERT_TRUE(jd["body"]["measure"].HasMember("comm_time_ms"));
+  ASSERT_TRUE(jd["body"]["measure"].HasMember("comm_wait_ms"));
   ASSERT_TRUE(jd["body"]["measure"].HasMember("L1_mean_error"));
   ASSERT_TRUE(jd["body"]["measure"]["L1_max_error_0"].GetDouble() > 0.0);
   ASSERT_TRUE(jd["body"]["parameters"]["input"].HasMember("max_vals"));
@@ -3774,6 +4667,104 @@ TEST(torchapi, service_train_csvts_nbeats_multigpu)
   rmdir(csvts_nbeats_repo.c_str());
 }
 
+TEST(torchapi, service_train_csvts_nbeats_distributed)
+{
+  torch::manual_seed(torch_seed);
+
+  // two ranks on the local cpu, each one in its own service
+  JsonAPI japi;
+  int world_size = 2;
+  std::string csvts_data = sinus + "train";
+  std::string csvts_test = sinus + "test";
+  std::string init_file = "csvts_nbeats_dist_init";
+  remove(init_file.c_str());
+
+  std::vector<std::string> snames;
+  std::vector<std::string> repos;
+  for (int rank = 0; rank < world_size; ++rank)
+    {
+      snames.push_back("nbeats_rank" + std::to_string(rank));
+      repos.push_back("csvts_nbeats_dist" + std::to_string(rank));
+      mkdir(repos.back().c_str(), 0777);
+
+      std::string jstr
+          = "{\"mllib\":\"torch\",\"description\":\"nbeats\",\"type\":"
+            "\"supervised\",\"model\":{\"repository\":\""
+            + repos.back()
+            + "\"},\"parameters\":{\"input\":{\"connector\":\"csvts\","
+              "\"ignore\":[\"output\"],\"backcast_timesteps\":50,"
+              "\"forecast_timesteps\":50},\"mllib\":{\"template\":"
+              "\"nbeats\",\"template_params\":{\"stackdef\":[\"t2\",\"s\","
+              "\"g3\",\"b3\"]},\"loss\":\"L1\"}}}";
+      std::string joutstr
+          = japi.jrender(japi.service_create(snames.back(), jstr));
+      ASSERT_EQ(created_str, joutstr);
+    }
+
+  // train all ranks concurrently
+  std::vector<std::string> joutstrs(world_size);
+  std::vector<std::thread> threads;
+  for (int rank = 0; rank < world_size; ++rank)
+    {
+      std::string jtrainstr
+          = "{\"service\":\"" + snames[rank]
+            + "\",\"async\":false,\"parameters\":{\"input\":{\"seed\":"
+              "12345,\"shuffle\":true,\"separator\":\",\",\"scale\":true,"
+              "\"backcast_timesteps\":50,\"forecast_timesteps\":50,"
+              "\"ignore\":[\"output\"]},\"mllib\":{\"gpu\":false,"
+              "\"distributed\":{\"world_size\":"
+            + std::to_string(world_size)
+            + ",\"rank\":" + std::to_string(rank)
+            + ",\"init_method\":\"file://" + init_file
+            + "\",\"bucket_size_mb\":0.01},\"solver\":{\"iterations\":"
+            + iterations_nbeats_cpu
+            + ",\"test_interval\":10,\"base_lr\":0.1,\"snapshot\":500,"
+              "\"test_initialization\":false,\"solver_type\":\"ADAM\"},"
+              "\"net\":{\"batch_size\":2,\"test_batch_size\":10}},"
+              "\"output\":{\"measure\":[\"L1_all\",\"L2\"]}},"
+              "\"data\":[\""
+            + csvts_data + "\",\"" + csvts_test + "\"]}";
+      threads.emplace_back([&japi, &joutstrs, rank, jtrainstr]() {
+        joutstrs[rank] = japi.jrender(japi.service_train(jtrainstr));
+      });
+    }
+  for (auto &t : threads)
+    t.join();
+
+  for (int rank = 0; rank < world_size; ++rank)
+    {
+      std::cout << "rank " << rank << " joutstr=" << joutstrs[rank]
+                << std::endl;
+      JDoc jd;
+      jd.Parse(joutstrs[rank].c_str());
+      ASSERT_TRUE(!jd.HasParseError());
+      ASSERT_EQ(201, jd["status"]["code"].GetInt());
+      if (rank == 0)
+        {
+          // only rank 0 tests and snapshots the model
+          ASSERT_TRUE(jd["body"]["measure"].HasMember("L1_mean_error"));
+          ASSERT_TRUE(fabs(jd["body"]["measure"]["train_loss"].GetDouble())
+                      > 0);
+          ASSERT_TRUE(fileops::file_exists(
+              repos[rank] + "/checkpoint-" + iterations_nbeats_cpu + ".npt"));
+        }
+      else
+        ASSERT_FALSE(fileops::file_exists(
+            repos[rank] + "/checkpoint-" + iterations_nbeats_cpu + ".npt"));
+    }
+
+  //  remove services
+  for (int rank = 0; rank < world_size; ++rank)
+    {
+      std::string jstr = "{\"clear\":\"full\"}";
+      std::string joutstr
+          = japi.jrender(japi.service_delete(snames[rank], jstr));
+      ASSERT_EQ(ok_str, joutstr);
+      rmdir(repos[rank].c_str());
+    }
+  remove(init_file.c_str());
+}
+
 TEST(torchapi, service_train_resnet18_multigpu)
 {
   setenv("CUBLAS_WORKSPACE_CONFIG", ":4096:8", true);
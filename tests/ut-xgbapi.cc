@@ -21,12 +21,14 @@
 
 #include "deepdetect.h"
 #include "jsonapi.h"
+#include "backends/xgb/xgbinputconns.h"
 
 #include <gtest/gtest.h>
 #include <stdio.h>
 #include <unistd.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <fstream>
 #include <iostream>
 
 using namespace dd;
@@ -313,3 +315,133 @@ TEST(xgbapi, service_train_csv_mt_regression)
   ASSERT_EQ(ok_str, joutstr);
   rmdir(sflare_repo_loc.c_str());
 }
+
+TEST(xgbapi, service_train_csv_missing)
+{
+  // data with empty feature cells
+  std::string repo = "xgb_missing";
+  mkdir(repo.c_str(), 0777);
+  std::ofstream of("test_xgb_missing.csv");
+  of << "id,val1,val2,label" << std::endl;
+  for (int i = 0; i < 40; ++i)
+    {
+      std::string val1 = i % 5 == 0 ? "" : std::to_string(i % 10);
+      std::string val2 = i % 7 == 0 ? "" : std::to_string(i % 3);
+      of << i << "," << val1 << "," << val2 << "," << (i % 10 >= 5)
+         << std::endl;
+    }
+  of.close();
+
+  JsonAPI japi;
+  std::string sname = "my_service";
+  std::string jstr
+      = "{\"mllib\":\"xgboost\",\"description\":\"my "
+        "classifier\",\"type\":\"supervised\",\"model\":{\"repository\":\""
+        + repo
+        + "\"},\"parameters\":{\"input\":{\"connector\":\"csv\"},\"mllib\":{"
+          "\"nclasses\":2}}}";
+  std::string joutstr = japi.jrender(japi.service_create(sname, jstr));
+  ASSERT_EQ(created_str, joutstr);
+
+  // train, missing values are left out of the matrix
+  std::string jtrainstr
+      = "{\"service\":\"" + sname
+        + "\",\"async\":false,\"parameters\":{\"input\":{\"label\":"
+          "\"label\",\"id\":\"id\",\"test_split\":0.2},\"mllib\":{"
+          "\"iterations\":10,\"objective\":\"multi:softprob\"},"
+          "\"output\":{\"measure\":[\"acc\"]}},\"data\":[\"test_xgb_"
+          "missing.csv\"]}";
+  joutstr = japi.jrender(japi.service_train(jtrainstr));
+  std::cout << "joutstr=" << joutstr << std::endl;
+  JDoc jd;
+  jd.Parse<rapidjson::kParseNanAndInfFlag>(joutstr.c_str());
+  ASSERT_TRUE(!jd.HasParseError());
+  ASSERT_EQ(201, jd["status"]["code"].GetInt());
+  ASSERT_TRUE(jd["body"]["measure"].HasMember("acc"));
+  ASSERT_TRUE(jd["body"]["measure"]["acc"].GetDouble() >= 0.0);
+
+  // empty labels are rejected
+  of.open("test_xgb_missing.csv");
+  of << "id,val1,val2,label" << std::endl;
+  of << "0,1,2,1" << std::endl;
+  of << "1,3,4," << std::endl;
+  of << "2,5,6,0" << std::endl;
+  of.close();
+  joutstr = japi.jrender(japi.service_train(jtrainstr));
+  std::cout << "joutstr=" << joutstr << std::endl;
+  jd.Parse<rapidjson::kParseNanAndInfFlag>(joutstr.c_str());
+  ASSERT_TRUE(!jd.HasParseError());
+  ASSERT_EQ(400, jd["status"]["code"].GetInt());
+
+  // remove service
+  jstr = "{\"clear\":\"full\"}";
+  joutstr = japi.jrender(japi.service_delete(sname, jstr));
+  ASSERT_EQ(ok_str, joutstr);
+  rmdir(repo.c_str());
+  remove("test_xgb_missing.csv");
+}
+
+TEST(xgbinputconn, csv_chunks)
+{
+  std::string header = "id,val1,val2,label";
+  std::ofstream of("test_xgb_chunks.csv");
+  of << header << std::endl;
+  of << "1,2590,56,1" << std::endl;
+  of << "2,4000,0,0" << std::endl;
+  of << "3,3295,40.5,1" << std::endl;
+  of << "4,,12,0" << std::endl;
+  of << "5,1200,7,1" << std::endl;
+  of.close();
+  std::ofstream oft("test_xgb_chunks_test.csv");
+  oft << header << std::endl;
+  oft << "6,3000,3,0" << std::endl;
+  oft << "7,1500,,1" << std::endl;
+  oft.close();
+  std::vector<std::string> vdata
+      = { "test_xgb_chunks.csv", "test_xgb_chunks_test.csv" };
+
+  // matrices from chunks read through disk, and from the in memory table
+  auto make_matrices = [&](const bool &streaming, CSVXGBInputFileConn &cifc) {
+    APIData ad;
+    ad.add("data", vdata);
+    APIData pad, pinp;
+    pinp.add("label", std::string("label"));
+    pinp.add("id", std::string("id"));
+    pinp.add("streaming", streaming);
+    pinp.add("chunk_size", 2);
+    std::vector<APIData> vpinp = { pinp };
+    pad.add("input", vpinp);
+    std::vector<APIData> vpad = { pad };
+    ad.add("parameters", vpad);
+    cifc._logger = spdlog::get("test_xgb_chunks")
+                       ? spdlog::get("test_xgb_chunks")
+                       : spdlog::stdout_logger_mt("test_xgb_chunks");
+    cifc._train = true;
+    cifc.transform(ad);
+  };
+  CSVXGBInputFileConn chunked;
+  make_matrices(true, chunked);
+  ASSERT_TRUE(chunked._chunks.empty());
+  CSVXGBInputFileConn table;
+  make_matrices(false, table);
+
+  ASSERT_TRUE(chunked._m != nullptr);
+  ASSERT_TRUE(chunked._mtest != nullptr);
+  ASSERT_EQ(5, chunked._m->Info().num_row_);
+  ASSERT_EQ(2, chunked._mtest->Info().num_row_);
+  // missing values are not stored
+  ASSERT_EQ(9, chunked._m->Info().num_nonzero_);
+  ASSERT_EQ(3, chunked._mtest->Info().num_nonzero_);
+  ASSERT_EQ(table._m->Info().num_row_, chunked._m->Info().num_row_);
+  ASSERT_EQ(table._m->Info().num_nonzero_, chunked._m->Info().num_nonzero_);
+  ASSERT_EQ(table._m->Info().labels_.HostVector(),
+            chunked._m->Info().labels_.HostVector());
+  ASSERT_EQ(table._mtest->Info().labels_.HostVector(),
+            chunked._mtest->Info().labels_.HostVector());
+  std::vector<float> labels{ 1, 0, 1, 0, 1 };
+  ASSERT_EQ(labels, chunked._m->Info().labels_.HostVector());
+  ASSERT_EQ(table._ids, chunked._ids);
+
+  remove("test_xgb_chunks.csv");
+  remove("test_xgb_chunks_test.csv");
+}